@@ -358,6 +358,7 @@ struct dxBody;      /* rigid body (dynamics object) */
 struct dxGeom;      /* geometry (collision object) */
 struct dxJoint;     /* joint */
 struct dxJointGroup;/* joint group */
+struct dxWorldSnapshot;/* saved dynamic state of a world */
 
 
 typedef struct dxWorld *dWorldID;
@@ -366,6 +367,7 @@ typedef struct dxBody *dBodyID;
 typedef struct dxGeom *dGeomID;
 typedef struct dxJoint *dJointID;
 typedef struct dxJointGroup *dJointGroupID;
+typedef struct dxWorldSnapshot *dWorldSnapshotID;
 
 
 /* error numbers */
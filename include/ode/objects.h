@@ -383,6 +383,81 @@ ODE_API void dWorldSetStepThreadingImplementation(dWorldID w, const dThreadingFu
  */
 ODE_API int dWorldStep (dWorldID w, dReal stepsize);
 
+/**
+ * @brief Enable/disable the sparse factorization of dWorldStep islands.
+ * @ingroup world
+ * @remarks
+ * When all the constraint rows of an island are unbounded (e.g. chains and
+ * mechanisms of ball, hinge and slider joints without motors, active
+ * limits or contacts), the LCP is a linear system. With this option it is
+ * assembled and factored as a sparse matrix, with the joints numbered so
+ * that the nonzero blocks stay near the diagonal, and the time and memory
+ * used for chains and trees grow linearly with the number of rows instead
+ * of cubically and quadratically. The other islands still use the dense
+ * LCP solver. The results only differ by rounding.
+ * The default is disabled.
+ * @param enabled 1 to enable, 0 to disable
+ */
+ODE_API void dWorldSetStepSparseFactorization (dWorldID, int enabled);
+
+/**
+ * @brief Get whether the sparse factorization of dWorldStep islands is enabled.
+ * @ingroup world
+ */
+ODE_API int dWorldGetStepSparseFactorization (dWorldID);
+
+/**
+ * @brief Enable/disable the articulated tree solver of dWorldStep islands.
+ * @ingroup world
+ * @remarks
+ * Articulated bodies such as robots and ragdolls are trees of joints whose
+ * rows are all unbounded (ball, hinge, slider, fixed etc. joints without
+ * motors or active limits). With this option dWorldStep eliminates such
+ * tree joints body by body, from the leaves to the root, in time and memory
+ * linear in the number of bodies, and the joints are satisfied exactly
+ * instead of being a part of the LCP. The remaining rows (contacts, motors,
+ * limits, joints that close loops and joints that attach a tree to the
+ * static environment a second time) are solved by the LCP solver through
+ * the tree, so the result is the same as without the option up to rounding.
+ * Islands without tree joints are not affected.
+ * The default is disabled.
+ * @param enabled 1 to enable, 0 to disable
+ */
+ODE_API void dWorldSetStepArticulatedTrees (dWorldID, int enabled);
+
+/**
+ * @brief Get whether the articulated tree solver of dWorldStep islands is enabled.
+ * @ingroup world
+ */
+ODE_API int dWorldGetStepArticulatedTrees (dWorldID);
+
+/**
+ * @brief Enable/disable warm starting of the dWorldStep LCP solver.
+ * @ingroup world
+ * @remarks
+ * The LCP solver normally builds the sets of clamped and unclamped rows
+ * from scratch, one row at a time, updating the factorization of the
+ * clamped rows for every change. With this option it first tries the sets
+ * implied by the constraint forces of the previous step: the clamped rows
+ * are factored at once and all the rows found in the wrong set are moved
+ * together (block pivoting). For resting contact and other slowly changing
+ * systems the sets rarely change, so one or two factorizations replace the
+ * row by row updates. If the sets do not settle quickly the usual solver is
+ * used, so the results only differ by rounding.
+ * Contact joints are usually destroyed after every step; their forces are
+ * kept in the same cache as for @c dWorldSetQuickStepWarmStarting and
+ * matched within @c dWorldSetQuickStepContactMatchDistance.
+ * The default is disabled.
+ * @param enabled 1 to enable, 0 to disable
+ */
+ODE_API void dWorldSetStepWarmStarting (dWorldID, int enabled);
+
+/**
+ * @brief Get whether warm starting of the dWorldStep LCP solver is enabled.
+ * @ingroup world
+ */
+ODE_API int dWorldGetStepWarmStarting (dWorldID);
+
 /**
  * @brief Quick-step the world.
  *
@@ -426,6 +501,119 @@ ODE_API int dWorldStep (dWorldID w, dReal stepsize);
  */
 ODE_API int dWorldQuickStep (dWorldID w, dReal stepsize);
 
+/**
+ * @brief Step the world, choosing dWorldStep() or dWorldQuickStep() for
+ * each island.
+ *
+ * The islands that contain joints other than contacts (robots, vehicles,
+ * ragdolls and the contacts they make) are stepped like dWorldStep(), for
+ * accuracy, as long as they have at most dWorldSetAutoStepMaxRows()
+ * constraint rows. The islands made of contacts only (piles of debris) and
+ * the islands with more rows are stepped like dWorldQuickStep(), for speed.
+ * The options of both steppers (warm starting, iterations etc.) apply to
+ * the islands they step. The choice is made again at every step, so an
+ * island may switch steppers as contacts join or leave it.
+ *
+ * Failure result status means that the memory allocation has failed for operation.
+ * In such a case all the objects remain in unchanged state and simulation can be
+ * retried as soon as more memory is available.
+ *
+ * @param w The world to be stepped
+ * @param stepsize The number of seconds that the simulation has to advance.
+ * @returns 1 for success and 0 for failure
+ *
+ * @ingroup world
+ */
+ODE_API int dWorldAutoStep (dWorldID w, dReal stepsize);
+
+/**
+ * @brief Set the most constraint rows of an island that dWorldAutoStep()
+ * steps exactly.
+ * @ingroup world
+ * @remarks
+ * The time of the exact stepper grows with the cube of the rows, so bigger
+ * islands are quick-stepped even if they have joints other than contacts.
+ * @param rows The default is 200.
+ */
+ODE_API void dWorldSetAutoStepMaxRows (dWorldID, int rows);
+
+/**
+ * @brief Get the most constraint rows of an island that dWorldAutoStep()
+ * steps exactly.
+ * @ingroup world
+ */
+ODE_API int dWorldGetAutoStepMaxRows (dWorldID);
+
+/**
+ * @brief Set the most constraint rows of an island of contacts only that
+ * dWorldAutoStep() steps exactly.
+ * @ingroup world
+ * @remarks
+ * With a small value, resting objects with a few contacts are stepped
+ * exactly while bigger piles are quick-stepped. It has no effect above
+ * dWorldSetAutoStepMaxRows().
+ * @param rows The default is 0, which quick-steps all the islands of
+ * contacts only.
+ */
+ODE_API void dWorldSetAutoStepMaxContactRows (dWorldID, int rows);
+
+/**
+ * @brief Get the most constraint rows of an island of contacts only that
+ * dWorldAutoStep() steps exactly.
+ * @ingroup world
+ */
+ODE_API int dWorldGetAutoStepMaxContactRows (dWorldID);
+
+
+/**
+ * @brief Save the dynamic state of a world so that it can be restored later.
+ *
+ * The snapshot holds, for every body, the position, orientation, velocities,
+ * force/torque accumulators, enabled state and auto-disable counters; and for
+ * every joint that is not in a joint group, the enabled state, the constraint
+ * forces of the last step (used for warm starting) and the feedback structure.
+ * Parameters such as masses, damping or joint limits are not saved.
+ *
+ * This is meant for resetting a simulation to a known state many times
+ * (e.g. episodic learning) without destroying and re-creating the world.
+ *
+ * @param w The world to take the snapshot of.
+ * @returns The new snapshot. It must be destroyed with
+ * @c dWorldSnapshotDestroy before the world is destroyed.
+ * @ingroup world
+ * @see dWorldSnapshotRestore
+ */
+ODE_API dWorldSnapshotID dWorldSnapshotCreate (dWorldID w);
+
+/**
+ * @brief Destroy a world snapshot.
+ * @ingroup world
+ */
+ODE_API void dWorldSnapshotDestroy (dWorldSnapshotID s);
+
+/**
+ * @brief Replace the contents of a snapshot with the current state of its world.
+ *
+ * The snapshot buffers only grow, so capturing the same world repeatedly
+ * does not allocate memory.
+ * @ingroup world
+ */
+ODE_API void dWorldSnapshotCapture (dWorldSnapshotID s);
+
+/**
+ * @brief Restore the state saved in a snapshot into its world.
+ *
+ * The world must contain the same bodies and non-grouped joints, attached
+ * the same way, as when the snapshot was captured. Grouped joints (e.g.
+ * contacts) are not touched, so contact groups should be emptied before
+ * restoring. Attached geoms are notified that their bodies moved.
+ *
+ * @returns 1 on success. 0 if bodies or joints were created, destroyed or
+ * re-attached since the capture; the world is left unchanged in that case.
+ * @ingroup world
+ */
+ODE_API int dWorldSnapshotRestore (dWorldSnapshotID s);
+
 
 /**
 * @brief Converts an impulse to a force.
@@ -482,6 +670,131 @@ ODE_API void dWorldSetQuickStepW (dWorldID, dReal over_relaxation);
  */
 ODE_API dReal dWorldGetQuickStepW (dWorldID);
 
+/**
+ * @brief Set the convergence tolerance of the QuickStep iterations.
+ * @ingroup world
+ * @remarks
+ * After each iteration the largest change of a constraint force (lambda)
+ * is found. Once it is not greater than the tolerance the island stops
+ * iterating, so calm islands use a few iterations and the islands that
+ * do not converge still use all of dWorldSetQuickStepNumIterations().
+ * @param tolerance The default is 0, which always performs all the
+ * iterations.
+ */
+ODE_API void dWorldSetQuickStepTolerance (dWorldID, dReal tolerance);
+
+/**
+ * @brief Get the convergence tolerance of the QuickStep iterations.
+ * @ingroup world
+ */
+ODE_API dReal dWorldGetQuickStepTolerance (dWorldID);
+
+
+/**
+ * @brief Enable or disable warm starting of the QuickStep solver.
+ * @ingroup world
+ * @remarks
+ * With warm starting the SOR iterations start from the constraint forces
+ * of the previous step instead of zero, so fewer iterations are needed to
+ * converge for resting contacts, stacks and motor-driven joints.
+ * Contact joints are usually destroyed after every step; their forces are
+ * kept in a cache inside the world and given to the contacts of the next
+ * step that have the same geoms and features (@c side1, @c side2) and lie
+ * within @c dWorldSetQuickStepContactMatchDistance of a cached contact.
+ * It may hurt with high-friction contacts. The default is disabled.
+ * @param enabled 1 to enable, 0 to disable
+ */
+ODE_API void dWorldSetQuickStepWarmStarting (dWorldID, int enabled);
+
+/**
+ * @brief Get whether QuickStep warm starting is enabled.
+ * @ingroup world
+ */
+ODE_API int dWorldGetQuickStepWarmStarting (dWorldID);
+
+/**
+ * @brief Set how far a contact may move between steps and still be
+ * warm started from the contact of the previous step.
+ * @ingroup world
+ * @param distance The default is 0.01.
+ */
+ODE_API void dWorldSetQuickStepContactMatchDistance (dWorldID, dReal distance);
+
+/**
+ * @brief Get the contact matching distance used for warm starting.
+ * @ingroup world
+ */
+ODE_API dReal dWorldGetQuickStepContactMatchDistance (dWorldID);
+
+/**
+ * @brief Enable/disable graph coloring of the QuickStep constraint rows.
+ * @ingroup world
+ * @remarks
+ * Once per step the rows are given colors so that the rows of a color have
+ * no bodies in common. The iterations sweep the colors one after another and
+ * the rows of each color in parallel, instead of following the dependencies
+ * between the rows of a randomly reordered sequence. The sweep order is kept
+ * for the whole step, so the results do not depend on the number of threads
+ * or on the random number generator. The rows left without a color, when
+ * a body has too many of them, are swept by a single thread after the colors.
+ * The default is disabled.
+ * @param enabled 1 to enable, 0 to disable
+ */
+ODE_API void dWorldSetQuickStepGraphColoring (dWorldID, int enabled);
+
+/**
+ * @brief Get whether QuickStep graph coloring is enabled.
+ * @ingroup world
+ */
+ODE_API int dWorldGetQuickStepGraphColoring (dWorldID);
+
+/**
+ * @brief Enable/disable the SIMD batches of graph colored QuickStep rows.
+ * @ingroup world
+ * @remarks
+ * With graph coloring the rows of a color can be solved several at a time
+ * with SIMD instructions where the CPU supports them. The batched rows get
+ * the same lambdas as when solved one by one up to rounding, which depends
+ * on the instruction set. Disable the batches for results which are the same
+ * on all the CPUs. The default is enabled.
+ * @param enabled 1 to enable, 0 to disable
+ */
+ODE_API void dWorldSetQuickStepRowBatching (dWorldID, int enabled);
+
+/**
+ * @brief Get whether the SIMD batches of QuickStep rows are enabled.
+ * @ingroup world
+ */
+ODE_API int dWorldGetQuickStepRowBatching (dWorldID);
+
+/**
+ * @brief Statistics of the last QuickStep.
+ * @ingroup world
+ * @remarks
+ * The rows attached to a single body (e.g. the contacts with static
+ * geometry) and the rows between two bodies are solved as separate streams
+ * with kernels specialized for each. The iterations and the residual are
+ * the worst ones among the islands; the residual can be compared with
+ * the value of dWorldSetQuickStepTolerance().
+ */
+typedef struct dQuickStepStats {
+  int rows;             /**< all the constraint rows of the step */
+  int one_body_rows;    /**< the rows attached to a single body */
+  int two_body_rows;    /**< the rows between two bodies */
+  int iterations;       /**< the most iterations performed by an island */
+  dReal residual;       /**< the largest change of lambda in the last iteration of an island */
+} dQuickStepStats;
+
+/**
+ * @brief Get the statistics of the last dWorldQuickStep call.
+ * @ingroup world
+ * @remarks
+ * After dWorldAutoStep() they cover the quick-stepped islands.
+ * @param stats The structure to fill. All the counters are zero
+ * before the first step.
+ */
+ODE_API void dWorldGetQuickStepStats (dWorldID, dQuickStepStats *stats);
+
 /* World contact parameter functions */
 
 /**
@@ -541,6 +854,13 @@ ODE_API dReal dWorldGetContactSurfaceLayer (dWorldID);
  * itself when
  *   @li It has been idle for a given number of simulation steps.
  *   @li It has also been idle for a given amount of simulation time.
+ *   @li All the other bodies of its island can be disabled as well.
+ *
+ * The bodies of an island are disabled together (the island goes to sleep),
+ * and they are woken together when any of them is enabled or gets connected
+ * to an enabled body, even if the joints between them have been destroyed in
+ * the meantime. Spaces do not report pairs of geoms that both belong to
+ * sleeping bodies.
  *
  * A body is considered to be idle when the magnitudes of both its
  * linear average velocity and angular average velocity are below given thresholds.
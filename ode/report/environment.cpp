@@ -0,0 +1,152 @@
+#include <drawstuff/drawstuff.h>  // 描画用ヘッダーファイル
+#include <ode/ode.h>              // ODE用ヘッダーファイル
+
+#include "environment.hpp"
+
+#include <cmath>
+
+
+Environment::Environment(const Timing& timing)
+    : timing(timing)
+{
+    build();
+}
+
+Environment::~Environment()
+{
+    destruct();
+}
+
+void Environment::build()
+{
+    world = dWorldCreate();
+    space = dHashSpaceCreate(0);
+    contactgroup = dJointGroupCreate(0);
+
+    foot.init(world, space, Eigen::Vector3d{0.2, 0.0, 0.15});
+    leg.init(world, space, Eigen::Vector3d{0.0, 0.0, 0.6});
+    thigh.init(world, space, Eigen::Vector3d{0.0, 0.0, 1.55});
+    head.init(world, space, Eigen::Vector3d{0.0, 0.0, 2.4});
+
+    ankle.init(world,
+        leg.getBody(), foot.getBody(),
+        Eigen::Vector3d{0.2, 0.0, 0.2},
+        Eigen::Matrix<int, 3, 1>{0, 1, 0});
+
+    knee.init(world,
+        thigh.getBody(), leg.getBody(),
+        Eigen::Vector3d{0.0, 0.0, 1.1},
+        Eigen::Matrix<int, 3, 1>{0, 1, 0});
+
+    neck.init(world, head.getBody(), thigh.getBody());
+
+    ankle.setParam(dParamLoStop, -0.7 * M_PI);
+    ankle.setParam(dParamHiStop, 0.7 * M_PI);
+    knee.setParam(dParamLoStop, -0.7 * M_PI);
+    knee.setParam(dParamHiStop, 0.7 * M_PI);
+
+
+    dWorldSetGravity(world, 0, 0, -9.81);
+    dWorldSetERP(world, 0.9);   // ERPの設定
+    dWorldSetCFM(world, 1e-4);  // CFMの設定
+    dWorldSetQuickStepWarmStarting(world, timing.warm_start);
+    dWorldSetStepArticulatedTrees(world, timing.articulated);
+
+    ground = dCreatePlane(space, 0, 0, 1, 0);
+
+    initial = dWorldSnapshotCreate(world);
+}
+
+// ボディとジオメトリはワールドとスペースと一緒に破棄される
+void Environment::destruct()
+{
+    dWorldSnapshotDestroy(initial);
+    dJointGroupDestroy(contactgroup);
+    dSpaceDestroy(space);
+    dWorldDestroy(world);
+}
+
+void Environment::reset()
+{
+    dJointGroupEmpty(contactgroup);
+    if (!dWorldSnapshotRestore(initial)) {
+        // ボディやジョイントの構成が変わっていたら作り直す
+        destruct();
+        build();
+    }
+}
+
+void Environment::nearCallback(void* data, dGeomID o1, dGeomID o2)
+{
+    Environment* env = static_cast<Environment*>(data);
+
+    constexpr int N = 3;  // 接触点数
+    dContact contact[N];
+
+    // 2つのボディがジョイントで結合されていたら衝突検出しない
+    dBodyID b1 = dGeomGetBody(o1);
+    dBodyID b2 = dGeomGetBody(o2);
+    if (b1 && b2 && dAreConnectedExcluding(b1, b2, dJointTypeContact)) {
+        return;
+    }
+
+    int n = dCollide(o1, o2, N, &contact[0].geom, sizeof(dContact));
+
+    for (int i = 0; i < n; i++) {
+        contact[i].surface.mode = dContactBounce | dContactSoftERP | dContactSoftCFM;
+        contact[i].surface.soft_erp = 0.2;         // 接触点のERP
+        contact[i].surface.soft_cfm = 0.001;       // 接触点のCFM
+        contact[i].surface.mu = 0.7;               // 摩擦係数
+        contact[i].surface.mode = dContactBounce;  // 接触面の反発性を設定
+        contact[i].surface.bounce = 0.6;           // 反発係数
+        contact[i].surface.bounce_vel = 0.0;       // 反発最低速度
+        dJointID c = dJointCreateContact(env->world, env->contactgroup, &contact[i]);
+        dJointAttach(c, dGeomGetBody(contact[i].geom.g1), dGeomGetBody(contact[i].geom.g2));
+    }
+}
+
+std::array<dReal, 2> Environment::getState()
+{
+    return std::array<dReal, 2>{
+        dJointGetHingeAngle(ankle.getID()),
+        dJointGetHingeAngle(knee.getID())};
+}
+
+std::array<dReal, 2> Environment::getRate()
+{
+    return std::array<dReal, 2>{
+        dJointGetHingeAngleRate(ankle.getID()),
+        dJointGetHingeAngleRate(knee.getID())};
+}
+
+void Environment::applyInput(const std::array<dReal, 2>& torque_input)
+{
+    dJointAddHingeTorque(ankle.getID(), torque_input[0]);
+    dJointAddHingeTorque(knee.getID(), torque_input[1]);
+}
+
+void Environment::step(dReal dt)
+{
+    dSpaceCollide(space, this, &nearCallback);
+    if (timing.autostep) {
+        dWorldAutoStep(world, dt);
+    } else if (timing.quickstep) {
+        dWorldQuickStep(world, dt);
+    } else {
+        dWorldStep(world, dt);
+    }
+    dJointGroupEmpty(contactgroup);
+}
+
+dReal Environment::headHeight()
+{
+    return dBodyGetPosition(head.getBody())[2];
+}
+
+void Environment::draw()
+{
+    leg.draw();
+    thigh.draw();
+    foot.draw();
+    head.draw();
+}
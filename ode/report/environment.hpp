@@ -0,0 +1,84 @@
+#pragma once
+
+#include "joint.hpp"
+#include "object.hpp"
+#include "simulation.hpp"
+
+#include <Eigen/Core>
+
+#include <array>
+
+/* @description: ロボット1体分の環境
+ * ワールド，スペース，コンタクトグループをそれぞれ独立に持つので，
+ * 複数のインスタンスを別々のスレッドで同時に動かせる
+ */
+class Environment
+{
+    Timing timing;
+
+    dWorldID world;              // 動力学計算用ワールド
+    dSpaceID space;              // 衝突検出用スペース
+    dGeomID ground;              // 地面
+    dJointGroupID contactgroup;  // コンタクトグループ
+    dWorldSnapshotID initial;    // 初期姿勢のスナップショット
+
+    Capsule leg{
+        3, 5.0, 0.2, 0.5,
+        Color{1.0, 0.0, 0.0}};
+    Capsule thigh{
+        3, 3.0, 0.2, 0.5,
+        Color{0.0, 0.0, 1.0}};
+    Box foot{
+        7.0, Eigen::Vector3d{0.8, 0.7, 0.2},
+        Color{0.0, 1.0, 0.0}};
+    Sphere head{
+        2.0, 0.4,
+        Color{1.0, 1.0, 0.0}};
+
+    Hinge ankle;
+    Hinge knee;
+    FixedJoint neck;
+
+    void build();
+    void destruct();
+
+    static void nearCallback(void* data, dGeomID o1, dGeomID o2);
+
+public:
+    /* @param: timing 使うステッパー
+     */
+    explicit Environment(const Timing& timing = Timing{});
+    ~Environment();
+
+    Environment(const Environment&) = delete;
+    Environment& operator=(const Environment&) = delete;
+
+    /* @description: 初期姿勢に戻す
+     * ワールドを作り直さず，build 直後のスナップショットを書き戻す
+     */
+    void reset();
+
+    /* @return: 足首と膝の角度
+     */
+    std::array<dReal, 2> getState();
+
+    /* @return: 足首と膝の角速度
+     */
+    std::array<dReal, 2> getRate();
+
+    /* @param: torque_input 足首と膝のトルク入力
+     */
+    void applyInput(const std::array<dReal, 2>& torque_input);
+
+    /* @description: 衝突検出と物理1ステップ分の動力学計算
+     * トルク入力はステップごとに消えるので，毎回 applyInput してから呼ぶ
+     * @param: dt 時間幅
+     */
+    void step(dReal dt);
+
+    /* @return: 頭の高さ (転倒判定用)
+     */
+    dReal headHeight();
+
+    void draw();
+};
@@ -1,79 +1,67 @@
-#include <drawstuff/drawstuff.h>  // 描画用ヘッダーファイル
-#include <ode/ode.h>              // ODE用ヘッダーファイル
-
-#include "simulation.hpp"
-
-#include <Eigen/Core>
-
-#include <cmath>
-#include <fstream>
-#include <iostream>
-
-/*
-std::array<dReal, 2> user_callback(const std::array<dReal, 2>& state)
-{
-    Eigen::Vector2d state_vec{state.at(0), state.at(1)};
-
-    std::array<dReal, 2> input;
-    input.at(0) = 0;
-    input.at(1) = 0;
-
-    return input;
-}
-*/
-
-/*
-std::array<dReal, 2> user_callback(const std::array<dReal, 2>& state)
-{
-    std::array<dReal, 2> input;
-    static std::array<dReal, 2> _state = state;
-
-    if (state.at(0) < 0) {
-        input.at(0) = 80;
-    } else {
-        input.at(0) = -80;
-    }
-    std::cout << "ankle = " << state.at(0) << std::endl;
-    std::cout << "knee = " << state.at(1) << std::endl;
-    std::cout << input.at(0) << std::endl;
-    input.at(1) = 0;
-
-    _state = state;
-
-    return input;
-}
-*/
-
-double kp_0 = 0.0, kv_0 = 0.0;
-double kp_1 = 0.0, kv_1 = 0.0;
-void loadParams()
-{
-    std::ifstream file("param.txt");
-    file >> kp_0 >> kv_0 >> kp_1 >> kv_1;
-    std::cout << "params : " << kp_0 << kv_0 << kp_1 << kv_1 << std::endl;
-}
-
-std::array<dReal, 2> user_callback(const std::array<dReal, 2>& state)
-{
-    static double t = 0.0;
-
-    std::array<dReal, 2> input;
-    static std::array<dReal, 2> _state = state;
-
-    {
-        std::cout << "ankle = " << state.at(0) << std::endl;
-        input.at(0) = kp_0 * (0.1 - state.at(0)) + kv_0 * (_state.at(0) - state.at(0));
-        std::cout << input.at(0) << std::endl;
-    }
-
-    {
-        std::cout << "knee = " << state.at(1) << std::endl;
-        input.at(1) = kp_0 * (-(0.4 * M_PI * std::sin(M_PI * t) + 0.1 * M_PI) - state.at(0)) + kv_0 * (-0.4 * M_PI * M_PI * std::cos(M_PI * t) - (_state.at(0) - state.at(0)));
-        std::cout << input.at(1) << std::endl;
-    }
-
-    _state = state;
-    t += 0.05;
-
-    return input;
-}
+#include <drawstuff/drawstuff.h>  // 描画用ヘッダーファイル
+#include <ode/ode.h>              // ODE用ヘッダーファイル
+
+#include "simulation.hpp"
+
+#include <cmath>
+#include <fstream>
+#include <iostream>
+
+Params loadParams()
+{
+    Params params;
+    std::vector<Params> sets = loadParamSets("param.txt");
+    if (!sets.empty()) {
+        params = sets.front();
+    }
+    std::cout << "params : " << params.kp_0 << " " << params.kv_0 << " "
+              << params.kp_1 << " " << params.kv_1 << std::endl;
+    return params;
+}
+
+std::vector<Params> loadParamSets(const std::string& filename)
+{
+    std::vector<Params> sets;
+    std::ifstream file(filename);
+    Params p;
+    while (file >> p.kp_0 >> p.kv_0 >> p.kp_1 >> p.kv_1) {
+        sets.push_back(p);
+    }
+    return sets;
+}
+
+// 目標軌道 (足首角, 膝角)
+static std::array<dReal, 2> reference(double t)
+{
+    return {0.1, -(0.4 * M_PI * std::sin(M_PI * t) + 0.1 * M_PI)};
+}
+
+std::array<dReal, 2> user_callback(
+    const Params& params, ControllerState& memory,
+    const std::array<dReal, 2>& state)
+{
+    if (!memory.initialized) {
+        memory.prev_state = state;
+        memory.initialized = true;
+    }
+    const std::array<dReal, 2>& _state = memory.prev_state;
+    const std::array<dReal, 2> ref = reference(memory.t);
+
+    std::array<dReal, 2> input;
+    input.at(0) = params.kp_0 * (ref.at(0) - state.at(0)) + params.kv_0 * (_state.at(0) - state.at(0));
+    // 元の制御則どおり，膝トルクも足首のゲイン (kp_0, kv_0) と足首角から計算する
+    input.at(1) = params.kp_0 * (ref.at(1) - state.at(0)) + params.kv_0 * (-0.4 * M_PI * M_PI * std::cos(M_PI * memory.t) - (_state.at(0) - state.at(0)));
+
+    memory.prev_state = state;
+    memory.t += memory.dt;
+
+    return input;
+}
+
+double user_cost(const std::array<dReal, 2>& state, const std::array<dReal, 2>& input, double t)
+{
+    const std::array<dReal, 2> ref = reference(t);
+    const double e0 = ref.at(0) - state.at(0);
+    const double e1 = ref.at(1) - state.at(1);
+    return e0 * e0 + e1 * e1 + 1e-6 * (input.at(0) * input.at(0) + input.at(1) * input.at(1));
+}
@@ -2,14 +2,37 @@
 
 #include <Eigen/Core>
 
-class activation
+/* 活性化関数 (要素ごと)
+ * f は入力から出力を，df は出力から微分を計算する．
+ * どちらもバッチ全体 (特徴量×バッチの行列) に一度に作用する
+ */
+namespace activation
 {
-};
 
-class Sigmoid
-{
+struct ReLu {
+    template <class Derived>
+    static auto f(const Eigen::ArrayBase<Derived>& x)
+    {
+        return x.max(typename Derived::Scalar(0));
+    }
+    template <class Derived>
+    static auto df(const Eigen::ArrayBase<Derived>& y)
+    {
+        return (y > typename Derived::Scalar(0)).template cast<typename Derived::Scalar>();
+    }
 };
 
-class ReLu
-{
+struct Sigmoid {
+    template <class Derived>
+    static auto f(const Eigen::ArrayBase<Derived>& x)
+    {
+        return (typename Derived::Scalar(1) + (-x).exp()).inverse();
+    }
+    template <class Derived>
+    static auto df(const Eigen::ArrayBase<Derived>& y)
+    {
+        return y * (typename Derived::Scalar(1) - y);
+    }
 };
+
+}  // namespace activation
@@ -1,77 +1,200 @@
 #pragma once
 
+#include "layer.hpp"
+#include "network.hpp"
+#include "replay_buffer.hpp"
+
 #include <Eigen/Core>
 
-#include <array>
-#include <iostream>
+#include <algorithm>
+#include <random>
 
-namespace DQN
+namespace DDPG
 {
 
-class Q
+/* @description: 行動価値関数 Q(s, a) (critic)
+ * 入力は状態と行動を縦に並べたもの
+ */
+class Q : public Network
 {
-private:
-    Eigen::Matrix<double, 3, 16> weight_1;
-    Eigen::Matrix<double, 16, 64> weight_2;
-    Eigen::Matrix<double, 64, 64> weight_3;
-    Eigen::Matrix<double, 64, 1> weight_4;
-
 public:
-    double ReLu(double x)
+    Q(const int state_dim, const int action_dim, const int hidden, const double learning_rate, std::mt19937& engine)
+        : Network(learning_rate)
     {
-        return (x < 0) ? 0 : x;
+        add<Linear>(state_dim + action_dim, hidden, engine);
+        add<ReLu>();
+        add<Linear>(hidden, hidden, engine);
+        add<ReLu>();
+        add<Linear>(hidden, 1, engine, 1e-2);
     }
-    double dReLu(double x)
+};
+
+/* @description: 決定的な方策 mu(s) (actor)
+ * 出力は Sigmoid で [0, 1] に収め，Agent 側で [-action_scale, action_scale] に広げる
+ */
+class Policy : public Network
+{
+public:
+    Policy(const int state_dim, const int action_dim, const int hidden, const double learning_rate, std::mt19937& engine)
+        : Network(learning_rate)
     {
-        return (x < 0) ? 0 : 1;
+        add<Linear>(state_dim, hidden, engine);
+        add<ReLu>();
+        add<Linear>(hidden, hidden, engine);
+        add<ReLu>();
+        add<Linear>(hidden, action_dim, engine, 1e-2);
+        add<Sigmoid>();
     }
-    template <int n>
-    Eigen::Matrix<double, n, 1> ReLu(const Eigen::Matrix<double, n, 1>& x)
+};
+
+// 方策の出力 [0, 1] を行動 [-action_scale, action_scale] に変換する
+template <class Derived>
+auto scaleAction(const Eigen::MatrixBase<Derived>& y, const double action_scale)
+{
+    return (action_scale * (2.0 * y.array() - 1.0)).matrix();
+}
+
+struct Config {
+    int hidden = 64;                  // 隠れ層の幅
+    double actor_learning_rate = 1e-4;
+    double critic_learning_rate = 1e-3;
+    double gamma = 0.99;              // 割引率
+    double tau = 0.005;               // ターゲットネットワークの追従率
+    double action_scale = 50.0;       // 行動 (トルク) の最大値
+    double noise = 0.1;               // 探索ノイズの標準偏差 (action_scale との比)
+    double reward_scale = 1e-3;       // 報酬に掛ける係数 (転倒の罰が大きいので小さくする)
+    unsigned seed = 0;
+};
+
+class Agent
+{
+    int state_dim;
+    int action_dim;
+    Config config;
+
+    std::mt19937 engine;
+
+    Policy actor;
+    Q critic;
+    Policy actor_target;
+    Q critic_target;
+
+    // 作業用の行列 (バッチサイズが変わらない限り再確保しない)
+    Eigen::MatrixXd action;
+    Eigen::MatrixXd critic_input;
+    Eigen::MatrixXd target;
+    Eigen::MatrixXd td_error;
+    Eigen::MatrixXd grad_q;
+    Eigen::MatrixXd grad_action;
+
+public:
+    Agent(const int state_dim, const int action_dim, const Config& config = Config{})
+        : state_dim(state_dim), action_dim(action_dim), config(config),
+          engine(config.seed),
+          actor(state_dim, action_dim, config.hidden, config.actor_learning_rate, engine),
+          critic(state_dim, action_dim, config.hidden, config.critic_learning_rate, engine),
+          actor_target(actor), critic_target(critic)
     {
-        Eigen::Matrix<double, n, 1> y;
-        for (int i = 0; i < n; ++i) {
-            y(i, 0) = ReLu(x(i, 0));
-        }
-        return y;
     }
-    template <int n>
-    Eigen::Matrix<double, n, 1> dReLu(const Eigen::Matrix<double, n, 1>& x)
+
+    /* @param: state 状態次元×バッチ
+     * @return: 行動次元×バッチの決定的な行動
+     */
+    const Eigen::MatrixXd& act(const Eigen::MatrixXd& state)
     {
-        Eigen::Matrix<double, n, 1> y;
-        for (int i = 0; i < n; ++i) {
-            y(i, 0) = dReLu(x(i, 0));
-        }
-        return y;
+        action = scaleAction(actor.forward(state), config.action_scale);
+        return action;
     }
 
+    const Policy& policy() const { return actor; }
+    const Config& getConfig() const { return config; }
+
+    /* @return: 直前の update での TD 誤差 (1×バッチ，優先度の更新用)
+     */
+    const Eigen::MatrixXd& tdError() const { return td_error; }
 
-    std::array<double, 2> predict(std::array<double, 2> state, int action_ankle, int action_knee)
+    /* @description: ミニバッチ1つ分 critic と actor を更新し，ターゲットネットワークを追従させる
+     * critic の損失は batch.weight で重み付けする
+     * @return: critic の重み付き二乗誤差
+     */
+    double update(const Batch& batch)
     {
-        Eigen::Vector4d x{state.at(0), state.at(1), action_ankle, action_knee};
+        const int n = static_cast<int>(batch.state.cols());
+
+        // critic のターゲット y = r + gamma * (1 - done) * Q'(s', mu'(s'))
+        critic_input.resize(state_dim + action_dim, n);
+        critic_input.topRows(state_dim) = batch.next_state;
+        critic_input.bottomRows(action_dim) = scaleAction(actor_target.forward(batch.next_state), config.action_scale);
+        target = config.reward_scale * batch.reward
+                 + config.gamma * (1.0 - batch.done.array()).matrix().cwiseProduct(critic_target.forward(critic_input));
+
+        // critic: 二乗誤差を最小化
+        critic_input.topRows(state_dim) = batch.state;
+        critic_input.bottomRows(action_dim) = batch.action;
+        const Eigen::MatrixXd& q = critic.forward(critic_input);
+        td_error = q - target;
+        grad_q = (2.0 / n) * td_error.cwiseProduct(batch.weight);
+        const double loss = td_error.cwiseAbs2().cwiseProduct(batch.weight).sum() / n;
+        critic.backward(grad_q);
+        critic.update();
 
-        Eigen::Matrix<double, 16, 1> y1 = ReLu(weight_1 * x);
-        Eigen::Matrix<double, 64, 1> y2 = ReLu(weight_2 * y1);
-        Eigen::Matrix<double, 64, 1> y3 = ReLu(weight_3 * y2);
-        Eigen::Matrix<double, 1, 1> y4 = ReLu(weight_4 * y3);
+        // actor: Q(s, mu(s)) の平均を最大化
+        critic_input.bottomRows(action_dim) = scaleAction(actor.forward(batch.state), config.action_scale);
+        critic.forward(critic_input);
+        grad_q.setConstant(1, n, -1.0 / n);
+        const Eigen::MatrixXd& grad_input = critic.backward(grad_q);
+        grad_action = (2.0 * config.action_scale) * grad_input.bottomRows(action_dim);
+        actor.backward(grad_action);
+        actor.update();
+
+        actor_target.softUpdate(actor, config.tau);
+        critic_target.softUpdate(critic, config.tau);
+
+        return loss;
     }
 };
 
-class J
+/* @description: 方策の写しを持って探索行動を作る
+ * 学習スレッドと別のスレッドで環境を動かすときに使い，sync で方策を更新する
+ */
+class Explorer
 {
-};
+    Policy actor;
+    double action_scale;
+    double sigma;
 
-class Agent
-{
-private:
-    double gamma = 0.8;     // 割引率
-    double epsilon = 0.99;  // 乱択率
+    std::mt19937 engine;
+    std::normal_distribution<double> normal{0.0, 1.0};
+
+    Eigen::MatrixXd action;
 
 public:
-    Agent(const double gamma, const double epsilon)
-        : gamma(gamma), epsilon(epsilon)
+    Explorer(const Agent& agent, const unsigned seed)
+        : actor(agent.policy()),
+          action_scale(agent.getConfig().action_scale),
+          sigma(agent.getConfig().noise * agent.getConfig().action_scale),
+          engine(seed)
+    {
+    }
+
+    void sync(const Policy& policy)
+    {
+        actor.softUpdate(policy, 1.0);
+    }
+
+    /* @description: 方策の行動に正規分布の探索ノイズを加え，範囲内に切り詰める
+     * @param: state 状態次元×バッチ
+     * @return: 行動次元×バッチ
+     */
+    const Eigen::MatrixXd& explore(const Eigen::MatrixXd& state)
     {
+        action = scaleAction(actor.forward(state), action_scale);
+        action = action.unaryExpr([&](double a) {
+            const double noisy = a + sigma * normal(engine);
+            return std::max(-action_scale, std::min(action_scale, noisy));
+        });
+        return action;
     }
-    ~Agent() = default;
 };
 
-}  // namespace DQN
+}  // namespace DDPG
@@ -1,23 +1,148 @@
 #pragma once
 
+#include "activation.hpp"
+#include "optimizer.hpp"
+
 #include <Eigen/Core>
 
+#include <cmath>
+#include <memory>
+#include <random>
+
+/* ミニバッチは全て 特徴量×バッチ の行列で扱う (1列が1サンプル)．
+ * 各層は出力と入力勾配を自分のメンバに持ち，バッチサイズが変わらない限り
+ * forward/backward の中でメモリ確保を行わない
+ */
 class Layer
 {
+public:
+    virtual ~Layer() = default;
+
+    /* @param: x 特徴量×バッチの入力
+     * @return: 特徴量×バッチの出力 (次に forward を呼ぶまで有効)
+     */
+    virtual const Eigen::MatrixXd& forward(const Eigen::MatrixXd& x) = 0;
+
+    /* @description: 直前の forward について誤差逆伝播し，パラメータの勾配を貯める
+     * @param: grad 損失の出力に関する勾配
+     * @return: 損失の入力に関する勾配
+     */
+    virtual const Eigen::MatrixXd& backward(const Eigen::MatrixXd& grad) = 0;
+
+    /* @description: 貯めた勾配でパラメータを更新する
+     */
+    virtual void update(const Adam& /* optimizer */) {}
+
+    /* @description: パラメータを source に近づける (param <- tau * source + (1 - tau) * param)
+     */
+    virtual void softUpdate(const Layer& /* source */, double /* tau */) {}
+
+    virtual std::unique_ptr<Layer> clone() const = 0;
 };
 
 class Linear : public Layer
 {
-};
+    Eigen::MatrixXd weight;  // 出力×入力
+    Eigen::MatrixXd bias;    // 出力×1
 
-class ReLu : public Layer
-{
+    Eigen::MatrixXd grad_weight;
+    Eigen::MatrixXd grad_bias;
+    AdamState weight_state;
+    AdamState bias_state;
+
+    const Eigen::MatrixXd* input = nullptr;
+    Eigen::MatrixXd output;
+    Eigen::MatrixXd grad_input;
+
+public:
+    /* @description: 重みを一様分布 U(-1/sqrt(n_in), 1/sqrt(n_in)) で初期化する
+     * @param: scale 初期値の幅に掛ける係数 (出力層を小さく始めたいとき用)
+     */
+    Linear(const int n_in, const int n_out, std::mt19937& engine, const double scale = 1.0)
+        : weight(n_out, n_in), bias(n_out, 1)
+    {
+        std::uniform_real_distribution<double> dist(-scale / std::sqrt(n_in), scale / std::sqrt(n_in));
+        weight = weight.unaryExpr([&](double) { return dist(engine); });
+        bias = bias.unaryExpr([&](double) { return dist(engine); });
+    }
+
+    const Eigen::MatrixXd& forward(const Eigen::MatrixXd& x) override
+    {
+        input = &x;
+        output.noalias() = weight * x;
+        output.colwise() += bias.col(0);
+        return output;
+    }
+
+    const Eigen::MatrixXd& backward(const Eigen::MatrixXd& grad) override
+    {
+        grad_weight.noalias() = grad * input->transpose();
+        grad_bias = grad.rowwise().sum();
+        grad_input.noalias() = weight.transpose() * grad;
+        return grad_input;
+    }
+
+    void update(const Adam& optimizer) override
+    {
+        optimizer.update(weight, grad_weight, weight_state);
+        optimizer.update(bias, grad_bias, bias_state);
+    }
+
+    void softUpdate(const Layer& source, double tau) override
+    {
+        const Linear& src = static_cast<const Linear&>(source);
+        weight = tau * src.weight + (1.0 - tau) * weight;
+        bias = tau * src.bias + (1.0 - tau) * bias;
+    }
+
+    std::unique_ptr<Layer> clone() const override
+    {
+        return std::unique_ptr<Layer>(new Linear(*this));
+    }
 };
 
-class Sigmoid : public Layer
+/* @description: 要素ごとの活性化関数の層
+ */
+template <class Activation>
+class ActivationLayer : public Layer
 {
+    Eigen::MatrixXd output;
+    Eigen::MatrixXd grad_input;
+
+public:
+    const Eigen::MatrixXd& forward(const Eigen::MatrixXd& x) override
+    {
+        output.resize(x.rows(), x.cols());
+        output.array() = Activation::f(x.array());
+        return output;
+    }
+
+    const Eigen::MatrixXd& backward(const Eigen::MatrixXd& grad) override
+    {
+        grad_input.resize(grad.rows(), grad.cols());
+        grad_input.array() = grad.array() * Activation::df(output.array());
+        return grad_input;
+    }
+
+    std::unique_ptr<Layer> clone() const override
+    {
+        return std::unique_ptr<Layer>(new ActivationLayer(*this));
+    }
 };
 
+using ReLu = ActivationLayer<activation::ReLu>;
+using Sigmoid = ActivationLayer<activation::Sigmoid>;
+
+/* @description: 入力をそのまま返す層
+ */
 class Input : public Layer
 {
+public:
+    const Eigen::MatrixXd& forward(const Eigen::MatrixXd& x) override { return x; }
+    const Eigen::MatrixXd& backward(const Eigen::MatrixXd& grad) override { return grad; }
+
+    std::unique_ptr<Layer> clone() const override
+    {
+        return std::unique_ptr<Layer>(new Input(*this));
+    }
 };
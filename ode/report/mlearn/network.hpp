@@ -0,0 +1,85 @@
+#pragma once
+
+#include "layer.hpp"
+#include "optimizer.hpp"
+
+#include <Eigen/Core>
+
+#include <memory>
+#include <utility>
+#include <vector>
+
+/* @description: 層を直列につないだネットワーク
+ */
+class Network
+{
+    std::vector<std::unique_ptr<Layer>> layers;
+    Adam optimizer;
+
+public:
+    explicit Network(const double learning_rate = 1e-3)
+        : optimizer(learning_rate)
+    {
+    }
+
+    Network(const Network& other)
+        : optimizer(other.optimizer)
+    {
+        layers.reserve(other.layers.size());
+        for (const auto& layer : other.layers) {
+            layers.push_back(layer->clone());
+        }
+    }
+
+    Network& operator=(const Network&) = delete;
+
+    template <class L, class... Args>
+    Network& add(Args&&... args)
+    {
+        layers.emplace_back(new L(std::forward<Args>(args)...));
+        return *this;
+    }
+
+    /* @param: x 特徴量×バッチの入力
+     * @return: 特徴量×バッチの出力
+     */
+    const Eigen::MatrixXd& forward(const Eigen::MatrixXd& x)
+    {
+        const Eigen::MatrixXd* y = &x;
+        for (auto& layer : layers) {
+            y = &layer->forward(*y);
+        }
+        return *y;
+    }
+
+    /* @param: grad 損失の出力に関する勾配
+     * @return: 損失の入力に関する勾配
+     */
+    const Eigen::MatrixXd& backward(const Eigen::MatrixXd& grad)
+    {
+        const Eigen::MatrixXd* g = &grad;
+        for (auto it = layers.rbegin(); it != layers.rend(); ++it) {
+            g = &(*it)->backward(*g);
+        }
+        return *g;
+    }
+
+    /* @description: 直前の backward で求めた勾配で全層を更新する
+     */
+    void update()
+    {
+        optimizer.step();
+        for (auto& layer : layers) {
+            layer->update(optimizer);
+        }
+    }
+
+    /* @description: ターゲットネットワーク用に source へ少しずつ近づける
+     */
+    void softUpdate(const Network& source, const double tau)
+    {
+        for (size_t i = 0; i < layers.size(); i++) {
+            layers[i]->softUpdate(*source.layers[i], tau);
+        }
+    }
+};
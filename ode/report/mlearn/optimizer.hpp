@@ -0,0 +1,57 @@
+#pragma once
+
+#include <Eigen/Core>
+
+#include <cmath>
+
+/* @description: Adam のパラメータごとの状態 (1次と2次のモーメント)
+ */
+struct AdamState {
+    Eigen::MatrixXd m;
+    Eigen::MatrixXd v;
+};
+
+class Adam
+{
+    double learning_rate;
+    double beta1;
+    double beta2;
+    double epsilon;
+    long t = 0;  // 更新回数
+
+    double correction1 = 1.0;  // 1 - beta1^t
+    double correction2 = 1.0;  // 1 - beta2^t
+
+public:
+    explicit Adam(const double learning_rate = 1e-3,
+        const double beta1 = 0.9, const double beta2 = 0.999, const double epsilon = 1e-8)
+        : learning_rate(learning_rate), beta1(beta1), beta2(beta2), epsilon(epsilon)
+    {
+    }
+
+    /* @description: 1回分の更新を始める (バイアス補正の係数を進める)
+     */
+    void step()
+    {
+        t++;
+        correction1 = 1.0 - std::pow(beta1, t);
+        correction2 = 1.0 - std::pow(beta2, t);
+    }
+
+    /* @description: パラメータを勾配方向に1回更新する
+     * @param: param 更新するパラメータ
+     * @param: grad 損失のパラメータに関する勾配
+     * @param: state param に対応するモーメント
+     */
+    void update(Eigen::MatrixXd& param, const Eigen::MatrixXd& grad, AdamState& state) const
+    {
+        if (state.m.rows() != param.rows() || state.m.cols() != param.cols()) {
+            state.m.setZero(param.rows(), param.cols());
+            state.v.setZero(param.rows(), param.cols());
+        }
+        state.m = beta1 * state.m + (1.0 - beta1) * grad;
+        state.v.array() = beta2 * state.v.array() + (1.0 - beta2) * grad.array().square();
+        param.array() -= (learning_rate / correction1) * state.m.array()
+                         / ((state.v.array() / correction2).sqrt() + epsilon);
+    }
+};
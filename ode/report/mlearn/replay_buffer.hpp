@@ -0,0 +1,255 @@
+#pragma once
+
+#include <Eigen/Core>
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+#include <memory>
+#include <random>
+#include <thread>
+#include <vector>
+
+/* @description: 学習に使うミニバッチ (1列が1サンプル)
+ */
+struct Batch {
+    Eigen::MatrixXd state;       // 状態次元×バッチ
+    Eigen::MatrixXd action;      // 行動次元×バッチ
+    Eigen::RowVectorXd reward;   // 1×バッチ
+    Eigen::MatrixXd next_state;  // 状態次元×バッチ
+    Eigen::RowVectorXd done;     // 1×バッチ (終了なら 1)
+    Eigen::RowVectorXd weight;   // 1×バッチ 重要度重み (一様サンプルなら全て 1)
+    std::vector<int> index;      // サンプルした位置 (優先度の更新用)
+
+    void resize(const int state_dim, const int action_dim, const int size)
+    {
+        state.resize(state_dim, size);
+        action.resize(action_dim, size);
+        reward.resize(size);
+        next_state.resize(state_dim, size);
+        done.resize(size);
+        weight.setOnes(size);
+        index.resize(size);
+    }
+};
+
+/* @description: 優先度の和を保持する二分木 (葉が各スロット)
+ * 学習スレッドだけが触る
+ */
+class SumTree
+{
+    int leaves;
+    std::vector<double> node;  // node[1] が根，node[leaves + i] が i 番目の葉
+
+public:
+    explicit SumTree(const int capacity)
+        : leaves(1)
+    {
+        while (leaves < capacity) {
+            leaves *= 2;
+        }
+        node.assign(2 * leaves, 0.0);
+    }
+
+    double total() const { return node[1]; }
+    double get(const int i) const { return node[leaves + i]; }
+
+    void set(int i, const double value)
+    {
+        i += leaves;
+        const double delta = value - node[i];
+        for (; i >= 1; i /= 2) {
+            node[i] += delta;
+        }
+    }
+
+    /* @return: 累積和が u を超える最初の葉
+     */
+    int find(double u) const
+    {
+        int i = 1;
+        while (i < leaves) {
+            if (u < node[2 * i]) {
+                i = 2 * i;
+            } else {
+                u -= node[2 * i];
+                i = 2 * i + 1;
+            }
+        }
+        return i - leaves;
+    }
+};
+
+/* @description: 固定長の経験リプレイ (状態，行動，報酬，次状態，終了の SoA 配列)
+ *
+ * push は複数のシミュレーションスレッドから同時に呼んでよく，mutex を使わない．
+ * 書き込み位置は atomic なチケットで決め，各スロットの sequence を
+ *   2t + 1 : チケット t の書き込み中
+ *   2t + 2 : チケット t の書き込み完了
+ * とする seqlock で公開する．同じスロットのチケットは一周前 (t - capacity) の
+ * 書き込み完了を待ってから書くので，スロットの sequence は必ず増えていく．サンプル側は読む前後で sequence が同じ偶数で
+ * あることを確かめ，書き込みと重なったサンプルは引き直す．
+ *
+ * sample / samplePrioritized / updatePriorities は学習スレッド1つから呼ぶ．
+ * 優先度の木は学習スレッドだけが持ち，新しく公開されたスロットは
+ * サンプル時にまとめて最大優先度で取り込む．
+ */
+class ReplayBuffer
+{
+    const int capacity;
+    const int state_dim;
+    const int action_dim;
+
+    std::vector<double> state;       // state_dim × capacity
+    std::vector<double> action;      // action_dim × capacity
+    std::vector<double> reward;      // capacity
+    std::vector<double> next_state;  // state_dim × capacity
+    std::vector<double> done;        // capacity
+
+    std::unique_ptr<std::atomic<std::uint64_t>[]> sequence;
+    std::atomic<std::uint64_t> ticket{0};
+
+    // 以下は学習スレッドのみ
+    SumTree tree;
+    std::uint64_t absorbed = 0;  // 優先度の木に取り込んだチケット数
+    double max_priority = 1.0;
+    double alpha;
+
+    // スロットの書き込み権を取る
+    // 一周前のチケットの書き込み完了を待つので，一周先のチケットに追い越されない
+    void lock(const int slot, const std::uint64_t t)
+    {
+        const std::uint64_t cap = static_cast<std::uint64_t>(capacity);
+        const std::uint64_t previous = t < cap ? 0 : 2 * (t - cap) + 2;
+        while (sequence[slot].load(std::memory_order_acquire) != previous) {
+            std::this_thread::yield();
+        }
+        // 書き込み中の印をデータより先に読み手へ見せる
+        sequence[slot].store(2 * t + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+    }
+
+    // スロット k を読み出し，書き込みと重ならなかったら true
+    bool read(const int k, Batch& batch, const int j) const
+    {
+        const std::uint64_t before = sequence[k].load(std::memory_order_acquire);
+        if (before == 0 || before % 2 == 1) {
+            return false;
+        }
+        batch.state.col(j) = Eigen::Map<const Eigen::VectorXd>(&state[k * state_dim], state_dim);
+        batch.action.col(j) = Eigen::Map<const Eigen::VectorXd>(&action[k * action_dim], action_dim);
+        batch.reward(j) = reward[k];
+        batch.next_state.col(j) = Eigen::Map<const Eigen::VectorXd>(&next_state[k * state_dim], state_dim);
+        batch.done(j) = done[k];
+        batch.index[j] = k;
+        std::atomic_thread_fence(std::memory_order_acquire);
+        return sequence[k].load(std::memory_order_relaxed) == before;
+    }
+
+    // 公開済みの新しいスロットを最大優先度で木に取り込む
+    void absorb()
+    {
+        const std::uint64_t end = ticket.load(std::memory_order_acquire);
+        if (end - absorbed > static_cast<std::uint64_t>(capacity)) {
+            absorbed = end - capacity;
+        }
+        const double p = std::pow(max_priority, alpha);
+        for (; absorbed < end; absorbed++) {
+            const int slot = static_cast<int>(absorbed % capacity);
+            if (sequence[slot].load(std::memory_order_acquire) < 2 * absorbed + 2) {
+                break;  // まだ書き込み中
+            }
+            tree.set(slot, p);
+        }
+    }
+
+public:
+    /* @param: alpha 優先度の強さ (0 なら一様)
+     */
+    ReplayBuffer(const int capacity, const int state_dim, const int action_dim, const double alpha = 0.6)
+        : capacity(capacity), state_dim(state_dim), action_dim(action_dim),
+          state(static_cast<size_t>(state_dim) * capacity), action(static_cast<size_t>(action_dim) * capacity),
+          reward(capacity), next_state(static_cast<size_t>(state_dim) * capacity), done(capacity),
+          sequence(new std::atomic<std::uint64_t>[capacity]),
+          tree(capacity), alpha(alpha)
+    {
+        for (int i = 0; i < capacity; i++) {
+            sequence[i].store(0, std::memory_order_relaxed);
+        }
+    }
+
+    /* @return: 保存されている経験の数 (書き込み中のものを含む)
+     */
+    int size() const
+    {
+        return static_cast<int>(std::min<std::uint64_t>(ticket.load(std::memory_order_relaxed), capacity));
+    }
+
+    /* @description: 経験を1つ追加する (複数スレッドから同時に呼んでよい)
+     */
+    void push(const double* s, const double* a, const double r, const double* s_next, const double d)
+    {
+        const std::uint64_t t = ticket.fetch_add(1, std::memory_order_relaxed);
+        const int slot = static_cast<int>(t % capacity);
+
+        lock(slot, t);
+        std::copy(s, s + state_dim, &state[slot * state_dim]);
+        std::copy(a, a + action_dim, &action[slot * action_dim]);
+        reward[slot] = r;
+        std::copy(s_next, s_next + state_dim, &next_state[slot * state_dim]);
+        done[slot] = d;
+        sequence[slot].store(2 * t + 2, std::memory_order_release);
+    }
+
+    /* @description: 一様にサンプルする．batch は resize 済みであること
+     */
+    void sample(Batch& batch, std::mt19937& engine) const
+    {
+        std::uniform_int_distribution<int> dist(0, size() - 1);
+        for (int j = 0; j < batch.state.cols(); j++) {
+            while (!read(dist(engine), batch, j)) {
+            }
+            batch.weight(j) = 1.0;
+        }
+    }
+
+    /* @description: 優先度に比例してサンプルし，重要度重みを batch.weight に入れる
+     * @param: beta 重要度重みの補正の強さ (1 で完全に補正)
+     */
+    void samplePrioritized(Batch& batch, std::mt19937& engine, const double beta)
+    {
+        absorb();
+
+        const int n = static_cast<int>(batch.state.cols());
+        const double total = tree.total();
+        const double segment = total / n;
+        const int count = size();
+        std::uniform_real_distribution<double> dist(0.0, 1.0);
+
+        double max_weight = 0.0;
+        for (int j = 0; j < n; j++) {
+            // 区間ごとに1つずつ引く (層化サンプリング)
+            int k = tree.find(std::min((j + dist(engine)) * segment, std::nextafter(total, 0.0)));
+            while (!read(k, batch, j)) {
+                k = tree.find(dist(engine) * total);
+            }
+            const double probability = tree.get(k) / total;
+            batch.weight(j) = std::pow(count * probability, -beta);
+            max_weight = std::max(max_weight, batch.weight(j));
+        }
+        batch.weight /= max_weight;
+    }
+
+    /* @description: サンプルした経験の優先度を TD 誤差で更新する
+     */
+    void updatePriorities(const std::vector<int>& index, const Eigen::MatrixXd& td_error)
+    {
+        constexpr double EPSILON = 1e-6;
+        for (size_t j = 0; j < index.size(); j++) {
+            const double priority = std::abs(td_error(j)) + EPSILON;
+            max_priority = std::max(max_priority, priority);
+            tree.set(index[j], std::pow(priority, alpha));
+        }
+    }
+};
@@ -0,0 +1,71 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+/* @description: 固定長のロックフリーキュー (複数の生産者，1つの消費者)
+ * 各セルの sequence で空き/使用中を表す (Vyukov の有界キュー)．
+ * 満杯のとき push は待たずに false を返す
+ */
+template <class T>
+class MpscQueue
+{
+    struct Cell {
+        std::atomic<std::size_t> sequence;
+        T data;
+    };
+
+    const std::size_t mask;
+    std::unique_ptr<Cell[]> cells;
+
+    alignas(64) std::atomic<std::size_t> enqueue_pos{0};
+    alignas(64) std::size_t dequeue_pos = 0;  // 消費者のみ
+
+public:
+    /* @param: capacity_log2 容量の2を底とする対数
+     */
+    explicit MpscQueue(const int capacity_log2)
+        : mask((std::size_t(1) << capacity_log2) - 1), cells(new Cell[mask + 1])
+    {
+        for (std::size_t i = 0; i <= mask; i++) {
+            cells[i].sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    bool push(const T& value)
+    {
+        std::size_t pos = enqueue_pos.load(std::memory_order_relaxed);
+        Cell* cell;
+        for (;;) {
+            cell = &cells[pos & mask];
+            const std::size_t seq = cell->sequence.load(std::memory_order_acquire);
+            const std::intptr_t diff = static_cast<std::intptr_t>(seq) - static_cast<std::intptr_t>(pos);
+            if (diff == 0) {
+                if (enqueue_pos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    break;
+                }
+            } else if (diff < 0) {
+                return false;  // 満杯
+            } else {
+                pos = enqueue_pos.load(std::memory_order_relaxed);
+            }
+        }
+        cell->data = value;
+        cell->sequence.store(pos + 1, std::memory_order_release);
+        return true;
+    }
+
+    bool pop(T& value)
+    {
+        Cell* cell = &cells[dequeue_pos & mask];
+        if (cell->sequence.load(std::memory_order_acquire) != dequeue_pos + 1) {
+            return false;  // 空，または書き込み中
+        }
+        value = cell->data;
+        cell->sequence.store(dequeue_pos + mask + 1, std::memory_order_release);
+        dequeue_pos++;
+        return true;
+    }
+};
@@ -22,11 +22,8 @@ public:
     {
     }
 
-    ~ObjectBase()
-    {
-        dBodyDestroy(body_id);
-        dGeomDestroy(geom_id);
-    }
+    // ボディとジオメトリはワールドとスペースの破棄時に破棄される
+    ~ObjectBase() {}
 
     virtual void draw() = 0;
 
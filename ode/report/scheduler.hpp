@@ -0,0 +1,76 @@
+#pragma once
+
+#include "simulation.hpp"
+
+#include <algorithm>
+
+/* @description: 物理，制御，描画をそれぞれ固定の周期で進めるスケジューラ
+ * 経過時間は物理のステップ数 (整数) で数えるので，周期が割り切れなくても
+ * どの実行でも同じ順序で呼ばれる
+ */
+class Scheduler
+{
+    Timing timing;
+    long ticks = 0;     // 物理を進めた回数
+    long controls = 0;  // 制御を呼んだ回数
+    long frames = 0;    // 描画したフレーム数
+
+    // 次の制御の時刻 controls / control_hz に達しているか
+    bool controlDue() const
+    {
+        return controls * timing.physics_hz <= ticks * timing.control_hz;
+    }
+
+public:
+    explicit Scheduler(const Timing& timing)
+        : timing(timing)
+    {
+        // 制御は物理より速くしても意味がないので物理に合わせる
+        this->timing.control_hz = std::min(timing.control_hz, timing.physics_hz);
+    }
+
+    dReal physicsStep() const { return dReal(1) / timing.physics_hz; }
+    dReal controlStep() const { return dReal(1) / timing.control_hz; }
+
+    /* @return: 物理の経過時間
+     */
+    double time() const { return static_cast<double>(ticks) / timing.physics_hz; }
+
+    long controlCount() const { return controls; }
+
+    /* @description: 物理を1ステップ進める．制御の時刻に達していれば先に control() を呼ぶ
+     * @param: control 制御 (引数なし)
+     * @param: physics 物理 (引数は時間幅)
+     */
+    template <class Control, class Physics>
+    void tick(Control&& control, Physics&& physics)
+    {
+        if (controlDue()) {
+            control();
+            controls++;
+        }
+        physics(physicsStep());
+        ticks++;
+    }
+
+    /* @description: 制御1回分 (次の制御の時刻まで) 進める
+     */
+    template <class Control, class Physics>
+    void controlPeriod(Control&& control, Physics&& physics)
+    {
+        do {
+            tick(control, physics);
+        } while (!controlDue());
+    }
+
+    /* @description: 描画1フレーム分 (1 / render_hz) 進める
+     */
+    template <class Control, class Physics>
+    void frame(Control&& control, Physics&& physics)
+    {
+        frames++;
+        while (ticks * timing.render_hz < frames * timing.physics_hz) {
+            tick(control, physics);
+        }
+    }
+};
@@ -1,97 +1,68 @@
 #include <drawstuff/drawstuff.h>  // 描画用ヘッダーファイル
 #include <ode/ode.h>              // ODE用ヘッダーファイル
 
-#include "joint.hpp"
-#include "object.hpp"
+#include "environment.hpp"
+#include "scheduler.hpp"
 #include "simulation.hpp"
+#include "sweep.hpp"
+#include "telemetry.hpp"
+#include "train.hpp"
 
-#include <Eigen/Core>
-
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <string>
 
 namespace Simulation
 {
 
-dWorldID world;              // 動力学計算用ワールド
-dSpaceID space;              // 衝突検出用スペース
-dGeomID ground;              // 地面
-dJointGroupID contactgroup;  // コンタクトグループ
-
-int STEPS = 0;  // シミュレーションのステップ数
-
+Timing timing;                         // 物理，制御，描画の更新頻度
+std::unique_ptr<Telemetry> telemetry;  // 各ステップの記録先 (--telemetry=<file> のとき)
 
-Capsule leg{
-    3, 5.0, 0.2, 0.5,
-    Color{1.0, 0.0, 0.0}};
-Capsule thigh{
-    3, 3.0, 0.2, 0.5,
-    Color{0.0, 0.0, 1.0}};
-Box foot{
-    7.0, Eigen::Vector3d{0.8, 0.7, 0.2},
-    Color{0.0, 1.0, 0.0}};
-Sphere head{
-    2.0, 0.4,
-    Color{1.0, 1.0, 0.0}};
+// 描画ありの実行で使う環境と制御器
+std::unique_ptr<Environment> env;
+std::unique_ptr<Scheduler> scheduler;
+Params params;
+ControllerState memory;
+std::array<dReal, 2> input{};  // 次の制御までかけ続けるトルク
 
-Hinge ankle;
-Hinge knee;
-FixedJoint neck;
+int STEPS = 0;  // 制御のステップ数
 
 
-void near_callback(void* data, dGeomID o1, dGeomID o2)
+void record(Telemetry* telemetry, std::uint32_t rollout_id, int step, double t,
+    const std::array<dReal, 2>& state, const std::array<dReal, 2>& input)
 {
-    constexpr int N = 3;  // 接触点数
-    dContact contact[N];
-
-    // 地面との衝突かどうか
-    int isGround = (ground == o1 || ground == o2);
-
-    // 2つのボディがジョイントで結合されていたら衝突検出しない
-    dBodyID b1 = dGeomGetBody(o1);
-    dBodyID b2 = dGeomGetBody(o2);
-    if (b1 && b2 && dAreConnectedExcluding(b1, b2, dJointTypeContact)) {
-        return;
-    }
-
-    int n = dCollide(o1, o2, N, &contact[0].geom, sizeof(dContact));
-
-    for (int i = 0; i < n; i++) {
-        contact[i].surface.mode = dContactBounce | dContactSoftERP | dContactSoftCFM;
-        contact[i].surface.soft_erp = 0.2;         // 接触点のERP
-        contact[i].surface.soft_cfm = 0.001;       // 接触点のCFM
-        contact[i].surface.mu = 0.7;               // 摩擦係数
-        contact[i].surface.mode = dContactBounce;  // 接触面の反発性を設定
-        contact[i].surface.bounce = 0.6;           // 反発係数
-        contact[i].surface.bounce_vel = 0.0;       // 反発最低速度
-        dJointID c = dJointCreateContact(world, contactgroup, &contact[i]);
-        dJointAttach(c, dGeomGetBody(contact[i].geom.g1), dGeomGetBody(contact[i].geom.g2));
+    if (telemetry) {
+        telemetry->push(TelemetryRecord{
+            rollout_id, static_cast<std::uint32_t>(step), static_cast<float>(t),
+            static_cast<float>(state[0]), static_cast<float>(state[1]),
+            static_cast<float>(input[0]), static_cast<float>(input[1])});
     }
 }
 
 void control()
 {
-    std::array<dReal, 2> torque_input
-        = user_callback(std::array<dReal, 2>{
-            dJointGetHingeAngle(ankle.getID()),
-            dJointGetHingeAngle(knee.getID())});
+    const double t = memory.t;
+    const std::array<dReal, 2> state = env->getState();
+    input = user_callback(params, memory, state);
+    record(telemetry.get(), 0, STEPS, t, state, input);
+    STEPS++;
+}
 
-    dJointAddHingeTorque(ankle.getID(), torque_input[0]);
-    dJointAddHingeTorque(knee.getID(), torque_input[1]);
+void physics(dReal dt)
+{
+    env->applyInput(input);
+    env->step(dt);
 }
 
 void step_callback(int pause)
 {
     if (!pause) {
-        STEPS++;
-        control();
-        dSpaceCollide(space, 0, &near_callback);
-        dWorldStep(world, 0.05);
-        dJointGroupEmpty(contactgroup);
+        scheduler->frame(&control, &physics);
     }
 
-    leg.draw();
-    thigh.draw();
-    foot.draw();
-    head.draw();
+    env->draw();
 }
 
 void restart();
@@ -144,8 +115,6 @@ void start()
 
 void initialize(int argc, char* argv[])
 {
-    dInitODE();
-
     // callback for drawstuff
     dsFunctions drawstuff;
     drawstuff.version = DS_VERSION;
@@ -154,64 +123,188 @@ void initialize(int argc, char* argv[])
     drawstuff.command = &command_callback;
     drawstuff.path_to_textures = DRAWSTUFF_TEXTURE_PATH;
 
-    world = dWorldCreate();
-    space = dHashSpaceCreate(0);
-    contactgroup = dJointGroupCreate(0);
-
-    foot.init(world, space, Eigen::Vector3d{0.2, 0.0, 0.15});
-    leg.init(world, space, Eigen::Vector3d{0.0, 0.0, 0.6});
-    thigh.init(world, space, Eigen::Vector3d{0.0, 0.0, 1.55});
-    head.init(world, space, Eigen::Vector3d{0.0, 0.0, 2.4});
-
-    ankle.init(world,
-        leg.getBody(), foot.getBody(),
-        Eigen::Vector3d{0.2, 0.0, 0.2},
-        Eigen::Matrix<int, 3, 1>{0, 1, 0});
-
-    knee.init(world,
-        thigh.getBody(), leg.getBody(),
-        Eigen::Vector3d{0.0, 0.0, 1.1},
-        Eigen::Matrix<int, 3, 1>{0, 1, 0});
-
-    neck.init(world, head.getBody(), thigh.getBody());
-
-    ankle.setParam(dParamLoStop, -0.7 * M_PI);
-    ankle.setParam(dParamHiStop, 0.7 * M_PI);
-    knee.setParam(dParamLoStop, -0.7 * M_PI);
-    knee.setParam(dParamHiStop, 0.7 * M_PI);
-
-
-    dWorldSetGravity(world, 0, 0, -9.81);
-    dWorldSetERP(world, 0.9);   // ERPの設定
-    dWorldSetCFM(world, 1e-4);  // CFMの設定
-
-    ground = dCreatePlane(space, 0, 0, 1, 0);
+    env.reset(new Environment(timing));
+    scheduler.reset(new Scheduler(timing));
+    memory.dt = scheduler->controlStep();
     dsSimulationLoop(argc, argv, 1280, 720, &drawstuff);
 }
 
 void destruct()
 {
-    dSpaceDestroy(space);
-    dWorldDestroy(world);
-    dCloseODE();
+    scheduler.reset();
+    env.reset();
 }
 
 void restart()
 {
     STEPS = 0;  // ステップ数の初期化
 
-    destruct();
+    env->reset();
+    scheduler.reset(new Scheduler(timing));
+    memory = ControllerState{};
+    memory.dt = scheduler->controlStep();
+    input = std::array<dReal, 2>{};
+}
+
+Trajectory rollout(const Params& params, int n_steps, const Timing& timing,
+    Telemetry* telemetry, std::uint32_t rollout_id)
+{
+    Environment environment(timing);
+    Scheduler scheduler(timing);
+
+    Trajectory trajectory;
+    trajectory.state.reserve(n_steps);
+    trajectory.input.reserve(n_steps);
+
+    ControllerState memory;
+    memory.dt = scheduler.controlStep();
+    for (int i = 0; i < n_steps; i++) {
+        const double t = memory.t;
+        std::array<dReal, 2> state;
+        std::array<dReal, 2> input;
+        scheduler.controlPeriod(
+            [&] {
+                state = environment.getState();
+                input = user_callback(params, memory, state);
+            },
+            [&](dReal dt) {
+                environment.applyInput(input);
+                environment.step(dt);
+            });
+        record(telemetry, rollout_id, i, t, state, input);
+
+        trajectory.state.push_back(state);
+        trajectory.input.push_back(input);
+        trajectory.cost += user_cost(state, input, t) * memory.dt;
+
+        if (environment.headHeight() < FALL_HEIGHT) {
+            trajectory.fallen = true;
+            trajectory.cost += FALL_PENALTY * (n_steps - i - 1) * memory.dt;
+            break;
+        }
+    }
+
+    return trajectory;
 }
 
 }  // namespace Simulation
 
+static void printResult(const Params& params, const Trajectory& trajectory)
+{
+    std::printf("%g %g %g %g cost = %g steps = %zu%s\n",
+        params.kp_0, params.kv_0, params.kp_1, params.kv_1,
+        trajectory.cost, trajectory.state.size(), trajectory.fallen ? " (fallen)" : "");
+}
+
+// argv から name で始まる引数を取り除き，name より後ろを value に入れる
+static bool takeOption(int& argc, char* argv[], const std::string& name, std::string& value)
+{
+    for (int i = 1; i < argc; i++) {
+        const std::string arg = argv[i];
+        if (arg.compare(0, name.size(), name) == 0) {
+            value = arg.substr(name.size());
+            std::copy(argv + i + 1, argv + argc, argv + i);
+            argc--;
+            return true;
+        }
+    }
+    return false;
+}
+
+// 使い方:
+//   report                                  描画ありで param.txt の先頭行のゲインを使う
+//   report --headless [n_steps]             描画なしで param.txt の全行のゲインを順に評価する
+//   report --sweep [n_steps] [n_threads]    描画なしで param.txt の全行のゲインを並列に評価する
+//   report --train [n_iterations] [n_envs] [n_threads]  DDPG で方策を学習する
+// どのモードでも次のオプションを付けられる
+//   --telemetry=<file>              各ステップを <file> に記録する (中身は telemetry_dump で読める)
+//   --rates=<物理>,<制御>,<描画>    それぞれの更新頻度 [Hz] (既定は 20,20,20)
+//   --quickstep                     物理に dWorldQuickStep を使う
+//   --warmstart                     dWorldQuickStep をウォームスタートする (--quickstep を含む)
+//   --articulated                   dWorldStep で関節の木を線形時間で解く (接触は LCP のまま)
+//   --autostep                      物理に dWorldAutoStep を使う (ロボットは dWorldStep，接触だけの島は dWorldQuickStep)
 int main(int argc, char* argv[])
 {
-    loadParams();
+    dInitODE();
 
-    Simulation::initialize(argc, argv);
-    Simulation::destruct();
+    std::string value;
+    if (takeOption(argc, argv, "--telemetry=", value)) {
+        Simulation::telemetry.reset(new Telemetry(value));
+        if (!Simulation::telemetry->isOpen()) {
+            std::fprintf(stderr, "cannot open %s\n", value.c_str());
+            return 1;
+        }
+    }
+    if (takeOption(argc, argv, "--rates=", value)) {
+        Timing& timing = Simulation::timing;
+        if (std::sscanf(value.c_str(), "%d,%d,%d", &timing.physics_hz, &timing.control_hz, &timing.render_hz) != 3
+            || timing.physics_hz <= 0 || timing.control_hz <= 0 || timing.render_hz <= 0) {
+            std::fprintf(stderr, "invalid rates : %s\n", value.c_str());
+            return 1;
+        }
+    }
+    if (takeOption(argc, argv, "--quickstep", value)) {
+        Simulation::timing.quickstep = true;
+    }
+    if (takeOption(argc, argv, "--warmstart", value)) {
+        Simulation::timing.quickstep = true;
+        Simulation::timing.warm_start = true;
+    }
+    if (takeOption(argc, argv, "--articulated", value)) {
+        Simulation::timing.articulated = true;
+    }
+    if (takeOption(argc, argv, "--autostep", value)) {
+        Simulation::timing.autostep = true;
+    }
 
+    const std::string mode = (argc >= 2) ? argv[1] : "";
+    const int n_steps = (argc >= 3) ? std::atoi(argv[2]) : 200;
+
+    if (mode == "--headless") {
+        std::uint32_t id = 0;
+        for (const Params& params : loadParamSets("param.txt")) {
+            printResult(params, Simulation::rollout(params, n_steps, Simulation::timing, Simulation::telemetry.get(), id++));
+        }
+    } else if (mode == "--sweep") {
+        const int n_threads = (argc >= 4) ? std::atoi(argv[3]) : 0;
+        const std::vector<Params> params_list = loadParamSets("param.txt");
+
+        ThreadPool pool(n_threads);
+        const std::vector<Trajectory> results = Simulation::sweep(pool, params_list, n_steps, Simulation::timing, Simulation::telemetry.get());
+
+        size_t best = 0;
+        for (size_t i = 0; i < results.size(); i++) {
+            printResult(params_list[i], results[i]);
+            if (results[i].cost < results[best].cost) {
+                best = i;
+            }
+        }
+        if (!results.empty()) {
+            std::printf("best : ");
+            printResult(params_list[best], results[best]);
+        }
+    } else if (mode == "--train") {
+        const int n_iterations = (argc >= 3) ? std::atoi(argv[2]) : 10000;
+        const int n_envs = (argc >= 4) ? std::atoi(argv[3]) : 16;
+        const int n_threads = (argc >= 5) ? std::atoi(argv[4]) : 0;
+
+        ThreadPool pool(n_threads);
+        Simulation::train(pool, n_envs, n_iterations, Simulation::timing);
+    } else {
+        Simulation::params = loadParams();
+
+        Simulation::initialize(argc, argv);
+        Simulation::destruct();
+    }
 
+    if (Simulation::telemetry) {
+        const std::uint64_t dropped = Simulation::telemetry->dropped();
+        Simulation::telemetry.reset();
+        if (dropped) {
+            std::fprintf(stderr, "telemetry : %llu records dropped\n", static_cast<unsigned long long>(dropped));
+        }
+    }
+
+    dCloseODE();
     return 0;
 }
@@ -1,6 +1,9 @@
 #pragma once
 
 #include <array>
+#include <cstdint>
+#include <string>
+#include <vector>
 
 #ifdef dDOUBLE
 #define dsDrawBox dsDrawBoxD
@@ -10,10 +13,90 @@
 #endif
 
 
+/* @description: 制御ゲイン (param.txt の1行に相当)
+ */
+struct Params {
+    double kp_0 = 0.0, kv_0 = 0.0;  // 足首
+    double kp_1 = 0.0, kv_1 = 0.0;  // 膝
+};
+
+/* @description: 物理，制御，描画の更新頻度 [Hz]
+ * 既定値は全て 20 Hz (dWorldStep を 0.05 秒ずつ) で，物理と制御を分けない
+ */
+struct Timing {
+    int physics_hz = 20;     // 物理の更新頻度
+    int control_hz = 20;     // 制御の更新頻度
+    int render_hz = 20;      // 描画の頻度 (1フレームで 1 / render_hz 秒進める)
+    bool quickstep = false;  // 物理に dWorldQuickStep を使う
+    bool warm_start = false; // dWorldQuickStep を前ステップの拘束力から始める
+    bool articulated = false; // dWorldStep で関節の木 (足首，膝，首) を線形時間で解く
+    bool autostep = false;   // 物理に dWorldAutoStep を使う (島ごとに dWorldStep と dWorldQuickStep を選ぶ)
+};
+
+/* @description: 制御器の内部状態 (時刻と前ステップの関節角)
+ */
+struct ControllerState {
+    double t = 0.0;
+    double dt = 0.05;  // 制御周期
+    std::array<dReal, 2> prev_state{};
+    bool initialized = false;
+};
+
+/* @description: 1回のロールアウトの結果
+ */
+struct Trajectory {
+    std::vector<std::array<dReal, 2>> state;  // 各ステップの足首と膝の角度
+    std::vector<std::array<dReal, 2>> input;  // 各ステップのトルク入力
+    double cost = 0.0;                        // 評価関数の積算値
+    bool fallen = false;                      // 転倒したかどうか
+};
+
+
 /* @description: ユーザーのコントロール関数
+ * @param: params 制御ゲイン
+ * @param: memory 制御器の内部状態 (ロールアウトごとに用意する)
  * @param: state 足首と膝の角度
  * @return: 足首と膝のトルク入力
  */
-std::array<dReal, 2> user_callback(const std::array<dReal, 2>& state);
+std::array<dReal, 2> user_callback(
+    const Params& params, ControllerState& memory,
+    const std::array<dReal, 2>& state);
+
+/* @description: ユーザーの評価関数 (1ステップ分のコスト)
+ * @param: state 足首と膝の角度
+ * @param: input 足首と膝のトルク入力
+ * @param: t 時刻
+ * @return: コスト
+ */
+double user_cost(const std::array<dReal, 2>& state, const std::array<dReal, 2>& input, double t);
+
+/* @description: param.txt の先頭行のゲインを読み込む (描画ありの実行用)
+ */
+Params loadParams();
+
+/* @description: パラメータファイルからゲインの組を全て読み込む
+ * @param: filename 1行に kp_0 kv_0 kp_1 kv_1 を並べたファイル
+ */
+std::vector<Params> loadParamSets(const std::string& filename);
+
+
+class Telemetry;
+
+namespace Simulation
+{
+
+constexpr dReal FALL_HEIGHT = 1.0;    // 頭がこの高さを下回ったら転倒とみなす
+constexpr double FALL_PENALTY = 1e3;  // 転倒後の残り時間 1 秒あたりに課すコスト
+
+/* @description: 描画なしでシミュレーションを回す
+ * @param: params 制御ゲイン
+ * @param: n_steps 制御のステップ数
+ * @param: timing 物理と制御の更新頻度
+ * @param: telemetry 各ステップを記録する先 (nullptr なら記録しない)
+ * @param: rollout_id 記録に付けるロールアウトの番号
+ * @return: 関節角とトルクの履歴，コスト
+ */
+Trajectory rollout(const Params& params, int n_steps, const Timing& timing = Timing{},
+    Telemetry* telemetry = nullptr, std::uint32_t rollout_id = 0);
 
-void loadParams();
+}  // namespace Simulation
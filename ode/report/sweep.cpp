@@ -0,0 +1,22 @@
+#include <ode/ode.h>  // ODE用ヘッダーファイル
+
+#include "sweep.hpp"
+
+
+namespace Simulation
+{
+
+std::vector<Trajectory> sweep(ThreadPool& pool, const std::vector<Params>& params_list, int n_steps,
+    const Timing& timing, Telemetry* telemetry)
+{
+    std::vector<Trajectory> results(params_list.size());
+
+    // 各タスクが自分の Environment を持つのでロック不要
+    pool.parallelFor(static_cast<int>(params_list.size()), [&](int i) {
+        results[i] = rollout(params_list[i], n_steps, timing, telemetry, i);
+    });
+
+    return results;
+}
+
+}  // namespace Simulation
@@ -0,0 +1,22 @@
+#pragma once
+
+#include "simulation.hpp"
+#include "thread_pool.hpp"
+
+#include <vector>
+
+namespace Simulation
+{
+
+/* @description: ゲインの組ごとに独立した環境を作り，スレッドプールで並列にロールアウトする
+ * @param: pool ロールアウトを回すスレッドプール
+ * @param: params_list 評価するゲインの組
+ * @param: n_steps 1回のロールアウトの制御のステップ数
+ * @param: timing 物理と制御の更新頻度
+ * @param: telemetry 各ステップを記録する先 (nullptr なら記録しない，番号は params_list の添字)
+ * @return: params_list と同じ順の結果
+ */
+std::vector<Trajectory> sweep(ThreadPool& pool, const std::vector<Params>& params_list, int n_steps,
+    const Timing& timing = Timing{}, Telemetry* telemetry = nullptr);
+
+}  // namespace Simulation
@@ -0,0 +1,167 @@
+#include "telemetry.hpp"
+
+#include <chrono>
+#include <cstring>
+
+
+namespace
+{
+
+constexpr char MAGIC[4] = {'R', 'T', 'L', 'M'};
+constexpr std::uint32_t VERSION = 1;
+
+constexpr std::uint8_t TYPE_UINT32 = 0;
+constexpr std::uint8_t TYPE_FLOAT32 = 1;
+
+struct Column {
+    std::uint8_t type;
+    const char* name;
+};
+
+constexpr Column COLUMNS[] = {
+    {TYPE_UINT32, "rollout"},
+    {TYPE_UINT32, "step"},
+    {TYPE_FLOAT32, "t"},
+    {TYPE_FLOAT32, "ankle"},
+    {TYPE_FLOAT32, "knee"},
+    {TYPE_FLOAT32, "ankle_torque"},
+    {TYPE_FLOAT32, "knee_torque"},
+};
+constexpr std::uint32_t N_COLUMNS = sizeof(COLUMNS) / sizeof(COLUMNS[0]);
+constexpr int NAME_LENGTH = 15;
+
+static_assert(sizeof(float) == sizeof(std::uint32_t), "every column must be 4 bytes");
+
+// 記録の c 列目へのポインタ (どの列も4バイト)
+void* field(TelemetryRecord& record, const std::uint32_t c)
+{
+    void* fields[N_COLUMNS] = {
+        &record.rollout, &record.step, &record.t,
+        &record.ankle, &record.knee, &record.ankle_torque, &record.knee_torque};
+    return fields[c];
+}
+
+}  // namespace
+
+
+Telemetry::Telemetry(const std::string& filename)
+    : file(std::fopen(filename.c_str(), "wb"))
+{
+    block.reserve(BLOCK_SIZE);
+    column.reserve(BLOCK_SIZE);
+    if (file) {
+        writeHeader();
+        writer = std::thread(&Telemetry::work, this);
+    }
+}
+
+Telemetry::~Telemetry()
+{
+    if (file) {
+        stop.store(true, std::memory_order_release);
+        writer.join();
+        std::fclose(file);
+    }
+}
+
+void Telemetry::writeHeader()
+{
+    std::fwrite(MAGIC, 1, sizeof(MAGIC), file);
+    std::fwrite(&VERSION, sizeof(VERSION), 1, file);
+    std::fwrite(&N_COLUMNS, sizeof(N_COLUMNS), 1, file);
+    for (const Column& column : COLUMNS) {
+        char name[NAME_LENGTH] = {};
+        std::strncpy(name, column.name, NAME_LENGTH - 1);
+        std::fwrite(&column.type, sizeof(column.type), 1, file);
+        std::fwrite(name, 1, NAME_LENGTH, file);
+    }
+}
+
+void Telemetry::writeBlock()
+{
+    if (block.empty()) {
+        return;
+    }
+
+    const std::uint32_t n = static_cast<std::uint32_t>(block.size());
+    std::fwrite(&n, sizeof(n), 1, file);
+
+    column.resize(n);
+    for (std::uint32_t c = 0; c < N_COLUMNS; c++) {
+        for (std::uint32_t r = 0; r < n; r++) {
+            std::memcpy(&column[r], field(block[r], c), sizeof(std::uint32_t));
+        }
+        std::fwrite(column.data(), sizeof(std::uint32_t), n, file);
+    }
+    block.clear();
+}
+
+void Telemetry::work()
+{
+    TelemetryRecord record;
+    for (;;) {
+        // stop を見てから取り出すことで，止める前に積まれた記録を取りこぼさない
+        const bool stopping = stop.load(std::memory_order_acquire);
+
+        bool popped = false;
+        while (queue.pop(record)) {
+            popped = true;
+            block.push_back(record);
+            if (block.size() == static_cast<size_t>(BLOCK_SIZE)) {
+                writeBlock();
+            }
+        }
+
+        if (stopping) {
+            break;
+        }
+        if (!popped) {
+            writeBlock();
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+    }
+    writeBlock();
+    std::fflush(file);
+}
+
+bool readTelemetry(const std::string& filename, const std::function<void(const TelemetryRecord&)>& callback)
+{
+    std::FILE* file = std::fopen(filename.c_str(), "rb");
+    if (!file) {
+        return false;
+    }
+
+    char magic[4];
+    std::uint32_t version, n_columns;
+    bool ok = std::fread(magic, 1, sizeof(magic), file) == sizeof(magic)
+              && std::memcmp(magic, MAGIC, sizeof(MAGIC)) == 0
+              && std::fread(&version, sizeof(version), 1, file) == 1 && version == VERSION
+              && std::fread(&n_columns, sizeof(n_columns), 1, file) == 1 && n_columns == N_COLUMNS;
+    for (std::uint32_t c = 0; ok && c < n_columns; c++) {
+        std::uint8_t type;
+        char name[NAME_LENGTH];
+        ok = std::fread(&type, sizeof(type), 1, file) == 1
+             && std::fread(name, 1, NAME_LENGTH, file) == NAME_LENGTH
+             && type == COLUMNS[c].type;
+    }
+
+    std::vector<TelemetryRecord> block;
+    std::vector<std::uint32_t> values;
+    std::uint32_t n;
+    while (ok && std::fread(&n, sizeof(n), 1, file) == 1) {
+        block.resize(n);
+        values.resize(n);
+        for (std::uint32_t c = 0; ok && c < n_columns; c++) {
+            ok = std::fread(values.data(), sizeof(std::uint32_t), n, file) == n;
+            for (std::uint32_t r = 0; ok && r < n; r++) {
+                std::memcpy(field(block[r], c), &values[r], sizeof(std::uint32_t));
+            }
+        }
+        for (std::uint32_t r = 0; ok && r < n; r++) {
+            callback(block[r]);
+        }
+    }
+
+    std::fclose(file);
+    return ok;
+}
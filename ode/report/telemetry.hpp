@@ -0,0 +1,79 @@
+#pragma once
+
+#include "mpsc_queue.hpp"
+
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <functional>
+#include <string>
+#include <thread>
+#include <vector>
+
+/* @description: 1ステップ分の記録
+ */
+struct TelemetryRecord {
+    std::uint32_t rollout;  // ロールアウトの番号
+    std::uint32_t step;     // ステップ数
+    float t;                // 時刻
+    float ankle;            // 足首の角度
+    float knee;             // 膝の角度
+    float ankle_torque;     // 足首のトルク入力
+    float knee_torque;      // 膝のトルク入力
+};
+
+/* @description: 記録をバックグラウンドのスレッドで列指向のバイナリファイルに書き出す
+ *
+ * push はロックフリーのキューに積むだけで，ファイル入出力は待たない．
+ * キューが満杯のときは記録を捨てて dropped() に数える．
+ *
+ * ファイル形式 (リトルエンディアン):
+ *   ヘッダ   "RTLM", uint32 版数, uint32 列数, 列ごとに { uint8 型 (0: uint32, 1: float32), char[15] 列名 }
+ *   ブロック uint32 行数 n, 続けて列ごとに n 個の値
+ */
+class Telemetry
+{
+    static constexpr int QUEUE_LOG2 = 16;    // キューの容量 (2^16 件)
+    static constexpr int BLOCK_SIZE = 4096;  // 1ブロックの最大行数
+
+    MpscQueue<TelemetryRecord> queue{QUEUE_LOG2};
+    std::FILE* file;
+    std::thread writer;
+    std::atomic<bool> stop{false};
+    std::atomic<std::uint64_t> n_dropped{0};
+
+    std::vector<TelemetryRecord> block;  // 書き出し待ちの行
+    std::vector<std::uint32_t> column;   // 書き出し用の1列分
+
+    void writeHeader();
+    void writeBlock();
+    void work();
+
+public:
+    explicit Telemetry(const std::string& filename);
+    ~Telemetry();
+
+    Telemetry(const Telemetry&) = delete;
+    Telemetry& operator=(const Telemetry&) = delete;
+
+    bool isOpen() const { return file != nullptr; }
+
+    /* @description: 記録を1つ積む (複数スレッドから同時に呼んでよい)
+     * @return: キューが満杯で捨てたら false
+     */
+    bool push(const TelemetryRecord& record)
+    {
+        if (!queue.push(record)) {
+            n_dropped.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+        return true;
+    }
+
+    std::uint64_t dropped() const { return n_dropped.load(std::memory_order_relaxed); }
+};
+
+/* @description: Telemetry が書いたファイルを読み，1行ずつ callback に渡す
+ * @return: 形式が正しく最後まで読めたら true
+ */
+bool readTelemetry(const std::string& filename, const std::function<void(const TelemetryRecord&)>& callback);
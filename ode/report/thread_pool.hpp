@@ -0,0 +1,132 @@
+#pragma once
+
+#include <ode/ode.h>
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/* @description: 固定数のワーカースレッドで parallelFor を処理するスレッドプール
+ * 各ワーカーは起動時に ODE のスレッドローカルデータを確保するので，
+ * ワーカーごとに別々のワールドを動かしてよい
+ */
+class ThreadPool
+{
+    std::vector<std::thread> workers;
+
+    std::mutex mutex;
+    std::condition_variable start_cv;
+    std::condition_variable done_cv;
+
+    const std::function<void(int)>* job = nullptr;  // 実行中の仕事
+    int job_size = 0;                               // 仕事の添字の数
+    std::atomic<int> next_index{0};                 // 次に取る添字
+    unsigned generation = 0;                        // parallelFor を呼んだ回数
+    int running = 0;                                // 仕事中のワーカー数
+    bool stop = false;
+
+    void runJob(const std::function<void(int)>& fn, int n)
+    {
+        for (int i = next_index.fetch_add(1); i < n; i = next_index.fetch_add(1)) {
+            fn(i);
+        }
+    }
+
+    void work()
+    {
+        dAllocateODEDataForThread(dAllocateMaskAll);
+
+        unsigned seen = 0;
+        for (;;) {
+            const std::function<void(int)>* fn;
+            int n;
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                start_cv.wait(lock, [&] { return stop || generation != seen; });
+                if (stop) {
+                    break;
+                }
+                seen = generation;
+                if (next_index.load() >= job_size) {
+                    continue;  // 起きる前に呼び出し元が全て片付けた
+                }
+                fn = job;
+                n = job_size;
+                running++;
+            }
+
+            runJob(*fn, n);
+
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                if (--running == 0) {
+                    done_cv.notify_all();
+                }
+            }
+        }
+
+        dCleanupODEAllDataForThread();
+    }
+
+public:
+    /* @param: n_threads 呼び出し元を含めたスレッド数 (0 ならコア数)
+     */
+    explicit ThreadPool(int n_threads = 0)
+    {
+        if (n_threads <= 0) {
+            n_threads = std::max(1u, std::thread::hardware_concurrency());
+        }
+        for (int i = 1; i < n_threads; i++) {
+            workers.emplace_back(&ThreadPool::work, this);
+        }
+    }
+
+    ~ThreadPool()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stop = true;
+        }
+        start_cv.notify_all();
+        for (std::thread& worker : workers) {
+            worker.join();
+        }
+    }
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    int size() const { return static_cast<int>(workers.size()) + 1; }
+
+    /* @description: i = 0, ..., n - 1 について fn(i) を並列に呼び，全て終わるまで待つ
+     * 呼び出し元のスレッドも仕事に加わる
+     */
+    void parallelFor(int n, const std::function<void(int)>& fn)
+    {
+        if (workers.empty() || n <= 1) {
+            for (int i = 0; i < n; i++) {
+                fn(i);
+            }
+            return;
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            job = &fn;
+            job_size = n;
+            next_index.store(0);
+            generation++;
+        }
+        start_cv.notify_all();
+
+        runJob(fn, n);
+
+        // 全ワーカーが添字を取り終えて抜けるのを待つ
+        std::unique_lock<std::mutex> lock(mutex);
+        done_cv.wait(lock, [&] { return running == 0 && next_index.load() >= n; });
+    }
+};
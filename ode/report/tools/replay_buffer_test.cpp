@@ -0,0 +1,163 @@
+#include "../mlearn/replay_buffer.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <map>
+#include <random>
+#include <thread>
+#include <vector>
+
+// 使い方: replay_buffer_test
+// 複数スレッドから ReplayBuffer::push を同時に呼び，破れたサンプルが出ないことと，
+// 最後に残る経験が各スレッドの最後の push の連続した並びになっていること
+// (一周先のチケットが一周前の書き込みに上書きされていないこと) を確かめる
+namespace
+{
+constexpr int CAPACITY = 4;  // 小さくして一周先の書き込みと頻繁に重ならせる
+constexpr int WRITERS = 8;
+constexpr int PUSHES = 2000;  // スレッド・ラウンドごと
+constexpr int ROUNDS = 50;
+constexpr int S = 3;
+constexpr int A = 2;
+constexpr int BATCH = 256;
+
+// 経験 id から全ての値を決める (読み出し時に破れを検出できる)
+void makeExperience(const double id, double* s, double* a, double* s_next)
+{
+    for (int i = 0; i < S; i++) {
+        s[i] = id + i;
+        s_next[i] = -id - i;
+    }
+    for (int i = 0; i < A; i++) {
+        a[i] = 2.0 * id + i;
+    }
+}
+
+// バッチの各列が1つの経験から来ていれば true
+bool consistent(const Batch& batch)
+{
+    for (int j = 0; j < batch.state.cols(); j++) {
+        const double id = batch.reward(j);
+        double s[S], a[A], s_next[S];
+        makeExperience(id, s, a, s_next);
+        for (int i = 0; i < S; i++) {
+            if (batch.state(i, j) != s[i] || batch.next_state(i, j) != s_next[i]) {
+                return false;
+            }
+        }
+        for (int i = 0; i < A; i++) {
+            if (batch.action(i, j) != a[i]) {
+                return false;
+            }
+        }
+        if (batch.done(j) != static_cast<double>(static_cast<long long>(id) % 2)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// 1ラウンド: 空のバッファへ WRITERS スレッドから同時に push して中身を確かめる
+bool runRound(const int round)
+{
+    ReplayBuffer memory(CAPACITY, S, A);
+    std::atomic<bool> writing{true};
+    std::atomic<int> torn{0};
+
+    std::vector<std::thread> writers;
+    for (int w = 0; w < WRITERS; w++) {
+        writers.emplace_back([&memory, w] {
+            double s[S], a[A], s_next[S];
+            for (int n = 0; n < PUSHES; n++) {
+                const int id = w * PUSHES + n;
+                makeExperience(id, s, a, s_next);
+                memory.push(s, a, id, s_next, id % 2);
+            }
+        });
+    }
+
+    // 書き込みと並行して一様サンプルし，破れたサンプルが返らないことを見る
+    std::thread reader([&] {
+        std::mt19937 engine(round);
+        Batch batch;
+        batch.resize(S, A, 8);
+        while (writing.load(std::memory_order_relaxed)) {
+            if (memory.size() < CAPACITY) {
+                std::this_thread::yield();
+                continue;
+            }
+            memory.sample(batch, engine);
+            if (!consistent(batch)) {
+                torn.fetch_add(1, std::memory_order_relaxed);
+            }
+        }
+    });
+
+    for (auto& writer : writers) {
+        writer.join();
+    }
+    writing.store(false, std::memory_order_relaxed);
+    reader.join();
+
+    if (torn.load() != 0) {
+        std::fprintf(stderr, "round %d: torn samples during concurrent push: %d\n", round, torn.load());
+        return false;
+    }
+
+    // 全ての push が終わった後の中身を一様サンプルで集める
+    std::mt19937 engine(round);
+    Batch batch;
+    batch.resize(S, A, BATCH);
+    std::map<int, int> contents;  // スロット → 経験 id
+    for (int k = 0; k < 16 && static_cast<int>(contents.size()) < CAPACITY; k++) {
+        memory.sample(batch, engine);
+        if (!consistent(batch)) {
+            std::fprintf(stderr, "round %d: torn sample after push\n", round);
+            return false;
+        }
+        for (int j = 0; j < BATCH; j++) {
+            contents[batch.index[j]] = static_cast<int>(batch.reward(j));
+        }
+    }
+    if (static_cast<int>(contents.size()) != CAPACITY) {
+        std::fprintf(stderr, "round %d: only %d of %d slots were sampled\n", round, static_cast<int>(contents.size()), CAPACITY);
+        return false;
+    }
+
+    // 残っているのは最後の CAPACITY 枚のチケットなので，
+    // スレッドごとに見ると最後の push から切れ目なく並んでいるはず
+    std::vector<int> kept(WRITERS, 0);
+    std::vector<int> oldest(WRITERS, PUSHES);
+    for (const auto& entry : contents) {
+        const int w = entry.second / PUSHES;
+        kept[w]++;
+        oldest[w] = std::min(oldest[w], entry.second % PUSHES);
+    }
+    for (int w = 0; w < WRITERS; w++) {
+        if (kept[w] != 0 && oldest[w] != PUSHES - kept[w]) {
+            std::fprintf(stderr, "round %d: writer %d kept %d experiences but the oldest is push %d (overwritten by a lapped writer)\n",
+                round, w, kept[w], oldest[w]);
+            return false;
+        }
+    }
+
+    // 優先度付きサンプルも公開済みのスロットだけを返す
+    memory.samplePrioritized(batch, engine, 0.4);
+    if (!consistent(batch)) {
+        std::fprintf(stderr, "round %d: torn prioritized sample\n", round);
+        return false;
+    }
+    return true;
+}
+}  // namespace
+
+int main()
+{
+    for (int round = 0; round < ROUNDS; round++) {
+        if (!runRound(round)) {
+            return 1;
+        }
+    }
+    std::printf("ok: %d rounds of %d pushes from %d threads\n", ROUNDS, WRITERS * PUSHES, WRITERS);
+    return 0;
+}
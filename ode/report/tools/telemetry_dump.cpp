@@ -0,0 +1,25 @@
+#include "../telemetry.hpp"
+
+#include <cstdio>
+
+// 使い方: telemetry_dump <file>
+// report --telemetry=<file> で記録したファイルを CSV で標準出力に書き出す
+int main(int argc, char* argv[])
+{
+    if (argc < 2) {
+        std::fprintf(stderr, "usage: %s <file>\n", argv[0]);
+        return 1;
+    }
+
+    std::printf("rollout,step,t,ankle,knee,ankle_torque,knee_torque\n");
+    const bool ok = readTelemetry(argv[1], [](const TelemetryRecord& r) {
+        std::printf("%u,%u,%g,%g,%g,%g,%g\n",
+            r.rollout, r.step, r.t, r.ankle, r.knee, r.ankle_torque, r.knee_torque);
+    });
+
+    if (!ok) {
+        std::fprintf(stderr, "%s : broken or not a telemetry file\n", argv[1]);
+        return 1;
+    }
+    return 0;
+}
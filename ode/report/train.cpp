@@ -0,0 +1,157 @@
+#include <drawstuff/drawstuff.h>  // 描画用ヘッダーファイル
+#include <ode/ode.h>              // ODE用ヘッダーファイル
+
+#include "mlearn/ddpg.hpp"
+#include "train.hpp"
+#include "vec_env.hpp"
+
+#include <Eigen/Core>
+
+#include <atomic>
+#include <cstdio>
+#include <mutex>
+#include <random>
+#include <thread>
+
+
+namespace
+{
+
+constexpr int CAPACITY = 100000;          // 経験の保存数
+constexpr int BATCH_SIZE = 128;           // ミニバッチの大きさ
+constexpr int WARMUP = 1000;              // 学習を始めるまでに貯める経験の数
+constexpr int UPDATES_PER_ITERATION = 1;  // VecEnv を1回進めるごとの学習回数の上限
+constexpr int MAX_LAG = 10;               // 学習が追いつくまで収集を先行させてよい回数
+constexpr int SYNC_INTERVAL = 50;         // 方策を収集側へ渡す間隔 (学習回数)
+constexpr int LOG_INTERVAL = 100;         // 途中経過を表示する間隔
+constexpr double ALPHA = 0.6;             // 優先度の強さ
+constexpr double BETA = 0.4;              // 重要度重みの補正の強さ (学習の終わりに 1 まで上げる)
+
+/* @description: 学習スレッドから収集スレッドへ方策を渡す箱
+ * 経験の受け渡しはロックを使わないが，重みの写しだけはここで mutex で守る
+ */
+struct PolicyMailbox {
+    std::mutex mutex;
+    DDPG::Policy policy;
+    std::atomic<unsigned> version{0};
+
+    explicit PolicyMailbox(const DDPG::Policy& policy)
+        : policy(policy)
+    {
+    }
+};
+
+}  // namespace
+
+
+namespace Simulation
+{
+
+void train(ThreadPool& pool, int n_envs, int n_iterations, const Timing& timing)
+{
+    constexpr int S = VecEnv::STATE_DIM;
+    constexpr int A = VecEnv::ACTION_DIM;
+
+    VecEnv env(n_envs, &pool, 200, timing);
+    DDPG::Agent agent(S, A);
+    DDPG::Explorer explorer(agent, 1);
+    ReplayBuffer memory(CAPACITY, S, A, ALPHA);
+    PolicyMailbox mailbox(agent.policy());
+
+    std::atomic<int> collected{0};
+    std::atomic<long> updates{0};
+    std::atomic<bool> finished{false};
+
+    // 収集スレッド: 方策の写しで VecEnv を進め，経験をリプレイに積む
+    std::thread collector([&] {
+        dAllocateODEDataForThread(dAllocateMaskAll);
+
+        // ネットワークは 特徴量×バッチ で扱うので VecEnv の N×次元 を転置して使う
+        Eigen::MatrixXd state = env.state().transpose().cast<double>();
+        Eigen::MatrixXd next_state(S, n_envs);
+        Eigen::MatrixXd action(A, n_envs);
+        VecEnv::ActionArray torque(n_envs, A);
+
+        Eigen::VectorXd episode_return = Eigen::VectorXd::Zero(n_envs);
+        double return_sum = 0.0;
+        int episodes = 0;
+        unsigned version = 0;
+
+        for (int it = 1; it <= n_iterations; it++) {
+            // 古い方策で経験を集めすぎないよう，学習が遅れたら待つ
+            while (memory.size() >= WARMUP
+                   && it - updates.load(std::memory_order_acquire) / UPDATES_PER_ITERATION > MAX_LAG + WARMUP / n_envs) {
+                std::this_thread::yield();
+            }
+
+            if (mailbox.version.load(std::memory_order_acquire) != version) {
+                std::lock_guard<std::mutex> lock(mailbox.mutex);
+                explorer.sync(mailbox.policy);
+                version = mailbox.version.load(std::memory_order_relaxed);
+            }
+
+            action = explorer.explore(state);
+            torque = action.transpose().cast<dReal>();
+            env.step(torque);
+            next_state = env.state().transpose().cast<double>();
+
+            for (int i = 0; i < n_envs; i++) {
+                memory.push(state.col(i).data(), action.col(i).data(),
+                    env.reward()(i), next_state.col(i).data(), env.done()(i));
+
+                episode_return(i) += env.reward()(i);
+                if (env.done()(i) != 0.0) {
+                    return_sum += episode_return(i);
+                    episodes++;
+                    episode_return(i) = 0.0;
+                }
+            }
+            state.swap(next_state);
+            collected.store(it, std::memory_order_release);
+
+            if (it % LOG_INTERVAL == 0) {
+                std::printf("iteration %d : return = %g (%d episodes)\n",
+                    it, episodes ? return_sum / episodes : 0.0, episodes);
+                return_sum = 0.0;
+                episodes = 0;
+            }
+        }
+
+        finished.store(true, std::memory_order_release);
+        dCleanupODEAllDataForThread();
+    });
+
+    // 学習スレッド (このスレッド): 経験の収集と並行してミニバッチで更新する
+    Batch batch;
+    batch.resize(S, A, BATCH_SIZE);
+    std::mt19937 engine(1);
+
+    double loss_sum = 0.0;
+    while (!finished.load(std::memory_order_acquire)) {
+        const int iterations = collected.load(std::memory_order_acquire);
+        if (memory.size() < WARMUP || updates.load(std::memory_order_relaxed) >= static_cast<long>(iterations) * UPDATES_PER_ITERATION) {
+            std::this_thread::yield();
+            continue;
+        }
+
+        const double beta = BETA + (1.0 - BETA) * iterations / n_iterations;
+        memory.samplePrioritized(batch, engine, beta);
+        loss_sum += agent.update(batch);
+        memory.updatePriorities(batch.index, agent.tdError());
+        const long n_updates = updates.fetch_add(1, std::memory_order_release) + 1;
+
+        if (n_updates % SYNC_INTERVAL == 0) {
+            std::lock_guard<std::mutex> lock(mailbox.mutex);
+            mailbox.policy.softUpdate(agent.policy(), 1.0);
+            mailbox.version.fetch_add(1, std::memory_order_release);
+        }
+        if (n_updates % LOG_INTERVAL == 0) {
+            std::printf("update %ld : critic loss = %g\n", n_updates, loss_sum / LOG_INTERVAL);
+            loss_sum = 0.0;
+        }
+    }
+
+    collector.join();
+}
+
+}  // namespace Simulation
@@ -0,0 +1,17 @@
+#pragma once
+
+#include "simulation.hpp"
+#include "thread_pool.hpp"
+
+namespace Simulation
+{
+
+/* @description: VecEnv 上で DDPG の方策を学習する
+ * @param: pool 環境を並列に進めるスレッドプール
+ * @param: n_envs 同時に動かす環境の数
+ * @param: n_iterations VecEnv を進める回数 (1回ごとにミニバッチ1つ分学習する)
+ * @param: timing 物理と制御の更新頻度
+ */
+void train(ThreadPool& pool, int n_envs, int n_iterations, const Timing& timing = Timing{});
+
+}  // namespace Simulation
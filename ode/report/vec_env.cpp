@@ -0,0 +1,87 @@
+#include <drawstuff/drawstuff.h>  // 描画用ヘッダーファイル
+#include <ode/ode.h>              // ODE用ヘッダーファイル
+
+#include "simulation.hpp"
+#include "vec_env.hpp"
+
+VecEnv::VecEnv(int n, ThreadPool* pool, int max_steps, const Timing& timing)
+    : pool(pool), max_steps(max_steps),
+      states(n, STATE_DIM), rewards(n), dones(n),
+      timing(timing), schedulers(n, Scheduler(timing))
+{
+    envs.reserve(n);
+    for (int i = 0; i < n; i++) {
+        envs.emplace_back(new Environment(timing));
+    }
+    step_job = [this](int i) { stepOne(i); };
+    reset();
+}
+
+void VecEnv::observe(int i)
+{
+    const std::array<dReal, 2> angle = envs[i]->getState();
+    const std::array<dReal, 2> rate = envs[i]->getRate();
+    states(i, 0) = angle[0];
+    states(i, 1) = angle[1];
+    states(i, 2) = rate[0];
+    states(i, 3) = rate[1];
+}
+
+const VecEnv::StateArray& VecEnv::reset()
+{
+    for (int i = 0; i < size(); i++) {
+        envs[i]->reset();
+        schedulers[i] = Scheduler(timing);
+        observe(i);
+    }
+    rewards.setZero();
+    dones.setZero();
+    return states;
+}
+
+void VecEnv::stepOne(int i)
+{
+    const int n = size();
+    const std::array<dReal, 2> input{torques[i], torques[n + i]};
+    const std::array<dReal, 2> angle{states(i, 0), states(i, 1)};
+
+    Environment& env = *envs[i];
+    Scheduler& scheduler = schedulers[i];
+    const double t = scheduler.time();
+    const dReal dt = scheduler.controlStep();
+    scheduler.controlPeriod(
+        [] {},
+        [&](dReal physics_dt) {
+            env.applyInput(input);
+            env.step(physics_dt);
+        });
+    const long steps = scheduler.controlCount();
+
+    rewards(i) = -user_cost(angle, input, t) * dt;
+
+    // 報酬の総和が rollout のコストの符号反転と一致するよう，転倒時は残りステップ分の罰を与える
+    const bool fallen = env.headHeight() < Simulation::FALL_HEIGHT;
+    if (fallen) {
+        rewards(i) -= Simulation::FALL_PENALTY * (max_steps - steps) * dt;
+    }
+    const bool done = fallen || steps >= max_steps;
+    dones(i) = done ? 1.0 : 0.0;
+    if (done) {
+        env.reset();
+        scheduler = Scheduler(timing);
+    }
+    observe(i);
+}
+
+void VecEnv::step(const dReal* torques)
+{
+    this->torques = torques;
+    if (pool) {
+        pool->parallelFor(size(), step_job);
+    } else {
+        for (int i = 0; i < size(); i++) {
+            stepOne(i);
+        }
+    }
+    this->torques = nullptr;
+}
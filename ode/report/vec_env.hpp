@@ -0,0 +1,71 @@
+#pragma once
+
+#include "environment.hpp"
+#include "scheduler.hpp"
+#include "thread_pool.hpp"
+
+#include <Eigen/Core>
+
+#include <functional>
+#include <memory>
+#include <vector>
+
+/* @description: N 体のロボットを同時に1ステップずつ進める環境
+ * 入出力は全て成分ごとに連続した配列 (SoA) で，列優先の N 行行列として持つ．
+ * 例えば state().col(0) は N 体分の足首角が並んだ連続領域になる．
+ * step() の中ではメモリ確保を行わない
+ */
+class VecEnv
+{
+public:
+    static constexpr int STATE_DIM = 4;   // 足首角，膝角，足首角速度，膝角速度
+    static constexpr int ACTION_DIM = 2;  // 足首トルク，膝トルク
+
+    using StateArray = Eigen::Matrix<dReal, Eigen::Dynamic, STATE_DIM>;
+    using ActionArray = Eigen::Matrix<dReal, Eigen::Dynamic, ACTION_DIM>;
+    using ScalarArray = Eigen::Matrix<dReal, Eigen::Dynamic, 1>;
+
+private:
+    std::vector<std::unique_ptr<Environment>> envs;
+    ThreadPool* pool;
+    int max_steps;
+
+    StateArray states;
+    ScalarArray rewards;
+    ScalarArray dones;  // 終了したら 1，そうでなければ 0
+
+    Timing timing;
+    std::vector<Scheduler> schedulers;
+
+    const dReal* torques = nullptr;  // step() 中の入力
+    std::function<void(int)> step_job;
+
+    void stepOne(int i);
+    void observe(int i);
+
+public:
+    /* @param: n 環境の数
+     * @param: pool 環境を並列に進めるスレッドプール (nullptr なら逐次)
+     * @param: max_steps 1エピソードの最大の制御ステップ数
+     * @param: timing 物理と制御の更新頻度 (1回の step で制御1周期分進める)
+     */
+    VecEnv(int n, ThreadPool* pool = nullptr, int max_steps = 200, const Timing& timing = Timing{});
+
+    int size() const { return static_cast<int>(envs.size()); }
+
+    /* @description: 全ての環境を初期姿勢に戻す
+     * @return: N×STATE_DIM の状態
+     */
+    const StateArray& reset();
+
+    /* @description: 全ての環境を1ステップ進める
+     * 終了した環境は自動で初期姿勢に戻し，state() には戻した後の状態が入る
+     * @param: torques N×2 のトルク入力 (列優先，足首トルク N 個の後に膝トルク N 個)
+     */
+    void step(const dReal* torques);
+    void step(const ActionArray& actions) { step(actions.data()); }
+
+    const StateArray& state() const { return states; }
+    const ScalarArray& reward() const { return rewards; }
+    const ScalarArray& done() const { return dones; }
+};
@@ -0,0 +1,153 @@
+/*************************************************************************
+ *                                                                       *
+ * Open Dynamics Engine, Copyright (C) 2001,2002 Russell L. Smith.       *
+ * All rights reserved.  Email: russ@q12.org   Web: www.q12.org          *
+ *                                                                       *
+ * This library is free software; you can redistribute it and/or         *
+ * modify it under the terms of EITHER:                                  *
+ *   (1) The GNU Lesser General Public License as published by the Free  *
+ *       Software Foundation; either version 2.1 of the License, or (at  *
+ *       your option) any later version. The text of the GNU Lesser      *
+ *       General Public License is included with this library in the     *
+ *       file LICENSE.TXT.                                               *
+ *   (2) The BSD-style license that is included with this library in     *
+ *       the file LICENSE-BSD.TXT.                                       *
+ *                                                                       *
+ * This library is distributed in the hope that it will be useful,       *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the files    *
+ * LICENSE.TXT and LICENSE-BSD.TXT for more details.                     *
+ *                                                                       *
+ *************************************************************************/
+
+#include <ode/common.h>
+#include "config.h"
+#include "body_state.h"
+#include "objects.h"
+#include "odemath.h"
+#include "threadingutils.h"
+
+
+void dxBodyStateStore::setCount (unsigned count)
+{
+    m_count = count;
+    m_bodies.setSize (count);
+    m_dirty.setSize (count);
+    m_dirtySlots.setSize (count);
+    m_pos.setSize (count * POS_STRIDE);
+    m_q.setSize (count * Q_STRIDE);
+    m_R.setSize (count * R_STRIDE);
+    m_lvel.setSize (count * VEL_STRIDE);
+    m_avel.setSize (count * VEL_STRIDE);
+    m_invMass.setSize (count);
+    m_I.setSize (count * INERTIA_STRIDE);
+    m_invI.setSize (count * INERTIA_STRIDE);
+}
+
+
+void dxBodyStateStore::add (dxBody *b)
+{
+    unsigned slot = m_count;
+    setCount (slot + 1);
+
+    m_bodies.data()[slot] = b;
+    m_dirty.data()[slot] = 0;
+    b->state_slot = slot;
+    load (b);
+}
+
+
+void dxBodyStateStore::remove (dxBody *b)
+{
+    unsigned slot = b->state_slot;
+    unsigned last = m_count - 1;
+    dIASSERT (slot <= last && m_bodies.data()[slot] == b);
+
+    // the slot is freed or reloaded below, and so is the last one.
+    dropDirty (slot);
+
+    if (slot != last) {
+        // the body is always up to date, so the moved one is just reloaded.
+        dropDirty (last);
+        dxBody *moved = m_bodies.data()[last];
+        m_bodies.data()[slot] = moved;
+        moved->state_slot = slot;
+        load (moved);
+    }
+
+    setCount (last);
+}
+
+
+void dxBodyStateStore::markDirty (dxBody *b)
+{
+    // bodies are marked from the island search and the moved callbacks of
+    // islands being stepped in parallel. the flag lets only the first mark
+    // of a slot append it, so the list never holds more than all the slots.
+    unsigned slot = b->state_slot;
+    if (ThrsafeExchange (m_dirty.data() + slot, 1) == 0) {
+        unsigned index = ThrsafeExchangeAdd (&m_dirtyCount, 1);
+        dIASSERT (index < m_count);
+        m_dirtySlots.data()[index] = slot;
+    }
+}
+
+
+void dxBodyStateStore::refresh()
+{
+    atomicord32 *dirty = m_dirty.data();
+    const unsigned *slots = m_dirtySlots.data();
+    dxBody *const *bodies = m_bodies.data();
+
+    for (unsigned i = 0, count = m_dirtyCount; i != count; i++) {
+        unsigned slot = slots[i];
+        dirty[slot] = 0;
+        load (bodies[slot]);
+    }
+    m_dirtyCount = 0;
+}
+
+
+void dxBodyStateStore::dropDirty (unsigned slot)
+{
+    atomicord32 *dirty = m_dirty.data();
+    if (dirty[slot] != 0) {
+        dirty[slot] = 0;
+
+        unsigned *slots = m_dirtySlots.data();
+        unsigned last = m_dirtyCount - 1;
+        for (unsigned i = 0; ; i++) {
+            dIASSERT (i <= last);
+            if (slots[i] == slot) {
+                slots[i] = slots[last];
+                break;
+            }
+        }
+        m_dirtyCount = last;
+    }
+}
+
+
+void dxBodyStateStore::load (dxBody *b)
+{
+    unsigned slot = b->state_slot;
+    dCopyVector4 (pos(slot), b->posr.pos);
+    dCopyVector4 (q(slot), b->q);
+    dCopyMatrix4x4 (R(slot), b->posr.R);
+    dCopyVector4 (lvel(slot), b->lvel);
+    dCopyVector4 (avel(slot), b->avel);
+    m_invMass.data()[slot] = b->invMass;
+    dCopyMatrix4x4 (m_I.data() + (sizeint)slot * INERTIA_STRIDE, b->mass.I);
+    dCopyMatrix4x4 (m_invI.data() + (sizeint)slot * INERTIA_STRIDE, b->invI);
+}
+
+
+void dxBodyStateStore::publish (dxBody *b) const
+{
+    unsigned slot = b->state_slot;
+    dCopyVector3 (b->posr.pos, pos(slot));
+    dCopyVector4 (b->q, q(slot));
+    dCopyMatrix4x3 (b->posr.R, R(slot));
+    dCopyVector3 (b->lvel, lvel(slot));
+    dCopyVector3 (b->avel, avel(slot));
+}
@@ -0,0 +1,104 @@
+/*************************************************************************
+ *                                                                       *
+ * Open Dynamics Engine, Copyright (C) 2001,2002 Russell L. Smith.       *
+ * All rights reserved.  Email: russ@q12.org   Web: www.q12.org          *
+ *                                                                       *
+ * This library is free software; you can redistribute it and/or         *
+ * modify it under the terms of EITHER:                                  *
+ *   (1) The GNU Lesser General Public License as published by the Free  *
+ *       Software Foundation; either version 2.1 of the License, or (at  *
+ *       your option) any later version. The text of the GNU Lesser      *
+ *       General Public License is included with this library in the     *
+ *       file LICENSE.TXT.                                               *
+ *   (2) The BSD-style license that is included with this library in     *
+ *       the file LICENSE-BSD.TXT.                                       *
+ *                                                                       *
+ * This library is distributed in the hope that it will be useful,       *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the files    *
+ * LICENSE.TXT and LICENSE-BSD.TXT for more details.                     *
+ *                                                                       *
+ *************************************************************************/
+
+// structure-of-arrays mirror of the body state that the steppers stream
+// through. the dxBody fields remain the public copy of the state: the body
+// API writes them and marks the body dirty, the dirty bodies are reloaded
+// before the next step, and the steppers publish the state of the bodies
+// they have moved back to them.
+
+
+#ifndef _ODE__PRIVATE_BODY_STATE_H_
+#define _ODE__PRIVATE_BODY_STATE_H_
+
+
+#include <ode/common.h>
+#include "array.h"
+#include "odeou.h"
+
+
+struct dxBody;
+
+
+class dxBodyStateStore {
+public:
+    enum {
+        POS_STRIDE = 4,		// dVector3
+        Q_STRIDE = 4,		// dQuaternion
+        R_STRIDE = 12,		// dMatrix3
+        VEL_STRIDE = 4,		// dVector3
+        INERTIA_STRIDE = 12,	// dMatrix3
+    };
+
+    dxBodyStateStore(): m_count(0), m_dirtyCount(0) {}
+
+    // assign a slot to a new body and load its state.
+    void add (dxBody *b);
+
+    // free the slot of the body. the last slot is moved into it.
+    void remove (dxBody *b);
+
+    // note that the state of the body was changed through the API. bodies
+    // may be marked from several threads at a time.
+    void markDirty (dxBody *b);
+
+    // reload the state of the bodies marked dirty since the last refresh.
+    void refresh();
+
+    // copy the state of the body to its slot.
+    void load (dxBody *b);
+
+    // copy the position, orientation and velocities of the slot to the body.
+    void publish (dxBody *b) const;
+
+    unsigned count() const { return m_count; }
+
+    dReal *pos (unsigned slot) const { return m_pos.data() + (sizeint)slot * POS_STRIDE; }
+    dReal *q (unsigned slot) const { return m_q.data() + (sizeint)slot * Q_STRIDE; }
+    dReal *R (unsigned slot) const { return m_R.data() + (sizeint)slot * R_STRIDE; }
+    dReal *lvel (unsigned slot) const { return m_lvel.data() + (sizeint)slot * VEL_STRIDE; }
+    dReal *avel (unsigned slot) const { return m_avel.data() + (sizeint)slot * VEL_STRIDE; }
+    dReal invMass (unsigned slot) const { return m_invMass.data()[slot]; }
+    const dReal *I (unsigned slot) const { return m_I.data() + (sizeint)slot * INERTIA_STRIDE; }
+    const dReal *invI (unsigned slot) const { return m_invI.data() + (sizeint)slot * INERTIA_STRIDE; }
+
+private:
+    void setCount (unsigned count);
+    void dropDirty (unsigned slot);
+
+    unsigned m_count;
+    atomicord32 m_dirtyCount;		// the number of entries in m_dirtySlots
+    dArray<dxBody *> m_bodies;		// the body of each slot
+    dArray<atomicord32> m_dirty;	// body changed since the last refresh
+    dArray<unsigned> m_dirtySlots;	// the slots marked dirty, each one once
+    dArray<dReal> m_pos;		// position of the point of reference
+    dArray<dReal> m_q;			// orientation quaternion
+    dArray<dReal> m_R;			// orientation matrix
+    dArray<dReal> m_lvel;		// linear velocity
+    dArray<dReal> m_avel;		// angular velocity
+    dArray<dReal> m_invMass;		// 1 / mass
+    dArray<dReal> m_I;			// inertia tensor in the body frame
+    dArray<dReal> m_invI;		// inverse of the inertia tensor
+};
+
+
+#endif // #ifndef _ODE__PRIVATE_BODY_STATE_H_
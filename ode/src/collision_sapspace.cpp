@@ -239,6 +239,9 @@ static void collideGeomsNoAABBs( dxGeom *g1, dxGeom *g2, void *data, dNearCallba
     // no contacts if both geoms on the same body, and the body is not 0
     if (g1->body == g2->body && g1->body) return;
 
+    // no contacts between sleeping bodies; they are woken by the awake ones
+    if (g1->body && g1->body->isAsleep() && g2->body && g2->body->isAsleep()) return;
+
     // test if the category and collide bitfields match
     if ( ((g1->category_bits & g2->collide_bits) ||
         (g2->category_bits & g1->collide_bits)) == 0) {
@@ -0,0 +1,109 @@
+/*************************************************************************
+ *                                                                       *
+ * Open Dynamics Engine, Copyright (C) 2001,2002 Russell L. Smith.       *
+ * All rights reserved.  Email: russ@q12.org   Web: www.q12.org          *
+ *                                                                       *
+ * This library is free software; you can redistribute it and/or         *
+ * modify it under the terms of EITHER:                                  *
+ *   (1) The GNU Lesser General Public License as published by the Free  *
+ *       Software Foundation; either version 2.1 of the License, or (at  *
+ *       your option) any later version. The text of the GNU Lesser      *
+ *       General Public License is included with this library in the     *
+ *       file LICENSE.TXT.                                               *
+ *   (2) The BSD-style license that is included with this library in     *
+ *       the file LICENSE-BSD.TXT.                                       *
+ *                                                                       *
+ * This library is distributed in the hope that it will be useful,       *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the files    *
+ * LICENSE.TXT and LICENSE-BSD.TXT for more details.                     *
+ *                                                                       *
+ *************************************************************************/
+
+#include <ode/common.h>
+#include <ode/objects.h>
+#include "config.h"
+#include "contact_cache.h"
+#include "odemath.h"
+#include "joints/contact.h"
+
+
+static inline bool entryKeyLess (const dxContactCacheEntry &a, const dxContactCacheEntry &b)
+{
+    if (a.g1 != b.g1) return a.g1 < b.g1;
+    if (a.g2 != b.g2) return a.g2 < b.g2;
+    if (a.side1 != b.side1) return a.side1 < b.side1;
+    return a.side2 < b.side2;
+}
+
+
+static inline void setEntryKey (dxContactCacheEntry &e, const dContactGeom &geom)
+{
+    e.g1 = geom.g1;
+    e.g2 = geom.g2;
+    e.side1 = geom.side1;
+    e.side2 = geom.side2;
+}
+
+
+void dxContactCache::load (dxWorld *w, dReal distance)
+{
+    int n = m_entries.size();
+    if (n == 0) return;
+
+    m_used.setSize (n);
+    memset (m_used.data(), 0, n);
+
+    const dxContactCacheEntry *begin = m_entries.data(), *end = begin + n;
+    const dReal max_dist2 = distance * distance;
+
+    for (dxJoint *j=w->firstjoint; j; j=(dxJoint*)j->next) {
+        if (j->type() != dJointTypeContact) continue;
+        const dContactGeom &geom = ((dxJointContact *)j)->contact.geom;
+
+        dxContactCacheEntry key;
+        setEntryKey (key, geom);
+        const dxContactCacheEntry *e = std::lower_bound (begin, end, key, entryKeyLess);
+
+        const dxContactCacheEntry *best = NULL;
+        dReal best_dist2 = max_dist2;
+        for (; e != end && !entryKeyLess (key, *e); e++) {
+            if (m_used[(int)(e - begin)]) continue;
+            dVector3 d;
+            dSubtractVectors3 (d, e->pos, geom.pos);
+            dReal dist2 = dCalcVectorLengthSquare3 (d);
+            if (dist2 <= best_dist2) {
+                best = e;
+                best_dist2 = dist2;
+            }
+        }
+
+        if (best != NULL) {
+            m_used[(int)(best - begin)] = 1;
+            j->lambda[0] = best->lambda[0];
+            j->lambda[1] = best->lambda[1];
+            j->lambda[2] = best->lambda[2];
+        }
+    }
+}
+
+
+void dxContactCache::store (dxWorld *w)
+{
+    m_entries.setSize (0);
+
+    for (dxJoint *j=w->firstjoint; j; j=(dxJoint*)j->next) {
+        if (j->type() != dJointTypeContact) continue;
+        const dContactGeom &geom = ((dxJointContact *)j)->contact.geom;
+
+        dxContactCacheEntry e;
+        setEntryKey (e, geom);
+        dCopyVector3 (e.pos, geom.pos);
+        e.lambda[0] = j->lambda[0];
+        e.lambda[1] = j->lambda[1];
+        e.lambda[2] = j->lambda[2];
+        m_entries.push (e);
+    }
+
+    std::sort (m_entries.data(), m_entries.data() + m_entries.size(), entryKeyLess);
+}
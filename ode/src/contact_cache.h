@@ -0,0 +1,63 @@
+/*************************************************************************
+ *                                                                       *
+ * Open Dynamics Engine, Copyright (C) 2001,2002 Russell L. Smith.       *
+ * All rights reserved.  Email: russ@q12.org   Web: www.q12.org          *
+ *                                                                       *
+ * This library is free software; you can redistribute it and/or         *
+ * modify it under the terms of EITHER:                                  *
+ *   (1) The GNU Lesser General Public License as published by the Free  *
+ *       Software Foundation; either version 2.1 of the License, or (at  *
+ *       your option) any later version. The text of the GNU Lesser      *
+ *       General Public License is included with this library in the     *
+ *       file LICENSE.TXT.                                               *
+ *   (2) The BSD-style license that is included with this library in     *
+ *       the file LICENSE-BSD.TXT.                                       *
+ *                                                                       *
+ * This library is distributed in the hope that it will be useful,       *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the files    *
+ * LICENSE.TXT and LICENSE-BSD.TXT for more details.                     *
+ *                                                                       *
+ *************************************************************************/
+
+// cache of contact constraint forces used to warm start the quick-step
+// solver. contact joints are normally destroyed after every step, so the
+// lambdas are kept here and copied to the matching contacts of the next step.
+
+
+#ifndef _ODE__PRIVATE_CONTACT_CACHE_H_
+#define _ODE__PRIVATE_CONTACT_CACHE_H_
+
+
+#include <ode/common.h>
+#include "objects.h"
+#include "array.h"
+
+
+struct dxContactCacheEntry {
+    dxGeom *g1, *g2;		// geom pair as reported by the collider
+    int side1, side2;		// geom features that are in contact
+    dVector3 pos;			// contact position
+    dReal lambda[3];		// normal and friction forces of the last step
+};
+
+
+class dxContactCache : public dBase {
+public:
+    // copy the cached lambdas to the contact joints of the world. a contact
+    // matches a cached one with the same geoms and features that lies within
+    // `distance'; if there are several, the nearest one is used.
+    void load (dxWorld *w, dReal distance);
+
+    // replace the cache with the lambdas of the contact joints of the world.
+    void store (dxWorld *w);
+
+    void clear() { m_entries.setSize (0); }
+
+private:
+    dArray<dxContactCacheEntry> m_entries;	// sorted by geoms and features
+    dArray<unsigned char> m_used;		// entry already matched in load()
+};
+
+
+#endif // #ifndef _ODE__PRIVATE_CONTACT_CACHE_H_
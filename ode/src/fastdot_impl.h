@@ -26,9 +26,17 @@
 #define _ODE_FASTDOT_IMPL_H_
 
 
+#include "fastsimd_impl.h"
+
+
 template<unsigned b_stride>
 dReal calculateLargeVectorDot (const dReal *a, const dReal *b, unsigned n)
 {
+    dReal vectorSum;
+    if (dxFastDot<b_stride>(vectorSum, a, b, n)) {
+        return vectorSum;
+    }
+
     dReal sum = 0;
     const dReal *a_end = a + (n & (int)(~3));
     for (; a != a_end; b += 4 * b_stride, a += 4) {
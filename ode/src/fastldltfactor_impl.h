@@ -33,6 +33,7 @@
 
 #include "error.h"
 #include "common.h"
+#include "fastsimd_impl.h"
 
 
 static void solveL1Stripe_2 (const dReal *L, dReal *B, unsigned rowCount, unsigned rowSkip);
@@ -130,93 +131,105 @@ void solveL1Stripe_2(const dReal *L, dReal *B, unsigned rowCount, unsigned rowSk
             /* set Z matrix to 0 */
             Z11 = 0; Z12 = 0; Z21 = 0; Z22 = 0;
 
-            /* the inner loop that computes outer products and adds them to Z */
-            // The iteration starts with even number and decreases it by 2. So, it must end in zero
-            for (unsigned columnCounter = blockStartRow; ;) 
+            dReal vectorZ[4];
+            if (dxFastDot2x2(vectorZ, ptrLElement, ptrBElement, rowSkip, blockStartRow))
             {
-                /* declare p and q vectors, etc */
-                dReal p1, q1, p2, q2;
-
-                /* compute outer product and add it to the Z matrix */
-                p1 = ptrLElement[0];
-                q1 = ptrBElement[0];
-                Z11 += p1 * q1;
-                q2 = ptrBElement[rowSkip];
-                Z12 += p1 * q2;
-                p2 = ptrLElement[rowSkip];
-                Z21 += p2 * q1;
-                Z22 += p2 * q2;
+                Z11 = vectorZ[0]; Z12 = vectorZ[1]; Z21 = vectorZ[2]; Z22 = vectorZ[3];
 
-                /* compute outer product and add it to the Z matrix */
-                p1 = ptrLElement[1];
-                q1 = ptrBElement[1];
-                Z11 += p1 * q1;
-                q2 = ptrBElement[1 + rowSkip];
-                Z12 += p1 * q2;
-                p2 = ptrLElement[1 + rowSkip];
-                Z21 += p2 * q1;
-                Z22 += p2 * q2;
-
-                if (columnCounter > 6)
+                /* advance pointers */
+                ptrLElement += blockStartRow;
+                ptrBElement += blockStartRow;
+            }
+            else
+            {
+                /* the inner loop that computes outer products and adds them to Z */
+                // The iteration starts with even number and decreases it by 2. So, it must end in zero
+                for (unsigned columnCounter = blockStartRow; ;) 
                 {
-                    columnCounter -= 6;
-
-                    /* advance pointers */
-                    ptrLElement += 6;
-                    ptrBElement += 6;
+                    /* declare p and q vectors, etc */
+                    dReal p1, q1, p2, q2;
 
                     /* compute outer product and add it to the Z matrix */
-                    p1 = ptrLElement[-4];
-                    q1 = ptrBElement[-4];
+                    p1 = ptrLElement[0];
+                    q1 = ptrBElement[0];
                     Z11 += p1 * q1;
-                    q2 = ptrBElement[-4 + rowSkip];
+                    q2 = ptrBElement[rowSkip];
                     Z12 += p1 * q2;
-                    p2 = ptrLElement[-4 + rowSkip];
+                    p2 = ptrLElement[rowSkip];
                     Z21 += p2 * q1;
                     Z22 += p2 * q2;
 
                     /* compute outer product and add it to the Z matrix */
-                    p1 = ptrLElement[-3];
-                    q1 = ptrBElement[-3];
+                    p1 = ptrLElement[1];
+                    q1 = ptrBElement[1];
                     Z11 += p1 * q1;
-                    q2 = ptrBElement[-3 + rowSkip];
+                    q2 = ptrBElement[1 + rowSkip];
                     Z12 += p1 * q2;
-                    p2 = ptrLElement[-3 + rowSkip];
+                    p2 = ptrLElement[1 + rowSkip];
                     Z21 += p2 * q1;
                     Z22 += p2 * q2;
 
-                    /* compute outer product and add it to the Z matrix */
-                    p1 = ptrLElement[-2];
-                    q1 = ptrBElement[-2];
-                    Z11 += p1 * q1;
-                    q2 = ptrBElement[-2 + rowSkip];
-                    Z12 += p1 * q2;
-                    p2 = ptrLElement[-2 + rowSkip];
-                    Z21 += p2 * q1;
-                    Z22 += p2 * q2;
+                    if (columnCounter > 6)
+                    {
+                        columnCounter -= 6;
 
-                    /* compute outer product and add it to the Z matrix */
-                    p1 = ptrLElement[-1];
-                    q1 = ptrBElement[-1];
-                    Z11 += p1 * q1;
-                    q2 = ptrBElement[-1 + rowSkip];
-                    Z12 += p1 * q2;
-                    p2 = ptrLElement[-1 + rowSkip];
-                    Z21 += p2 * q1;
-                    Z22 += p2 * q2;
-                }
-                else
-                {
-                    /* advance pointers */
-                    ptrLElement += 2;
-                    ptrBElement += 2;
+                        /* advance pointers */
+                        ptrLElement += 6;
+                        ptrBElement += 6;
 
-                    if ((columnCounter -= 2) == 0)
+                        /* compute outer product and add it to the Z matrix */
+                        p1 = ptrLElement[-4];
+                        q1 = ptrBElement[-4];
+                        Z11 += p1 * q1;
+                        q2 = ptrBElement[-4 + rowSkip];
+                        Z12 += p1 * q2;
+                        p2 = ptrLElement[-4 + rowSkip];
+                        Z21 += p2 * q1;
+                        Z22 += p2 * q2;
+
+                        /* compute outer product and add it to the Z matrix */
+                        p1 = ptrLElement[-3];
+                        q1 = ptrBElement[-3];
+                        Z11 += p1 * q1;
+                        q2 = ptrBElement[-3 + rowSkip];
+                        Z12 += p1 * q2;
+                        p2 = ptrLElement[-3 + rowSkip];
+                        Z21 += p2 * q1;
+                        Z22 += p2 * q2;
+
+                        /* compute outer product and add it to the Z matrix */
+                        p1 = ptrLElement[-2];
+                        q1 = ptrBElement[-2];
+                        Z11 += p1 * q1;
+                        q2 = ptrBElement[-2 + rowSkip];
+                        Z12 += p1 * q2;
+                        p2 = ptrLElement[-2 + rowSkip];
+                        Z21 += p2 * q1;
+                        Z22 += p2 * q2;
+
+                        /* compute outer product and add it to the Z matrix */
+                        p1 = ptrLElement[-1];
+                        q1 = ptrBElement[-1];
+                        Z11 += p1 * q1;
+                        q2 = ptrBElement[-1 + rowSkip];
+                        Z12 += p1 * q2;
+                        p2 = ptrLElement[-1 + rowSkip];
+                        Z21 += p2 * q1;
+                        Z22 += p2 * q2;
+                    }
+                    else
                     {
-                        break;
+                        /* advance pointers */
+                        ptrLElement += 2;
+                        ptrBElement += 2;
+
+                        if ((columnCounter -= 2) == 0)
+                        {
+                            break;
+                        }
                     }
+                    /* end of inner loop */
                 }
-                /* end of inner loop */
             }
         }
         else
@@ -260,91 +273,102 @@ void scaleAndFactorizeL1Stripe_2(dReal *ARow, dReal *d, unsigned factorizationRo
     /* compute Z = the outer product matrix that we'll need. */
     dReal Z11 = 0, Z21 = 0, Z22 = 0;
 
-    for (unsigned columnCounter = factorizationRow; ; ) 
+    dReal vectorZ[3];
+    if (dxFastScaleDot2<d_stride>(vectorZ, ptrAElement, rowSkip, ptrDElement, factorizationRow))
     {
-        dReal p1, q1, p2, q2, dd;
-
-        p1 = ptrAElement[0];
-        p2 = ptrAElement[rowSkip];
-        dd = ptrDElement[0 * d_stride];
-        q1 = p1 * dd;
-        q2 = p2 * dd;
-        ptrAElement[0] = q1;
-        ptrAElement[rowSkip] = q2;
-        Z11 += p1 * q1;
-        Z21 += p2 * q1;
-        Z22 += p2 * q2;
+        Z11 = vectorZ[0]; Z21 = vectorZ[1]; Z22 = vectorZ[2];
 
-        p1 = ptrAElement[1];
-        p2 = ptrAElement[1 + rowSkip];
-        dd = ptrDElement[1 * d_stride];
-        q1 = p1 * dd;
-        q2 = p2 * dd;
-        ptrAElement[1] = q1;
-        ptrAElement[1 + rowSkip] = q2;
-        Z11 += p1 * q1;
-        Z21 += p2 * q1;
-        Z22 += p2 * q2;
-
-        if (columnCounter > 6)
+        ptrAElement += factorizationRow;
+        ptrDElement += (sizeint)factorizationRow * d_stride;
+    }
+    else
+    {
+        for (unsigned columnCounter = factorizationRow; ; ) 
         {
-            columnCounter -= 6;
-
-            ptrAElement += 6;
-            ptrDElement += 6 * d_stride;
+            dReal p1, q1, p2, q2, dd;
 
-            p1 = ptrAElement[-4];
-            p2 = ptrAElement[-4 + rowSkip];
-            dd = ptrDElement[-4 * (int)d_stride];
+            p1 = ptrAElement[0];
+            p2 = ptrAElement[rowSkip];
+            dd = ptrDElement[0 * d_stride];
             q1 = p1 * dd;
             q2 = p2 * dd;
-            ptrAElement[-4] = q1;
-            ptrAElement[-4 + rowSkip] = q2;
+            ptrAElement[0] = q1;
+            ptrAElement[rowSkip] = q2;
             Z11 += p1 * q1;
             Z21 += p2 * q1;
             Z22 += p2 * q2;
 
-            p1 = ptrAElement[-3];
-            p2 = ptrAElement[-3 + rowSkip];
-            dd = ptrDElement[-3 * (int)d_stride];
+            p1 = ptrAElement[1];
+            p2 = ptrAElement[1 + rowSkip];
+            dd = ptrDElement[1 * d_stride];
             q1 = p1 * dd;
             q2 = p2 * dd;
-            ptrAElement[-3] = q1;
-            ptrAElement[-3 + rowSkip] = q2;
+            ptrAElement[1] = q1;
+            ptrAElement[1 + rowSkip] = q2;
             Z11 += p1 * q1;
             Z21 += p2 * q1;
             Z22 += p2 * q2;
 
-            p1 = ptrAElement[-2];
-            p2 = ptrAElement[-2 + rowSkip];
-            dd = ptrDElement[-2 * (int)d_stride];
-            q1 = p1 * dd;
-            q2 = p2 * dd;
-            ptrAElement[-2] = q1;
-            ptrAElement[-2 + rowSkip] = q2;
-            Z11 += p1 * q1;
-            Z21 += p2 * q1;
-            Z22 += p2 * q2;
+            if (columnCounter > 6)
+            {
+                columnCounter -= 6;
 
-            p1 = ptrAElement[-1];
-            p2 = ptrAElement[-1 + rowSkip];
-            dd = ptrDElement[-1 * (int)d_stride];
-            q1 = p1 * dd;
-            q2 = p2 * dd;
-            ptrAElement[-1] = q1;
-            ptrAElement[-1 + rowSkip] = q2;
-            Z11 += p1 * q1;
-            Z21 += p2 * q1;
-            Z22 += p2 * q2;
-        }
-        else
-        {
-            ptrAElement += 2;
-            ptrDElement += 2 * d_stride;
+                ptrAElement += 6;
+                ptrDElement += 6 * d_stride;
 
-            if ((columnCounter -= 2) == 0)
+                p1 = ptrAElement[-4];
+                p2 = ptrAElement[-4 + rowSkip];
+                dd = ptrDElement[-4 * (int)d_stride];
+                q1 = p1 * dd;
+                q2 = p2 * dd;
+                ptrAElement[-4] = q1;
+                ptrAElement[-4 + rowSkip] = q2;
+                Z11 += p1 * q1;
+                Z21 += p2 * q1;
+                Z22 += p2 * q2;
+
+                p1 = ptrAElement[-3];
+                p2 = ptrAElement[-3 + rowSkip];
+                dd = ptrDElement[-3 * (int)d_stride];
+                q1 = p1 * dd;
+                q2 = p2 * dd;
+                ptrAElement[-3] = q1;
+                ptrAElement[-3 + rowSkip] = q2;
+                Z11 += p1 * q1;
+                Z21 += p2 * q1;
+                Z22 += p2 * q2;
+
+                p1 = ptrAElement[-2];
+                p2 = ptrAElement[-2 + rowSkip];
+                dd = ptrDElement[-2 * (int)d_stride];
+                q1 = p1 * dd;
+                q2 = p2 * dd;
+                ptrAElement[-2] = q1;
+                ptrAElement[-2 + rowSkip] = q2;
+                Z11 += p1 * q1;
+                Z21 += p2 * q1;
+                Z22 += p2 * q2;
+
+                p1 = ptrAElement[-1];
+                p2 = ptrAElement[-1 + rowSkip];
+                dd = ptrDElement[-1 * (int)d_stride];
+                q1 = p1 * dd;
+                q2 = p2 * dd;
+                ptrAElement[-1] = q1;
+                ptrAElement[-1 + rowSkip] = q2;
+                Z11 += p1 * q1;
+                Z21 += p2 * q1;
+                Z22 += p2 * q2;
+            }
+            else
             {
-                break;
+                ptrAElement += 2;
+                ptrDElement += 2 * d_stride;
+
+                if ((columnCounter -= 2) == 0)
+                {
+                    break;
+                }
             }
         }
     }
@@ -31,6 +31,9 @@
 #define _ODE_FASTLSOLVE_IMPL_H_
 
 
+#include "fastsimd_impl.h"
+
+
 /* solve L*X=B, with B containing 1 right hand sides.
  * L is an n*n lower triangular matrix with ones on the diagonal.
  * L is stored by rows and its leading dimension is lskip.
@@ -67,82 +70,29 @@ void solveL1Straight (const dReal *L, dReal *B, unsigned rowCount, unsigned rowS
             /* set the Z matrix to 0 */
             Z11 = 0; Z21 = 0; Z31 = 0; Z41 = 0;
 
-            /* the inner loop that computes outer products and adds them to Z */
-            for (unsigned columnCounter = blockStartRow; ; )
+            dReal vectorZ[4];
+            if (dxFastDot4Rows<b_stride>(vectorZ, ptrLElement - rowSkip, rowSkip, ptrBElement, blockStartRow))
             {
-                dReal q1, p1, p2, p3, p4;
-
-                /* load p and q values */
-                q1 = ptrBElement[0 * b_stride];
-                p1 = (ptrLElement - rowSkip)[0];
-                p2 = ptrLElement[0];
-                ptrLElement += rowSkip;
-                p3 = ptrLElement[0];
-                p4 = ptrLElement[0 + rowSkip];
-
-                /* compute outer product and add it to the Z matrix */
-                Z11 += p1 * q1;
-                Z21 += p2 * q1;
-                Z31 += p3 * q1;
-                Z41 += p4 * q1;
-
-                /* load p and q values */
-                q1 = ptrBElement[1 * b_stride];
-                p3 = ptrLElement[1];
-                p4 = ptrLElement[1 + rowSkip];
-                ptrLElement -= rowSkip;
-                p1 = (ptrLElement - rowSkip)[1];
-                p2 = ptrLElement[1];
+                Z11 = vectorZ[0]; Z21 = vectorZ[1]; Z31 = vectorZ[2]; Z41 = vectorZ[3];
 
-                /* compute outer product and add it to the Z matrix */
-                Z11 += p1 * q1;
-                Z21 += p2 * q1;
-                Z31 += p3 * q1;
-                Z41 += p4 * q1;
-
-                /* load p and q values */
-                q1 = ptrBElement[2 * b_stride];
-                p1 = (ptrLElement - rowSkip)[2];
-                p2 = ptrLElement[2];
-                ptrLElement += rowSkip;
-                p3 = ptrLElement[2];
-                p4 = ptrLElement[2 + rowSkip];
-
-                /* compute outer product and add it to the Z matrix */
-                Z11 += p1 * q1;
-                Z21 += p2 * q1;
-                Z31 += p3 * q1;
-                Z41 += p4 * q1;
-
-                /* load p and q values */
-                q1 = ptrBElement[3 * b_stride];
-                p3 = ptrLElement[3];
-                p4 = ptrLElement[3 + rowSkip];
-                ptrLElement -= rowSkip;
-                p1 = (ptrLElement - rowSkip)[3];
-                p2 = ptrLElement[3];
-
-                /* compute outer product and add it to the Z matrix */
-                Z11 += p1 * q1;
-                Z21 += p2 * q1;
-                Z31 += p3 * q1;
-                Z41 += p4 * q1;
-
-                if (columnCounter > 12)
+                /* advance pointers */
+                ptrLElement += blockStartRow;
+                ptrBElement += blockStartRow * b_stride;
+            }
+            else
+            {
+                /* the inner loop that computes outer products and adds them to Z */
+                for (unsigned columnCounter = blockStartRow; ; )
                 {
-                    columnCounter -= 12;
-
-                    /* advance pointers */
-                    ptrLElement += 12;
-                    ptrBElement += 12 * b_stride;
+                    dReal q1, p1, p2, p3, p4;
 
                     /* load p and q values */
-                    q1 = ptrBElement[-8 * (int)b_stride];
-                    p1 = (ptrLElement - rowSkip)[-8];
-                    p2 = ptrLElement[-8];
+                    q1 = ptrBElement[0 * b_stride];
+                    p1 = (ptrLElement - rowSkip)[0];
+                    p2 = ptrLElement[0];
                     ptrLElement += rowSkip;
-                    p3 = ptrLElement[-8];
-                    p4 = ptrLElement[-8 + rowSkip];
+                    p3 = ptrLElement[0];
+                    p4 = ptrLElement[0 + rowSkip];
 
                     /* compute outer product and add it to the Z matrix */
                     Z11 += p1 * q1;
@@ -151,12 +101,12 @@ void solveL1Straight (const dReal *L, dReal *B, unsigned rowCount, unsigned rowS
                     Z41 += p4 * q1;
 
                     /* load p and q values */
-                    q1 = ptrBElement[-7 * (int)b_stride];
-                    p3 = ptrLElement[-7];
-                    p4 = ptrLElement[-7 + rowSkip];
+                    q1 = ptrBElement[1 * b_stride];
+                    p3 = ptrLElement[1];
+                    p4 = ptrLElement[1 + rowSkip];
                     ptrLElement -= rowSkip;
-                    p1 = (ptrLElement - rowSkip)[-7];
-                    p2 = ptrLElement[-7];
+                    p1 = (ptrLElement - rowSkip)[1];
+                    p2 = ptrLElement[1];
 
                     /* compute outer product and add it to the Z matrix */
                     Z11 += p1 * q1;
@@ -165,12 +115,12 @@ void solveL1Straight (const dReal *L, dReal *B, unsigned rowCount, unsigned rowS
                     Z41 += p4 * q1;
 
                     /* load p and q values */
-                    q1 = ptrBElement[-6 * (int)b_stride];
-                    p1 = (ptrLElement - rowSkip)[-6];
-                    p2 = ptrLElement[-6];
+                    q1 = ptrBElement[2 * b_stride];
+                    p1 = (ptrLElement - rowSkip)[2];
+                    p2 = ptrLElement[2];
                     ptrLElement += rowSkip;
-                    p3 = ptrLElement[-6];
-                    p4 = ptrLElement[-6 + rowSkip];
+                    p3 = ptrLElement[2];
+                    p4 = ptrLElement[2 + rowSkip];
 
                     /* compute outer product and add it to the Z matrix */
                     Z11 += p1 * q1;
@@ -179,12 +129,12 @@ void solveL1Straight (const dReal *L, dReal *B, unsigned rowCount, unsigned rowS
                     Z41 += p4 * q1;
 
                     /* load p and q values */
-                    q1 = ptrBElement[-5 * (int)b_stride];
-                    p3 = ptrLElement[-5];
-                    p4 = ptrLElement[-5 + rowSkip];
+                    q1 = ptrBElement[3 * b_stride];
+                    p3 = ptrLElement[3];
+                    p4 = ptrLElement[3 + rowSkip];
                     ptrLElement -= rowSkip;
-                    p1 = (ptrLElement - rowSkip)[-5];
-                    p2 = ptrLElement[-5];
+                    p1 = (ptrLElement - rowSkip)[3];
+                    p2 = ptrLElement[3];
 
                     /* compute outer product and add it to the Z matrix */
                     Z11 += p1 * q1;
@@ -192,74 +142,139 @@ void solveL1Straight (const dReal *L, dReal *B, unsigned rowCount, unsigned rowS
                     Z31 += p3 * q1;
                     Z41 += p4 * q1;
 
-                    /* load p and q values */
-                    q1 = ptrBElement[-4 * (int)b_stride];
-                    p1 = (ptrLElement - rowSkip)[-4];
-                    p2 = ptrLElement[-4];
-                    ptrLElement += rowSkip;
-                    p3 = ptrLElement[-4];
-                    p4 = ptrLElement[-4 + rowSkip];
+                    if (columnCounter > 12)
+                    {
+                        columnCounter -= 12;
 
-                    /* compute outer product and add it to the Z matrix */
-                    Z11 += p1 * q1;
-                    Z21 += p2 * q1;
-                    Z31 += p3 * q1;
-                    Z41 += p4 * q1;
+                        /* advance pointers */
+                        ptrLElement += 12;
+                        ptrBElement += 12 * b_stride;
 
-                    /* load p and q values */
-                    q1 = ptrBElement[-3 * (int)b_stride];
-                    p3 = ptrLElement[-3];
-                    p4 = ptrLElement[-3 + rowSkip];
-                    ptrLElement -= rowSkip;
-                    p1 = (ptrLElement - rowSkip)[-3];
-                    p2 = ptrLElement[-3];
+                        /* load p and q values */
+                        q1 = ptrBElement[-8 * (int)b_stride];
+                        p1 = (ptrLElement - rowSkip)[-8];
+                        p2 = ptrLElement[-8];
+                        ptrLElement += rowSkip;
+                        p3 = ptrLElement[-8];
+                        p4 = ptrLElement[-8 + rowSkip];
 
-                    /* compute outer product and add it to the Z matrix */
-                    Z11 += p1 * q1;
-                    Z21 += p2 * q1;
-                    Z31 += p3 * q1;
-                    Z41 += p4 * q1;
+                        /* compute outer product and add it to the Z matrix */
+                        Z11 += p1 * q1;
+                        Z21 += p2 * q1;
+                        Z31 += p3 * q1;
+                        Z41 += p4 * q1;
 
-                    /* load p and q values */
-                    q1 = ptrBElement[-2 * (int)b_stride];
-                    p1 = (ptrLElement - rowSkip)[-2];
-                    p2 = ptrLElement[-2];
-                    ptrLElement += rowSkip;
-                    p3 = ptrLElement[-2];
-                    p4 = ptrLElement[-2 + rowSkip];
+                        /* load p and q values */
+                        q1 = ptrBElement[-7 * (int)b_stride];
+                        p3 = ptrLElement[-7];
+                        p4 = ptrLElement[-7 + rowSkip];
+                        ptrLElement -= rowSkip;
+                        p1 = (ptrLElement - rowSkip)[-7];
+                        p2 = ptrLElement[-7];
 
-                    /* compute outer product and add it to the Z matrix */
-                    Z11 += p1 * q1;
-                    Z21 += p2 * q1;
-                    Z31 += p3 * q1;
-                    Z41 += p4 * q1;
+                        /* compute outer product and add it to the Z matrix */
+                        Z11 += p1 * q1;
+                        Z21 += p2 * q1;
+                        Z31 += p3 * q1;
+                        Z41 += p4 * q1;
 
-                    /* load p and q values */
-                    q1 = ptrBElement[-1 * (int)b_stride];
-                    p3 = ptrLElement[-1];
-                    p4 = ptrLElement[-1 + rowSkip];
-                    ptrLElement -= rowSkip;
-                    p1 = (ptrLElement - rowSkip)[-1];
-                    p2 = ptrLElement[-1];
+                        /* load p and q values */
+                        q1 = ptrBElement[-6 * (int)b_stride];
+                        p1 = (ptrLElement - rowSkip)[-6];
+                        p2 = ptrLElement[-6];
+                        ptrLElement += rowSkip;
+                        p3 = ptrLElement[-6];
+                        p4 = ptrLElement[-6 + rowSkip];
 
-                    /* compute outer product and add it to the Z matrix */
-                    Z11 += p1 * q1;
-                    Z21 += p2 * q1;
-                    Z31 += p3 * q1;
-                    Z41 += p4 * q1;
-                }
-                else
-                {
-                    /* advance pointers */
-                    ptrLElement += 4;
-                    ptrBElement += 4 * b_stride;
+                        /* compute outer product and add it to the Z matrix */
+                        Z11 += p1 * q1;
+                        Z21 += p2 * q1;
+                        Z31 += p3 * q1;
+                        Z41 += p4 * q1;
+
+                        /* load p and q values */
+                        q1 = ptrBElement[-5 * (int)b_stride];
+                        p3 = ptrLElement[-5];
+                        p4 = ptrLElement[-5 + rowSkip];
+                        ptrLElement -= rowSkip;
+                        p1 = (ptrLElement - rowSkip)[-5];
+                        p2 = ptrLElement[-5];
 
-                    if ((columnCounter -= 4) == 0)
+                        /* compute outer product and add it to the Z matrix */
+                        Z11 += p1 * q1;
+                        Z21 += p2 * q1;
+                        Z31 += p3 * q1;
+                        Z41 += p4 * q1;
+
+                        /* load p and q values */
+                        q1 = ptrBElement[-4 * (int)b_stride];
+                        p1 = (ptrLElement - rowSkip)[-4];
+                        p2 = ptrLElement[-4];
+                        ptrLElement += rowSkip;
+                        p3 = ptrLElement[-4];
+                        p4 = ptrLElement[-4 + rowSkip];
+
+                        /* compute outer product and add it to the Z matrix */
+                        Z11 += p1 * q1;
+                        Z21 += p2 * q1;
+                        Z31 += p3 * q1;
+                        Z41 += p4 * q1;
+
+                        /* load p and q values */
+                        q1 = ptrBElement[-3 * (int)b_stride];
+                        p3 = ptrLElement[-3];
+                        p4 = ptrLElement[-3 + rowSkip];
+                        ptrLElement -= rowSkip;
+                        p1 = (ptrLElement - rowSkip)[-3];
+                        p2 = ptrLElement[-3];
+
+                        /* compute outer product and add it to the Z matrix */
+                        Z11 += p1 * q1;
+                        Z21 += p2 * q1;
+                        Z31 += p3 * q1;
+                        Z41 += p4 * q1;
+
+                        /* load p and q values */
+                        q1 = ptrBElement[-2 * (int)b_stride];
+                        p1 = (ptrLElement - rowSkip)[-2];
+                        p2 = ptrLElement[-2];
+                        ptrLElement += rowSkip;
+                        p3 = ptrLElement[-2];
+                        p4 = ptrLElement[-2 + rowSkip];
+
+                        /* compute outer product and add it to the Z matrix */
+                        Z11 += p1 * q1;
+                        Z21 += p2 * q1;
+                        Z31 += p3 * q1;
+                        Z41 += p4 * q1;
+
+                        /* load p and q values */
+                        q1 = ptrBElement[-1 * (int)b_stride];
+                        p3 = ptrLElement[-1];
+                        p4 = ptrLElement[-1 + rowSkip];
+                        ptrLElement -= rowSkip;
+                        p1 = (ptrLElement - rowSkip)[-1];
+                        p2 = ptrLElement[-1];
+
+                        /* compute outer product and add it to the Z matrix */
+                        Z11 += p1 * q1;
+                        Z21 += p2 * q1;
+                        Z31 += p3 * q1;
+                        Z41 += p4 * q1;
+                    }
+                    else
                     {
-                        break;
+                        /* advance pointers */
+                        ptrLElement += 4;
+                        ptrBElement += 4 * b_stride;
+
+                        if ((columnCounter -= 4) == 0)
+                        {
+                            break;
+                        }
                     }
+                    /* end of inner loop */
                 }
-                /* end of inner loop */
             }
         }
         else
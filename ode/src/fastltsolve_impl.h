@@ -32,6 +32,9 @@
 #define _ODE_FASTLTSOLVE_IMPL_H_
 
 
+#include "fastsimd_impl.h"
+
+
 /* solve L^T * x=b, with b containing 1 right hand side.
  * L is an n*n lower triangular matrix with ones on the diagonal.
  * L is stored by rows and its leading dimension is rowSkip.
@@ -101,135 +104,24 @@ void solveL1Transposed(const dReal *L, dReal *B, unsigned rowCount, unsigned row
             /* set the Z matrix to 0 */
             Z41 = 0; Z31 = 0; Z21 = 0; Z11 = 0;
 
-            unsigned rowCounter = blockStartRow;
-
-            if (rowCounter % 2 != 0)
+            dReal vectorZ[4];
+            if (dxFastAccumulate4Columns<b_stride>(vectorZ, ptrLElement - 3, rowSkip, ptrBElement, blockStartRow))
             {
-                dReal q1, p4, p3, p2, p1;
-
-                /* load p and q values */
-                q1 = ptrBElement[0 * (int)b_stride];
-                p4 = ptrLElement[-3];
-                p3 = ptrLElement[-2];
-                p2 = ptrLElement[-1];
-                p1 = ptrLElement[0];
-                ptrLElement -= rowSkip;
-
-                /* compute outer product and add it to the Z matrix */
-                Z41 += p4 * q1;
-                Z31 += p3 * q1;
-                Z21 += p2 * q1;
-                Z11 += p1 * q1;
-
-                ptrBElement -= 1 * b_stride;
-                rowCounter -= 1;
-            }
+                Z41 = vectorZ[0]; Z31 = vectorZ[1]; Z21 = vectorZ[2]; Z11 = vectorZ[3];
 
-            if (rowCounter % 4 != 0)
-            {
-                dReal q1, p4, p3, p2, p1;
-
-                /* load p and q values */
-                q1 = ptrBElement[0 * (int)b_stride];
-                p4 = ptrLElement[-3];
-                p3 = ptrLElement[-2];
-                p2 = ptrLElement[-1];
-                p1 = ptrLElement[0];
-                ptrLElement -= rowSkip;
-
-                /* compute outer product and add it to the Z matrix */
-                Z41 += p4 * q1;
-                Z31 += p3 * q1;
-                Z21 += p2 * q1;
-                Z11 += p1 * q1;
-
-                /* load p and q values */
-                q1 = ptrBElement[-1 * (int)b_stride];
-                p4 = ptrLElement[-3];
-                p3 = ptrLElement[-2];
-                p2 = ptrLElement[-1];
-                p1 = ptrLElement[0];
-                ptrLElement -= rowSkip;
-
-                /* compute outer product and add it to the Z matrix */
-                Z41 += p4 * q1;
-                Z31 += p3 * q1;
-                Z21 += p2 * q1;
-                Z11 += p1 * q1;
-
-                ptrBElement -= 2 * b_stride;
-                rowCounter -= 2;
+                ptrLElement -= (sizeint)blockStartRow * rowSkip;
+                ptrBElement -= (sizeint)blockStartRow * b_stride;
             }
-
-            /* the inner loop that computes outer products and adds them to Z */
-            for (bool exitLoop = rowCounter == 0; !exitLoop; exitLoop = false)
+            else
             {
-                dReal q1, p4, p3, p2, p1;
-
-                /* load p and q values */
-                q1 = ptrBElement[0 * (int)b_stride];
-                p4 = ptrLElement[-3];
-                p3 = ptrLElement[-2];
-                p2 = ptrLElement[-1];
-                p1 = ptrLElement[0];
-                ptrLElement -= rowSkip;
-
-                /* compute outer product and add it to the Z matrix */
-                Z41 += p4 * q1;
-                Z31 += p3 * q1;
-                Z21 += p2 * q1;
-                Z11 += p1 * q1;
-
-                /* load p and q values */
-                q1 = ptrBElement[-1 * (int)b_stride];
-                p4 = ptrLElement[-3];
-                p3 = ptrLElement[-2];
-                p2 = ptrLElement[-1];
-                p1 = ptrLElement[0];
-                ptrLElement -= rowSkip;
-
-                /* compute outer product and add it to the Z matrix */
-                Z41 += p4 * q1;
-                Z31 += p3 * q1;
-                Z21 += p2 * q1;
-                Z11 += p1 * q1;
-
-                /* load p and q values */
-                q1 = ptrBElement[-2 * (int)b_stride];
-                p4 = ptrLElement[-3];
-                p3 = ptrLElement[-2];
-                p2 = ptrLElement[-1];
-                p1 = ptrLElement[0];
-                ptrLElement -= rowSkip;
-
-                /* compute outer product and add it to the Z matrix */
-                Z41 += p4 * q1;
-                Z31 += p3 * q1;
-                Z21 += p2 * q1;
-                Z11 += p1 * q1;
-
-                /* load p and q values */
-                q1 = ptrBElement[-3 * (int)b_stride];
-                p4 = ptrLElement[-3];
-                p3 = ptrLElement[-2];
-                p2 = ptrLElement[-1];
-                p1 = ptrLElement[0];
-                ptrLElement -= rowSkip;
-
-                /* compute outer product and add it to the Z matrix */
-                Z41 += p4 * q1;
-                Z31 += p3 * q1;
-                Z21 += p2 * q1;
-                Z11 += p1 * q1;
-
-                if (rowCounter > 12)
-                {
-                    rowCounter -= 12;
+                unsigned rowCounter = blockStartRow;
 
-                    ptrBElement -= 12 * b_stride;
+                if (rowCounter % 2 != 0)
+                {
+                    dReal q1, p4, p3, p2, p1;
 
                     /* load p and q values */
-                    q1 = ptrBElement[8 * b_stride];
+                    q1 = ptrBElement[0 * (int)b_stride];
                     p4 = ptrLElement[-3];
                     p3 = ptrLElement[-2];
                     p2 = ptrLElement[-1];
@@ -242,22 +134,16 @@ void solveL1Transposed(const dReal *L, dReal *B, unsigned rowCount, unsigned row
                     Z21 += p2 * q1;
                     Z11 += p1 * q1;
 
-                    /* load p and q values */
-                    q1 = ptrBElement[7 * b_stride];
-                    p4 = ptrLElement[-3];
-                    p3 = ptrLElement[-2];
-                    p2 = ptrLElement[-1];
-                    p1 = ptrLElement[0];
-                    ptrLElement -= rowSkip;
+                    ptrBElement -= 1 * b_stride;
+                    rowCounter -= 1;
+                }
 
-                    /* compute outer product and add it to the Z matrix */
-                    Z41 += p4 * q1;
-                    Z31 += p3 * q1;
-                    Z21 += p2 * q1;
-                    Z11 += p1 * q1;
+                if (rowCounter % 4 != 0)
+                {
+                    dReal q1, p4, p3, p2, p1;
 
                     /* load p and q values */
-                    q1 = ptrBElement[6 * b_stride];
+                    q1 = ptrBElement[0 * (int)b_stride];
                     p4 = ptrLElement[-3];
                     p3 = ptrLElement[-2];
                     p2 = ptrLElement[-1];
@@ -271,7 +157,7 @@ void solveL1Transposed(const dReal *L, dReal *B, unsigned rowCount, unsigned row
                     Z11 += p1 * q1;
 
                     /* load p and q values */
-                    q1 = ptrBElement[5 * b_stride];
+                    q1 = ptrBElement[-1 * (int)b_stride];
                     p4 = ptrLElement[-3];
                     p3 = ptrLElement[-2];
                     p2 = ptrLElement[-1];
@@ -284,8 +170,17 @@ void solveL1Transposed(const dReal *L, dReal *B, unsigned rowCount, unsigned row
                     Z21 += p2 * q1;
                     Z11 += p1 * q1;
 
+                    ptrBElement -= 2 * b_stride;
+                    rowCounter -= 2;
+                }
+
+                /* the inner loop that computes outer products and adds them to Z */
+                for (bool exitLoop = rowCounter == 0; !exitLoop; exitLoop = false)
+                {
+                    dReal q1, p4, p3, p2, p1;
+
                     /* load p and q values */
-                    q1 = ptrBElement[4 * b_stride];
+                    q1 = ptrBElement[0 * (int)b_stride];
                     p4 = ptrLElement[-3];
                     p3 = ptrLElement[-2];
                     p2 = ptrLElement[-1];
@@ -299,7 +194,7 @@ void solveL1Transposed(const dReal *L, dReal *B, unsigned rowCount, unsigned row
                     Z11 += p1 * q1;
 
                     /* load p and q values */
-                    q1 = ptrBElement[3 * b_stride];
+                    q1 = ptrBElement[-1 * (int)b_stride];
                     p4 = ptrLElement[-3];
                     p3 = ptrLElement[-2];
                     p2 = ptrLElement[-1];
@@ -313,7 +208,7 @@ void solveL1Transposed(const dReal *L, dReal *B, unsigned rowCount, unsigned row
                     Z11 += p1 * q1;
 
                     /* load p and q values */
-                    q1 = ptrBElement[2 * b_stride];
+                    q1 = ptrBElement[-2 * (int)b_stride];
                     p4 = ptrLElement[-3];
                     p3 = ptrLElement[-2];
                     p2 = ptrLElement[-1];
@@ -327,7 +222,7 @@ void solveL1Transposed(const dReal *L, dReal *B, unsigned rowCount, unsigned row
                     Z11 += p1 * q1;
 
                     /* load p and q values */
-                    q1 = ptrBElement[1 * b_stride];
+                    q1 = ptrBElement[-3 * (int)b_stride];
                     p4 = ptrLElement[-3];
                     p3 = ptrLElement[-2];
                     p2 = ptrLElement[-1];
@@ -339,17 +234,136 @@ void solveL1Transposed(const dReal *L, dReal *B, unsigned rowCount, unsigned row
                     Z31 += p3 * q1;
                     Z21 += p2 * q1;
                     Z11 += p1 * q1;
-                }
-                else
-                {
-                    ptrBElement -= 4 * b_stride;
 
-                    if ((rowCounter -= 4) == 0)
+                    if (rowCounter > 12)
                     {
-                        break;
+                        rowCounter -= 12;
+
+                        ptrBElement -= 12 * b_stride;
+
+                        /* load p and q values */
+                        q1 = ptrBElement[8 * b_stride];
+                        p4 = ptrLElement[-3];
+                        p3 = ptrLElement[-2];
+                        p2 = ptrLElement[-1];
+                        p1 = ptrLElement[0];
+                        ptrLElement -= rowSkip;
+
+                        /* compute outer product and add it to the Z matrix */
+                        Z41 += p4 * q1;
+                        Z31 += p3 * q1;
+                        Z21 += p2 * q1;
+                        Z11 += p1 * q1;
+
+                        /* load p and q values */
+                        q1 = ptrBElement[7 * b_stride];
+                        p4 = ptrLElement[-3];
+                        p3 = ptrLElement[-2];
+                        p2 = ptrLElement[-1];
+                        p1 = ptrLElement[0];
+                        ptrLElement -= rowSkip;
+
+                        /* compute outer product and add it to the Z matrix */
+                        Z41 += p4 * q1;
+                        Z31 += p3 * q1;
+                        Z21 += p2 * q1;
+                        Z11 += p1 * q1;
+
+                        /* load p and q values */
+                        q1 = ptrBElement[6 * b_stride];
+                        p4 = ptrLElement[-3];
+                        p3 = ptrLElement[-2];
+                        p2 = ptrLElement[-1];
+                        p1 = ptrLElement[0];
+                        ptrLElement -= rowSkip;
+
+                        /* compute outer product and add it to the Z matrix */
+                        Z41 += p4 * q1;
+                        Z31 += p3 * q1;
+                        Z21 += p2 * q1;
+                        Z11 += p1 * q1;
+
+                        /* load p and q values */
+                        q1 = ptrBElement[5 * b_stride];
+                        p4 = ptrLElement[-3];
+                        p3 = ptrLElement[-2];
+                        p2 = ptrLElement[-1];
+                        p1 = ptrLElement[0];
+                        ptrLElement -= rowSkip;
+
+                        /* compute outer product and add it to the Z matrix */
+                        Z41 += p4 * q1;
+                        Z31 += p3 * q1;
+                        Z21 += p2 * q1;
+                        Z11 += p1 * q1;
+
+                        /* load p and q values */
+                        q1 = ptrBElement[4 * b_stride];
+                        p4 = ptrLElement[-3];
+                        p3 = ptrLElement[-2];
+                        p2 = ptrLElement[-1];
+                        p1 = ptrLElement[0];
+                        ptrLElement -= rowSkip;
+
+                        /* compute outer product and add it to the Z matrix */
+                        Z41 += p4 * q1;
+                        Z31 += p3 * q1;
+                        Z21 += p2 * q1;
+                        Z11 += p1 * q1;
+
+                        /* load p and q values */
+                        q1 = ptrBElement[3 * b_stride];
+                        p4 = ptrLElement[-3];
+                        p3 = ptrLElement[-2];
+                        p2 = ptrLElement[-1];
+                        p1 = ptrLElement[0];
+                        ptrLElement -= rowSkip;
+
+                        /* compute outer product and add it to the Z matrix */
+                        Z41 += p4 * q1;
+                        Z31 += p3 * q1;
+                        Z21 += p2 * q1;
+                        Z11 += p1 * q1;
+
+                        /* load p and q values */
+                        q1 = ptrBElement[2 * b_stride];
+                        p4 = ptrLElement[-3];
+                        p3 = ptrLElement[-2];
+                        p2 = ptrLElement[-1];
+                        p1 = ptrLElement[0];
+                        ptrLElement -= rowSkip;
+
+                        /* compute outer product and add it to the Z matrix */
+                        Z41 += p4 * q1;
+                        Z31 += p3 * q1;
+                        Z21 += p2 * q1;
+                        Z11 += p1 * q1;
+
+                        /* load p and q values */
+                        q1 = ptrBElement[1 * b_stride];
+                        p4 = ptrLElement[-3];
+                        p3 = ptrLElement[-2];
+                        p2 = ptrLElement[-1];
+                        p1 = ptrLElement[0];
+                        ptrLElement -= rowSkip;
+
+                        /* compute outer product and add it to the Z matrix */
+                        Z41 += p4 * q1;
+                        Z31 += p3 * q1;
+                        Z21 += p2 * q1;
+                        Z11 += p1 * q1;
                     }
+                    else
+                    {
+                        ptrBElement -= 4 * b_stride;
+
+                        if ((rowCounter -= 4) == 0)
+                        {
+                            break;
+                        }
+                    }
+                    /* end of inner loop */
                 }
-                /* end of inner loop */
             }
         }
         else
@@ -0,0 +1,607 @@
+
+
+/*************************************************************************
+ *                                                                       *
+ * Open Dynamics Engine, Copyright (C) 2001,2002 Russell L. Smith.       *
+ * All rights reserved.  Email: russ@q12.org   Web: www.q12.org          *
+ *                                                                       *
+ * This library is free software; you can redistribute it and/or         *
+ * modify it under the terms of EITHER:                                  *
+ *   (1) The GNU Lesser General Public License as published by the Free  *
+ *       Software Foundation; either version 2.1 of the License, or (at  *
+ *       your option) any later version. The text of the GNU Lesser      *
+ *       General Public License is included with this library in the     *
+ *       file LICENSE.TXT.                                               *
+ *   (2) The BSD-style license that is included with this library in     *
+ *       the file LICENSE-BSD.TXT.                                       *
+ *                                                                       *
+ * This library is distributed in the hope that it will be useful,       *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the files    *
+ * LICENSE.TXT and LICENSE-BSD.TXT for more details.                     *
+ *                                                                       *
+ *************************************************************************/
+
+/*
+ * AVX2 and AVX-512 inner loops of the fast dot product, LDLT factorization
+ * and L1 solving kernels.
+ *
+ * The blocked kernels keep their blocking and only hand the long
+ * accumulation loops over their already computed columns (rows for
+ * the transposed solve) to the functions below. The instruction set is
+ * selected at run time, so the library still runs on CPUs without AVX2.
+ * The vector loops sum the products in a different order than the scalar
+ * ones and may use fused multiply-adds, so the results can differ from
+ * the generic code in the last bits.
+ */
+
+#ifndef _ODE_FASTSIMD_IMPL_H_
+#define _ODE_FASTSIMD_IMPL_H_
+
+
+#if !defined(dxFAST_KERNELS_SIMD)
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__) && !defined(__INTEL_COMPILER)
+#define dxFAST_KERNELS_SIMD 1
+#else
+#define dxFAST_KERNELS_SIMD 0
+#endif
+#endif
+
+// Shorter accumulations are left to the scalar code
+#if !defined(dxFAST_KERNELS_SIMD_MIN_LENGTH)
+#define dxFAST_KERNELS_SIMD_MIN_LENGTH 16U
+#endif
+
+
+enum dxFastKernelSet
+{
+    FKS__MIN,
+
+    FKS_GENERIC = FKS__MIN,
+    FKS_AVX2,
+    FKS_AVX512,
+
+    FKS__MAX,
+};
+
+static inline
+dxFastKernelSet dxSelectFastKernelSet()
+{
+    dxFastKernelSet result = FKS_GENERIC;
+
+#if dxFAST_KERNELS_SIMD
+
+    if (__builtin_cpu_supports("avx512f")) {
+        result = FKS_AVX512;
+    }
+    else if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma")) {
+        result = FKS_AVX2;
+    }
+
+
+#endif // #if dxFAST_KERNELS_SIMD
+
+    return result;
+}
+
+
+#if dxFAST_KERNELS_SIMD
+
+#include <immintrin.h>
+
+#define dxFAST_KERNELS_TARGET_AVX2      __attribute__((target("avx2,fma")))
+#define dxFAST_KERNELS_TARGET_AVX512    __attribute__((target("avx512f,avx2,fma")))
+
+#if defined(dDOUBLE)
+
+#define dxAVX2_LANES                    4U
+#define dxAVX2_VECTOR                   __m256d
+#define dxAVX2_ZERO()                   _mm256_setzero_pd()
+#define dxAVX2_LOAD(p)                  _mm256_loadu_pd(p)
+#define dxAVX2_STORE(p, v)              _mm256_storeu_pd(p, v)
+#define dxAVX2_ADD(a, b)                _mm256_add_pd(a, b)
+#define dxAVX2_MUL(a, b)                _mm256_mul_pd(a, b)
+#define dxAVX2_FMADD(a, b, c)           _mm256_fmadd_pd(a, b, c)
+
+// Four consecutive matrix columns
+#define dxCOLUMNS4_VECTOR               __m256d
+#define dxCOLUMNS4_ZERO()               _mm256_setzero_pd()
+#define dxCOLUMNS4_LOAD(p)              _mm256_loadu_pd(p)
+#define dxCOLUMNS4_STORE(p, v)          _mm256_storeu_pd(p, v)
+#define dxCOLUMNS4_SET1(s)              _mm256_set1_pd(s)
+#define dxCOLUMNS4_ADD(a, b)            _mm256_add_pd(a, b)
+#define dxCOLUMNS4_FMADD(a, b, c)       _mm256_fmadd_pd(a, b, c)
+
+#define dxAVX512_LANES                  8U
+#define dxAVX512_VECTOR                 __m512d
+#define dxAVX512_ZERO()                 _mm512_setzero_pd()
+#define dxAVX512_LOAD(p)                _mm512_loadu_pd(p)
+#define dxAVX512_STORE(p, v)            _mm512_storeu_pd(p, v)
+#define dxAVX512_ADD(a, b)              _mm512_add_pd(a, b)
+#define dxAVX512_MUL(a, b)              _mm512_mul_pd(a, b)
+#define dxAVX512_FMADD(a, b, c)         _mm512_fmadd_pd(a, b, c)
+
+
+#else // #if !defined(dDOUBLE)
+
+#define dxAVX2_LANES                    8U
+#define dxAVX2_VECTOR                   __m256
+#define dxAVX2_ZERO()                   _mm256_setzero_ps()
+#define dxAVX2_LOAD(p)                  _mm256_loadu_ps(p)
+#define dxAVX2_STORE(p, v)              _mm256_storeu_ps(p, v)
+#define dxAVX2_ADD(a, b)                _mm256_add_ps(a, b)
+#define dxAVX2_MUL(a, b)                _mm256_mul_ps(a, b)
+#define dxAVX2_FMADD(a, b, c)           _mm256_fmadd_ps(a, b, c)
+
+#define dxCOLUMNS4_VECTOR               __m128
+#define dxCOLUMNS4_ZERO()               _mm_setzero_ps()
+#define dxCOLUMNS4_LOAD(p)              _mm_loadu_ps(p)
+#define dxCOLUMNS4_STORE(p, v)          _mm_storeu_ps(p, v)
+#define dxCOLUMNS4_SET1(s)              _mm_set1_ps(s)
+#define dxCOLUMNS4_ADD(a, b)            _mm_add_ps(a, b)
+#define dxCOLUMNS4_FMADD(a, b, c)       _mm_fmadd_ps(a, b, c)
+
+#define dxAVX512_LANES                  16U
+#define dxAVX512_VECTOR                 __m512
+#define dxAVX512_ZERO()                 _mm512_setzero_ps()
+#define dxAVX512_LOAD(p)                _mm512_loadu_ps(p)
+#define dxAVX512_STORE(p, v)            _mm512_storeu_ps(p, v)
+#define dxAVX512_ADD(a, b)              _mm512_add_ps(a, b)
+#define dxAVX512_MUL(a, b)              _mm512_mul_ps(a, b)
+#define dxAVX512_FMADD(a, b, c)         _mm512_fmadd_ps(a, b, c)
+
+
+#endif // #if !defined(dDOUBLE)
+
+
+//////////////////////////////////////////////////////////////////////////
+// Vector loads and sums
+
+dxFAST_KERNELS_TARGET_AVX2
+static inline
+dReal dxAVX2_Sum(dxAVX2_VECTOR v)
+{
+#if defined(dDOUBLE)
+    __m128d pairs = _mm_add_pd(_mm256_castpd256_pd128(v), _mm256_extractf128_pd(v, 1));
+    return _mm_cvtsd_f64(_mm_add_sd(pairs, _mm_unpackhi_pd(pairs, pairs)));
+#else
+    __m128 quads = _mm_add_ps(_mm256_castps256_ps128(v), _mm256_extractf128_ps(v, 1));
+    __m128 pairs = _mm_add_ps(quads, _mm_movehl_ps(quads, quads));
+    return _mm_cvtss_f32(_mm_add_ss(pairs, _mm_shuffle_ps(pairs, pairs, _MM_SHUFFLE(1, 1, 1, 1))));
+#endif
+}
+
+// The halves are extracted with zero masking. GCC's unmasked extracts, which
+// _mm512_reduce_add_pd and the 512 to 256 bit casts are built on, pass an
+// undefined vector that -Wall reports as used uninitialized.
+dxFAST_KERNELS_TARGET_AVX512
+static inline
+dReal dxAVX512_Sum(dxAVX512_VECTOR v)
+{
+#if defined(dDOUBLE)
+    __m256d lower = _mm512_maskz_extractf64x4_pd(0xF, v, 0);
+    __m256d upper = _mm512_maskz_extractf64x4_pd(0xF, v, 1);
+    return dxAVX2_Sum(_mm256_add_pd(lower, upper));
+#else
+    // 256 bit float extracts need AVX512DQ; the halves are the same bits
+    __m512d bits = _mm512_castps_pd(v);
+    __m256 lower = _mm256_castpd_ps(_mm512_maskz_extractf64x4_pd(0xF, bits, 0));
+    __m256 upper = _mm256_castpd_ps(_mm512_maskz_extractf64x4_pd(0xF, bits, 1));
+    return dxAVX2_Sum(_mm256_add_ps(lower, upper));
+#endif
+}
+
+// Strided loads only support the element pair arrays of the LCP (stride 2).
+// The second vector is loaded so that it ends at the last element needed,
+// since the pointer may be at the second member of the pairs.
+template<unsigned int stride>
+dxFAST_KERNELS_TARGET_AVX2
+static inline
+dxAVX2_VECTOR dxAVX2_LoadStrided(const dReal *p)
+{
+    dSASSERT(stride == 1 || stride == 2);
+
+    dxAVX2_VECTOR result;
+
+    if (stride == 1) {
+        result = dxAVX2_LOAD(p);
+    }
+    else {
+#if defined(dDOUBLE)
+        // p0 p4 p2 p6
+        __m256d mixed = _mm256_blend_pd(_mm256_loadu_pd(p), _mm256_loadu_pd(p + 3), 0xA);
+        result = _mm256_permute4x64_pd(mixed, _MM_SHUFFLE(3, 1, 2, 0));
+#else
+        // p0 p8 p2 p10 p4 p12 p6 p14
+        __m256 mixed = _mm256_blend_ps(_mm256_loadu_ps(p), _mm256_loadu_ps(p + 7), 0xAA);
+        result = _mm256_permutevar8x32_ps(mixed, _mm256_setr_epi32(0, 2, 4, 6, 1, 3, 5, 7));
+#endif
+    }
+
+    return result;
+}
+
+template<unsigned int stride>
+dxFAST_KERNELS_TARGET_AVX512
+static inline
+dxAVX512_VECTOR dxAVX512_LoadStrided(const dReal *p)
+{
+    dSASSERT(stride == 1 || stride == 2);
+
+    dxAVX512_VECTOR result;
+
+    if (stride == 1) {
+        result = dxAVX512_LOAD(p);
+    }
+    else {
+#if defined(dDOUBLE)
+        const __m512i evens = _mm512_set_epi64(15, 13, 11, 9, 6, 4, 2, 0);
+        result = _mm512_permutex2var_pd(_mm512_loadu_pd(p), evens, _mm512_loadu_pd(p + 7));
+#else
+        const __m512i evens = _mm512_set_epi32(31, 29, 27, 25, 23, 21, 19, 17, 14, 12, 10, 8, 6, 4, 2, 0);
+        result = _mm512_permutex2var_ps(_mm512_loadu_ps(p), evens, _mm512_loadu_ps(p + 15));
+#endif
+    }
+
+    return result;
+}
+
+
+//////////////////////////////////////////////////////////////////////////
+// a . b with a stored contiguously and b with b_stride
+
+template<unsigned int b_stride>
+dxFAST_KERNELS_TARGET_AVX2
+static
+dReal dxFastDot_AVX2(const dReal *a, const dReal *b, unsigned n)
+{
+    dxAVX2_VECTOR sum0 = dxAVX2_ZERO(), sum1 = dxAVX2_ZERO();
+
+    unsigned i = 0;
+    for (; i + 2 * dxAVX2_LANES <= n; i += 2 * dxAVX2_LANES) {
+        sum0 = dxAVX2_FMADD(dxAVX2_LOAD(a + i), dxAVX2_LoadStrided<b_stride>(b + (sizeint)i * b_stride), sum0);
+        sum1 = dxAVX2_FMADD(dxAVX2_LOAD(a + i + dxAVX2_LANES), dxAVX2_LoadStrided<b_stride>(b + (sizeint)(i + dxAVX2_LANES) * b_stride), sum1);
+    }
+    if (i + dxAVX2_LANES <= n) {
+        sum0 = dxAVX2_FMADD(dxAVX2_LOAD(a + i), dxAVX2_LoadStrided<b_stride>(b + (sizeint)i * b_stride), sum0);
+        i += dxAVX2_LANES;
+    }
+
+    dReal sum = dxAVX2_Sum(dxAVX2_ADD(sum0, sum1));
+    for (; i != n; ++i) {
+        sum += a[i] * b[(sizeint)i * b_stride];
+    }
+    return sum;
+}
+
+template<unsigned int b_stride>
+dxFAST_KERNELS_TARGET_AVX512
+static
+dReal dxFastDot_AVX512(const dReal *a, const dReal *b, unsigned n)
+{
+    dxAVX512_VECTOR sum0 = dxAVX512_ZERO(), sum1 = dxAVX512_ZERO();
+
+    unsigned i = 0;
+    for (; i + 2 * dxAVX512_LANES <= n; i += 2 * dxAVX512_LANES) {
+        sum0 = dxAVX512_FMADD(dxAVX512_LOAD(a + i), dxAVX512_LoadStrided<b_stride>(b + (sizeint)i * b_stride), sum0);
+        sum1 = dxAVX512_FMADD(dxAVX512_LOAD(a + i + dxAVX512_LANES), dxAVX512_LoadStrided<b_stride>(b + (sizeint)(i + dxAVX512_LANES) * b_stride), sum1);
+    }
+    if (i + dxAVX512_LANES <= n) {
+        sum0 = dxAVX512_FMADD(dxAVX512_LOAD(a + i), dxAVX512_LoadStrided<b_stride>(b + (sizeint)i * b_stride), sum0);
+        i += dxAVX512_LANES;
+    }
+
+    dReal sum = dxAVX512_Sum(dxAVX512_ADD(sum0, sum1));
+    for (; i != n; ++i) {
+        sum += a[i] * b[(sizeint)i * b_stride];
+    }
+    return sum;
+}
+
+
+//////////////////////////////////////////////////////////////////////////
+// Z[k] = L(k,:) . b for the 4 consecutive rows of L at rowSkip distances
+
+template<unsigned int b_stride>
+dxFAST_KERNELS_TARGET_AVX2
+static
+void dxFastDot4Rows_AVX2(dReal Z[4], const dReal *L, unsigned rowSkip, const dReal *b, unsigned n)
+{
+    const dReal *L0 = L, *L1 = L0 + rowSkip, *L2 = L1 + rowSkip, *L3 = L2 + rowSkip;
+    dxAVX2_VECTOR sum0 = dxAVX2_ZERO(), sum1 = dxAVX2_ZERO(), sum2 = dxAVX2_ZERO(), sum3 = dxAVX2_ZERO();
+
+    unsigned i = 0;
+    for (; i + dxAVX2_LANES <= n; i += dxAVX2_LANES) {
+        dxAVX2_VECTOR q = dxAVX2_LoadStrided<b_stride>(b + (sizeint)i * b_stride);
+        sum0 = dxAVX2_FMADD(dxAVX2_LOAD(L0 + i), q, sum0);
+        sum1 = dxAVX2_FMADD(dxAVX2_LOAD(L1 + i), q, sum1);
+        sum2 = dxAVX2_FMADD(dxAVX2_LOAD(L2 + i), q, sum2);
+        sum3 = dxAVX2_FMADD(dxAVX2_LOAD(L3 + i), q, sum3);
+    }
+
+    dReal Z0 = dxAVX2_Sum(sum0), Z1 = dxAVX2_Sum(sum1), Z2 = dxAVX2_Sum(sum2), Z3 = dxAVX2_Sum(sum3);
+    for (; i != n; ++i) {
+        dReal q = b[(sizeint)i * b_stride];
+        Z0 += L0[i] * q;
+        Z1 += L1[i] * q;
+        Z2 += L2[i] * q;
+        Z3 += L3[i] * q;
+    }
+    Z[0] = Z0; Z[1] = Z1; Z[2] = Z2; Z[3] = Z3;
+}
+
+template<unsigned int b_stride>
+dxFAST_KERNELS_TARGET_AVX512
+static
+void dxFastDot4Rows_AVX512(dReal Z[4], const dReal *L, unsigned rowSkip, const dReal *b, unsigned n)
+{
+    const dReal *L0 = L, *L1 = L0 + rowSkip, *L2 = L1 + rowSkip, *L3 = L2 + rowSkip;
+    dxAVX512_VECTOR sum0 = dxAVX512_ZERO(), sum1 = dxAVX512_ZERO(), sum2 = dxAVX512_ZERO(), sum3 = dxAVX512_ZERO();
+
+    unsigned i = 0;
+    for (; i + dxAVX512_LANES <= n; i += dxAVX512_LANES) {
+        dxAVX512_VECTOR q = dxAVX512_LoadStrided<b_stride>(b + (sizeint)i * b_stride);
+        sum0 = dxAVX512_FMADD(dxAVX512_LOAD(L0 + i), q, sum0);
+        sum1 = dxAVX512_FMADD(dxAVX512_LOAD(L1 + i), q, sum1);
+        sum2 = dxAVX512_FMADD(dxAVX512_LOAD(L2 + i), q, sum2);
+        sum3 = dxAVX512_FMADD(dxAVX512_LOAD(L3 + i), q, sum3);
+    }
+
+    dReal Z0 = dxAVX512_Sum(sum0), Z1 = dxAVX512_Sum(sum1), Z2 = dxAVX512_Sum(sum2), Z3 = dxAVX512_Sum(sum3);
+    for (; i != n; ++i) {
+        dReal q = b[(sizeint)i * b_stride];
+        Z0 += L0[i] * q;
+        Z1 += L1[i] * q;
+        Z2 += L2[i] * q;
+        Z3 += L3[i] * q;
+    }
+    Z[0] = Z0; Z[1] = Z1; Z[2] = Z2; Z[3] = Z3;
+}
+
+
+//////////////////////////////////////////////////////////////////////////
+// The 2 x 2 outer product matrix Z = L * B' of the row pairs starting at L and B
+// (Z[0] = Z11, Z[1] = Z12, Z[2] = Z21, Z[3] = Z22)
+
+dxFAST_KERNELS_TARGET_AVX2
+static
+void dxFastDot2x2_AVX2(dReal Z[4], const dReal *L, const dReal *B, unsigned rowSkip, unsigned n)
+{
+    const dReal *L1 = L, *L2 = L + rowSkip, *B1 = B, *B2 = B + rowSkip;
+    dxAVX2_VECTOR sum11 = dxAVX2_ZERO(), sum12 = dxAVX2_ZERO(), sum21 = dxAVX2_ZERO(), sum22 = dxAVX2_ZERO();
+
+    unsigned i = 0;
+    for (; i + dxAVX2_LANES <= n; i += dxAVX2_LANES) {
+        dxAVX2_VECTOR p1 = dxAVX2_LOAD(L1 + i), p2 = dxAVX2_LOAD(L2 + i);
+        dxAVX2_VECTOR q1 = dxAVX2_LOAD(B1 + i), q2 = dxAVX2_LOAD(B2 + i);
+        sum11 = dxAVX2_FMADD(p1, q1, sum11);
+        sum12 = dxAVX2_FMADD(p1, q2, sum12);
+        sum21 = dxAVX2_FMADD(p2, q1, sum21);
+        sum22 = dxAVX2_FMADD(p2, q2, sum22);
+    }
+
+    dReal Z11 = dxAVX2_Sum(sum11), Z12 = dxAVX2_Sum(sum12), Z21 = dxAVX2_Sum(sum21), Z22 = dxAVX2_Sum(sum22);
+    for (; i != n; ++i) {
+        dReal p1 = L1[i], p2 = L2[i], q1 = B1[i], q2 = B2[i];
+        Z11 += p1 * q1;
+        Z12 += p1 * q2;
+        Z21 += p2 * q1;
+        Z22 += p2 * q2;
+    }
+    Z[0] = Z11; Z[1] = Z12; Z[2] = Z21; Z[3] = Z22;
+}
+
+dxFAST_KERNELS_TARGET_AVX512
+static
+void dxFastDot2x2_AVX512(dReal Z[4], const dReal *L, const dReal *B, unsigned rowSkip, unsigned n)
+{
+    const dReal *L1 = L, *L2 = L + rowSkip, *B1 = B, *B2 = B + rowSkip;
+    dxAVX512_VECTOR sum11 = dxAVX512_ZERO(), sum12 = dxAVX512_ZERO(), sum21 = dxAVX512_ZERO(), sum22 = dxAVX512_ZERO();
+
+    unsigned i = 0;
+    for (; i + dxAVX512_LANES <= n; i += dxAVX512_LANES) {
+        dxAVX512_VECTOR p1 = dxAVX512_LOAD(L1 + i), p2 = dxAVX512_LOAD(L2 + i);
+        dxAVX512_VECTOR q1 = dxAVX512_LOAD(B1 + i), q2 = dxAVX512_LOAD(B2 + i);
+        sum11 = dxAVX512_FMADD(p1, q1, sum11);
+        sum12 = dxAVX512_FMADD(p1, q2, sum12);
+        sum21 = dxAVX512_FMADD(p2, q1, sum21);
+        sum22 = dxAVX512_FMADD(p2, q2, sum22);
+    }
+
+    dReal Z11 = dxAVX512_Sum(sum11), Z12 = dxAVX512_Sum(sum12), Z21 = dxAVX512_Sum(sum21), Z22 = dxAVX512_Sum(sum22);
+    for (; i != n; ++i) {
+        dReal p1 = L1[i], p2 = L2[i], q1 = B1[i], q2 = B2[i];
+        Z11 += p1 * q1;
+        Z12 += p1 * q2;
+        Z21 += p2 * q1;
+        Z22 += p2 * q2;
+    }
+    Z[0] = Z11; Z[1] = Z12; Z[2] = Z21; Z[3] = Z22;
+}
+
+
+//////////////////////////////////////////////////////////////////////////
+// Scale the row pair starting at A by d and compute the outer product
+// matrix of the original and the scaled rows
+// (Z[0] = Z11, Z[1] = Z21, Z[2] = Z22)
+
+template<unsigned int d_stride>
+dxFAST_KERNELS_TARGET_AVX2
+static
+void dxFastScaleDot2_AVX2(dReal Z[3], dReal *A, unsigned rowSkip, const dReal *d, unsigned n)
+{
+    dReal *A1 = A, *A2 = A + rowSkip;
+    dxAVX2_VECTOR sum11 = dxAVX2_ZERO(), sum21 = dxAVX2_ZERO(), sum22 = dxAVX2_ZERO();
+
+    unsigned i = 0;
+    for (; i + dxAVX2_LANES <= n; i += dxAVX2_LANES) {
+        dxAVX2_VECTOR p1 = dxAVX2_LOAD(A1 + i), p2 = dxAVX2_LOAD(A2 + i);
+        dxAVX2_VECTOR dd = dxAVX2_LoadStrided<d_stride>(d + (sizeint)i * d_stride);
+        dxAVX2_VECTOR q1 = dxAVX2_MUL(p1, dd), q2 = dxAVX2_MUL(p2, dd);
+        dxAVX2_STORE(A1 + i, q1);
+        dxAVX2_STORE(A2 + i, q2);
+        sum11 = dxAVX2_FMADD(p1, q1, sum11);
+        sum21 = dxAVX2_FMADD(p2, q1, sum21);
+        sum22 = dxAVX2_FMADD(p2, q2, sum22);
+    }
+
+    dReal Z11 = dxAVX2_Sum(sum11), Z21 = dxAVX2_Sum(sum21), Z22 = dxAVX2_Sum(sum22);
+    for (; i != n; ++i) {
+        dReal p1 = A1[i], p2 = A2[i], dd = d[(sizeint)i * d_stride];
+        dReal q1 = p1 * dd, q2 = p2 * dd;
+        A1[i] = q1;
+        A2[i] = q2;
+        Z11 += p1 * q1;
+        Z21 += p2 * q1;
+        Z22 += p2 * q2;
+    }
+    Z[0] = Z11; Z[1] = Z21; Z[2] = Z22;
+}
+
+template<unsigned int d_stride>
+dxFAST_KERNELS_TARGET_AVX512
+static
+void dxFastScaleDot2_AVX512(dReal Z[3], dReal *A, unsigned rowSkip, const dReal *d, unsigned n)
+{
+    dReal *A1 = A, *A2 = A + rowSkip;
+    dxAVX512_VECTOR sum11 = dxAVX512_ZERO(), sum21 = dxAVX512_ZERO(), sum22 = dxAVX512_ZERO();
+
+    unsigned i = 0;
+    for (; i + dxAVX512_LANES <= n; i += dxAVX512_LANES) {
+        dxAVX512_VECTOR p1 = dxAVX512_LOAD(A1 + i), p2 = dxAVX512_LOAD(A2 + i);
+        dxAVX512_VECTOR dd = dxAVX512_LoadStrided<d_stride>(d + (sizeint)i * d_stride);
+        dxAVX512_VECTOR q1 = dxAVX512_MUL(p1, dd), q2 = dxAVX512_MUL(p2, dd);
+        dxAVX512_STORE(A1 + i, q1);
+        dxAVX512_STORE(A2 + i, q2);
+        sum11 = dxAVX512_FMADD(p1, q1, sum11);
+        sum21 = dxAVX512_FMADD(p2, q1, sum21);
+        sum22 = dxAVX512_FMADD(p2, q2, sum22);
+    }
+
+    dReal Z11 = dxAVX512_Sum(sum11), Z21 = dxAVX512_Sum(sum21), Z22 = dxAVX512_Sum(sum22);
+    for (; i != n; ++i) {
+        dReal p1 = A1[i], p2 = A2[i], dd = d[(sizeint)i * d_stride];
+        dReal q1 = p1 * dd, q2 = p2 * dd;
+        A1[i] = q1;
+        A2[i] = q2;
+        Z11 += p1 * q1;
+        Z21 += p2 * q1;
+        Z22 += p2 * q2;
+    }
+    Z[0] = Z11; Z[1] = Z21; Z[2] = Z22;
+}
+
+
+//////////////////////////////////////////////////////////////////////////
+// Z[k] = sum(L(-j,k) * b(-j)), j = 0..n-1, for the 4 consecutive columns
+// starting at L, going up the rows of L and down the elements of b.
+// There are only 4 columns, so AVX-512 CPUs use this one too.
+
+template<unsigned int b_stride>
+dxFAST_KERNELS_TARGET_AVX2
+static
+void dxFastAccumulate4Columns_AVX2(dReal Z[4], const dReal *L, unsigned rowSkip, const dReal *b, unsigned n)
+{
+    dxCOLUMNS4_VECTOR sum0 = dxCOLUMNS4_ZERO(), sum1 = dxCOLUMNS4_ZERO(), sum2 = dxCOLUMNS4_ZERO(), sum3 = dxCOLUMNS4_ZERO();
+
+    unsigned i = 0;
+    for (; i + 4 <= n; i += 4, L -= 4 * (sizeint)rowSkip, b -= 4 * b_stride) {
+        sum0 = dxCOLUMNS4_FMADD(dxCOLUMNS4_LOAD(L), dxCOLUMNS4_SET1(b[0]), sum0);
+        sum1 = dxCOLUMNS4_FMADD(dxCOLUMNS4_LOAD(L - rowSkip), dxCOLUMNS4_SET1(b[-1 * (int)b_stride]), sum1);
+        sum2 = dxCOLUMNS4_FMADD(dxCOLUMNS4_LOAD(L - 2 * (sizeint)rowSkip), dxCOLUMNS4_SET1(b[-2 * (int)b_stride]), sum2);
+        sum3 = dxCOLUMNS4_FMADD(dxCOLUMNS4_LOAD(L - 3 * (sizeint)rowSkip), dxCOLUMNS4_SET1(b[-3 * (int)b_stride]), sum3);
+    }
+    for (; i != n; ++i, L -= rowSkip, b -= b_stride) {
+        sum0 = dxCOLUMNS4_FMADD(dxCOLUMNS4_LOAD(L), dxCOLUMNS4_SET1(b[0]), sum0);
+    }
+
+    dxCOLUMNS4_STORE(Z, dxCOLUMNS4_ADD(dxCOLUMNS4_ADD(sum0, sum1), dxCOLUMNS4_ADD(sum2, sum3)));
+}
+
+
+#endif // #if dxFAST_KERNELS_SIMD
+
+
+//////////////////////////////////////////////////////////////////////////
+// Dispatchers -- these return false if the CPU or the build has no vector
+// kernels or the accumulation is too short and the caller is to run its
+// scalar loop instead
+
+template<unsigned int b_stride>
+static inline
+bool dxFastDot(dReal &out_sum, const dReal *a, const dReal *b, unsigned n)
+{
+#if dxFAST_KERNELS_SIMD
+    if (n >= dxFAST_KERNELS_SIMD_MIN_LENGTH) {
+        switch (dxSelectFastKernelSet()) {
+            case FKS_AVX512: out_sum = dxFastDot_AVX512<b_stride>(a, b, n); return true;
+            case FKS_AVX2: out_sum = dxFastDot_AVX2<b_stride>(a, b, n); return true;
+            default: break;
+        }
+    }
+#endif
+    return false;
+}
+
+template<unsigned int b_stride>
+static inline
+bool dxFastDot4Rows(dReal Z[4], const dReal *L, unsigned rowSkip, const dReal *b, unsigned n)
+{
+#if dxFAST_KERNELS_SIMD
+    if (n >= dxFAST_KERNELS_SIMD_MIN_LENGTH) {
+        switch (dxSelectFastKernelSet()) {
+            case FKS_AVX512: dxFastDot4Rows_AVX512<b_stride>(Z, L, rowSkip, b, n); return true;
+            case FKS_AVX2: dxFastDot4Rows_AVX2<b_stride>(Z, L, rowSkip, b, n); return true;
+            default: break;
+        }
+    }
+#endif
+    return false;
+}
+
+static inline
+bool dxFastDot2x2(dReal Z[4], const dReal *L, const dReal *B, unsigned rowSkip, unsigned n)
+{
+#if dxFAST_KERNELS_SIMD
+    if (n >= dxFAST_KERNELS_SIMD_MIN_LENGTH) {
+        switch (dxSelectFastKernelSet()) {
+            case FKS_AVX512: dxFastDot2x2_AVX512(Z, L, B, rowSkip, n); return true;
+            case FKS_AVX2: dxFastDot2x2_AVX2(Z, L, B, rowSkip, n); return true;
+            default: break;
+        }
+    }
+#endif
+    return false;
+}
+
+template<unsigned int d_stride>
+static inline
+bool dxFastScaleDot2(dReal Z[3], dReal *A, unsigned rowSkip, const dReal *d, unsigned n)
+{
+#if dxFAST_KERNELS_SIMD
+    if (n >= dxFAST_KERNELS_SIMD_MIN_LENGTH) {
+        switch (dxSelectFastKernelSet()) {
+            case FKS_AVX512: dxFastScaleDot2_AVX512<d_stride>(Z, A, rowSkip, d, n); return true;
+            case FKS_AVX2: dxFastScaleDot2_AVX2<d_stride>(Z, A, rowSkip, d, n); return true;
+            default: break;
+        }
+    }
+#endif
+    return false;
+}
+
+template<unsigned int b_stride>
+static inline
+bool dxFastAccumulate4Columns(dReal Z[4], const dReal *L, unsigned rowSkip, const dReal *b, unsigned n)
+{
+#if dxFAST_KERNELS_SIMD
+    if (n >= dxFAST_KERNELS_SIMD_MIN_LENGTH && dxSelectFastKernelSet() != FKS_GENERIC) {
+        dxFastAccumulate4Columns_AVX2<b_stride>(Z, L, rowSkip, b, n);
+        return true;
+    }
+#endif
+    return false;
+}
+
+
+#endif // #ifndef _ODE_FASTSIMD_IMPL_H_
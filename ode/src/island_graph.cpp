@@ -0,0 +1,409 @@
+/*************************************************************************
+ *                                                                       *
+ * Open Dynamics Engine, Copyright (C) 2001,2002 Russell L. Smith.       *
+ * All rights reserved.  Email: russ@q12.org   Web: www.q12.org          *
+ *                                                                       *
+ * This library is free software; you can redistribute it and/or         *
+ * modify it under the terms of EITHER:                                  *
+ *   (1) The GNU Lesser General Public License as published by the Free  *
+ *       Software Foundation; either version 2.1 of the License, or (at  *
+ *       your option) any later version. The text of the GNU Lesser      *
+ *       General Public License is included with this library in the     *
+ *       file LICENSE.TXT.                                               *
+ *   (2) The BSD-style license that is included with this library in     *
+ *       the file LICENSE-BSD.TXT.                                       *
+ *                                                                       *
+ * This library is distributed in the hope that it will be useful,       *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the files    *
+ * LICENSE.TXT and LICENSE-BSD.TXT for more details.                     *
+ *                                                                       *
+ *************************************************************************/
+
+#include <ode/common.h>
+#include "config.h"
+#include "island_graph.h"
+#include "objects.h"
+#include "joints/joint.h"
+#include <algorithm>
+
+
+dxIslandGraph::~dxIslandGraph()
+{
+    // the bodies of the world release their components as they are destroyed
+    dIASSERT (m_active.size() == 0);
+    dIASSERT (m_reserved.size() == 0);
+
+    dxIslandComponent *const *freecurr = m_free.data();
+    for (int i = 0; i != m_free.size(); i++) {
+        dFree (freecurr[i], sizeof(dxIslandComponent));
+    }
+}
+
+
+dxIslandComponent *dxIslandGraph::allocComponent()
+{
+    dxIslandComponent *c;
+    int nfree = m_free.size();
+    if (nfree != 0) {
+        c = m_free[nfree - 1];
+        m_free.setSize (nfree - 1);
+    }
+    else {
+        c = (dxIslandComponent *)dAlloc (sizeof(dxIslandComponent));
+    }
+    c->first = c->last = NULL;
+    c->size = 0;
+    c->joints = 0;
+    c->split = false;
+    c->ordered = true;
+    c->awake = false;
+    c->active = -1;
+    return c;
+}
+
+
+void dxIslandGraph::freeComponent (dxIslandComponent *c)
+{
+    dIASSERT (c->active == -1);
+    m_free.push (c);
+}
+
+
+void dxIslandGraph::insertBody (dxIslandComponent *c, dxBody *b)
+{
+    b->island = c;
+    b->island_next = NULL;
+    b->island_prev = c->last;
+    if (c->last != NULL) {
+        c->last->island_next = b;
+        if (c->last->serial < b->serial) c->ordered = false;
+    }
+    else c->first = b;
+    c->last = b;
+    c->size++;
+}
+
+
+void dxIslandGraph::unlinkBody (dxIslandComponent *c, dxBody *b)
+{
+    if (b->island_prev != NULL) b->island_prev->island_next = b->island_next;
+    else c->first = b->island_next;
+    if (b->island_next != NULL) b->island_next->island_prev = b->island_prev;
+    else c->last = b->island_prev;
+    b->island = NULL;
+    c->size--;
+}
+
+
+void dxIslandGraph::pushActive (dxIslandComponent *c)
+{
+    c->active = m_active.size();
+    m_active.push (c);
+}
+
+
+void dxIslandGraph::addBody (dxBody *b)
+{
+    b->serial = m_serial++;
+    dxIslandComponent *c = allocComponent();
+    insertBody (c, b);
+    pushActive (c);
+}
+
+
+void dxIslandGraph::removeBody (dxBody *b)
+{
+    dxIslandComponent *c = b->island;
+    unlinkBody (c, b);
+
+    // the joints are detached from the body after it has been removed
+    for (dxJointNode *n = b->firstjoint; n != NULL; n = n->next) {
+        c->joints--;
+    }
+
+    if (c->size == 0) {
+        if (c->active != -1) deactivate (c);
+        freeComponent (c);
+    }
+    else if (b->firstjoint != NULL) {
+        // the rest of the component may only have been connected through the body
+        c->split = true;
+    }
+}
+
+
+void dxIslandGraph::attach (dxBody *b1, dxBody *b2)
+{
+    dxIslandComponent *c1 = b1->island;
+    c1->joints++;
+    if (b2 == NULL) return;
+
+    dxIslandComponent *c2 = b2->island;
+    c2->joints++;
+    if (c1 == c2) return;
+
+    // relabel the bodies of the smaller component
+    if (c1->size < c2->size) {
+        dxIslandComponent *tmp = c1; c1 = c2; c2 = tmp;
+    }
+
+    for (dxBody *b = c2->first; b != NULL; b = b->island_next) {
+        b->island = c1;
+    }
+    c1->ordered = c1->ordered && c2->ordered && c1->last->serial > c2->first->serial;
+    c1->last->island_next = c2->first;
+    c2->first->island_prev = c1->last;
+    c1->last = c2->last;
+    c1->size += c2->size;
+    c1->joints += c2->joints;
+    c1->split = c1->split || c2->split;
+
+    if (c2->active != -1) {
+        if (c1->active == -1) {
+            // the merged component takes over the place in the active list
+            c1->active = c2->active;
+            m_active[c1->active] = c1;
+            c2->active = -1;
+        }
+        else {
+            deactivate (c2);
+        }
+    }
+
+    c2->first = c2->last = NULL;
+    c2->size = 0;
+    c2->joints = 0;
+    freeComponent (c2);
+}
+
+
+void dxIslandGraph::detach (dxBody *b1, dxBody *b2)
+{
+    if (b1 != NULL) b1->island->joints--;
+    if (b2 != NULL) b2->island->joints--;
+
+    if (b1 != NULL && b2 != NULL) {
+        dIASSERT (b1->island == b2->island);
+        b1->island->split = true;
+    }
+}
+
+
+void dxIslandGraph::activate (dxBody *b)
+{
+    dxIslandComponent *c = b->island;
+    if (c->active == -1) pushActive (c);
+}
+
+
+// bottom-up merge sort of the list of bodies, the newest first
+void dxIslandGraph::orderBodies (dxIslandComponent *c)
+{
+    dxBody *list = c->first;
+    for (unsigned width = 1; ; width *= 2) {
+        dxBody *head = NULL, **tail = &head;
+        dxBody *p = list;
+        unsigned merges = 0;
+
+        while (p != NULL) {
+            merges++;
+            dxBody *q = p;
+            unsigned psize = 0;
+            for (; psize != width && q != NULL; psize++) q = q->island_next;
+            unsigned qsize = width;
+
+            // merge the runs starting at p and q
+            while (psize != 0 || (qsize != 0 && q != NULL)) {
+                dxBody *e;
+                if (psize != 0 && (qsize == 0 || q == NULL || p->serial > q->serial)) {
+                    e = p; p = p->island_next; psize--;
+                }
+                else {
+                    e = q; q = q->island_next; qsize--;
+                }
+                *tail = e;
+                tail = &e->island_next;
+            }
+            p = q;
+        }
+        *tail = NULL;
+        list = head;
+
+        if (merges <= 1) break;
+    }
+
+    dxBody *prev = NULL;
+    for (dxBody *b = list; b != NULL; b = b->island_next) {
+        b->island_prev = prev;
+        prev = b;
+    }
+    c->first = list;
+    c->last = prev;
+    c->ordered = true;
+}
+
+
+struct dxIslandComponentNewer {
+    bool operator()(const dxIslandComponent *c1, const dxIslandComponent *c2) const {
+        return c1->first->serial > c2->first->serial;
+    }
+};
+
+
+void dxIslandGraph::orderActive()
+{
+    dxIslandComponent **activecurr = m_active.data();
+    const int count = m_active.size();
+
+    bool sorted = true;
+    for (int i = 0; i != count; i++) {
+        dxIslandComponent *c = activecurr[i];
+        if (!c->ordered) orderBodies (c);
+        if (i != 0 && activecurr[i - 1]->first->serial < c->first->serial) sorted = false;
+    }
+
+    if (!sorted) {
+        std::sort (activecurr, activecurr + count, dxIslandComponentNewer());
+        for (int i = 0; i != count; i++) {
+            activecurr[i]->active = i;
+        }
+    }
+}
+
+
+dxBody *dxIslandGraph::firstActiveBody() const
+{
+    // active components are never empty
+    return m_active.size() != 0 ? m_active[0]->first : NULL;
+}
+
+
+dxBody *dxIslandGraph::nextActiveBody (dxBody *b) const
+{
+    if (b->island_next != NULL) return b->island_next;
+
+    int next = b->island->active + 1;
+    dIASSERT (next > 0);
+    return next != m_active.size() ? m_active[next]->first : NULL;
+}
+
+
+void dxIslandGraph::deactivate (dxIslandComponent *c)
+{
+    int i = c->active, last = m_active.size() - 1;
+    dIASSERT (i >= 0 && m_active[i] == c);
+
+    dxIslandComponent *moved = m_active[last];
+    m_active[i] = moved;
+    moved->active = i;
+    m_active.setSize (last);
+    c->active = -1;
+}
+
+
+dxIslandComponent *const *dxIslandGraph::reserveParts (unsigned count)
+{
+    dIASSERT (m_reserved.size() == 0);
+    m_reserved.setSize ((int)count);
+
+    dxIslandComponent **reserved = m_reserved.data();
+    for (unsigned i = 0; i != count; i++) {
+        reserved[i] = allocComponent();
+    }
+    return reserved;
+}
+
+
+unsigned dxIslandGraph::separate (dxIslandComponent *c, dxIslandComponent *const *parts, dxBody **stack)
+{
+    dIASSERT (c->split);
+
+    dxBody *const members = c->first;
+    for (dxBody *b = members; b != NULL; b = b->island_next) {
+        b->island = NULL;
+    }
+
+    // the first part reuses the component
+    c->first = c->last = NULL;
+    c->size = 0;
+    c->joints = 0;
+    c->split = false;
+    c->ordered = true;
+    c->awake = false;
+    dxIslandComponent *part = c;
+    unsigned partcount = 0;
+
+    // label the bodies with their parts
+    for (dxBody *bb = members; bb != NULL; bb = bb->island_next) {
+        if (bb->island != NULL) continue;
+
+        if (part == NULL) {
+            part = parts[partcount++];
+        }
+
+        bb->island = part;
+        unsigned stacksize = 0;
+        stack[stacksize++] = bb;
+
+        while (stacksize != 0) {
+            dxBody *b = stack[--stacksize];
+
+            // any attached joint connects the bodies, enabled or not
+            for (dxJointNode *n = b->firstjoint; n != NULL; n = n->next) {
+                part->joints++;
+                dxBody *nbody = n->body;
+                if (nbody != NULL && nbody->island == NULL) {
+                    nbody->island = part;
+                    stack[stacksize++] = nbody;
+                }
+                dIASSERT (nbody == NULL || nbody->island == part);
+            }
+
+            // the bodies of a sleeping island stay together, whether or not
+            // their joints are still there
+            dxBody *sbody = b->sleep_next;
+            if (sbody != NULL && sbody->island == NULL) {
+                sbody->island = part;
+                stack[stacksize++] = sbody;
+            }
+        }
+
+        part = NULL;
+    }
+
+    // then link them in their previous order
+    dxBody *next;
+    for (dxBody *b = members; b != NULL; b = next) {
+        next = b->island_next;
+        dxIslandComponent *bpart = b->island;
+        insertBody (bpart, b);
+        if ((b->flags & dxBodyDisabled) == 0) bpart->awake = true;
+    }
+
+    return partcount;
+}
+
+
+void dxIslandGraph::commitParts (dxIslandComponent *const *parts, unsigned count)
+{
+    dxIslandComponent **reserved = m_reserved.data();
+    const int offset = (int)(parts - reserved);
+    dIASSERT (offset >= 0 && offset + (int)count <= m_reserved.size());
+
+    for (unsigned i = 0; i != count; i++) {
+        dxIslandComponent *part = reserved[offset + i];
+        if (part->awake) pushActive (part);
+        reserved[offset + i] = NULL;
+    }
+}
+
+
+void dxIslandGraph::releaseParts()
+{
+    dxIslandComponent *const *reserved = m_reserved.data();
+    for (int i = 0; i != m_reserved.size(); i++) {
+        if (reserved[i] != NULL) freeComponent (reserved[i]);
+    }
+    m_reserved.setSize (0);
+}
@@ -0,0 +1,131 @@
+/*************************************************************************
+ *                                                                       *
+ * Open Dynamics Engine, Copyright (C) 2001,2002 Russell L. Smith.       *
+ * All rights reserved.  Email: russ@q12.org   Web: www.q12.org          *
+ *                                                                       *
+ * This library is free software; you can redistribute it and/or         *
+ * modify it under the terms of EITHER:                                  *
+ *   (1) The GNU Lesser General Public License as published by the Free  *
+ *       Software Foundation; either version 2.1 of the License, or (at  *
+ *       your option) any later version. The text of the GNU Lesser      *
+ *       General Public License is included with this library in the     *
+ *       file LICENSE.TXT.                                               *
+ *   (2) The BSD-style license that is included with this library in     *
+ *       the file LICENSE-BSD.TXT.                                       *
+ *                                                                       *
+ * This library is distributed in the hope that it will be useful,       *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the files    *
+ * LICENSE.TXT and LICENSE-BSD.TXT for more details.                     *
+ *                                                                       *
+ *************************************************************************/
+
+// persistent union-find of the bodies connected by joints. the components
+// are merged when a joint is attached to two bodies. detaching a joint or
+// destroying a body only flags the component as possibly split, and the
+// component is separated again the next time it takes part in a step.
+// the bodies of a component are kept in the order of the world list (the
+// newest first), and the active components are visited in the order of
+// their first bodies. the islands are thus built in the same order from
+// step to step, and the order does not depend on the rest of the world.
+// the bodies of a sleeping island count as connected and are never
+// separated.
+// the components that may contain enabled bodies are kept in a list, so
+// that finding the islands does not have to visit the rest of the world.
+// the active components are independent of each other and may be
+// processed by several threads; see separate().
+
+
+#ifndef _ODE__PRIVATE_ISLAND_GRAPH_H_
+#define _ODE__PRIVATE_ISLAND_GRAPH_H_
+
+
+#include <ode/common.h>
+#include "array.h"
+
+
+struct dxBody;
+
+
+struct dxIslandComponent {
+    dxBody *first, *last;	// list of the bodies, linked by dxBody::island_next
+    unsigned size;		// number of bodies
+    unsigned joints;		// number of joint attachments of the bodies
+    bool split;			// a connection was removed since the last separation
+    bool ordered;		// the bodies are in the order of the world list
+    bool awake;			// has enabled bodies (found while building islands)
+    int active;			// index in the list of active components, or -1
+};
+
+
+class dxIslandGraph {
+public:
+    dxIslandGraph(): m_serial(0) {}
+    ~dxIslandGraph();
+
+    // put a new (enabled) body into a component of its own.
+    void addBody (dxBody *b);
+
+    // take a body that is about to be destroyed out of its component.
+    void removeBody (dxBody *b);
+
+    // a joint has been attached to the bodies (b2 may be NULL).
+    void attach (dxBody *b1, dxBody *b2);
+
+    // a joint has been detached from the bodies (either may be NULL).
+    void detach (dxBody *b1, dxBody *b2);
+
+    // the body may have been enabled: visit its component in the next step.
+    void activate (dxBody *b);
+
+    // the components that may contain enabled bodies.
+    unsigned activeCount() const { return (unsigned)m_active.size(); }
+    dxIslandComponent *activeComponent (unsigned i) const { return m_active[(int)i]; }
+
+    // put the bodies of the active components into the order of the world
+    // list, which merging components does not keep, and sort the active
+    // components by their first bodies.
+    void orderActive();
+
+    // iterate over the bodies of the active components.
+    dxBody *firstActiveBody() const;
+    dxBody *nextActiveBody (dxBody *b) const;
+
+    // the component has no enabled bodies left.
+    void deactivate (dxIslandComponent *c);
+
+    // set aside `count' components for the parts of the split components
+    // and return them.
+    dxIslandComponent *const *reserveParts (unsigned count);
+
+    // separate a component flagged as split into its connected parts and
+    // mark the parts that have enabled bodies as awake. the first part
+    // keeps the component, the others are taken in order from `parts',
+    // and their number is returned. `stack' must have room for all the
+    // bodies of the component. only the component and the given parts are
+    // modified, so distinct components may be separated concurrently.
+    unsigned separate (dxIslandComponent *c, dxIslandComponent *const *parts, dxBody **stack);
+
+    // put the parts taken by separate() into use. the awake ones are
+    // added to the active components.
+    void commitParts (dxIslandComponent *const *parts, unsigned count);
+
+    // return the reserved parts that were not taken.
+    void releaseParts();
+
+private:
+    dxIslandComponent *allocComponent();
+    void freeComponent (dxIslandComponent *c);
+    void insertBody (dxIslandComponent *c, dxBody *b);
+    void unlinkBody (dxIslandComponent *c, dxBody *b);
+    void pushActive (dxIslandComponent *c);
+    void orderBodies (dxIslandComponent *c);
+
+    duint64 m_serial;				// creation number of the next body
+    dArray<dxIslandComponent *> m_active;	// components with possibly enabled bodies
+    dArray<dxIslandComponent *> m_free;		// released components for reuse
+    dArray<dxIslandComponent *> m_reserved;	// parts set aside by reserveParts()
+};
+
+
+#endif // #ifndef _ODE__PRIVATE_ISLAND_GRAPH_H_
@@ -53,6 +53,7 @@ dxJoint::dxJoint( dxWorld *w ) :
     node[1].body = 0;
     node[1].next = 0;
     dSetZero( lambda, 6 );
+    serial = w->joint_serial++;
 
     addObjectToList( this, ( dObject ** ) &w->firstjoint );
 
@@ -196,6 +196,7 @@ struct dxJoint : public dObject
     dxJointNode node[2];        // connections to bodies. node[1].body can be 0
     dJointFeedback *feedback;   // optional feedback structure
     dReal lambda[6];            // lambda generated by last step
+    duint64 serial;             // creation number in the world
 
 
     dxJoint( dxWorld *w );
@@ -153,6 +153,12 @@ rows/columns and manipulate C.
 
 #define LMATRIX_ALIGNMENT       dMAX(64, EFFICIENT_ALIGNMENT)
 
+
+// block pivoting parameters
+#define dxLCP_BP_MAX_SOLUTIONS  8   // solutions of A(C,C) tried before giving up
+#define dxLCP_BP_BLOCK_TRIES    3   // block pivots allowed without fewer bad indexes
+#define dxLCP_BP_TOLERANCE      dSqrt(dEpsilon) // relative error allowed on the line segments
+
 //***************************************************************************
 
 
@@ -809,10 +815,12 @@ void dLCP::unpermute_W()
 static void dxSolveLCP_AllUnbounded (dxWorldProcessMemArena *memarena, unsigned n, dReal *A, dReal pairsbx[PBX__MAX]);
 static void dxSolveLCP_Generic (dxWorldProcessMemArena *memarena, unsigned n, dReal *A, dReal pairsbx[PBX__MAX], 
                                 dReal *outer_w/*=NULL*/, unsigned nub, dReal pairslh[PLH__MAX], int *findex);
+static bool dxSolveLCP_BlockPivoting (dxWorldProcessMemArena *memarena, unsigned n, const dReal *A, dReal pairsbx[PBX__MAX], 
+                                      dReal *outer_w/*=NULL*/, unsigned nub, const dReal pairslh[PLH__MAX], const int *findex);
 
 /*extern */
 void dxSolveLCP (dxWorldProcessMemArena *memarena, unsigned n, dReal *A, dReal pairsbx[PBX__MAX],
-    dReal *outer_w/*=NULL*/, unsigned nub, dReal pairslh[PLH__MAX], int *findex)
+    dReal *outer_w/*=NULL*/, unsigned nub, dReal pairslh[PLH__MAX], int *findex, bool warm_start)
 {
     if (nub >= n)
     {
@@ -820,7 +828,17 @@ void dxSolveLCP (dxWorldProcessMemArena *memarena, unsigned n, dReal *A, dReal p
     }
     else
     {
-        dxSolveLCP_Generic (memarena, n, A, pairsbx, outer_w, nub, pairslh, findex);
+        bool solved = false;
+
+        if (warm_start) {
+            BEGIN_STATE_SAVE(memarena, blockstate) {
+                solved = dxSolveLCP_BlockPivoting (memarena, n, A, pairsbx, outer_w, nub, pairslh, findex);
+            } END_STATE_SAVE(memarena, blockstate);
+        }
+
+        if (!solved) {
+            dxSolveLCP_Generic (memarena, n, A, pairsbx, outer_w, nub, pairslh, findex);
+        }
     }
 }
 
@@ -1134,6 +1152,337 @@ void dxSolveLCP_Generic (dxWorldProcessMemArena *memarena, unsigned n, dReal *A,
     lcp.unpermute_X(); // This destroys p[] and must be done last
 }
 
+//***************************************************************************
+// a warm started driver for the lo-hi LCP problem that uses block principal
+// pivoting.
+//
+// on entry the x elements of pairsbx hold an estimate of the solution, e.g.
+// the lambdas of the previous step. the index sets are guessed from it: an x
+// at lo or hi puts the index in N with that state, any other x puts it in C.
+// with x(N) fixed at the limits, A(C,C) is factored as a whole and
+// x(C) = A(C,C) \ (b(C) - A(C,N)*x(N)) is solved. all the indexes that are
+// not on their line segments (x(C) beyond lo or hi, or w(N) pulling x(N) off
+// its limit) then switch sets at once and the system is solved again. to
+// avoid cycling, once the number of bad indexes has not dropped for a few
+// solutions only the last bad index is switched (Murty's rule).
+//
+// friction indexes are handled as in the Dantzig driver: the other indexes
+// are solved first with x=0 for the friction indexes, then lo and hi of the
+// friction indexes are set from that solution and all the indexes are solved.
+// as A is positive definite, the solutions are the ones the Dantzig driver
+// finds.
+//
+// for resting contact the guess is mostly right and the sets settle after
+// one or two solutions, instead of the index by index LDLT updates of the
+// Dantzig driver. false is returned if they do not settle within
+// dxLCP_BP_MAX_SOLUTIONS solutions; pairsbx(x) is then undefined.
+
+enum dxLCPBPState
+{
+    BPS_C,      // i in C
+    BPS_LO,     // i in N, x(i)=lo(i)
+    BPS_HI,     // i in N, x(i)=hi(i)
+};
+
+// y = A*x for the symmetric n*n matrix A of which only the lower triangle
+// is referenced. the leading dimension of A is nskip.
+static 
+void multiplySymmetricLower (dReal *y, const dReal *A, const dReal *x, unsigned n, unsigned nskip)
+{
+    const dReal *Arow = A;
+    for (unsigned i = 0; i != n; Arow += nskip, ++i) {
+        const dReal x_i = x[i];
+        dReal sum = REAL(0.0);
+        for (unsigned j = 0; j != i; ++j) {
+            sum += Arow[j] * x[j];
+            y[j] += Arow[j] * x_i;
+        }
+        y[i] = sum + Arow[i] * x_i;
+    }
+}
+
+struct dLCPBlockPivoting {
+    const unsigned m_n;
+    const unsigned m_nskip;
+    const dReal *const m_A;
+    const dReal *const m_pairsbx;
+    const int *const m_findex;
+    dReal *const m_pairslh;             // limits of the current solution
+    dReal *const m_x, *const m_y;       // x and A*x
+    dReal *const m_L, *const m_d, *const m_tmp; // L*D*L' factorization of A(C,C)
+    unsigned *const m_C;
+    unsigned char *const m_state;
+
+    dLCPBlockPivoting (unsigned _n, unsigned _nskip, const dReal *_A, const dReal *_pairsbx, const int *_findex,
+        dReal *_pairslh, dReal *_x, dReal *_y, dReal *_L, dReal *_d, dReal *_tmp, unsigned *_C, unsigned char *_state):
+        m_n(_n), m_nskip(_nskip), m_A(_A), m_pairsbx(_pairsbx), m_findex(_findex),
+        m_pairslh(_pairslh), m_x(_x), m_y(_y), m_L(_L), m_d(_d), m_tmp(_tmp), m_C(_C), m_state(_state)
+    {
+    }
+
+    bool isFriction (unsigned i) const { return m_findex != NULL && m_findex[i] >= 0; }
+    dReal lo (unsigned i) const { return (m_pairslh + (sizeint)i * PLH__MAX)[PLH_LO]; }
+    dReal hi (unsigned i) const { return (m_pairslh + (sizeint)i * PLH__MAX)[PLH_HI]; }
+    dReal b (unsigned i) const { return (m_pairsbx + (sizeint)i * PBX__MAX)[PBX_B]; }
+    dReal w (unsigned i) const { return m_y[i] - b(i); }
+
+    void solveC (bool with_friction);
+    bool isBad (unsigned i, dReal x_tolerance) const;
+    bool solve (bool with_friction);
+};
+
+// solve x(C) with x(N) at the limits and compute y=A*x. the friction
+// indexes must have x=0 unless `with_friction' is set.
+void dLCPBlockPivoting::solveC (bool with_friction)
+{
+    const unsigned n = m_n;
+    dReal *x = m_x, *y = m_y;
+    unsigned *C = m_C;
+
+    unsigned nC = 0;
+    for (unsigned i = 0; i != n; ++i) {
+        if (m_state[i] == BPS_C && (with_friction || !isFriction(i))) {
+            C[nC++] = i;
+            x[i] = REAL(0.0);
+        }
+    }
+
+    if (nC != 0) {
+        multiplySymmetricLower (y, m_A, x, n, m_nskip);
+
+        // C is ascending, so the lower triangle of A(C,C) comes from the
+        // lower triangle of A
+        const unsigned Lskip = dPAD(nC);
+        dReal *Lrow = m_L, *tmp = m_tmp;
+        for (unsigned r = 0; r != nC; Lrow += Lskip, ++r) {
+            const dReal *Arow = m_A + (sizeint)C[r] * m_nskip;
+            for (unsigned c = 0; c <= r; ++c) Lrow[c] = Arow[C[c]];
+            tmp[r] = b(C[r]) - y[C[r]];
+        }
+
+        factorMatrixAsLDLT<1> (m_L, m_d, nC, Lskip);
+        solveEquationSystemWithLDLT<1, 1> (m_L, m_d, tmp, nC, Lskip);
+
+        for (unsigned r = 0; r != nC; ++r) x[C[r]] = tmp[r];
+    }
+
+    multiplySymmetricLower (y, m_A, x, n, m_nskip);
+}
+
+// see if x(i),w(i) is off its line segment by more than the tolerance
+bool dLCPBlockPivoting::isBad (unsigned i, dReal x_tolerance) const
+{
+    const dReal lo_i = lo(i), hi_i = hi(i);
+    const dReal x_i = m_x[i];
+
+    bool result;
+    if (m_state[i] == BPS_C) {
+        result = x_i < lo_i - x_tolerance || x_i > hi_i + x_tolerance;
+    }
+    else if (lo_i == 0 && hi_i == 0) {
+        // as in the Dantzig driver, indexes with lo=hi=0 stay in N
+        result = false;
+    }
+    else {
+        const dReal w_tolerance = dxLCP_BP_TOLERANCE * (dFabs(m_y[i]) + dFabs(b(i)));
+        const dReal w_i = w(i);
+        result = m_state[i] == BPS_LO ? w_i < -w_tolerance : w_i > w_tolerance;
+    }
+    return result;
+}
+
+// pivot until all the indexes are on their line segments. the friction
+// indexes are left out with x=0 unless `with_friction' is set.
+bool dLCPBlockPivoting::solve (bool with_friction)
+{
+    const unsigned n = m_n;
+    dReal *x = m_x;
+    unsigned char *state = m_state;
+
+    unsigned least_bad = n + 1, block_tries = dxLCP_BP_BLOCK_TRIES;
+    for (unsigned solution = 0; solution != dxLCP_BP_MAX_SOLUTIONS; ++solution) {
+        dReal x_max = REAL(0.0);
+        for (unsigned i = 0; i != n; ++i) {
+            if (!with_friction && isFriction(i)) {
+                x[i] = REAL(0.0);
+            }
+            else if (state[i] != BPS_C) {
+                x[i] = state[i] == BPS_LO ? lo(i) : hi(i);
+                x_max = dMAX(x_max, dFabs(x[i]));
+            }
+        }
+
+        solveC (with_friction);
+
+        for (unsigned i = 0; i != n; ++i) {
+            if (state[i] == BPS_C && (with_friction || !isFriction(i))) {
+                // a singular A(C,C) is left to the Dantzig driver
+                if (!(dFabs(x[i]) < dInfinity)) return false;
+                x_max = dMAX(x_max, dFabs(x[i]));
+            }
+        }
+        const dReal x_tolerance = dxLCP_BP_TOLERANCE * x_max;
+
+        unsigned bad = 0, last_bad = 0;
+        for (unsigned i = 0; i != n; ++i) {
+            if ((with_friction || !isFriction(i)) && isBad(i, x_tolerance)) {
+                bad++;
+                last_bad = i;
+            }
+        }
+
+        if (bad == 0) {
+            // put x(C) onto the line segments
+            for (unsigned i = 0; i != n; ++i) {
+                if (state[i] == BPS_C && (with_friction || !isFriction(i))) {
+                    x[i] = dMIN(dMAX(x[i], lo(i)), hi(i));
+                }
+            }
+            return true;
+        }
+
+        bool block_pivot;
+        if (bad < least_bad) {
+            least_bad = bad;
+            block_tries = dxLCP_BP_BLOCK_TRIES;
+            block_pivot = true;
+        }
+        else if (block_tries != 0) {
+            block_tries--;
+            block_pivot = true;
+        }
+        else {
+            block_pivot = false;
+        }
+
+        for (unsigned i = block_pivot ? 0 : last_bad; i <= last_bad; ++i) {
+            if ((with_friction || !isFriction(i)) && isBad(i, x_tolerance)) {
+                state[i] = state[i] != BPS_C ? BPS_C : (x[i] < lo(i) ? BPS_LO : BPS_HI);
+            }
+        }
+    }
+
+    return false;
+}
+
+static 
+bool dxSolveLCP_BlockPivoting (dxWorldProcessMemArena *memarena, unsigned n, const dReal *A, dReal pairsbx[PBX__MAX],
+    dReal *outer_w/*=NULL*/, unsigned nub, const dReal pairslh[PLH__MAX], const int *findex)
+{
+    dAASSERT (n > 0 && A && pairsbx && pairslh && nub < n);
+
+    // an estimate of zero says nothing about the index sets
+    {
+        bool any_estimate = false;
+        const dReal *endbx = pairsbx + (sizeint)n * PBX__MAX;
+        for (const dReal *currbx = pairsbx; currbx != endbx; currbx += PBX__MAX) {
+            if (currbx[PBX_X] != REAL(0.0)) {
+                any_estimate = true;
+                break;
+            }
+        }
+        if (!any_estimate) {
+            return false;
+        }
+    }
+
+    const unsigned nskip = dPAD(n);
+    dReal *L = memarena->AllocateOveralignedArray<dReal> ((sizeint)nskip * n, LMATRIX_ALIGNMENT);
+    dReal *d = memarena->AllocateArray<dReal> (n);
+    dReal *x = memarena->AllocateArray<dReal> (n);
+    dReal *y = memarena->AllocateArray<dReal> (n);
+    dReal *tmp = memarena->AllocateArray<dReal> (n);
+    dReal *lh = memarena->AllocateArray<dReal> ((sizeint)n * PLH__MAX);
+    unsigned *C = memarena->AllocateArray<unsigned> (n);
+    unsigned char *state = memarena->AllocateArray<unsigned char> (n);
+
+    dLCPBlockPivoting lcp(n, nskip, A, pairsbx, findex, lh, x, y, L, d, tmp, C, state);
+
+    // guess the index sets. the friction limits of the estimate are those
+    // of its own normal forces.
+    bool any_friction = false;
+    for (unsigned i = 0; i != n; ++i) {
+        const dReal *currlh = pairslh + (sizeint)i * PLH__MAX;
+        dReal *currlhtgt = lh + (sizeint)i * PLH__MAX;
+        const dReal x_i = (pairsbx + (sizeint)i * PBX__MAX)[PBX_X];
+
+        dReal lo_i = i < nub ? -dInfinity : currlh[PLH_LO], hi_i = i < nub ? dInfinity : currlh[PLH_HI];
+        currlhtgt[PLH_LO] = lo_i;
+        currlhtgt[PLH_HI] = hi_i;
+
+        if (lcp.isFriction(i)) {
+            any_friction = true;
+            hi_i = dFabs (hi_i * (pairsbx + (sizeint)findex[i] * PBX__MAX)[PBX_X]);
+            lo_i = -hi_i;
+            if (hi_i == 0) {
+                // no friction before, so guess static friction
+                state[i] = BPS_C;
+                continue;
+            }
+        }
+
+        const dReal x_tolerance = dxLCP_BP_TOLERANCE * dFabs(x_i);
+        state[i] = lo_i == 0 && hi_i == 0 ? BPS_LO
+            : x_i <= lo_i + x_tolerance ? BPS_LO
+            : x_i >= hi_i - x_tolerance ? BPS_HI
+            : BPS_C;
+    }
+
+    if (any_friction) {
+        if (!lcp.solve (false)) {
+            return false;
+        }
+
+        // set the friction limits from the normal forces. 0*infinity = 0 here
+        // too, so there is no friction without a normal force.
+        for (unsigned k = 0; k != n; ++k) {
+            if (lcp.isFriction(k)) {
+                dReal *currlh = lh + (sizeint)k * PLH__MAX;
+                const dReal wfk = x[findex[k]];
+                if (wfk == 0) {
+                    currlh[PLH_HI] = 0;
+                    currlh[PLH_LO] = 0;
+                    state[k] = BPS_LO;
+                }
+                else {
+                    currlh[PLH_HI] = dFabs (currlh[PLH_HI] * wfk);
+                    currlh[PLH_LO] = -currlh[PLH_HI];
+                }
+            }
+        }
+    }
+
+    if (!lcp.solve (true)) {
+        return false;
+    }
+
+    for (unsigned i = 0; i != n; ++i) {
+        (pairsbx + (sizeint)i * PBX__MAX)[PBX_X] = x[i];
+    }
+    if (outer_w != NULL) {
+        for (unsigned i = 0; i != n; ++i) {
+            outer_w[i] = state[i] != BPS_C ? lcp.w(i) : REAL(0.0);
+        }
+    }
+    return true;
+}
+
+static 
+sizeint dxEstimateSolveLCPBlockPivotingMemoryReq(unsigned n)
+{
+    const unsigned nskip = dPAD(n);
+
+    sizeint res = 0;
+
+    res += dOVERALIGNED_SIZE(sizeof(dReal) * ((sizeint)n * nskip), LMATRIX_ALIGNMENT); // for L
+    res += 4 * dEFFICIENT_SIZE(sizeof(dReal) * n); // for d, x, y, tmp
+    res += dEFFICIENT_SIZE(sizeof(dReal) * PLH__MAX * n); // for lh
+    res += dEFFICIENT_SIZE(sizeof(unsigned) * n); // for C
+    res += dEFFICIENT_SIZE(sizeof(unsigned char) * n); // for state
+
+    return res;
+}
+
 sizeint dxEstimateSolveLCPMemoryReq(unsigned n, bool outer_w_avail)
 {
     const unsigned nskip = dPAD(n);
@@ -1155,6 +1504,9 @@ sizeint dxEstimateSolveLCPMemoryReq(unsigned n, bool outer_w_avail)
     sizeint lcp_transfer_req = dLCP::estimate_transfer_i_from_C_to_N_mem_req(n, nskip);
     res += dEFFICIENT_SIZE(lcp_transfer_req); // for dLCP::transfer_i_from_C_to_N
 
+    // the block pivoting driver runs first and releases its memory
+    res = dMAX(res, dxEstimateSolveLCPBlockPivotingMemoryReq(n));
+
     return res;
 }
 
@@ -1268,7 +1620,7 @@ extern "C" ODE_API int dTestSolveLCP()
             dStopwatchReset (&sw);
             dStopwatchStart (&sw);
 
-            dxSolveLCP (arena,n,A2,pairsbx,w,nub,pairslh,0);
+            dxSolveLCP (arena,n,A2,pairsbx,w,nub,pairslh,0,false);
 
             dStopwatchStop (&sw);
             double time = dStopwatchTime(&sw);
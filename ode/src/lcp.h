@@ -44,6 +44,10 @@ for the special constraints are set:
 and the solution continues. this mechanism allows a friction approximation
 to be implemented. the first `nub' variables are assumed to have findex < 0.
 
+if `warm_start' is set, x holds an estimate of the solution (e.g. that of the
+previous step) and the index sets it implies are tried first with block
+pivoting. otherwise x is ignored on input.
+
 */
 
 
@@ -74,7 +78,7 @@ enum dxLCPLHElement
 
 void dxSolveLCP (dxWorldProcessMemArena *memarena, 
     unsigned n, dReal *A, dReal pairsbx[PBX__MAX], dReal *w,
-    unsigned nub, dReal pairslh[PLH__MAX], int *findex);
+    unsigned nub, dReal pairslh[PLH__MAX], int *findex, bool warm_start);
 
 sizeint dxEstimateSolveLCPMemoryReq(unsigned n, bool outer_w_avail);
 
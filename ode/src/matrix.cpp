@@ -500,6 +500,83 @@ void dxRemoveRowCol(dReal *A, unsigned n, unsigned nskip, unsigned r)
 }
 
 
+/*extern */
+void dxFactorLDLTEnvelope(dReal *A, dReal *d, const sizeint *rowstart, unsigned n)
+{
+    dAASSERT (n > 0 && A && d && rowstart);
+
+    for (unsigned i = 0; i != n; ++i) {
+        dReal *arow = A + rowstart[i];
+        const unsigned ifirst = i + 1 - (unsigned)(rowstart[i + 1] - rowstart[i]);
+
+        // replace a(i,j) by l(i,j)*D(j) = a(i,j) - sum_k l(i,k)*D(k)*l(j,k)
+        for (unsigned j = ifirst; j != i; ++j) {
+            const dReal *lrow = A + rowstart[j];
+            const unsigned jfirst = j + 1 - (unsigned)(rowstart[j + 1] - rowstart[j]);
+            const unsigned kfirst = ifirst > jfirst ? ifirst : jfirst;
+            dReal sum = arow[j - ifirst];
+            const dReal *a = arow + (kfirst - ifirst), *aend = arow + (j - ifirst);
+            const dReal *l = lrow + (kfirst - jfirst);
+            for (; a != aend; ++a, ++l) {
+                sum -= (*a) * (*l);
+            }
+            arow[j - ifirst] = sum;
+        }
+
+        // scale the row to l(i,j) and compute D(i)
+        const dReal aii = arow[i - ifirst];
+        dReal diag = aii;
+        for (unsigned k = ifirst; k != i; ++k) {
+            const dReal u = arow[k - ifirst];
+            const dReal l = u * d[k];
+            arow[k - ifirst] = l;
+            diag -= u * l;
+        }
+        // rows made dependent by a loop of joints without CFM leave a
+        // vanishing (or, after rounding, negative) pivot, which is clamped
+        // to a tiny fraction of the diagonal
+        const dReal limit = dEpsilon * (aii > 0 ? aii : REAL(1.0));
+        d[i] = dRecip (diag > limit ? diag : limit);
+    }
+}
+
+
+/*extern */
+void dxSolveLDLTEnvelope(const dReal *L, const dReal *d, const sizeint *rowstart, dReal *b, unsigned n)
+{
+    dAASSERT (n > 0 && L && d && rowstart && b);
+
+    // solve L*y = b, the rows only reach back to their first column
+    for (unsigned i = 0; i != n; ++i) {
+        const dReal *lrow = L + rowstart[i];
+        const unsigned ifirst = i + 1 - (unsigned)(rowstart[i + 1] - rowstart[i]);
+        dReal sum = b[i];
+        const dReal *bb = b + ifirst, *bend = b + i;
+        for (; bb != bend; ++lrow, ++bb) {
+            sum -= (*lrow) * (*bb);
+        }
+        b[i] = sum;
+    }
+
+    // solve D*z = y
+    for (unsigned i = 0; i != n; ++i) {
+        b[i] *= d[i];
+    }
+
+    // solve L'*x = y, going through the rows of L as the columns of L'
+    for (unsigned i = n; i != 0; ) {
+        --i;
+        const dReal *lrow = L + rowstart[i];
+        const unsigned ifirst = i + 1 - (unsigned)(rowstart[i + 1] - rowstart[i]);
+        const dReal x = b[i];
+        dReal *bb = b + ifirst, *bend = b + i;
+        for (; bb != bend; ++lrow, ++bb) {
+            *bb -= (*lrow) * x;
+        }
+    }
+}
+
+
 #undef dSetZero
 #undef dSetValue
 //#undef dDot
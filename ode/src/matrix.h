@@ -100,6 +100,18 @@ void dxLDLTAddTL (dReal *L, dReal *d, const dReal *a, unsigned n, unsigned nskip
 void dxLDLTRemove (dReal **A, const unsigned *p, dReal *L, dReal *d, unsigned n1, unsigned n2, unsigned r, unsigned nskip, void *tmpbuf);
 void dxRemoveRowCol (dReal *A, unsigned n, unsigned nskip, unsigned r);
 
+// LDLT factorization of a symmetric matrix stored as an envelope (skyline):
+// row i holds its lower triangle from its first nonzero column up to the
+// diagonal at offset rowstart[i], and rowstart[n] is the total size. the
+// length of row i is rowstart[i+1] - rowstart[i]. the fill-in of the factor
+// stays within the envelope, so the cost only depends on the row lengths.
+// on return A holds L (the unit diagonal is not stored) and d holds the
+// reciprocals of the diagonal of D, as with dFactorLDLT. A should be
+// positive definite: pivots below dEpsilon times their diagonal element
+// are raised to that, so that singular systems still get a finite solution.
+void dxFactorLDLTEnvelope (dReal *A, dReal *d, const sizeint *rowstart, unsigned n);
+void dxSolveLDLTEnvelope (const dReal *L, const dReal *d, const sizeint *rowstart, dReal *b, unsigned n);
+
 ODE_PURE_INLINE sizeint dxEstimateFactorCholeskyTmpbufSize(unsigned n)
 {
     return dPAD(n) * sizeof(dReal);
@@ -28,6 +28,7 @@
 #include <ode/objects.h>
 #include "config.h"
 #include "objects.h"
+#include "contact_cache.h"
 #include "default_threading.h"
 #include "threading_impl.h"
 #include "matrix.h"
@@ -70,7 +71,18 @@ dxDampingParameters::dxDampingParameters(void *):
 
 dxQuickStepParameters::dxQuickStepParameters(void *):
     num_iterations(20),
-    w(REAL(1.3))
+    w(REAL(1.3)),
+    warm_starting(0),
+    contact_match_distance(REAL(0.01)),
+    graph_coloring(0),
+    row_batching(1),
+    tolerance(REAL(0.0))
+{
+}
+
+dxAutoStepParameters::dxAutoStepParameters(void *):
+    max_rows(200),
+    max_contact_rows(0)
 {
 }
 
@@ -87,13 +99,19 @@ dxWorld::dxWorld():
     firstjoint(NULL),
     nb(0),
     nj(0),
+    joint_serial(0),
     global_erp(dWORLD_DEFAULT_GLOBAL_ERP),
     global_cfm(dWORLD_DEFAULT_GLOBAL_CFM),
     adis(NULL),
     body_flags(0),
     islands_max_threads(dWORLDSTEP_THREADCOUNT_UNLIMITED),
     wmem(NULL),
+    contact_cache(NULL),
+    step_sparse(0),
+    step_articulated(0),
+    step_warm_starting(0),
     qs(NULL),
+    autostep(NULL),
     contactp(NULL),
     dampingp(NULL),
     max_angular_speed(dInfinity),
@@ -111,6 +129,8 @@ dxWorld::~dxWorld()
         wmem->CleanupWorldReferences(this);
         wmem->Release();
     }
+
+    delete contact_cache;
 }
 
 
@@ -32,12 +32,16 @@
 #include <ode/mass.h>
 #include "error.h"
 #include "array.h"
+#include "body_state.h"
+#include "island_graph.h"
 #include "common.h"
 #include "threading_base.h"
+#include "odeou.h"
 
 
 struct dxJointNode;
 class dxStepWorkingMemory;
+class dxContactCache;
 class dxWorldProcessContext;
 
 
@@ -110,12 +114,56 @@ struct dxDampingParameters {
 struct dxQuickStepParameters {
     int num_iterations;		// number of SOR iterations to perform
     dReal w;			// the SOR over-relaxation parameter
+    int warm_starting;		// start from the lambdas of the previous step
+    dReal contact_match_distance;	// how far a contact may move and still be warm started
+    int graph_coloring;		// sweep the rows by colors of rows not sharing bodies
+    int row_batching;		// solve the rows of a color in SIMD batches
+    dReal tolerance;		// stop iterating once no lambda changes more (0 = never)
 
     dxQuickStepParameters() {}
     explicit dxQuickStepParameters(void *);
 };
 
 
+// auto-step parameters (which stepper an island is stepped with)
+struct dxAutoStepParameters {
+    int max_rows;		// islands with more constraint rows are quick-stepped
+    int max_contact_rows;	// islands of contacts only with more rows are quick-stepped
+
+    dxAutoStepParameters() {}
+    explicit dxAutoStepParameters(void *);
+};
+
+
+// quick-step statistics of the last step
+struct dxQuickStepStats {
+    volatile atomicord32 one_body_rows;	// rows of a single body (e.g. contacts with static geometry)
+    volatile atomicord32 two_body_rows;	// rows between two bodies
+    volatile atomicord32 iterations;	// the most iterations done by an island
+    volatile atomicord32 residual;	// the largest lambda change of the last iterations (encoded)
+
+    dxQuickStepStats() { reset(); }
+    void reset() { one_body_rows = 0; two_body_rows = 0; iterations = 0; residual = encodeResidual(REAL(0.0)); }
+
+    // The residuals are kept as the bits of floats which, for non-negative values, 
+    // order the same way as unsigned integers and can be raised atomically.
+    static atomicord32 encodeResidual(dReal value)
+    {
+        dSASSERT(sizeof(float) == sizeof(atomicord32));
+        union { float f; atomicord32 bits; } residual;
+        residual.f = (float)value;
+        return residual.bits;
+    }
+
+    static dReal decodeResidual(atomicord32 bits)
+    {
+        union { float f; atomicord32 bits; } residual;
+        residual.bits = bits;
+        return (dReal)residual.f;
+    }
+};
+
+
 // contact generation parameters
 struct dxContactParameters {
     dReal max_vel;		// maximum correcting velocity
@@ -135,6 +183,11 @@ struct dxPosR {
 struct dxBody : public dObject {
     dxJointNode *firstjoint;	// list of attached joints
     unsigned flags;			// some dxBodyFlagXXX flags
+    unsigned state_slot;		// slot of the body in the world body state store
+    dxIslandComponent *island;	// connected component of the body in the island graph
+    duint64 serial;		// creation number, orders the bodies like the world list
+    dxBody *island_next, *island_prev;	// other bodies of the component
+    dxBody *sleep_next;		// ring of the bodies of the sleeping island, or NULL if awake
     dGeomID geom;			// first collision geom associated with body
     dMass mass;			// mass parameters about POR
     dMatrix3 invI;		// inverse of mass.I
@@ -159,6 +212,10 @@ struct dxBody : public dObject {
     dReal max_angular_speed;      // limit the angular velocity to this magnitude
 
     dxBody(dxWorld *w);
+
+    // the body was put to sleep together with its island. it is disabled
+    // and only woken together with the rest of the island.
+    bool isAsleep() const { return sleep_next != NULL; }
 };
 
 
@@ -166,6 +223,7 @@ struct dxWorld : public dBase, public dxThreadingBase, private dxIThreadingDefau
     dxBody *firstbody;		// body linked list
     dxJoint *firstjoint;		// joint linked list
     int nb,nj;			// number of bodies and joints in lists
+    duint64 joint_serial;		// creation number of the next joint
     dVector3 gravity;		// gravity vector (m/s/s)
     dReal global_erp;		// global error reduction parameter
     dReal global_cfm;		// global constraint force mixing parameter
@@ -173,8 +231,16 @@ struct dxWorld : public dBase, public dxThreadingBase, private dxIThreadingDefau
     int body_flags;               // flags for new bodies
     unsigned islands_max_threads; // maximum threads to allocate for island processing
     dxStepWorkingMemory *wmem; // Working memory object for dWorldStep/dWorldQuickStep
+    dxContactCache *contact_cache; // contact lambdas kept for warm starting (or NULL)
+    dxBodyStateStore body_state; // SoA mirror of the body state used by the steppers
+    dxIslandGraph islands; // bodies connected by joints, maintained incrementally
+    int step_sparse;		// factor the unbounded dWorldStep islands as sparse matrices
+    int step_articulated;	// eliminate the joint trees of dWorldStep islands in linear time
+    int step_warm_starting;	// start the dWorldStep LCP from the lambdas of the previous step
 
     dxQuickStepParameters qs;
+    dxQuickStepStats qs_stats;  // updated by the quick-stepped islands of each step
+    dxAutoStepParameters autostep;
     dxContactParameters contactp;
     dxDampingParameters dampingp; // damping parameters
     dReal max_angular_speed;      // limit the angular velocity to this magnitude
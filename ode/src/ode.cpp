@@ -34,6 +34,7 @@
 #include "matrix.h"
 #include "odemath.h"
 #include "objects.h"
+#include "contact_cache.h"
 #include "joints/joints.h"
 #include "step.h"
 #include "quickstep.h"
@@ -74,6 +75,8 @@ static inline void removeObjectFromList (dObject *obj)
 
 static void removeJointReferencesFromAttachedBodies (dxJoint *j)
 {
+    j->world->islands.detach (j->node[0].body, j->node[1].body);
+
     for (int i=0; i<2; i++) {
         dxBody *body = j->node[i].body;
         if (body) {
@@ -261,6 +264,9 @@ dxBody *dBodyCreate (dxWorld *w)
     dSetZero (b->finite_rot_axis,4);
     addObjectToList (b,(dObject **) &w->firstbody);
     w->nb++;
+    w->body_state.add (b);
+    w->islands.addBody (b);
+    b->sleep_next = NULL;
 
     // set auto-disable parameters
     b->average_avel_buffer = b->average_lvel_buffer = NULL; // no buffer at beginning
@@ -298,6 +304,10 @@ void dBodyDestroy (dxBody *b)
         dGeomSetBody (geom,0);
     }
 
+    // the rest of a sleeping island loses its support
+    if (b->isAsleep()) dInternalWakeIsland (b);
+    b->world->islands.removeBody (b);
+
     // detach all neighbouring joints, then delete this body.
     dxJointNode *n = b->firstjoint;
     while (n) {
@@ -311,6 +321,7 @@ void dBodyDestroy (dxBody *b)
     }
     removeObjectFromList (b);
     b->world->nb--;
+    b->world->body_state.remove (b);
 
     // delete the average buffers
     if(b->average_lvel_buffer)
@@ -348,6 +359,7 @@ void dBodySetPosition (dBodyID b, dReal x, dReal y, dReal z)
     b->posr.pos[0] = x;
     b->posr.pos[1] = y;
     b->posr.pos[2] = z;
+    b->world->body_state.markDirty (b);
 
     // notify all attached geoms that this body has moved
     for (dxGeom *geom = b->geom; geom; geom = dGeomGetBodyNext (geom))
@@ -366,6 +378,7 @@ void dBodySetRotation (dBodyID b, const dMatrix3 R)
 
     dRtoQ (R, b->q);
     dNormalize4 (b->q);
+    b->world->body_state.markDirty (b);
 
     // notify all attached geoms that this body has moved
     for (dxGeom *geom = b->geom; geom; geom = dGeomGetBodyNext (geom)) {
@@ -383,6 +396,7 @@ void dBodySetQuaternion (dBodyID b, const dQuaternion q)
     b->q[3] = q[3];
     dNormalize4 (b->q);
     dQtoR (b->q,b->posr.R);
+    b->world->body_state.markDirty (b);
 
     // notify all attached geoms that this body has moved
     for (dxGeom *geom = b->geom; geom; geom = dGeomGetBodyNext (geom))
@@ -396,6 +410,7 @@ void dBodySetLinearVel  (dBodyID b, dReal x, dReal y, dReal z)
     b->lvel[0] = x;
     b->lvel[1] = y;
     b->lvel[2] = z;
+    b->world->body_state.markDirty (b);
 }
 
 
@@ -405,6 +420,7 @@ void dBodySetAngularVel (dBodyID b, dReal x, dReal y, dReal z)
     b->avel[0] = x;
     b->avel[1] = y;
     b->avel[2] = z;
+    b->world->body_state.markDirty (b);
 }
 
 
@@ -500,6 +516,7 @@ void dBodySetMass (dBodyID b, const dMass *mass)
         dRSetIdentity (b->invI);
     }
     b->invMass = dRecip(b->mass.mass);
+    b->world->body_state.markDirty (b);
 }
 
 
@@ -837,6 +854,7 @@ void dBodySetKinematic (dBodyID b)
     dAASSERT (b);
     dSetZero (b->invI,4*3);
     b->invMass = 0; 
+    b->world->body_state.markDirty (b);
 }
 
 int dBodyIsKinematic (dBodyID b)
@@ -848,7 +866,9 @@ int dBodyIsKinematic (dBodyID b)
 void dBodyEnable (dBodyID b)
 {
     dAASSERT (b);
+    if (b->isAsleep()) dInternalWakeIsland (b);
     b->flags &= ~dxBodyDisabled;
+    b->world->islands.activate (b);
     b->adis_stepsleft = b->adis.idle_steps;
     b->adis_timeleft = b->adis.idle_time;
     // no code for average-processing needed here
@@ -994,7 +1014,9 @@ void dBodySetAutoDisableFlag (dBodyID b, int do_auto_disable)
     {
         b->flags &= ~dxBodyAutoDisable;
         // (mg) we should also reset the IsDisabled state to correspond to the DoDisabling flag
+        if (b->isAsleep()) dInternalWakeIsland (b);
         b->flags &= ~dxBodyDisabled;
+        b->world->islands.activate (b);
         b->adis.idle_steps = dWorldGetAutoDisableSteps(b->world);
         b->adis.idle_time = dWorldGetAutoDisableTime(b->world);
         // resetting the average calculations too
@@ -1434,6 +1456,10 @@ void dJointAttach (dxJoint *joint, dxBody *body1, dxBody *body2)
     if (body1 != NULL || body2 != NULL) {
         joint->setRelativeValues();
     }
+
+    if (body1 != NULL) {
+        world->islands.attach (body1, body2);
+    }
 }
 
 void dJointEnable (dxJoint *joint)
@@ -1823,6 +1849,23 @@ void dWorldSetStepThreadingImplementation(dWorldID w,
 }
 
 
+// the steppers of the islands
+
+enum
+{
+    dxISLANDSTEPPER_STEP,
+    dxISLANDSTEPPER_QUICKSTEP,
+
+    dxISLANDSTEPPER__MAX
+};
+
+static const dxIslandStepperInfo g_IslandSteppers[dxISLANDSTEPPER__MAX] =
+{
+    { &dxStepIsland, &dxEstimateStepMemoryRequirements, &dxEstimateStepMaxCallCount, dxSTEP_ISLAND_BATCH_ROWS },
+    { &dxQuickStepIsland, &dxEstimateQuickStepMemoryRequirements, &dxEstimateQuickStepMaxCallCount, dxQUICKSTEP_ISLAND_BATCH_ROWS },
+};
+
+
 int dWorldStep (dWorldID w, dReal stepsize)
 {
     dUASSERT (w,"bad world argument");
@@ -1830,15 +1873,24 @@ int dWorldStep (dWorldID w, dReal stepsize)
 
     bool result = false;
 
+    dxContactCache *contact_cache = w->step_warm_starting ? w->contact_cache : NULL;
+    if (contact_cache != NULL) {
+        contact_cache->load (w, w->qs.contact_match_distance);
+    }
+
     dxWorldProcessIslandsInfo islandsinfo;
-    if (dxReallocateWorldProcessContext (w, islandsinfo, stepsize, &dxEstimateStepMemoryRequirements))
+    if (dxReallocateWorldProcessContext (w, islandsinfo, stepsize, &g_IslandSteppers[dxISLANDSTEPPER_STEP], NULL))
     {
-        if (dxProcessIslands (w, islandsinfo, stepsize, &dxStepIsland, &dxEstimateStepMaxCallCount))
+        if (dxProcessIslands (w, islandsinfo, stepsize, &g_IslandSteppers[dxISLANDSTEPPER_STEP], 1))
         {
             result = true;
         }
     }
 
+    if (result && contact_cache != NULL) {
+        contact_cache->store (w);
+    }
+
     return result;
 }
 
@@ -1849,15 +1901,76 @@ int dWorldQuickStep (dWorldID w, dReal stepsize)
 
     bool result = false;
 
+    dxContactCache *contact_cache = w->qs.warm_starting ? w->contact_cache : NULL;
+    if (contact_cache != NULL) {
+        contact_cache->load (w, w->qs.contact_match_distance);
+    }
+
+    w->qs_stats.reset();
+
+    dxWorldProcessIslandsInfo islandsinfo;
+    if (dxReallocateWorldProcessContext (w, islandsinfo, stepsize, &g_IslandSteppers[dxISLANDSTEPPER_QUICKSTEP], NULL))
+    {
+        if (dxProcessIslands (w, islandsinfo, stepsize, &g_IslandSteppers[dxISLANDSTEPPER_QUICKSTEP], 1))
+        {
+            result = true;
+        }
+    }
+
+    if (result && contact_cache != NULL) {
+        contact_cache->store (w);
+    }
+
+    return result;
+}
+
+
+// the islands with joints other than contacts (robots, vehicles, ragdolls)
+// are stepped exactly unless they are too big for the dense LCP. the islands
+// held together by contacts alone (piles of debris) are quick-stepped.
+static unsigned dxSelectAutoStepper (dxWorld *w, dxJoint * const *joint, unsigned int nj, unsigned int rows)
+{
+    if (rows > (unsigned)w->autostep.max_rows) {
+        return dxISLANDSTEPPER_QUICKSTEP;
+    }
+    if (rows <= (unsigned)w->autostep.max_contact_rows) {
+        return dxISLANDSTEPPER_STEP;
+    }
+    for (unsigned int i = 0; i != nj; ++i) {
+        if (joint[i]->type() != dJointTypeContact) {
+            return dxISLANDSTEPPER_STEP;
+        }
+    }
+    return dxISLANDSTEPPER_QUICKSTEP;
+}
+
+int dWorldAutoStep (dWorldID w, dReal stepsize)
+{
+    dUASSERT (w,"bad world argument");
+    dUASSERT (stepsize > 0,"stepsize must be > 0");
+
+    bool result = false;
+
+    dxContactCache *contact_cache = w->qs.warm_starting || w->step_warm_starting ? w->contact_cache : NULL;
+    if (contact_cache != NULL) {
+        contact_cache->load (w, w->qs.contact_match_distance);
+    }
+
+    w->qs_stats.reset();
+
     dxWorldProcessIslandsInfo islandsinfo;
-    if (dxReallocateWorldProcessContext (w, islandsinfo, stepsize, &dxEstimateQuickStepMemoryRequirements))
+    if (dxReallocateWorldProcessContext (w, islandsinfo, stepsize, g_IslandSteppers, &dxSelectAutoStepper))
     {
-        if (dxProcessIslands (w, islandsinfo, stepsize, &dxQuickStepIsland, &dxEstimateQuickStepMaxCallCount))
+        if (dxProcessIslands (w, islandsinfo, stepsize, g_IslandSteppers, dxISLANDSTEPPER__MAX))
         {
             result = true;
         }
     }
 
+    if (result && contact_cache != NULL) {
+        contact_cache->store (w);
+    }
+
     return result;
 }
 
@@ -2046,6 +2159,98 @@ void dWorldSetMaxAngularSpeed(dWorldID w, dReal max_speed)
 }
 
 
+void dWorldSetStepSparseFactorization (dWorldID w, int enabled)
+{
+    dAASSERT(w);
+    w->step_sparse = enabled != 0;
+}
+
+
+int dWorldGetStepSparseFactorization (dWorldID w)
+{
+    dAASSERT(w);
+    return w->step_sparse;
+}
+
+
+void dWorldSetStepArticulatedTrees (dWorldID w, int enabled)
+{
+    dAASSERT(w);
+    w->step_articulated = enabled != 0;
+}
+
+
+int dWorldGetStepArticulatedTrees (dWorldID w)
+{
+    dAASSERT(w);
+    return w->step_articulated;
+}
+
+
+// the joint lambdas and the contact cache are kept while either stepper is
+// warm started. call this after changing the options.
+static void updateWarmStartingStorage (dxWorld *w, bool was_kept)
+{
+    const bool keep = w->qs.warm_starting || w->step_warm_starting;
+    if (keep && !was_kept) {
+        // lambdas were not saved while warm starting was off
+        for (dxJoint *j=w->firstjoint; j; j=(dxJoint*)j->next) {
+            dSetZero (j->lambda, 6);
+        }
+        if (w->contact_cache == NULL) w->contact_cache = new dxContactCache();
+    }
+    else if (!keep && was_kept && w->contact_cache != NULL) {
+        w->contact_cache->clear();
+    }
+}
+
+
+void dWorldSetStepWarmStarting (dWorldID w, int enabled)
+{
+    dAASSERT(w);
+    const bool was_kept = w->qs.warm_starting || w->step_warm_starting;
+    w->step_warm_starting = enabled != 0;
+    updateWarmStartingStorage (w, was_kept);
+}
+
+
+int dWorldGetStepWarmStarting (dWorldID w)
+{
+    dAASSERT(w);
+    return w->step_warm_starting;
+}
+
+
+void dWorldSetAutoStepMaxRows (dWorldID w, int rows)
+{
+    dAASSERT(w);
+    dUASSERT(rows >= 0, "rows must be >= 0");
+    w->autostep.max_rows = rows;
+}
+
+
+int dWorldGetAutoStepMaxRows (dWorldID w)
+{
+    dAASSERT(w);
+    return w->autostep.max_rows;
+}
+
+
+void dWorldSetAutoStepMaxContactRows (dWorldID w, int rows)
+{
+    dAASSERT(w);
+    dUASSERT(rows >= 0, "rows must be >= 0");
+    w->autostep.max_contact_rows = rows;
+}
+
+
+int dWorldGetAutoStepMaxContactRows (dWorldID w)
+{
+    dAASSERT(w);
+    return w->autostep.max_contact_rows;
+}
+
+
 void dWorldSetQuickStepNumIterations (dWorldID w, int num)
 {
     dAASSERT(w);
@@ -2074,6 +2279,92 @@ dReal dWorldGetQuickStepW (dWorldID w)
 }
 
 
+void dWorldSetQuickStepTolerance (dWorldID w, dReal tolerance)
+{
+    dAASSERT(w);
+    dUASSERT(tolerance >= 0, "tolerance must not be negative");
+    w->qs.tolerance = tolerance;
+}
+
+
+dReal dWorldGetQuickStepTolerance (dWorldID w)
+{
+    dAASSERT(w);
+    return w->qs.tolerance;
+}
+
+
+void dWorldSetQuickStepWarmStarting (dWorldID w, int enabled)
+{
+    dAASSERT(w);
+    const bool was_kept = w->qs.warm_starting || w->step_warm_starting;
+    w->qs.warm_starting = enabled != 0;
+    updateWarmStartingStorage (w, was_kept);
+}
+
+
+int dWorldGetQuickStepWarmStarting (dWorldID w)
+{
+    dAASSERT(w);
+    return w->qs.warm_starting;
+}
+
+
+void dWorldSetQuickStepContactMatchDistance (dWorldID w, dReal distance)
+{
+    dAASSERT(w);
+    dUASSERT(distance >= 0, "distance must be >= 0");
+    w->qs.contact_match_distance = distance;
+}
+
+
+dReal dWorldGetQuickStepContactMatchDistance (dWorldID w)
+{
+    dAASSERT(w);
+    return w->qs.contact_match_distance;
+}
+
+
+void dWorldSetQuickStepGraphColoring (dWorldID w, int enabled)
+{
+    dAASSERT(w);
+    w->qs.graph_coloring = enabled != 0;
+}
+
+
+int dWorldGetQuickStepGraphColoring (dWorldID w)
+{
+    dAASSERT(w);
+    return w->qs.graph_coloring;
+}
+
+
+void dWorldSetQuickStepRowBatching (dWorldID w, int enabled)
+{
+    dAASSERT(w);
+    w->qs.row_batching = enabled != 0;
+}
+
+
+int dWorldGetQuickStepRowBatching (dWorldID w)
+{
+    dAASSERT(w);
+    return w->qs.row_batching;
+}
+
+
+void dWorldGetQuickStepStats (dWorldID w, dQuickStepStats *stats)
+{
+    dAASSERT(w);
+    dAASSERT(stats);
+    stats->one_body_rows = (int)w->qs_stats.one_body_rows;
+    stats->two_body_rows = (int)w->qs_stats.two_body_rows;
+    stats->rows = stats->one_body_rows + stats->two_body_rows;
+    stats->iterations = (int)w->qs_stats.iterations;
+    stats->residual = dxQuickStepStats::decodeResidual(w->qs_stats.residual);
+}
+
+
 void dWorldSetContactMaxCorrectingVel (dWorldID w, dReal vel)
 {
     dAASSERT(w);
@@ -2101,6 +2392,252 @@ dReal dWorldGetContactSurfaceLayer (dWorldID w)
     return w->contactp.min_depth;
 }
 
+//****************************************************************************
+// world snapshots
+
+// dynamic state of one body. settings (mass, damping, auto-disable
+// parameters, ...) are not part of a snapshot.
+
+struct dxBodySnapshot {
+    dxBody *body;
+    duint64 serial;                 // tells a new body at the same address apart
+    dxPosR posr;
+    dQuaternion q;
+    dVector3 lvel,avel;
+    dVector3 facc,tacc;
+    unsigned disabled;              // dxBodyDisabled bit of the flags
+    dReal adis_timeleft;
+    int adis_stepsleft;
+    unsigned int average_counter;
+    int average_ready;
+    unsigned int average_samples;   // length of the average buffers when captured
+};
+
+// dynamic state of one joint that does not belong to a joint group.
+// the attached bodies are recorded to detect re-attachment.
+
+struct dxJointSnapshot {
+    dxJoint *joint;
+    duint64 serial;                 // tells a new joint at the same address apart
+    dxBody *body[2];
+    unsigned disabled;              // dJOINT_DISABLED bit of the flags
+    dReal lambda[6];
+    bool has_feedback;
+    dJointFeedback feedback;
+};
+
+struct dxWorldSnapshot : public dBase {
+    dxWorld *world;
+    unsigned nb,nj;                 // number of captured bodies and joints
+    unsigned nb_max,nj_max;         // capacity of bodies and joints
+    sizeint na,na_max;              // size and capacity of the average buffers
+    dxBodySnapshot *bodies;
+    dxJointSnapshot *joints;
+    dVector3 *average;              // linear then angular samples of each body
+
+    explicit dxWorldSnapshot(dxWorld *w):
+        world(w), nb(0), nj(0), nb_max(0), nj_max(0), na(0), na_max(0),
+        bodies(NULL), joints(NULL), average(NULL) {}
+    ~dxWorldSnapshot();
+
+    void reserve(unsigned nb_req, unsigned nj_req, sizeint na_req);
+};
+
+
+dxWorldSnapshot::~dxWorldSnapshot()
+{
+    if (bodies) dFree (bodies, nb_max * sizeof(dxBodySnapshot));
+    if (joints) dFree (joints, nj_max * sizeof(dxJointSnapshot));
+    if (average) dFree (average, na_max * sizeof(dVector3));
+}
+
+
+// the buffers only grow, so capturing the same world again does not allocate
+
+void dxWorldSnapshot::reserve(unsigned nb_req, unsigned nj_req, sizeint na_req)
+{
+    if (nb_req > nb_max) {
+        if (bodies) dFree (bodies, nb_max * sizeof(dxBodySnapshot));
+        bodies = (dxBodySnapshot *) dAlloc (nb_req * sizeof(dxBodySnapshot));
+        nb_max = nb_req;
+    }
+    if (nj_req > nj_max) {
+        if (joints) dFree (joints, nj_max * sizeof(dxJointSnapshot));
+        joints = (dxJointSnapshot *) dAlloc (nj_req * sizeof(dxJointSnapshot));
+        nj_max = nj_req;
+    }
+    if (na_req > na_max) {
+        if (average) dFree (average, na_max * sizeof(dVector3));
+        average = (dVector3 *) dAlloc (na_req * sizeof(dVector3));
+        na_max = na_req;
+    }
+}
+
+
+dxWorldSnapshot *dWorldSnapshotCreate (dxWorld *w)
+{
+    dAASSERT (w);
+    dxWorldSnapshot *s = new dxWorldSnapshot(w);
+    dWorldSnapshotCapture (s);
+    return s;
+}
+
+
+void dWorldSnapshotDestroy (dxWorldSnapshot *s)
+{
+    dAASSERT (s);
+    delete s;
+}
+
+
+void dWorldSnapshotCapture (dxWorldSnapshot *s)
+{
+    dAASSERT (s);
+    dxWorld *w = s->world;
+
+    unsigned nj = 0;
+    sizeint na = 0;
+    for (dxJoint *j=w->firstjoint; j; j=(dxJoint*)j->next) {
+        if (!(j->flags & dJOINT_INGROUP)) nj++;
+    }
+    for (dxBody *b=w->firstbody; b; b=(dxBody*)b->next) {
+        if (b->average_lvel_buffer) na += 2 * (sizeint)b->adis.average_samples;
+    }
+    s->reserve (w->nb, nj, na);
+
+    dxBodySnapshot *bs = s->bodies;
+    dVector3 *avg = s->average;
+    for (dxBody *b=w->firstbody; b; b=(dxBody*)b->next, bs++) {
+        bs->body = b;
+        bs->serial = b->serial;
+        bs->posr = b->posr;
+        dCopyVector4 (bs->q, b->q);
+        dCopyVector3 (bs->lvel, b->lvel);
+        dCopyVector3 (bs->avel, b->avel);
+        dCopyVector3 (bs->facc, b->facc);
+        dCopyVector3 (bs->tacc, b->tacc);
+        bs->disabled = b->flags & dxBodyDisabled;
+        bs->adis_timeleft = b->adis_timeleft;
+        bs->adis_stepsleft = b->adis_stepsleft;
+        bs->average_counter = b->average_counter;
+        bs->average_ready = b->average_ready;
+        bs->average_samples = 0;
+        if (b->average_lvel_buffer) {
+            unsigned int n = b->adis.average_samples;
+            memcpy (avg, b->average_lvel_buffer, n * sizeof(dVector3));
+            memcpy (avg + n, b->average_avel_buffer, n * sizeof(dVector3));
+            avg += 2 * (sizeint)n;
+            bs->average_samples = n;
+        }
+    }
+
+    dxJointSnapshot *js = s->joints;
+    for (dxJoint *j=w->firstjoint; j; j=(dxJoint*)j->next) {
+        if (j->flags & dJOINT_INGROUP) continue;
+        js->joint = j;
+        js->serial = j->serial;
+        js->body[0] = j->node[0].body;
+        js->body[1] = j->node[1].body;
+        js->disabled = j->flags & dJOINT_DISABLED;
+        memcpy (js->lambda, j->lambda, sizeof(js->lambda));
+        js->has_feedback = j->feedback != NULL;
+        if (j->feedback) js->feedback = *j->feedback;
+        js++;
+    }
+
+    s->nb = w->nb;
+    s->nj = nj;
+    s->na = na;
+}
+
+
+// check that the world still has exactly the captured bodies and
+// non-grouped joints, in the same order and with the same attachments.
+// an object destroyed and created again may get the same address, so the
+// creation numbers are compared too.
+
+static bool snapshotMatchesWorld (const dxWorldSnapshot *s)
+{
+    const dxWorld *w = s->world;
+    if ((unsigned)w->nb != s->nb) return false;
+
+    const dxBodySnapshot *bs = s->bodies;
+    for (dxBody *b=w->firstbody; b; b=(dxBody*)b->next, bs++) {
+        if (bs->body != b || bs->serial != b->serial) return false;
+    }
+
+    const dxJointSnapshot *js = s->joints, *js_end = s->joints + s->nj;
+    for (dxJoint *j=w->firstjoint; j; j=(dxJoint*)j->next) {
+        if (j->flags & dJOINT_INGROUP) continue;
+        if (js == js_end || js->joint != j || js->serial != j->serial
+            || js->body[0] != j->node[0].body || js->body[1] != j->node[1].body) return false;
+        js++;
+    }
+    return js == js_end;
+}
+
+
+int dWorldSnapshotRestore (dxWorldSnapshot *s)
+{
+    dAASSERT (s);
+    if (!snapshotMatchesWorld (s)) return 0;
+
+    // cached contacts belong to the state that is being replaced
+    if (s->world->contact_cache != NULL) s->world->contact_cache->clear();
+
+    // the sleeping islands are not captured; the restored disabled bodies
+    // are woken one by one, like the ones disabled through the API
+    for (dxBody *b = s->world->firstbody; b; b = (dxBody *)b->next) {
+        b->sleep_next = NULL;
+    }
+
+    const dVector3 *avg = s->average;
+    const dxBodySnapshot *bs = s->bodies, *bs_end = s->bodies + s->nb;
+    for (; bs != bs_end; bs++) {
+        dxBody *b = bs->body;
+        b->posr = bs->posr;
+        dCopyVector4 (b->q, bs->q);
+        dCopyVector3 (b->lvel, bs->lvel);
+        dCopyVector3 (b->avel, bs->avel);
+        dCopyVector3 (b->facc, bs->facc);
+        dCopyVector3 (b->tacc, bs->tacc);
+        b->flags = (b->flags & ~dxBodyDisabled) | bs->disabled;
+        b->adis_timeleft = bs->adis_timeleft;
+        b->adis_stepsleft = bs->adis_stepsleft;
+        s->world->body_state.markDirty (b);
+        if (bs->disabled == 0) s->world->islands.activate (b);
+
+        unsigned int n = bs->average_samples;
+        if (n != 0 && b->average_lvel_buffer && b->adis.average_samples == n) {
+            memcpy (b->average_lvel_buffer, avg, n * sizeof(dVector3));
+            memcpy (b->average_avel_buffer, avg + n, n * sizeof(dVector3));
+            b->average_counter = bs->average_counter;
+            b->average_ready = bs->average_ready;
+        }
+        else {
+            // the buffer length was changed since capture; start averaging over
+            b->average_counter = 0;
+            b->average_ready = 0;
+        }
+        avg += 2 * (sizeint)n;
+
+        // notify all attached geoms that this body has moved
+        for (dxGeom *geom = b->geom; geom; geom = dGeomGetBodyNext (geom))
+            dGeomMoved (geom);
+    }
+
+    const dxJointSnapshot *js = s->joints, *js_end = s->joints + s->nj;
+    for (; js != js_end; js++) {
+        dxJoint *j = js->joint;
+        j->flags = (j->flags & ~dJOINT_DISABLED) | js->disabled;
+        memcpy (j->lambda, js->lambda, sizeof(j->lambda));
+        if (j->feedback && js->has_feedback) *j->feedback = js->feedback;
+    }
+
+    return 1;
+}
+
+
 //****************************************************************************
 // testing
 
@@ -41,11 +41,10 @@
 // configuration
 
 // for the SOR and CG methods:
-// uncomment the following line to use warm starting. this definitely
-// help for motor-driven joints. unfortunately it appears to hurt
-// with high-friction contacts using the SOR method. use with care
-
-// #define WARM_STARTING 1
+// warm starting is selected per world at run time with
+// dWorldSetQuickStepWarmStarting(). this definitely helps for motor-driven
+// joints. unfortunately it appears to hurt with high-friction contacts using
+// the SOR method. use with care
 
 
 #define REORDERING_METHOD__DONT_REORDER 0
@@ -74,6 +73,25 @@
 #endif
 
 
+// for the SOR method with graph coloring:
+// the rows of a color are solved several at a time with SIMD instructions.
+// the kernels are compiled for double precision x86 with GCC compatible
+// compilers and selected at run time by the CPU features (AVX2+FMA or SSE2).
+// elsewhere the rows are solved one by one.
+
+#if !defined(dxSOR_ROW_BATCH_SIMD)
+#if defined(dDOUBLE) && (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__) && !defined(__INTEL_COMPILER)
+#define dxSOR_ROW_BATCH_SIMD 1
+#else
+#define dxSOR_ROW_BATCH_SIMD 0
+#endif
+#endif
+
+#if dxSOR_ROW_BATCH_SIMD
+#include <immintrin.h>
+#endif
+
+
 #if CONSTRAINTS_REORDERING_METHOD == REORDERING_METHOD__RANDOMLY
 #if !defined(RANDOM_CONSTRAINTS_REORDERING_FREQUENCY)
 #define RANDOM_CONSTRAINTS_REORDERING_FREQUENCY 8U
@@ -104,23 +122,22 @@ struct IndexError;
 #define dxQUICKSTEPISLAND_STAGE2B_STEP  16U
 #define dxQUICKSTEPISLAND_STAGE2C_STEP  32U
 
-#ifdef WARM_STARTING
-#define dxQUICKSTEPISLAND_STAGE4A_STEP  256U
-#else
 #define dxQUICKSTEPISLAND_STAGE4A_STEP  512U
-#endif
 
 #define dxQUICKSTEPISLAND_STAGE4LCP_IMJ_STEP 8U
 #define dxQUICKSTEPISLAND_STAGE4LCP_AD_STEP  8U
 
-#ifdef WARM_STARTING
-#define dxQUICKSTEPISLAND_STAGE4LCP_FC_STEP  128U
-#define dxQUICKSTEPISLAND_STAGE4LCP_FC_COMPLETE_TO_PREPARE_COMPLEXITY_DIVISOR  4
-#define dxQUICKSTEPISLAND_STAGE4LCP_FC_STEP_PREPARE  (dxQUICKSTEPISLAND_STAGE4LCP_FC_STEP * dxQUICKSTEPISLAND_STAGE4LCP_FC_COMPLETE_TO_PREPARE_COMPLEXITY_DIVISOR)
-#define dxQUICKSTEPISLAND_STAGE4LCP_FC_STEP_COMPLETE (dxQUICKSTEPISLAND_STAGE4LCP_FC_STEP)
-#else
 #define dxQUICKSTEPISLAND_STAGE4LCP_FC_STEP  (dxQUICKSTEPISLAND_STAGE4A_STEP / 2) // Average info.m is 3 for stage4a, while there are 6 reals per index in fc
-#endif
+
+// fc computation when warm starting
+#define dxQUICKSTEPISLAND_STAGE4LCP_FC_WARM_STEP  128U
+#define dxQUICKSTEPISLAND_STAGE4LCP_FC_COMPLETE_TO_PREPARE_COMPLEXITY_DIVISOR  4
+#define dxQUICKSTEPISLAND_STAGE4LCP_FC_STEP_PREPARE  (dxQUICKSTEPISLAND_STAGE4LCP_FC_WARM_STEP * dxQUICKSTEPISLAND_STAGE4LCP_FC_COMPLETE_TO_PREPARE_COMPLEXITY_DIVISOR)
+#define dxQUICKSTEPISLAND_STAGE4LCP_FC_STEP_COMPLETE (dxQUICKSTEPISLAND_STAGE4LCP_FC_WARM_STEP)
+
+// graph colored SOR iterations
+#define dxQUICKSTEPISLAND_STAGE4LCP_COLOR_STEP  32U
+#define dxQUICKSTEPISLAND_STAGE4LCP_COLORS_MAX  64U // The bit count of body color masks
 
 #define dxQUICKSTEPISLAND_STAGE4B_STEP  256U
 
@@ -637,6 +654,21 @@ struct dxQuickStepperStage5CallContext
     void                            *m_stage3MemArenaState;
 };
 
+struct dxQuickStepperStage4CallContext;
+
+// Returns the largest absolute lambda change of the batch rows
+typedef dReal dxSORRowBatchFunction(dxQuickStepperStage4CallContext *stage4CallContext, unsigned int i);
+
+enum dxSORRowStream
+{
+    SRS__MIN,
+
+    SRS_ONE_BODY = SRS__MIN, // The rows of a single body (e.g. contacts with static geometry)
+    SRS_TWO_BODIES,
+
+    SRS__MAX,
+};
+
 struct dxQuickStepperStage4CallContext
 {
     void Initialize(const dxStepperProcessingCallContext *callContext, const dxQuickStepperLocalContext *localContext, 
@@ -644,6 +676,9 @@ struct dxQuickStepperStage4CallContext
     {
         m_stepperCallContext = callContext;
         m_localContext = localContext;
+        m_warmStarting = callContext->m_world->qs.warm_starting;
+        m_graphColoring = callContext->m_world->qs.graph_coloring;
+        m_tolerance = callContext->m_world->qs.tolerance;
         m_lambda = lambda;
         m_cforce = cforce;
         m_iMJ = iMJ;
@@ -659,6 +694,17 @@ struct dxQuickStepperStage4CallContext
         m_mi_fc = 0;
         m_mi_Ad = 0;
         m_LCP_iteration = 0;
+        m_LCP_maxDelta = dxQuickStepStats::encodeResidual(REAL(0.0));
+        m_LCP_color = 0;
+        m_SOR_uncoloredOrder = NULL;
+        m_SOR_bodyColors = NULL;
+        m_SOR_rowColors = NULL;
+        m_SOR_oneBodyRowCount = 0;
+        m_SOR_rowBatchFunctions[SRS_ONE_BODY] = NULL;
+        m_SOR_rowBatchFunctions[SRS_TWO_BODIES] = NULL;
+        m_SOR_rowBatchSize = 1;
+        m_SOR_colorCount = 0;
+        m_SOR_parallelColorCount = 0;
         m_cf_4b = 0;
         m_ji_4b = 0;
     }
@@ -669,6 +715,17 @@ struct dxQuickStepperStage4CallContext
         m_LCP_IterationAllowedThreads = iterationAllowedThreads;
     }
 
+    void AssignSOR_ColoringData(IndexError *uncoloredOrder, duint64 *bodyColors, unsigned char *rowColors, 
+        dxSORRowBatchFunction *const rowBatchFunctions[SRS__MAX], unsigned int rowBatchSize)
+    {
+        m_SOR_uncoloredOrder = uncoloredOrder;
+        m_SOR_bodyColors = bodyColors;
+        m_SOR_rowColors = rowColors;
+        m_SOR_rowBatchFunctions[SRS_ONE_BODY] = rowBatchFunctions[SRS_ONE_BODY];
+        m_SOR_rowBatchFunctions[SRS_TWO_BODIES] = rowBatchFunctions[SRS_TWO_BODIES];
+        m_SOR_rowBatchSize = rowBatchSize;
+    }
+
     void AssignLCP_fcStartReleasee(dCallReleaseeID releaseeInstance)
     {
         m_LCP_fcStartReleasee = releaseeInstance;
@@ -703,9 +760,35 @@ struct dxQuickStepperStage4CallContext
         m_LCP_iterationNextReleasee = nextReleasee;
     }
 
+    void ResetLCP_IterationDelta()
+    {
+        m_LCP_maxDelta = dxQuickStepStats::encodeResidual(REAL(0.0));
+    }
+
+    void RecordLCP_IterationDelta(dReal maxDelta)
+    {
+        ThrsafeRaiseIntToValue(&m_LCP_maxDelta, dxQuickStepStats::encodeResidual(maxDelta));
+    }
+
+    bool IsLCP_IterationConverged() const
+    {
+        return m_tolerance > REAL(0.0) && dxQuickStepStats::decodeResidual(m_LCP_maxDelta) <= m_tolerance;
+    }
+
+    void RecordSOR_ColorSweep(unsigned int startIndex, unsigned int splitIndex, unsigned int endIndex)
+    {
+        m_SOR_colorSweepStart = startIndex;
+        m_SOR_colorSweepSplit = splitIndex;
+        m_SOR_colorSweepEnd = endIndex;
+        m_mi_color = 0;
+    }
+
 
     const dxStepperProcessingCallContext *m_stepperCallContext;
     const dxQuickStepperLocalContext   *m_localContext;
+    bool                            m_warmStarting;
+    bool                            m_graphColoring;
+    dReal                           m_tolerance;
     dReal                           *m_lambda;
     dReal                           *m_cforce;
     dReal                           *m_iMJ;
@@ -723,6 +806,7 @@ struct dxQuickStepperStage4CallContext
     unsigned int                    m_LCP_fcCompleteThreadsTotal;
     volatile atomicord32            m_mi_Ad;
     unsigned int                    m_LCP_iteration;
+    volatile atomicord32            m_LCP_maxDelta; // The largest lambda change of the iteration (encoded as in dxQuickStepStats)
     unsigned int                    m_LCP_iterationThreadsTotal;
     volatile atomicord32            m_LCP_iterationThreadsRemaining;
     dCallReleaseeID                 m_LCP_iterationNextReleasee;
@@ -733,6 +817,21 @@ struct dxQuickStepperStage4CallContext
     volatile atomicord32            m_SOR_mi_zeroHeadTaken;
     volatile atomicord32            m_SOR_mi_zeroTailTaken;
     volatile atomicord32            m_SOR_reorderThreadsRemaining;
+    unsigned int                    m_SOR_oneBodyRowCount;
+    IndexError                      *m_SOR_uncoloredOrder;
+    duint64                         *m_SOR_bodyColors;
+    unsigned char                   *m_SOR_rowColors;
+    dxSORRowBatchFunction           *m_SOR_rowBatchFunctions[SRS__MAX];
+    unsigned int                    m_SOR_rowBatchSize;
+    unsigned int                    m_SOR_colorCount;
+    unsigned int                    m_SOR_parallelColorCount;
+    unsigned int                    m_SOR_colorStarts[dxQUICKSTEPISLAND_STAGE4LCP_COLORS_MAX + 2];
+    unsigned int                    m_SOR_colorSplits[dxQUICKSTEPISLAND_STAGE4LCP_COLORS_MAX + 1]; // The two body rows start of each color
+    unsigned int                    m_LCP_color;
+    unsigned int                    m_SOR_colorSweepStart;
+    unsigned int                    m_SOR_colorSweepSplit;
+    unsigned int                    m_SOR_colorSweepEnd;
+    volatile atomicord32            m_mi_color;
     volatile atomicord32            m_cf_4b;
     volatile atomicord32            m_ji_4b;
 };
@@ -743,15 +842,15 @@ static int dxQuickStepIsland_Stage4LCP_iMJ_Callback(void *callContext, dcallinde
 static int dxQuickStepIsland_Stage4LCP_iMJSync_Callback(void *callContext, dcallindex_t callInstanceIndex, dCallReleaseeID callThisReleasee);
 static int dxQuickStepIsland_Stage4LCP_fcStart_Callback(void *callContext, dcallindex_t callInstanceIndex, dCallReleaseeID callThisReleasee);
 static int dxQuickStepIsland_Stage4LCP_fc_Callback(void *callContext, dcallindex_t callInstanceIndex, dCallReleaseeID callThisReleasee);
-#ifdef WARM_STARTING
 static int dxQuickStepIsland_Stage4LCP_fcWarmComplete_Callback(void *_stage4CallContext, dcallindex_t callInstanceIndex, dCallReleaseeID callThisReleasee);
-#endif
 static int dxQuickStepIsland_Stage4LCP_Ad_Callback(void *callContext, dcallindex_t callInstanceIndex, dCallReleaseeID callThisReleasee);
 static int dxQuickStepIsland_Stage4LCP_ReorderPrep_Callback(void *callContext, dcallindex_t callInstanceIndex, dCallReleaseeID callThisReleasee);
 static int dxQuickStepIsland_Stage4LCP_IterationStart_Callback(void *callContext, dcallindex_t callInstanceIndex, dCallReleaseeID callThisReleasee);
 static int dxQuickStepIsland_Stage4LCP_ConstraintsReordering_Callback(void *_stage4CallContext, dcallindex_t callInstanceIndex, dCallReleaseeID callThisReleasee);
 static int dxQuickStepIsland_Stage4LCP_ConstraintsReorderingSync_Callback(void *_stage4CallContext, dcallindex_t callInstanceIndex, dCallReleaseeID callThisReleasee);
 static int dxQuickStepIsland_Stage4LCP_Iteration_Callback(void *callContext, dcallindex_t callInstanceIndex, dCallReleaseeID callThisReleasee);
+static int dxQuickStepIsland_Stage4LCP_ColoredIterationStart_Callback(void *callContext, dcallindex_t callInstanceIndex, dCallReleaseeID callThisReleasee);
+static int dxQuickStepIsland_Stage4LCP_ColorSweep_Callback(void *callContext, dcallindex_t callInstanceIndex, dCallReleaseeID callThisReleasee);
 static int dxQuickStepIsland_Stage4LCP_IterationSync_Callback(void *callContext, dcallindex_t callInstanceIndex, dCallReleaseeID callThisReleasee);
 static int dxQuickStepIsland_Stage4b_Callback(void *callContext, dcallindex_t callInstanceIndex, dCallReleaseeID callThisReleasee);
 static int dxQuickStepIsland_Stage5_Callback(void *callContext, dcallindex_t callInstanceIndex, dCallReleaseeID callThisReleasee);
@@ -759,16 +858,15 @@ static int dxQuickStepIsland_Stage5_Callback(void *callContext, dcallindex_t cal
 static void dxQuickStepIsland_Stage4a(dxQuickStepperStage4CallContext *stage4CallContext);
 static void dxQuickStepIsland_Stage4LCP_iMJComputation(dxQuickStepperStage4CallContext *stage4CallContext);
 static void dxQuickStepIsland_Stage4LCP_MTfcComputation(dxQuickStepperStage4CallContext *stage4CallContext, dCallReleaseeID callThisReleasee);
-#ifdef WARM_STARTING
 static void dxQuickStepIsland_Stage4LCP_MTfcComputation_warm(dxQuickStepperStage4CallContext *stage4CallContext, dCallReleaseeID callThisReleasee);
 static void dxQuickStepIsland_Stage4LCP_MTfcComputation_warmZeroArrays(dxQuickStepperStage4CallContext *stage4CallContext);
 static void dxQuickStepIsland_Stage4LCP_MTfcComputation_warmPrepare(dxQuickStepperStage4CallContext *stage4CallContext);
 static void dxQuickStepIsland_Stage4LCP_MTfcComputation_warmComplete(dxQuickStepperStage4CallContext *stage4CallContext);
-#endif
 static void dxQuickStepIsland_Stage4LCP_MTfcComputation_cold(dxQuickStepperStage4CallContext *stage4CallContext);
 static void dxQuickStepIsland_Stage4LCP_STfcComputation(dxQuickStepperStage4CallContext *stage4CallContext);
 static void dxQuickStepIsland_Stage4LCP_AdComputation(dxQuickStepperStage4CallContext *stage4CallContext);
 static void dxQuickStepIsland_Stage4LCP_ReorderPrep(dxQuickStepperStage4CallContext *stage4CallContext);
+static void dxQuickStepIsland_Stage4LCP_ConstraintsColoring(dxQuickStepperStage4CallContext *stage4CallContext);
 static void dxQuickStepIsland_Stage4LCP_ConstraintsReordering(dxQuickStepperStage4CallContext *stage4CallContext);
 static bool dxQuickStepIsland_Stage4LCP_ConstraintsShuffling(dxQuickStepperStage4CallContext *stage4CallContext, unsigned int iteration);
 static void dxQuickStepIsland_Stage4LCP_LinksArraysZeroing(dxQuickStepperStage4CallContext *stage4CallContext);
@@ -776,7 +874,16 @@ static void dxQuickStepIsland_Stage4LCP_DependencyMapForNewOrderRebuilding(dxQui
 static void dxQuickStepIsland_Stage4LCP_DependencyMapFromSavedLevelsReconstruction(dxQuickStepperStage4CallContext *stage4CallContext);
 static void dxQuickStepIsland_Stage4LCP_MTIteration(dxQuickStepperStage4CallContext *stage4CallContext, unsigned int initiallyKnownToBeCompletedLevel);
 static void dxQuickStepIsland_Stage4LCP_STIteration(dxQuickStepperStage4CallContext *stage4CallContext);
-static void dxQuickStepIsland_Stage4LCP_IterationStep(dxQuickStepperStage4CallContext *stage4CallContext, unsigned int i);
+static void dxQuickStepIsland_Stage4LCP_ColorSweep(dxQuickStepperStage4CallContext *stage4CallContext);
+static void dxQuickStepIsland_Stage4LCP_STColoredIteration(dxQuickStepperStage4CallContext *stage4CallContext);
+template<bool tTwoBodies>
+static dReal dxQuickStepIsland_Stage4LCP_ColorRangeSweep(dxQuickStepperStage4CallContext *stage4CallContext, unsigned int startIndex, unsigned int endIndex);
+static dReal dxQuickStepIsland_Stage4LCP_ColorSweepInPlace(dxQuickStepperStage4CallContext *stage4CallContext, unsigned int color);
+static unsigned int dxQuickStepIsland_Stage4LCP_SelectRowBatchFunctions(dxSORRowBatchFunction *out_batchFunctions[SRS__MAX], bool allowSIMD);
+static dReal dxQuickStepIsland_Stage4LCP_IterationStep(dxQuickStepperStage4CallContext *stage4CallContext, unsigned int i);
+template<bool tTwoBodies>
+static dReal dxQuickStepIsland_Stage4LCP_RowIterationStep(dxQuickStepperStage4CallContext *stage4CallContext, unsigned int i);
+static void dxQuickStepIsland_Stage4LCP_IterationStatsRecording(dxQuickStepperStage4CallContext *stage4CallContext);
 static void dxQuickStepIsland_Stage4b(dxQuickStepperStage4CallContext *stage4CallContext);
 static void dxQuickStepIsland_Stage5(dxQuickStepperStage5CallContext *stage5CallContext);
 
@@ -849,8 +956,6 @@ void compute_invM_JT (volatile atomicord32 *mi_storage, dReal *iMJ,
     }
 }
 
-#ifdef WARM_STARTING
-
 static 
 void multiply_invM_JT_init_array(unsigned int nb, atomicord32 *bi_links/*=[nb]*/)
 {
@@ -969,7 +1074,6 @@ void _multiply_invM_JT (dReal *out,
         iMJ_ptr += IMJ__MAX;
     }
 }
-#endif
 
 // compute out = J*in.
 template<unsigned int step_size, unsigned int in_offset, unsigned int in_stride>
@@ -1178,36 +1282,39 @@ void dxQuickStepIsland_Stage0_Bodies(dxQuickStepperStage0BodiesCallContext *call
     // frame, and compute the rotational force and add it to the torque
     // accumulator. I and invI are a vertical stack of 3x4 matrices, one per body.
     {
+        const dxBodyStateStore &state = callContext->m_stepperCallContext->m_world->body_state;
         dReal *invI = callContext->m_invI;
         unsigned int bodyIndex;
         while ((bodyIndex = ThrsafeIncrementIntUpToLimit(&callContext->m_inertiaBodyIndex, nb)) != nb) {
             dReal *invIrow = invI + (sizeint)bodyIndex * IIE__MAX;
             dxBody *b = body[bodyIndex];
+            const unsigned slot = b->state_slot;
+            const dReal *R = state.R(slot), *avel = state.avel(slot);
 
             dMatrix3 tmp;
             // compute inverse inertia tensor in global frame
-            dMultiply2_333 (tmp, b->invI, b->posr.R);
-            dMultiply0_333 (invIrow + IIE__MATRIX_MIN, b->posr.R, tmp);
+            dMultiply2_333 (tmp, state.invI(slot), R);
+            dMultiply0_333 (invIrow + IIE__MATRIX_MIN, R, tmp);
 
             // Don't apply gyroscopic torques to bodies
             // if not flagged or the body is kinematic
-            if ((b->flags & dxBodyGyroscopic) && (b->invMass > 0)) {
+            if ((b->flags & dxBodyGyroscopic) && (state.invMass(slot) > 0)) {
                 dMatrix3 I;
                 // compute inertia tensor in global frame
-                dMultiply2_333 (tmp, b->mass.I, b->posr.R);
-                dMultiply0_333 (I, b->posr.R, tmp);
+                dMultiply2_333 (tmp, state.I(slot), R);
+                dMultiply0_333 (I, R, tmp);
                 // compute rotational force
 #if 0
                 // Explicit computation
-                dMultiply0_331 (tmp, I, b->avel);
-                dSubtractVectorCross3(b->tacc, b->avel, tmp);
+                dMultiply0_331 (tmp, I, avel);
+                dSubtractVectorCross3(b->tacc, avel, tmp);
 #else
                 // Do the implicit computation based on 
                 //"Stabilizing Gyroscopic Forces in Rigid Multibody Simulations"
                 // (Lacoursière 2006)
                 dReal h = callContext->m_stepperCallContext->m_stepSize; // Step size
                 dVector3 L; // Compute angular momentum
-                dMultiply0_331(L, I, b->avel);
+                dMultiply0_331(L, I, avel);
                 
                 // Compute a new effective 'inertia tensor'
                 // for the implicit step: the cross-product 
@@ -1609,6 +1716,7 @@ void dxQuickStepIsland_Stage2b(dxQuickStepperStage2CallContext *stage2CallContex
         // Warning!!!
         dxBody * const *const body = callContext->m_islandBodiesStart;
         const unsigned int nb = callContext->m_islandBodiesCount;
+        const dxBodyStateStore &state = callContext->m_world->body_state;
         const dReal *invI = localContext->m_invI;
         dReal *rhs_tmp = stage2CallContext->m_rhs_tmp;
 
@@ -1627,10 +1735,12 @@ void dxQuickStepIsland_Stage2b(dxQuickStepperStage2CallContext *stage2CallContex
             const dReal *invIrow = invI + (sizeint)bi * IIE__MAX;
             while (true) {
                 dxBody *b = body[bi];
-                dReal body_invMass = b->invMass;
-                for (unsigned int j = dSA__MIN; j != dSA__MAX; ++j) rhscurr[RHS__L_MIN + j] = -(b->facc[dV3E__AXES_MIN + j] * body_invMass + b->lvel[dV3E__AXES_MIN + j] * stepsizeRecip);
+                const unsigned slot = b->state_slot;
+                dReal body_invMass = state.invMass(slot);
+                const dReal *lvel = state.lvel(slot), *avel = state.avel(slot);
+                for (unsigned int j = dSA__MIN; j != dSA__MAX; ++j) rhscurr[RHS__L_MIN + j] = -(b->facc[dV3E__AXES_MIN + j] * body_invMass + lvel[dV3E__AXES_MIN + j] * stepsizeRecip);
                 dMultiply0_331 (rhscurr + RHS__A_MIN, invIrow + IIE__MATRIX_MIN, b->tacc);
-                for (unsigned int k = dSA__MIN; k != dSA__MAX; ++k) rhscurr[RHS__A_MIN + k] = -(b->avel[dV3E__AXES_MIN + k] * stepsizeRecip) - rhscurr[RHS__A_MIN + k];
+                for (unsigned int k = dSA__MIN; k != dSA__MAX; ++k) rhscurr[RHS__A_MIN + k] = -(avel[dV3E__AXES_MIN + k] * stepsizeRecip) - rhscurr[RHS__A_MIN + k];
                 
                 if (++bi == biend) {
                     break;
@@ -1758,6 +1868,16 @@ void dxQuickStepIsland_Stage3(dxQuickStepperStage3CallContext *stage3CallContext
         dxQuickStepperStage4CallContext *stage4CallContext = (dxQuickStepperStage4CallContext *)memarena->AllocateBlock(sizeof(dxQuickStepperStage4CallContext));
         stage4CallContext->Initialize(callContext, localContext, lambda, cforce, iMJ, order, last_lambda, bi_links_or_mi_levels, mi_links);
 
+        if (stage4CallContext->m_graphColoring) {
+            // the order is partitioned into here and then laid out color by color into the order array
+            IndexError *uncolored_order = memarena->AllocateArray<IndexError>(m);
+            duint64 *body_colors = memarena->AllocateArray<duint64>(nb);
+            unsigned char *row_colors = memarena->AllocateArray<unsigned char>(m);
+            dxSORRowBatchFunction *row_batch_functions[SRS__MAX];
+            unsigned int row_batch_size = dxQuickStepIsland_Stage4LCP_SelectRowBatchFunctions(row_batch_functions, callContext->m_world->qs.row_batching != 0);
+            stage4CallContext->AssignSOR_ColoringData(uncolored_order, body_colors, row_colors, row_batch_functions, row_batch_size);
+        }
+
         if (singleThreadedExecution)
         {
             dxQuickStepIsland_Stage4a(stage4CallContext);
@@ -1770,13 +1890,28 @@ void dxQuickStepIsland_Stage3(dxQuickStepperStage3CallContext *stage3CallContext
             
             dxWorld *world = callContext->m_world;
             const unsigned int num_iterations = world->qs.num_iterations;
-            for (unsigned int iteration=0; iteration < num_iterations; iteration++) {
-                if (IsSORConstraintsReorderRequiredForIteration(iteration)) {
+            unsigned int iteration = 0;
+            while (iteration < num_iterations) {
+                // colored rows keep their order for the whole step
+                if (!stage4CallContext->m_graphColoring && IsSORConstraintsReorderRequiredForIteration(iteration)) {
                     stage4CallContext->ResetSOR_ConstraintsReorderVariables(0);
                     dxQuickStepIsland_Stage4LCP_ConstraintsShuffling(stage4CallContext, iteration);
                 }
-                dxQuickStepIsland_Stage4LCP_STIteration(stage4CallContext);
+                stage4CallContext->ResetLCP_IterationDelta();
+                if (stage4CallContext->m_graphColoring) {
+                    dxQuickStepIsland_Stage4LCP_STColoredIteration(stage4CallContext);
+                }
+                else {
+                    dxQuickStepIsland_Stage4LCP_STIteration(stage4CallContext);
+                }
+                ++iteration;
+
+                if (stage4CallContext->IsLCP_IterationConverged()) {
+                    break;
+                }
             }
+            stage4CallContext->m_LCP_iteration = iteration;
+            dxQuickStepIsland_Stage4LCP_IterationStatsRecording(stage4CallContext);
 
             dxQuickStepIsland_Stage4b(stage4CallContext);
             dxQuickStepIsland_Stage5(stage5CallContext);
@@ -1796,26 +1931,29 @@ void dxQuickStepIsland_Stage3(dxQuickStepperStage3CallContext *stage3CallContext
             unsigned int stage4LCP_Iteration_allowedThreads = CalculateOptimalThreadsCount<1U>(m, allowedThreads);
             stage4CallContext->AssignLCP_IterationData(stage4LCP_IterationSyncReleasee, stage4LCP_Iteration_allowedThreads);
 
+            dThreadedCallFunction *stage4LCP_IterationStartFunction = stage4CallContext->m_graphColoring
+                ? &dxQuickStepIsland_Stage4LCP_ColoredIterationStart_Callback : &dxQuickStepIsland_Stage4LCP_IterationStart_Callback;
+
             dCallReleaseeID stage4LCP_IterationStartReleasee;
             world->PostThreadedCall(NULL, &stage4LCP_IterationStartReleasee, 3, stage4LCP_IterationSyncReleasee, 
-                NULL, &dxQuickStepIsland_Stage4LCP_IterationStart_Callback, stage4CallContext, 0, "QuickStepIsland Stage4LCP_Iteration Start");
+                NULL, stage4LCP_IterationStartFunction, stage4CallContext, 0, "QuickStepIsland Stage4LCP_Iteration Start");
 
             unsigned int nj = localContext->m_nj;
             unsigned int stage4a_allowedThreads = CalculateOptimalThreadsCount<dxQUICKSTEPISLAND_STAGE4A_STEP>(nj, allowedThreads);
 
             dCallReleaseeID stage4LCP_fcStartReleasee;
-            // Note: It is unnecessary to make fc dependent on 4a if there is no WARM_STARTING
-            // However I'm doing so to minimize use of preprocessor conditions in sources
+            // Note: It is unnecessary to make fc dependent on 4a if there is no warm starting
+            // However I'm doing so to keep the call graph the same in both modes
             unsigned stage4LCP_fcDependenciesCountToUse = stage4a_allowedThreads;
-#ifdef WARM_STARTING
-            // Posted with extra dependency to be removed from dxQuickStepIsland_Stage4LCP_iMJSync_Callback
-            stage4LCP_fcDependenciesCountToUse += 1;
-#endif
+            if (stage4CallContext->m_warmStarting) {
+                // Posted with extra dependency to be removed from dxQuickStepIsland_Stage4LCP_iMJSync_Callback
+                stage4LCP_fcDependenciesCountToUse += 1;
+            }
             world->PostThreadedCall(NULL, &stage4LCP_fcStartReleasee, stage4LCP_fcDependenciesCountToUse, stage4LCP_IterationStartReleasee, 
                 NULL, &dxQuickStepIsland_Stage4LCP_fcStart_Callback, stage4CallContext, 0, "QuickStepIsland Stage4LCP_fc Start");
-#ifdef WARM_STARTING
-            stage4CallContext->AssignLCP_fcStartReleasee(stage4LCP_fcStartReleasee);
-#endif
+            if (stage4CallContext->m_warmStarting) {
+                stage4CallContext->AssignLCP_fcStartReleasee(stage4LCP_fcStartReleasee);
+            }
 
             unsigned stage4LCP_iMJ_allowedThreads = CalculateOptimalThreadsCount<dxQUICKSTEPISLAND_STAGE4LCP_IMJ_STEP>(m, allowedThreads);
 
@@ -1855,9 +1993,8 @@ void dxQuickStepIsland_Stage4a(dxQuickStepperStage4CallContext *stage4CallContex
 
     dReal *lambda = stage4CallContext->m_lambda;
     const dxMIndexItem *mindex = localContext->m_mindex;
-#ifdef WARM_STARTING
     dJointWithInfo1 *jointinfos = localContext->m_jointinfos;
-#endif
+    const bool warmStarting = stage4CallContext->m_warmStarting;
     unsigned int nj = localContext->m_nj;
     const unsigned int step_size = dxQUICKSTEPISLAND_STAGE4A_STEP;
     unsigned int nj_steps = (nj + (step_size - 1)) / step_size;
@@ -1866,31 +2003,32 @@ void dxQuickStepIsland_Stage4a(dxQuickStepperStage4CallContext *stage4CallContex
     while ((ji_step = ThrsafeIncrementIntUpToLimit(&stage4CallContext->m_ji_4a, nj_steps)) != nj_steps) {
         unsigned int ji = ji_step * step_size;
         dReal *lambdacurr = lambda + mindex[ji].mIndex;
-#ifdef WARM_STARTING
-        const dJointWithInfo1 *jicurr = jointinfos + ji;
-        const dJointWithInfo1 *const jiend = jicurr + dMIN(step_size, nj - ji);
-        
-        do {
-            const dReal *joint_lambdas = jicurr->joint->lambda;
-            dReal *const lambdsnext = lambdacurr + jicurr->info.m;
-            
-            while (true) {
-                // for warm starting, multiplication by 0.9 seems to be necessary to prevent
-                // jerkiness in motor-driven joints. I have no idea why this works.
-                *lambdacurr = *joint_lambdas * 0.9;
+        if (warmStarting) {
+            const dJointWithInfo1 *jicurr = jointinfos + ji;
+            const dJointWithInfo1 *const jiend = jicurr + dMIN(step_size, nj - ji);
 
-                if (++lambdacurr == lambdsnext) {
-                    break;
-                }
+            do {
+                const dReal *joint_lambdas = jicurr->joint->lambda;
+                dReal *const lambdsnext = lambdacurr + jicurr->info.m;
 
-                ++joint_lambdas;
-            }
-        } 
-        while (++jicurr != jiend);
-#else
-        dReal *lambdsnext = lambda + mindex[ji + dMIN(step_size, nj - ji)].mIndex;
-        dSetZero(lambdacurr, lambdsnext - lambdacurr);
-#endif
+                while (true) {
+                    // for warm starting, multiplication by 0.9 seems to be necessary to prevent
+                    // jerkiness in motor-driven joints. I have no idea why this works.
+                    *lambdacurr = *joint_lambdas * 0.9;
+
+                    if (++lambdacurr == lambdsnext) {
+                        break;
+                    }
+
+                    ++joint_lambdas;
+                }
+            } 
+            while (++jicurr != jiend);
+        }
+        else {
+            dReal *lambdsnext = lambda + mindex[ji + dMIN(step_size, nj - ji)].mIndex;
+            dSetZero(lambdacurr, lambdsnext - lambdacurr);
+        }
     }
 }
 
@@ -1934,12 +2072,10 @@ int dxQuickStepIsland_Stage4LCP_iMJSync_Callback(void *_stage4CallContext, dcall
 
     unsigned int stage4LCP_Ad_allowedThreads = CalculateOptimalThreadsCount<dxQUICKSTEPISLAND_STAGE4LCP_AD_STEP>(m, allowedThreads);
 
-#ifdef WARM_STARTING
-    {
+    if (stage4CallContext->m_warmStarting) {
         dxWorld *world = callContext->m_world;
         world->AlterThreadedCallDependenciesCount(stage4CallContext->m_LCP_fcStartReleasee, -1);
     }
-#endif
     
     if (stage4LCP_Ad_allowedThreads > 1) {
         dxWorld *world = callContext->m_world;
@@ -1959,22 +2095,24 @@ int dxQuickStepIsland_Stage4LCP_fcStart_Callback(void *_stage4CallContext, dcall
     const dxStepperProcessingCallContext *callContext = stage4CallContext->m_stepperCallContext;
     const dxQuickStepperLocalContext *localContext = stage4CallContext->m_localContext;
 
-    unsigned int fcPrepareComplexity, fcCompleteComplexity;
-#ifdef WARM_STARTING
-    fcPrepareComplexity = localContext->m_m / dxQUICKSTEPISLAND_STAGE4LCP_FC_COMPLETE_TO_PREPARE_COMPLEXITY_DIVISOR;
-    fcCompleteComplexity = callContext->m_islandBodiesCount;
-#else
-    fcPrepareComplexity = localContext->m_m;
-    fcCompleteComplexity = 0;
-#endif
     const unsigned allowedThreads = callContext->m_stepperAllowedThreads;
-    unsigned int stage4LCP_fcPrepare_allowedThreads = CalculateOptimalThreadsCount<dxQUICKSTEPISLAND_STAGE4LCP_FC_STEP>(fcPrepareComplexity, allowedThreads);
-    unsigned int stage4LCP_fcComplete_allowedThreads = CalculateOptimalThreadsCount<dxQUICKSTEPISLAND_STAGE4LCP_FC_STEP>(fcCompleteComplexity, allowedThreads);
+    unsigned int stage4LCP_fcPrepare_allowedThreads, stage4LCP_fcComplete_allowedThreads;
+    if (stage4CallContext->m_warmStarting) {
+        unsigned int fcPrepareComplexity = localContext->m_m / dxQUICKSTEPISLAND_STAGE4LCP_FC_COMPLETE_TO_PREPARE_COMPLEXITY_DIVISOR;
+        unsigned int fcCompleteComplexity = callContext->m_islandBodiesCount;
+        stage4LCP_fcPrepare_allowedThreads = CalculateOptimalThreadsCount<dxQUICKSTEPISLAND_STAGE4LCP_FC_WARM_STEP>(fcPrepareComplexity, allowedThreads);
+        stage4LCP_fcComplete_allowedThreads = CalculateOptimalThreadsCount<dxQUICKSTEPISLAND_STAGE4LCP_FC_WARM_STEP>(fcCompleteComplexity, allowedThreads);
+    }
+    else {
+        unsigned int fcPrepareComplexity = localContext->m_m;
+        stage4LCP_fcPrepare_allowedThreads = CalculateOptimalThreadsCount<dxQUICKSTEPISLAND_STAGE4LCP_FC_STEP>(fcPrepareComplexity, allowedThreads);
+        stage4LCP_fcComplete_allowedThreads = 0;
+    }
     stage4CallContext->AssignLCP_fcAllowedThreads(stage4LCP_fcPrepare_allowedThreads, stage4LCP_fcComplete_allowedThreads);
 
-#ifdef WARM_STARTING
-    dxQuickStepIsland_Stage4LCP_MTfcComputation_warmZeroArrays(stage4CallContext);
-#endif
+    if (stage4CallContext->m_warmStarting) {
+        dxQuickStepIsland_Stage4LCP_MTfcComputation_warmZeroArrays(stage4CallContext);
+    }
 
     if (stage4LCP_fcPrepare_allowedThreads > 1) {
         dxWorld *world = callContext->m_world;
@@ -1998,16 +2136,14 @@ int dxQuickStepIsland_Stage4LCP_fc_Callback(void *_stage4CallContext, dcallindex
 static 
 void dxQuickStepIsland_Stage4LCP_MTfcComputation(dxQuickStepperStage4CallContext *stage4CallContext, dCallReleaseeID callThisReleasee)
 {
-#ifdef WARM_STARTING
-    dxQuickStepIsland_Stage4LCP_MTfcComputation_warm(stage4CallContext, callThisReleasee);
-#else
-    (void)callThisReleasee; // unused
-    dxQuickStepIsland_Stage4LCP_MTfcComputation_cold(stage4CallContext);
-#endif
+    if (stage4CallContext->m_warmStarting) {
+        dxQuickStepIsland_Stage4LCP_MTfcComputation_warm(stage4CallContext, callThisReleasee);
+    }
+    else {
+        dxQuickStepIsland_Stage4LCP_MTfcComputation_cold(stage4CallContext);
+    }
 }
 
-#ifdef WARM_STARTING
-
 static 
 void dxQuickStepIsland_Stage4LCP_MTfcComputation_warm(dxQuickStepperStage4CallContext *stage4CallContext, dCallReleaseeID callThisReleasee)
 {
@@ -2082,8 +2218,6 @@ void dxQuickStepIsland_Stage4LCP_MTfcComputation_warmComplete(dxQuickStepperStag
     multiply_invM_JT_complete<dxQUICKSTEPISLAND_STAGE4LCP_FC_STEP_COMPLETE, CFE__DYNAMICS_MIN, CFE__MAX>(&stage4CallContext->m_mi_fc, fc, nb, iMJ, jb, lambda, stage4CallContext->m_bi_links_or_mi_levels, stage4CallContext->m_mi_links);
 }
 
-#else // #ifndef WARM_STARTING
-
 static 
 void dxQuickStepIsland_Stage4LCP_MTfcComputation_cold(dxQuickStepperStage4CallContext *stage4CallContext)
 {
@@ -2102,34 +2236,29 @@ void dxQuickStepIsland_Stage4LCP_MTfcComputation_cold(dxQuickStepperStage4CallCo
     }
 }
 
-#endif // #ifndef WARM_STARTING
-
 
 static 
 void dxQuickStepIsland_Stage4LCP_STfcComputation(dxQuickStepperStage4CallContext *stage4CallContext)
 {
-#ifdef WARM_STARTING
     const dxStepperProcessingCallContext *callContext = stage4CallContext->m_stepperCallContext;
-    const dxQuickStepperLocalContext *localContext = stage4CallContext->m_localContext;
-
     dReal *fc = stage4CallContext->m_cforce;
-    unsigned int m = localContext->m_m;
     unsigned int nb = callContext->m_islandBodiesCount;
-    dReal *iMJ = stage4CallContext->m_iMJ;
-    const dxJBodiesItem *jb = localContext->m_jb;
-    dReal *lambda = stage4CallContext->m_lambda;
 
-    // compute fc=(inv(M)*J')*lambda. we will incrementally maintain fc
-    // as we change lambda.
-    _multiply_invM_JT<CFE__DYNAMICS_MIN, CFE__MAX>(fc, m, nb, iMJ, jb, lambda);
-#else
-	dReal *fc = stage4CallContext->m_cforce;
-    const dxStepperProcessingCallContext *callContext = stage4CallContext->m_stepperCallContext;
-    unsigned int nb = callContext->m_islandBodiesCount;
+    if (stage4CallContext->m_warmStarting) {
+        const dxQuickStepperLocalContext *localContext = stage4CallContext->m_localContext;
 
-    dSetZero(fc, (sizeint)nb * CFE__MAX);
-#endif
+        unsigned int m = localContext->m_m;
+        dReal *iMJ = stage4CallContext->m_iMJ;
+        const dxJBodiesItem *jb = localContext->m_jb;
+        dReal *lambda = stage4CallContext->m_lambda;
 
+        // compute fc=(inv(M)*J')*lambda. we will incrementally maintain fc
+        // as we change lambda.
+        _multiply_invM_JT<CFE__DYNAMICS_MIN, CFE__MAX>(fc, m, nb, iMJ, jb, lambda);
+    }
+    else {
+        dSetZero(fc, (sizeint)nb * CFE__MAX);
+    }
 }
 
 static 
@@ -2227,25 +2356,144 @@ void dxQuickStepIsland_Stage4LCP_ReorderPrep(dxQuickStepperStage4CallContext *st
     unsigned int m = localContext->m_m;
     unsigned int valid_findices = localContext->m_valid_findices;
 
-    IndexError *order = stage4CallContext->m_order;
+    // with graph coloring the partitioned order is only an input for the coloring
+    IndexError *order = stage4CallContext->m_graphColoring ? stage4CallContext->m_SOR_uncoloredOrder : stage4CallContext->m_order;
+
+    const dxJBodiesItem *jb = localContext->m_jb;
+    const int *findex = localContext->m_findex;
+
+    unsigned int m1 = 0, m1_findices = 0;
+    for (unsigned int i = 0; i != m; ++i) {
+        if (jb[i].second == -1) {
+            m1 += 1;
+            m1_findices += findex[i] != -1;
+        }
+    }
 
     {
-        // make sure constraints with findex < 0 come first.
-        IndexError *orderhead = order, *ordertail = order + (m - valid_findices);
-        const int *findex = localContext->m_findex;
+        // make sure single body constraints come first, so that the two streams 
+        // could be solved with separate kernels, and that constraints with 
+        // findex < 0 come first within each stream.
+        IndexError *orderheads[SRS__MAX] = { order, order + m1 };
+        IndexError *ordertails[SRS__MAX] = { order + (m1 - m1_findices), order + (m - (valid_findices - m1_findices)) };
 
-        // Fill the array from both ends
+        // Fill the arrays from both ends
         for (unsigned int i = 0; i != m; ++i) {
+            unsigned int stream = jb[i].second == -1 ? SRS_ONE_BODY : SRS_TWO_BODIES;
             if (findex[i] == -1) {
-                orderhead->index = i; // Place them at the front
-                ++orderhead;
+                orderheads[stream]->index = i; // Place them at the front
+                ++orderheads[stream];
             } else {
-                ordertail->index = i; // Place them at the end
-                ++ordertail;
+                ordertails[stream]->index = i; // Place them at the end
+                ++ordertails[stream];
+            }
+        }
+        dIASSERT(orderheads[SRS_ONE_BODY] == order + (m1 - m1_findices));
+        dIASSERT(ordertails[SRS_ONE_BODY] == order + m1);
+        dIASSERT(orderheads[SRS_TWO_BODIES] == order + (m - (valid_findices - m1_findices)));
+        dIASSERT(ordertails[SRS_TWO_BODIES] == order + m);
+    }
+
+    stage4CallContext->m_SOR_oneBodyRowCount = m1;
+
+    const dxStepperProcessingCallContext *callContext = stage4CallContext->m_stepperCallContext;
+    dxQuickStepStats *stats = &callContext->m_world->qs_stats;
+    ThrsafeAdd(&stats->one_body_rows, m1);
+    ThrsafeAdd(&stats->two_body_rows, m - m1);
+
+    if (stage4CallContext->m_graphColoring) {
+        dxQuickStepIsland_Stage4LCP_ConstraintsColoring(stage4CallContext);
+    }
+}
+
+static 
+void dxQuickStepIsland_Stage4LCP_ConstraintsColoring(dxQuickStepperStage4CallContext *stage4CallContext)
+{
+    const dxStepperProcessingCallContext *callContext = stage4CallContext->m_stepperCallContext;
+    const dxQuickStepperLocalContext *localContext = stage4CallContext->m_localContext;
+    unsigned int m = localContext->m_m;
+    unsigned int nb = callContext->m_islandBodiesCount;
+
+    const IndexError *uncolored_order = stage4CallContext->m_SOR_uncoloredOrder;
+    duint64 *body_colors = stage4CallContext->m_SOR_bodyColors;
+    unsigned char *row_colors = stage4CallContext->m_SOR_rowColors;
+
+    // The rows that can not be given a color are swept serially after all the colors
+    const unsigned int serial_color = dxQUICKSTEPISLAND_STAGE4LCP_COLORS_MAX;
+    unsigned int color_sizes[dxQUICKSTEPISLAND_STAGE4LCP_COLORS_MAX + 1];
+    unsigned int color_one_body_sizes[dxQUICKSTEPISLAND_STAGE4LCP_COLORS_MAX + 1];
+    memset(color_sizes, 0, sizeof(color_sizes));
+    memset(color_one_body_sizes, 0, sizeof(color_one_body_sizes));
+    memset(body_colors, 0, sizeof(body_colors[0]) * nb);
+
+    unsigned int parallel_colors = 0;
+    {
+        const dxJBodiesItem *jb = localContext->m_jb;
+        const int *findex = localContext->m_findex;
+
+        for (unsigned int i = 0; i != m; ++i) {
+            unsigned int index = uncolored_order[i].index;
+
+            int b1 = jb[index].first;
+            int b2 = jb[index].second;
+
+            duint64 busy_colors = body_colors[(unsigned int)b1];
+            if (b2 != -1) {
+                busy_colors |= body_colors[(unsigned int)b2];
+            }
+
+            // A row limited by findex must be swept after the row it refers to.
+            // The findex rows come last in the order and so the referred rows already have their colors.
+            unsigned int color = 0;
+            if (findex[index] != -1) {
+                color = dMIN(row_colors[(unsigned int)findex[index]] + 1U, serial_color);
             }
+
+            // Take the lowest color that none of the row bodies has been given yet
+            for (; color != serial_color; ++color) {
+                if ((busy_colors & ((duint64)1 << color)) == 0) {
+                    break;
+                }
+            }
+
+            if (color != serial_color) {
+                duint64 color_bit = (duint64)1 << color;
+                body_colors[(unsigned int)b1] |= color_bit;
+                if (b2 != -1) {
+                    body_colors[(unsigned int)b2] |= color_bit;
+                }
+                parallel_colors = dMAX(parallel_colors, color + 1);
+            }
+
+            row_colors[index] = (unsigned char)color;
+            color_sizes[color] += 1;
+            color_one_body_sizes[color] += b2 == -1;
         }
-        dIASSERT(orderhead == order + (m - valid_findices));
-        dIASSERT(ordertail == order + m);
+    }
+
+    // Lay the rows out color by color preserving their relative order.
+    // Since the single body rows come first in the uncolored order they also come first within each color.
+    unsigned int *color_starts = stage4CallContext->m_SOR_colorStarts;
+    unsigned int *color_splits = stage4CallContext->m_SOR_colorSplits;
+    unsigned int color_offset = 0;
+    for (unsigned int color = 0; color != parallel_colors; ++color) {
+        color_starts[color] = color_offset;
+        color_splits[color] = color_offset + color_one_body_sizes[color];
+        color_offset += color_sizes[color];
+        color_sizes[color] = color_starts[color]; // Reuse sizes as the fill positions
+    }
+    color_starts[parallel_colors] = color_offset;
+    color_splits[parallel_colors] = color_offset + color_one_body_sizes[serial_color];
+    color_sizes[serial_color] = color_offset;
+    color_starts[parallel_colors + 1] = m;
+
+    stage4CallContext->m_SOR_parallelColorCount = parallel_colors;
+    stage4CallContext->m_SOR_colorCount = parallel_colors + (color_offset != m ? 1 : 0);
+
+    IndexError *order = stage4CallContext->m_order;
+    for (unsigned int i = 0; i != m; ++i) {
+        unsigned int index = uncolored_order[i].index;
+        order[color_sizes[row_colors[index]]++] = uncolored_order[i];
     }
 }
 
@@ -2262,9 +2510,14 @@ int dxQuickStepIsland_Stage4LCP_IterationStart_Callback(void *_stage4CallContext
 
     const unsigned int num_iterations = qs->num_iterations;
     unsigned iteration = stage4CallContext->m_LCP_iteration;
+
+    // Stop early if no lambda has changed by more than the tolerance in the previous iteration
+    bool converged = iteration != 0 && stage4CallContext->IsLCP_IterationConverged();
     
-    if (iteration < num_iterations)
+    if (iteration < num_iterations && !converged)
     {
+        stage4CallContext->ResetLCP_IterationDelta();
+
         dCallReleaseeID nextReleasee;
         dCallReleaseeID stage4LCP_IterationSyncReleasee = stage4CallContext->m_LCP_IterationSyncReleasee;
         unsigned int stage4LCP_Iteration_allowedThreads = stage4CallContext->m_LCP_IterationAllowedThreads;
@@ -2401,16 +2654,21 @@ bool dxQuickStepIsland_Stage4LCP_ConstraintsShuffling(dxQuickStepperStage4CallCo
         // sort the constraints so that the ones converging slowest
         // get solved last. use the absolute (not relative) error.
         /*
-         *  Full reorder needs to be done.
+         *  Full reorder of each row stream needs to be done.
          *  Even though this contradicts the initial idea of moving dependent constraints
          *  to the order end the algorithm does not work the other way well.
          *  It looks like the iterative method needs a shake after it already found
          *  some initial approximations and those incurred errors help it to converge even better.
          */
         if (ThrsafeExchange(&stage4CallContext->m_SOR_reorderHeadTaken, 1) == 0) {
-            // Process the head
+            // Process the single body rows
+            ConstraintsReorderingHelper()(stage4CallContext, 0, stage4CallContext->m_SOR_oneBodyRowCount);
+        }
+
+        if (ThrsafeExchange(&stage4CallContext->m_SOR_reorderTailTaken, 1) == 0) {
+            // Process the two body rows
             const dxQuickStepperLocalContext *localContext = stage4CallContext->m_localContext;
-            ConstraintsReorderingHelper()(stage4CallContext, 0, localContext->m_m);
+            ConstraintsReorderingHelper()(stage4CallContext, stage4CallContext->m_SOR_oneBodyRowCount, localContext->m_m);
         }
         
         result = true;
@@ -2463,16 +2721,22 @@ bool dxQuickStepIsland_Stage4LCP_ConstraintsShuffling(dxQuickStepperStage4CallCo
             };
 
             /*
-             *  Full reorder needs to be done.
+             *  Full reorder of each row stream needs to be done.
              *  Even though this contradicts the initial idea of moving dependent constraints
              *  to the order end the algorithm does not work the other way well.
              *  It looks like the iterative method needs a shake after it already found
              *  some initial approximations and those incurred errors help it to converge even better.
              */
             if (ThrsafeExchange(&stage4CallContext->m_SOR_reorderHeadTaken, 1) == 0) {
-                // Process the head
+                // Process the single body rows
+                ConstraintsReorderingHelper()(stage4CallContext, 0, stage4CallContext->m_SOR_oneBodyRowCount);
+            }
+
+            if (ThrsafeExchange(&stage4CallContext->m_SOR_reorderTailTaken, 1) == 0) {
+                // Process the two body rows
                 const dxQuickStepperLocalContext *localContext = stage4CallContext->m_localContext;
-                ConstraintsReorderingHelper()(stage4CallContext, 0, localContext->m_m);
+                unsigned int m1 = stage4CallContext->m_SOR_oneBodyRowCount;
+                ConstraintsReorderingHelper()(stage4CallContext, m1, localContext->m_m - m1);
             }
         }
         dIASSERT((RRS__MAX, true)); // A reference to RRS__MAX to be located by Find in Files
@@ -2676,6 +2940,7 @@ void dxQuickStepIsland_Stage4LCP_MTIteration(dxQuickStepperStage4CallContext *st
     atomicord32 *mi_links = stage4CallContext->m_mi_links;
 
     unsigned int knownToBeCompletedLevel = initiallyKnownToBeCompletedLevel;
+    dReal maxDelta = REAL(0.0);
 
     while (true) {
         unsigned int initialLevelRoot = mi_links[2 * dxHEAD_INDEX + 0];
@@ -2697,7 +2962,8 @@ void dxQuickStepIsland_Stage4LCP_MTIteration(dxQuickStepperStage4CallContext *st
                 unsigned currentLevelNextLink = mi_links[2 * (sizeint)currentLevelFirstLink + 0];
                 if (ThrsafeCompareExchange(&mi_links[2 * (sizeint)currentLevelRoot + 1], currentLevelFirstLink, currentLevelNextLink)) {
                     // if succeeded, execute selected iteration step...
-                    dxQuickStepIsland_Stage4LCP_IterationStep(stage4CallContext, dxDECODE_INDEX(currentLevelFirstLink));
+                    dReal delta = dxQuickStepIsland_Stage4LCP_IterationStep(stage4CallContext, dxDECODE_INDEX(currentLevelFirstLink));
+                    maxDelta = dMAX(maxDelta, delta);
 
                     // Check if there are any dependencies
                     unsigned level0DownLink = mi_links[2 * (sizeint)currentLevelFirstLink + 1];
@@ -2751,19 +3017,231 @@ void dxQuickStepIsland_Stage4LCP_MTIteration(dxQuickStepperStage4CallContext *st
         knownToBeCompletedLevel = initialLevelRoot;
     }
 
+    stage4CallContext->RecordLCP_IterationDelta(maxDelta);
+
     // Decrement running threads count on exit
     ThrsafeAdd(&stage4CallContext->m_LCP_iterationThreadsRemaining, (atomicord32)(-1));
 }
 
+/*
+ *  With graph coloring the rows of a color have no bodies in common and can be
+ *  swept in any order, and in parallel, without the dependency map. The colors
+ *  are swept one after another with a barrier between them. The colors that
+ *  are too small to be split among threads are swept in place by the thread
+ *  which schedules the sweeps, as are the rows that could not be colored.
+ *  Since the colored order is not changed during the step, the result does not
+ *  depend on the number of threads.
+ */
+static 
+int dxQuickStepIsland_Stage4LCP_ColoredIterationStart_Callback(void *_stage4CallContext, dcallindex_t callInstanceIndex, dCallReleaseeID callThisReleasee)
+{
+    (void)callInstanceIndex; // unused
+    (void)callThisReleasee; // unused
+    dxQuickStepperStage4CallContext *stage4CallContext = (dxQuickStepperStage4CallContext *)_stage4CallContext;
+    const dxStepperProcessingCallContext *callContext = stage4CallContext->m_stepperCallContext;
+
+    dxWorld *world = callContext->m_world;
+    const unsigned int num_iterations = world->qs.num_iterations;
+
+    const unsigned int *color_starts = stage4CallContext->m_SOR_colorStarts;
+    const unsigned int colorCount = stage4CallContext->m_SOR_colorCount;
+    const unsigned int parallelColorCount = stage4CallContext->m_SOR_parallelColorCount;
+
+    unsigned int iteration = stage4CallContext->m_LCP_iteration;
+    unsigned int color = stage4CallContext->m_LCP_color;
+
+    while (iteration < num_iterations) {
+        if (color == 0) {
+            // Stop early if no lambda has changed by more than the tolerance in the previous iteration
+            if (iteration != 0 && stage4CallContext->IsLCP_IterationConverged()) {
+                break;
+            }
+            stage4CallContext->ResetLCP_IterationDelta();
+        }
+
+        unsigned int sweptColor = color;
+        unsigned int startIndex = color_starts[color], endIndex = color_starts[color + 1];
+        bool serialRows = color == parallelColorCount;
+        unsigned int sweepThreads = !serialRows
+            ? CalculateOptimalThreadsCount<dxQUICKSTEPISLAND_STAGE4LCP_COLOR_STEP>(endIndex - startIndex, stage4CallContext->m_LCP_IterationAllowedThreads)
+            : 1;
+
+        if (++color == colorCount) {
+            color = 0;
+            ++iteration;
+        }
+
+        if (sweepThreads <= 1) {
+            stage4CallContext->m_LCP_iteration = iteration;
+            stage4CallContext->m_LCP_color = color;
+            dReal maxDelta = dxQuickStepIsland_Stage4LCP_ColorSweepInPlace(stage4CallContext, sweptColor);
+            stage4CallContext->RecordLCP_IterationDelta(maxDelta);
+            continue;
+        }
+
+        // Advance the position before the sweep calls are posted as the next start may be executed right after them
+        stage4CallContext->m_LCP_iteration = iteration;
+        stage4CallContext->m_LCP_color = color;
+        stage4CallContext->RecordSOR_ColorSweep(startIndex, stage4CallContext->m_SOR_colorSplits[sweptColor], endIndex);
+
+        dCallReleaseeID stage4LCP_IterationSyncReleasee = stage4CallContext->m_LCP_IterationSyncReleasee;
+        dCallReleaseeID nextReleasee;
+
+        if (iteration < num_iterations) {
+            dCallReleaseeID stage4LCP_IterationStartReleasee;
+            world->PostThreadedCallForUnawareReleasee(NULL, &stage4LCP_IterationStartReleasee, sweepThreads, stage4LCP_IterationSyncReleasee, 
+                NULL, &dxQuickStepIsland_Stage4LCP_ColoredIterationStart_Callback, stage4CallContext, 0, "QuickStepIsland Stage4LCP_Iteration Start");
+            nextReleasee = stage4LCP_IterationStartReleasee;
+        }
+        else {
+            world->AlterThreadedCallDependenciesCount(stage4LCP_IterationSyncReleasee, sweepThreads);
+            nextReleasee = stage4LCP_IterationSyncReleasee;
+        }
+
+        world->PostThreadedCallsGroup(NULL, sweepThreads - 1, nextReleasee, &dxQuickStepIsland_Stage4LCP_ColorSweep_Callback, stage4CallContext, "QuickStepIsland Stage4LCP_ColorSweep");
+        dxQuickStepIsland_Stage4LCP_ColorSweep(stage4CallContext);
+        world->AlterThreadedCallDependenciesCount(nextReleasee, -1);
+        break;
+    }
+
+    return 1;
+}
+
+static 
+int dxQuickStepIsland_Stage4LCP_ColorSweep_Callback(void *_stage4CallContext, dcallindex_t callInstanceIndex, dCallReleaseeID callThisReleasee)
+{
+    (void)callInstanceIndex; // unused
+    (void)callThisReleasee; // unused
+    dxQuickStepperStage4CallContext *stage4CallContext = (dxQuickStepperStage4CallContext *)_stage4CallContext;
+    dxQuickStepIsland_Stage4LCP_ColorSweep(stage4CallContext);
+    return 1;
+}
+
+static 
+void dxQuickStepIsland_Stage4LCP_ColorSweep(dxQuickStepperStage4CallContext *stage4CallContext)
+{
+    const unsigned int startIndex = stage4CallContext->m_SOR_colorSweepStart;
+    const unsigned int splitIndex = stage4CallContext->m_SOR_colorSweepSplit;
+    const unsigned int endIndex = stage4CallContext->m_SOR_colorSweepEnd;
+
+    // The single body and the two body rows of the color are split into steps separately
+    const unsigned int step_size = dxQUICKSTEPISLAND_STAGE4LCP_COLOR_STEP;
+    unsigned int one_body_steps = (splitIndex - startIndex + (step_size - 1)) / step_size;
+    unsigned int sweep_steps = one_body_steps + (endIndex - splitIndex + (step_size - 1)) / step_size;
+
+    dReal maxDelta = REAL(0.0);
+
+    unsigned sweep_step;
+    while ((sweep_step = ThrsafeIncrementIntUpToLimit(&stage4CallContext->m_mi_color, sweep_steps)) != sweep_steps) {
+        dReal delta;
+        if (sweep_step < one_body_steps) {
+            unsigned int i = startIndex + sweep_step * step_size;
+            const unsigned int iend = i + dMIN(step_size, splitIndex - i);
+            delta = dxQuickStepIsland_Stage4LCP_ColorRangeSweep<false>(stage4CallContext, i, iend);
+        }
+        else {
+            unsigned int i = splitIndex + (sweep_step - one_body_steps) * step_size;
+            const unsigned int iend = i + dMIN(step_size, endIndex - i);
+            delta = dxQuickStepIsland_Stage4LCP_ColorRangeSweep<true>(stage4CallContext, i, iend);
+        }
+        maxDelta = dMAX(maxDelta, delta);
+    }
+
+    stage4CallContext->RecordLCP_IterationDelta(maxDelta);
+}
+
+static 
+void dxQuickStepIsland_Stage4LCP_STColoredIteration(dxQuickStepperStage4CallContext *stage4CallContext)
+{
+    const unsigned int colorCount = stage4CallContext->m_SOR_colorCount;
+
+    dReal maxDelta = REAL(0.0);
+    for (unsigned int color = 0; color != colorCount; ++color) {
+        dReal delta = dxQuickStepIsland_Stage4LCP_ColorSweepInPlace(stage4CallContext, color);
+        maxDelta = dMAX(maxDelta, delta);
+    }
+
+    stage4CallContext->RecordLCP_IterationDelta(maxDelta);
+}
+
+static 
+dReal dxQuickStepIsland_Stage4LCP_ColorSweepInPlace(dxQuickStepperStage4CallContext *stage4CallContext, unsigned int color)
+{
+    const unsigned int startIndex = stage4CallContext->m_SOR_colorStarts[color];
+    const unsigned int splitIndex = stage4CallContext->m_SOR_colorSplits[color];
+    const unsigned int endIndex = stage4CallContext->m_SOR_colorStarts[color + 1];
+
+    dReal maxDelta;
+
+    if (color != stage4CallContext->m_SOR_parallelColorCount) {
+        dReal oneBodyDelta = dxQuickStepIsland_Stage4LCP_ColorRangeSweep<false>(stage4CallContext, startIndex, splitIndex);
+        dReal twoBodiesDelta = dxQuickStepIsland_Stage4LCP_ColorRangeSweep<true>(stage4CallContext, splitIndex, endIndex);
+        maxDelta = dMAX(oneBodyDelta, twoBodiesDelta);
+    }
+    else {
+        // The rows that could not be colored are swept one by one
+        maxDelta = REAL(0.0);
+        for (unsigned int i = startIndex; i != splitIndex; ++i) {
+            dReal delta = dxQuickStepIsland_Stage4LCP_RowIterationStep<false>(stage4CallContext, i);
+            maxDelta = dMAX(maxDelta, delta);
+        }
+        for (unsigned int i = splitIndex; i != endIndex; ++i) {
+            dReal delta = dxQuickStepIsland_Stage4LCP_RowIterationStep<true>(stage4CallContext, i);
+            maxDelta = dMAX(maxDelta, delta);
+        }
+    }
+
+    return maxDelta;
+}
+
+// The batches start at the stream start within the color in both single and 
+// multithreaded sweeps (the sweep step is a multiple of any batch size) 
+// and hence the results do not depend on the number of threads.
+dSASSERT(dxQUICKSTEPISLAND_STAGE4LCP_COLOR_STEP % 4 == 0);
+
+template<bool tTwoBodies>
+static 
+dReal dxQuickStepIsland_Stage4LCP_ColorRangeSweep(dxQuickStepperStage4CallContext *stage4CallContext, unsigned int startIndex, unsigned int endIndex)
+{
+    dReal maxDelta = REAL(0.0);
+    unsigned int i = startIndex;
+
+    const unsigned int batchSize = stage4CallContext->m_SOR_rowBatchSize;
+    if (batchSize > 1) {
+        dxSORRowBatchFunction *rowBatchFunction = stage4CallContext->m_SOR_rowBatchFunctions[tTwoBodies ? SRS_TWO_BODIES : SRS_ONE_BODY];
+        for (; endIndex - i >= batchSize; i += batchSize) {
+            dReal delta = rowBatchFunction(stage4CallContext, i);
+            maxDelta = dMAX(maxDelta, delta);
+        }
+    }
+
+    for (; i != endIndex; ++i) {
+        dReal delta = dxQuickStepIsland_Stage4LCP_RowIterationStep<tTwoBodies>(stage4CallContext, i);
+        maxDelta = dMAX(maxDelta, delta);
+    }
+
+    return maxDelta;
+}
+
 static 
 void dxQuickStepIsland_Stage4LCP_STIteration(dxQuickStepperStage4CallContext *stage4CallContext)
 {
     const dxQuickStepperLocalContext *localContext = stage4CallContext->m_localContext;
 
+    dReal maxDelta = REAL(0.0);
+
     unsigned int m = localContext->m_m;
-    for (unsigned int i = 0; i != m; ++i) {
-        dxQuickStepIsland_Stage4LCP_IterationStep(stage4CallContext, i);
+    unsigned int m1 = stage4CallContext->m_SOR_oneBodyRowCount;
+    for (unsigned int i = 0; i != m1; ++i) {
+        dReal delta = dxQuickStepIsland_Stage4LCP_RowIterationStep<false>(stage4CallContext, i);
+        maxDelta = dMAX(maxDelta, delta);
+    }
+    for (unsigned int i = m1; i != m; ++i) {
+        dReal delta = dxQuickStepIsland_Stage4LCP_RowIterationStep<true>(stage4CallContext, i);
+        maxDelta = dMAX(maxDelta, delta);
     }
+
+    stage4CallContext->RecordLCP_IterationDelta(maxDelta);
 }
 
 //***************************************************************************
@@ -2779,8 +3257,20 @@ void dxQuickStepIsland_Stage4LCP_STIteration(dxQuickStepperStage4CallContext *st
 //
 // b, lo and hi are modified on exit
 
+// The iteration steps return the absolute change of the row lambda
+
+static 
+dReal dxQuickStepIsland_Stage4LCP_IterationStep(dxQuickStepperStage4CallContext *stage4CallContext, unsigned int i)
+{
+    // the single body rows come first in the order
+    return i < stage4CallContext->m_SOR_oneBodyRowCount
+        ? dxQuickStepIsland_Stage4LCP_RowIterationStep<false>(stage4CallContext, i)
+        : dxQuickStepIsland_Stage4LCP_RowIterationStep<true>(stage4CallContext, i);
+}
+
+template<bool tTwoBodies>
 static 
-void dxQuickStepIsland_Stage4LCP_IterationStep(dxQuickStepperStage4CallContext *stage4CallContext, unsigned int i)
+dReal dxQuickStepIsland_Stage4LCP_RowIterationStep(dxQuickStepperStage4CallContext *stage4CallContext, unsigned int i)
 {
     const dxQuickStepperLocalContext *localContext = stage4CallContext->m_localContext;
 
@@ -2788,7 +3278,7 @@ void dxQuickStepIsland_Stage4LCP_IterationStep(dxQuickStepperStage4CallContext *
     unsigned int index = order[i].index;
 
     dReal *fc_ptr1;
-    dReal *fc_ptr2 = NULL;
+    dReal *fc_ptr2;
     dReal delta;
 
     dReal *lambda = stage4CallContext->m_lambda;
@@ -2803,22 +3293,26 @@ void dxQuickStepIsland_Stage4LCP_IterationStep(dxQuickStepperStage4CallContext *
         dReal *fc = stage4CallContext->m_cforce;
 
         const dxJBodiesItem *jb = localContext->m_jb;
-        int b2 = jb[index].second;
         int b1 = jb[index].first;
 
-        // @@@ potential optimization: SIMD-ize this and the b2 >= 0 case
         fc_ptr1 = fc + (sizeint)(unsigned)b1 * CFE__MAX;
         delta -= fc_ptr1[CFE_LX] * J_ptr[JME_J1LX] + fc_ptr1[CFE_LY] * J_ptr[JME_J1LY] +
             fc_ptr1[CFE_LZ] * J_ptr[JME_J1LZ] + fc_ptr1[CFE_AX] * J_ptr[JME_J1AX] +
             fc_ptr1[CFE_AY] * J_ptr[JME_J1AY] + fc_ptr1[CFE_AZ] * J_ptr[JME_J1AZ];
-        // @@@ potential optimization: handle 1-body constraints in a separate
-        //     loop to avoid the cost of test & jump?
-        if (b2 != -1) {
+        // 1-body constraints are solved by a separate instance to avoid the cost of test & jump
+        if (tTwoBodies) {
+            int b2 = jb[index].second;
+            dIASSERT(b2 != -1);
+
             fc_ptr2 = fc + (sizeint)(unsigned)b2 * CFE__MAX;
             delta -= fc_ptr2[CFE_LX] * J_ptr[JME_J2LX] + fc_ptr2[CFE_LY] * J_ptr[JME_J2LY] +
                 fc_ptr2[CFE_LZ] * J_ptr[JME_J2LZ] + fc_ptr2[CFE_AX] * J_ptr[JME_J2AX] +
                 fc_ptr2[CFE_AY] * J_ptr[JME_J2AY] + fc_ptr2[CFE_AZ] * J_ptr[JME_J2AZ];
         }
+        else {
+            dIASSERT(jb[index].second == -1);
+            fc_ptr2 = NULL;
+        }
     }
 
     {
@@ -2841,20 +3335,10 @@ void dxQuickStepIsland_Stage4LCP_IterationStep(dxQuickStepperStage4CallContext *
         }
 
         // compute lambda and clamp it to [lo,hi].
-        // @@@ potential optimization: does SSE have clamping instructions
-        //     to save test+jump penalties here?
-        dReal new_lambda = old_lambda + delta;
-        if (new_lambda < lo_act) {
-            delta = lo_act - old_lambda;
-            lambda[index] = lo_act;
-        }
-        else if (new_lambda > hi_act) {
-            delta = hi_act - old_lambda;
-            lambda[index] = hi_act;
-        }
-        else {
-            lambda[index] = new_lambda;
-        }
+        // the min/max pair compiles to the clamping instructions without test+jump.
+        dReal new_lambda = dMIN(dMAX(old_lambda + delta, lo_act), hi_act);
+        delta = new_lambda - old_lambda;
+        lambda[index] = new_lambda;
     }
 
     //@@@ a trick that may or may not help
@@ -2865,16 +3349,13 @@ void dxQuickStepIsland_Stage4LCP_IterationStep(dxQuickStepperStage4CallContext *
         dReal *iMJ = stage4CallContext->m_iMJ;
         const dReal *iMJ_ptr = iMJ + (sizeint)index * IMJ__MAX;
         // update fc.
-        // @@@ potential optimization: SIMD for this and the b2 >= 0 case
         fc_ptr1[CFE_LX] += delta * iMJ_ptr[IMJ_1LX];
         fc_ptr1[CFE_LY] += delta * iMJ_ptr[IMJ_1LY];
         fc_ptr1[CFE_LZ] += delta * iMJ_ptr[IMJ_1LZ];
         fc_ptr1[CFE_AX] += delta * iMJ_ptr[IMJ_1AX];
         fc_ptr1[CFE_AY] += delta * iMJ_ptr[IMJ_1AY];
         fc_ptr1[CFE_AZ] += delta * iMJ_ptr[IMJ_1AZ];
-        // @@@ potential optimization: handle 1-body constraints in a separate
-        //     loop to avoid the cost of test & jump?
-        if (fc_ptr2) {
+        if (tTwoBodies) {
             fc_ptr2[CFE_LX] += delta * iMJ_ptr[IMJ_2LX];
             fc_ptr2[CFE_LY] += delta * iMJ_ptr[IMJ_2LY];
             fc_ptr2[CFE_LZ] += delta * iMJ_ptr[IMJ_2LZ];
@@ -2883,16 +3364,265 @@ void dxQuickStepIsland_Stage4LCP_IterationStep(dxQuickStepperStage4CallContext *
             fc_ptr2[CFE_AZ] += delta * iMJ_ptr[IMJ_2AZ];
         }
     }
+
+    return dFabs(delta);
 }
 
+//***************************************************************************
+// SIMD SOR row batches
+//
+// The rows of a color have no bodies in common. So the rows of a batch can be
+// solved together: their J*fc dot products are computed and reduced as vectors,
+// and the lambda deltas are added to the forces of the distinct bodies.
+
+#if dxSOR_ROW_BATCH_SIMD
+
+dSASSERT(JME__J1_COUNT == 6 && JME__J2_COUNT == 6); // 4 + 2 elements per vector loads
+dSASSERT(CFE__MAX == 6);
+
 static inline 
-bool IsStage4bJointInfosIterationRequired(const dxQuickStepperLocalContext *localContext)
+void dxQuickStepIsland_Stage4LCP_RowLimits(dxQuickStepperStage4CallContext *stage4CallContext, unsigned int index, const dReal *J_ptr, 
+    dReal &out_lo_act, dReal &out_hi_act)
 {
-    return 
-#ifdef WARM_STARTING
-        true ||      
-#endif
-        localContext->m_mfb > 0;
+    const dxQuickStepperLocalContext *localContext = stage4CallContext->m_localContext;
+    const int *findex = localContext->m_findex;
+
+    if (findex[index] != -1) {
+        // The row of findex belongs to another color
+        out_hi_act = dFabs (J_ptr[JME_HI] * stage4CallContext->m_lambda[(unsigned)findex[index]]);
+        out_lo_act = -out_hi_act;
+    } else {
+        out_hi_act = J_ptr[JME_HI];
+        out_lo_act = J_ptr[JME_LO];
+    }
+}
+
+template<bool tTwoBodies>
+__attribute__((target("avx2,fma")))
+static 
+dReal dxQuickStepIsland_Stage4LCP_IterationStep4_AVX2(dxQuickStepperStage4CallContext *stage4CallContext, unsigned int i)
+{
+    const dxQuickStepperLocalContext *localContext = stage4CallContext->m_localContext;
+
+    const IndexError *order = stage4CallContext->m_order + i;
+    const dxJBodiesItem *jb = localContext->m_jb;
+    const dReal *J = localContext->m_J;
+    const dReal *iMJ = stage4CallContext->m_iMJ;
+    dReal *fc = stage4CallContext->m_cforce;
+    dReal *lambda = stage4CallContext->m_lambda;
+
+    unsigned int index[4];
+    dReal *fc_ptr1[4], *fc_ptr2[4];
+    dReal rhs[4], cfm[4], old_lambda[4], lo_act[4], hi_act[4];
+    __m256d products[4];
+
+    for (unsigned int k = 0; k != 4; ++k) {
+        unsigned int row = order[k].index;
+        index[k] = row;
+
+        const dReal *row_J = J + (sizeint)row * JME__MAX;
+
+        int b1 = jb[row].first;
+        int b2 = jb[row].second;
+        dIASSERT((b2 != -1) == tTwoBodies);
+        fc_ptr1[k] = fc + (sizeint)(unsigned)b1 * CFE__MAX;
+        fc_ptr2[k] = tTwoBodies ? fc + (sizeint)(unsigned)b2 * CFE__MAX : NULL;
+
+        // J*fc element products with the last two added to the first two
+        __m256d product = _mm256_mul_pd(_mm256_loadu_pd(row_J + JME__J1_MIN), _mm256_loadu_pd(fc_ptr1[k]));
+        __m128d product_tail = _mm_mul_pd(_mm_loadu_pd(row_J + JME__J1_MIN + 4), _mm_loadu_pd(fc_ptr1[k] + 4));
+        if (tTwoBodies) {
+            product = _mm256_fmadd_pd(_mm256_loadu_pd(row_J + JME__J2_MIN), _mm256_loadu_pd(fc_ptr2[k]), product);
+            product_tail = _mm_fmadd_pd(_mm_loadu_pd(row_J + JME__J2_MIN + 4), _mm_loadu_pd(fc_ptr2[k] + 4), product_tail);
+        }
+        products[k] = _mm256_add_pd(product, _mm256_insertf128_pd(_mm256_setzero_pd(), product_tail, 0));
+
+        rhs[k] = row_J[JME_RHS];
+        cfm[k] = row_J[JME_CFM];
+        old_lambda[k] = lambda[row];
+        dxQuickStepIsland_Stage4LCP_RowLimits(stage4CallContext, row, row_J, lo_act[k], hi_act[k]);
+    }
+
+    // Reduce the four product vectors to a vector of the four dot products
+    __m256d pairs01 = _mm256_hadd_pd(products[0], products[1]);
+    __m256d pairs23 = _mm256_hadd_pd(products[2], products[3]);
+    __m256d dots = _mm256_add_pd(_mm256_permute2f128_pd(pairs01, pairs23, 0x20), _mm256_permute2f128_pd(pairs01, pairs23, 0x31));
+
+    __m256d old_lambdas = _mm256_loadu_pd(old_lambda);
+    __m256d deltas = _mm256_sub_pd(_mm256_fnmadd_pd(old_lambdas, _mm256_loadu_pd(cfm), _mm256_loadu_pd(rhs)), dots);
+
+    // compute lambda and clamp it to [lo,hi]
+    __m256d new_lambdas = _mm256_min_pd(_mm256_max_pd(_mm256_add_pd(old_lambdas, deltas), _mm256_loadu_pd(lo_act)), _mm256_loadu_pd(hi_act));
+    deltas = _mm256_sub_pd(new_lambdas, old_lambdas);
+
+    dReal new_lambda[4], delta[4];
+    _mm256_storeu_pd(new_lambda, new_lambdas);
+    _mm256_storeu_pd(delta, deltas);
+
+    // update fc
+    dReal maxDelta = REAL(0.0);
+    for (unsigned int k = 0; k != 4; ++k) {
+        maxDelta = dMAX(maxDelta, dFabs(delta[k]));
+        unsigned int row = index[k];
+        lambda[row] = new_lambda[k];
+
+        const dReal *iMJ_ptr = iMJ + (sizeint)row * IMJ__MAX;
+        __m256d row_delta = _mm256_set1_pd(delta[k]);
+        __m128d row_delta_tail = _mm_set1_pd(delta[k]);
+
+        dReal *fc_ptr = fc_ptr1[k];
+        _mm256_storeu_pd(fc_ptr, _mm256_fmadd_pd(row_delta, _mm256_loadu_pd(iMJ_ptr + IMJ__1_MIN), _mm256_loadu_pd(fc_ptr)));
+        _mm_storeu_pd(fc_ptr + 4, _mm_fmadd_pd(row_delta_tail, _mm_loadu_pd(iMJ_ptr + IMJ__1_MIN + 4), _mm_loadu_pd(fc_ptr + 4)));
+
+        if (tTwoBodies) {
+            fc_ptr = fc_ptr2[k];
+            _mm256_storeu_pd(fc_ptr, _mm256_fmadd_pd(row_delta, _mm256_loadu_pd(iMJ_ptr + IMJ__2_MIN), _mm256_loadu_pd(fc_ptr)));
+            _mm_storeu_pd(fc_ptr + 4, _mm_fmadd_pd(row_delta_tail, _mm_loadu_pd(iMJ_ptr + IMJ__2_MIN + 4), _mm_loadu_pd(fc_ptr + 4)));
+        }
+    }
+
+    return maxDelta;
+}
+
+template<bool tTwoBodies>
+__attribute__((target("sse2")))
+static 
+dReal dxQuickStepIsland_Stage4LCP_IterationStep2_SSE2(dxQuickStepperStage4CallContext *stage4CallContext, unsigned int i)
+{
+    const dxQuickStepperLocalContext *localContext = stage4CallContext->m_localContext;
+
+    const IndexError *order = stage4CallContext->m_order + i;
+    const dxJBodiesItem *jb = localContext->m_jb;
+    const dReal *J = localContext->m_J;
+    const dReal *iMJ = stage4CallContext->m_iMJ;
+    dReal *fc = stage4CallContext->m_cforce;
+    dReal *lambda = stage4CallContext->m_lambda;
+
+    unsigned int index[2];
+    dReal *fc_ptr1[2], *fc_ptr2[2];
+    dReal rhs[2], cfm[2], old_lambda[2], lo_act[2], hi_act[2];
+    __m128d products[2];
+
+    for (unsigned int k = 0; k != 2; ++k) {
+        unsigned int row = order[k].index;
+        index[k] = row;
+
+        const dReal *row_J = J + (sizeint)row * JME__MAX;
+
+        int b1 = jb[row].first;
+        int b2 = jb[row].second;
+        dIASSERT((b2 != -1) == tTwoBodies);
+        fc_ptr1[k] = fc + (sizeint)(unsigned)b1 * CFE__MAX;
+        fc_ptr2[k] = tTwoBodies ? fc + (sizeint)(unsigned)b2 * CFE__MAX : NULL;
+
+        __m128d product = _mm_mul_pd(_mm_loadu_pd(row_J + JME__J1_MIN), _mm_loadu_pd(fc_ptr1[k]));
+        product = _mm_add_pd(product, _mm_mul_pd(_mm_loadu_pd(row_J + JME__J1_MIN + 2), _mm_loadu_pd(fc_ptr1[k] + 2)));
+        product = _mm_add_pd(product, _mm_mul_pd(_mm_loadu_pd(row_J + JME__J1_MIN + 4), _mm_loadu_pd(fc_ptr1[k] + 4)));
+        if (tTwoBodies) {
+            product = _mm_add_pd(product, _mm_mul_pd(_mm_loadu_pd(row_J + JME__J2_MIN), _mm_loadu_pd(fc_ptr2[k])));
+            product = _mm_add_pd(product, _mm_mul_pd(_mm_loadu_pd(row_J + JME__J2_MIN + 2), _mm_loadu_pd(fc_ptr2[k] + 2)));
+            product = _mm_add_pd(product, _mm_mul_pd(_mm_loadu_pd(row_J + JME__J2_MIN + 4), _mm_loadu_pd(fc_ptr2[k] + 4)));
+        }
+        products[k] = product;
+
+        rhs[k] = row_J[JME_RHS];
+        cfm[k] = row_J[JME_CFM];
+        old_lambda[k] = lambda[row];
+        dxQuickStepIsland_Stage4LCP_RowLimits(stage4CallContext, row, row_J, lo_act[k], hi_act[k]);
+    }
+
+    // Reduce the two product vectors to a vector of the two dot products
+    __m128d dots = _mm_add_pd(_mm_unpacklo_pd(products[0], products[1]), _mm_unpackhi_pd(products[0], products[1]));
+
+    __m128d old_lambdas = _mm_loadu_pd(old_lambda);
+    __m128d deltas = _mm_sub_pd(_mm_sub_pd(_mm_loadu_pd(rhs), _mm_mul_pd(old_lambdas, _mm_loadu_pd(cfm))), dots);
+
+    // compute lambda and clamp it to [lo,hi]
+    __m128d new_lambdas = _mm_min_pd(_mm_max_pd(_mm_add_pd(old_lambdas, deltas), _mm_loadu_pd(lo_act)), _mm_loadu_pd(hi_act));
+    deltas = _mm_sub_pd(new_lambdas, old_lambdas);
+
+    dReal new_lambda[2], delta[2];
+    _mm_storeu_pd(new_lambda, new_lambdas);
+    _mm_storeu_pd(delta, deltas);
+
+    // update fc
+    dReal maxDelta = REAL(0.0);
+    for (unsigned int k = 0; k != 2; ++k) {
+        maxDelta = dMAX(maxDelta, dFabs(delta[k]));
+        unsigned int row = index[k];
+        lambda[row] = new_lambda[k];
+
+        const dReal *iMJ_ptr = iMJ + (sizeint)row * IMJ__MAX;
+        __m128d row_delta = _mm_set1_pd(delta[k]);
+
+        dReal *fc_ptr = fc_ptr1[k];
+        for (unsigned int j = 0; j != 6; j += 2) {
+            _mm_storeu_pd(fc_ptr + j, _mm_add_pd(_mm_loadu_pd(fc_ptr + j), _mm_mul_pd(row_delta, _mm_loadu_pd(iMJ_ptr + IMJ__1_MIN + j))));
+        }
+
+        if (tTwoBodies) {
+            fc_ptr = fc_ptr2[k];
+            for (unsigned int j = 0; j != 6; j += 2) {
+                _mm_storeu_pd(fc_ptr + j, _mm_add_pd(_mm_loadu_pd(fc_ptr + j), _mm_mul_pd(row_delta, _mm_loadu_pd(iMJ_ptr + IMJ__2_MIN + j))));
+            }
+        }
+    }
+
+    return maxDelta;
+}
+
+#endif // #if dxSOR_ROW_BATCH_SIMD
+
+static 
+unsigned int dxQuickStepIsland_Stage4LCP_SelectRowBatchFunctions(dxSORRowBatchFunction *out_batchFunctions[SRS__MAX], bool allowSIMD)
+{
+    out_batchFunctions[SRS_ONE_BODY] = &dxQuickStepIsland_Stage4LCP_RowIterationStep<false>;
+    out_batchFunctions[SRS_TWO_BODIES] = &dxQuickStepIsland_Stage4LCP_RowIterationStep<true>;
+    unsigned int batchSize = 1;
+
+#if dxSOR_ROW_BATCH_SIMD
+
+    if (!allowSIMD) {
+        // the rows are solved one by one
+    }
+    else if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma")) {
+        out_batchFunctions[SRS_ONE_BODY] = &dxQuickStepIsland_Stage4LCP_IterationStep4_AVX2<false>;
+        out_batchFunctions[SRS_TWO_BODIES] = &dxQuickStepIsland_Stage4LCP_IterationStep4_AVX2<true>;
+        batchSize = 4;
+    }
+    else if (__builtin_cpu_supports("sse2")) {
+        out_batchFunctions[SRS_ONE_BODY] = &dxQuickStepIsland_Stage4LCP_IterationStep2_SSE2<false>;
+        out_batchFunctions[SRS_TWO_BODIES] = &dxQuickStepIsland_Stage4LCP_IterationStep2_SSE2<true>;
+        batchSize = 2;
+    }
+
+
+#else // #if !dxSOR_ROW_BATCH_SIMD
+
+    (void)allowSIMD; // unused
+
+
+#endif // #if dxSOR_ROW_BATCH_SIMD
+
+    return batchSize;
+}
+
+static 
+void dxQuickStepIsland_Stage4LCP_IterationStatsRecording(dxQuickStepperStage4CallContext *stage4CallContext)
+{
+    const dxStepperProcessingCallContext *callContext = stage4CallContext->m_stepperCallContext;
+    dxQuickStepStats *stats = &callContext->m_world->qs_stats;
+
+    // the lambda change of the last iteration is the residual
+    ThrsafeRaiseIntToValue(&stats->iterations, stage4CallContext->m_LCP_iteration);
+    ThrsafeRaiseIntToValue(&stats->residual, stage4CallContext->m_LCP_maxDelta);
+}
+
+static inline 
+bool IsStage4bJointInfosIterationRequired(const dxQuickStepperStage4CallContext *stage4CallContext)
+{
+    // with warm starting the lambdas of all joints are saved for the next step
+    return stage4CallContext->m_warmStarting || stage4CallContext->m_localContext->m_mfb > 0;
 }
 
 static 
@@ -2903,9 +3633,11 @@ int dxQuickStepIsland_Stage4LCP_IterationSync_Callback(void *_stage4CallContext,
     dxQuickStepperStage4CallContext *stage4CallContext = (dxQuickStepperStage4CallContext *)_stage4CallContext;
     const dxStepperProcessingCallContext *callContext = stage4CallContext->m_stepperCallContext;
     const dxQuickStepperLocalContext *localContext = stage4CallContext->m_localContext;
+
+    dxQuickStepIsland_Stage4LCP_IterationStatsRecording(stage4CallContext);
     
     unsigned int stage4b_allowedThreads = 1;
-    if (IsStage4bJointInfosIterationRequired(localContext)) {
+    if (IsStage4bJointInfosIterationRequired(stage4CallContext)) {
         unsigned int allowedThreads = callContext->m_stepperAllowedThreads;
         dIASSERT(allowedThreads >= stage4b_allowedThreads);
         stage4b_allowedThreads += CalculateOptimalThreadsCount<dxQUICKSTEPISLAND_STAGE4B_STEP>(localContext->m_nj, allowedThreads - stage4b_allowedThreads);
@@ -2942,14 +3674,16 @@ void dxQuickStepIsland_Stage4b(dxQuickStepperStage4CallContext *stage4CallContex
         unsigned int nb = callContext->m_islandBodiesCount;
         const dReal *cforce = stage4CallContext->m_cforce;
         dReal stepsize = callContext->m_stepSize;
+        dxBodyStateStore &state = callContext->m_world->body_state;
         // add stepsize * cforce to the body velocity
         const dReal *cforcecurr = cforce;
         dxBody *const *const bodyend = body + nb;
         for (dxBody *const *bodycurr = body; bodycurr != bodyend; cforcecurr += CFE__MAX, bodycurr++) {
-            dxBody *b = *bodycurr;
+            const unsigned slot = (*bodycurr)->state_slot;
+            dReal *lvel = state.lvel(slot), *avel = state.avel(slot);
             for (unsigned int j = dSA__MIN; j != dSA__MAX; j++) {
-                b->lvel[dV3E__AXES_MIN + j] += stepsize * cforcecurr[CFE__L_MIN + j];
-                b->avel[dV3E__AXES_MIN + j] += stepsize * cforcecurr[CFE__A_MIN + j];
+                lvel[dV3E__AXES_MIN + j] += stepsize * cforcecurr[CFE__L_MIN + j];
+                avel[dV3E__AXES_MIN + j] += stepsize * cforcecurr[CFE__A_MIN + j];
             }
         }
     }
@@ -2958,7 +3692,7 @@ void dxQuickStepIsland_Stage4b(dxQuickStepperStage4CallContext *stage4CallContex
     // note that the SOR method overwrites rhs and J at this point, so
     // they should not be used again.
 
-    if (IsStage4bJointInfosIterationRequired(localContext)) {
+    if (IsStage4bJointInfosIterationRequired(stage4CallContext)) {
         dReal data[JVE__MAX];
         const dReal *Jcopy = localContext->m_Jcopy;
         const dReal *lambda = stage4CallContext->m_lambda;
@@ -2987,9 +3721,9 @@ void dxQuickStepIsland_Stage4b(dxQuickStepperStage4CallContext *stage4CallContex
                     const dReal *lambdacurr = lambda + mindex[ji].mIndex;
                     dxJoint *joint = jointinfos[ji].joint;
 
-#ifdef WARM_STARTING
-                    memcpy(joint->lambda, lambdacurr, fb_infom * sizeof(dReal));
-#endif
+                    if (stage4CallContext->m_warmStarting) {
+                        memcpy(joint->lambda, lambdacurr, fb_infom * sizeof(dReal));
+                    }
 
                     dJointFeedback *fb = joint->feedback;
 
@@ -3017,13 +3751,11 @@ void dxQuickStepIsland_Stage4b(dxQuickStepperStage4CallContext *stage4CallContex
 
                     Jcopycurr += fb_infom * JCE__MAX;
                 }
-                else {
-#ifdef WARM_STARTING
+                else if (stage4CallContext->m_warmStarting) {
                     const dReal *lambdacurr = lambda + mindex[ji].mIndex;
                     const unsigned int infom = mindex[ji + 1].mIndex - mindex[ji].mIndex;
                     dxJoint *joint = jointinfos[ji].joint;
                     memcpy(joint->lambda, lambdacurr, infom * sizeof(dReal));
-#endif
                 }
 
                 if (++ji == jiend) {
@@ -3108,6 +3840,7 @@ void dxQuickStepIsland_Stage6a(dxQuickStepperStage6CallContext *stage6CallContex
     dReal stepsize = callContext->m_stepSize;
     dReal *invI = localContext->m_invI;
     dxBody * const *body = callContext->m_islandBodiesStart;
+    dxBodyStateStore &state = callContext->m_world->body_state;
 
     unsigned int nb = callContext->m_islandBodiesCount;
     const unsigned int step_size = dxQUICKSTEPISLAND_STAGE6A_STEP;
@@ -3125,12 +3858,14 @@ void dxQuickStepIsland_Stage6a(dxQuickStepperStage6CallContext *stage6CallContex
             // compute the velocity update:
             // add stepsize * invM * fe to the body velocity
             dxBody *b = *bodycurr;
-            dReal body_invMass_mul_stepsize = stepsize * b->invMass;
+            const unsigned slot = b->state_slot;
+            dReal *lvel = state.lvel(slot);
+            dReal body_invMass_mul_stepsize = stepsize * state.invMass(slot);
             for (unsigned int j = dSA__MIN; j != dSA__MAX; ++j) {
-                b->lvel[dV3E__AXES_MIN + j] += body_invMass_mul_stepsize * b->facc[dV3E__AXES_MIN + j];
+                lvel[dV3E__AXES_MIN + j] += body_invMass_mul_stepsize * b->facc[dV3E__AXES_MIN + j];
                 b->tacc[dV3E__AXES_MIN + j] *= stepsize;
             }
-            dMultiplyAdd0_331 (b->avel, invIrow + IIE__MATRIX_MIN, b->tacc);
+            dMultiplyAdd0_331 (state.avel(slot), invIrow + IIE__MATRIX_MIN, b->tacc);
             
             if (++bodycurr == bodyend) {
                 break;
@@ -3176,6 +3911,7 @@ void dxQuickStepIsland_Stage6_VelocityCheck(dxQuickStepperStage6CallContext *sta
     if (m > 0) {
         const dxStepperProcessingCallContext *callContext = stage6CallContext->m_stepperCallContext;
         dxBody * const *body = callContext->m_islandBodiesStart;
+        const dxBodyStateStore &state = callContext->m_world->body_state;
         dReal *J = localContext->m_J;
         const dxJBodiesItem *jb = localContext->m_jb;
 
@@ -3185,11 +3921,11 @@ void dxQuickStepIsland_Stage6_VelocityCheck(dxQuickStepperStage6CallContext *sta
             int b1 = jb[i].first;
             int b2 = jb[i].second;
             dReal sum = 0;
-            dxBody *bodycurr = body[(unsigned)b1];
-            for (unsigned int j = dSA__MIN; j != dSA__MAX; ++j) sum += J_ptr[JME__J1L_MIN + j] * bodycurr->lvel[dV3E__AXES_MIN + j] + J_ptr[JME__J1A_MIN + j] * bodycurr->avel[dV3E__AXES_MIN + j];
+            unsigned slot = body[(unsigned)b1]->state_slot;
+            for (unsigned int j = dSA__MIN; j != dSA__MAX; ++j) sum += J_ptr[JME__J1L_MIN + j] * state.lvel(slot)[dV3E__AXES_MIN + j] + J_ptr[JME__J1A_MIN + j] * state.avel(slot)[dV3E__AXES_MIN + j];
             if (b2 != -1) {
-                dxBody *bodycurr = body[(unsigned)b2];
-                for (unsigned int k = dSA__MIN; k != dSA__MAX; ++k) sum += J_ptr[JME__J2L_MIN + k] * bodycurr->lvel[dV3E__AXES_MIN + k] + J_ptr[JME__J2A_MIN + k] * bodycurr->avel[dV3E__AXES_MIN + k];
+                slot = body[(unsigned)b2]->state_slot;
+                for (unsigned int k = dSA__MIN; k != dSA__MAX; ++k) sum += J_ptr[JME__J2L_MIN + k] * state.lvel(slot)[dV3E__AXES_MIN + k] + J_ptr[JME__J2A_MIN + k] * state.avel(slot)[dV3E__AXES_MIN + k];
             }
             J_ptr += JME__MAX;
             error += dFabs(sum);
@@ -3308,6 +4044,10 @@ sizeint dxEstimateQuickStepMemoryRequirements (dxBody * const *body,
                     sub3_res1 += dEFFICIENT_SIZE(sizeof(atomicord32) * 2 * ((sizeint)m + 1)); // for mi_links
 #endif
                     sub3_res1 += dEFFICIENT_SIZE(sizeof(dxQuickStepperStage4CallContext)); // for dxQuickStepperStage4CallContext;
+                    // graph coloring is a world setting unknown here, so it is always accounted for
+                    sub3_res1 += dEFFICIENT_SIZE(sizeof(IndexError) * m); // for uncolored_order
+                    sub3_res1 += dEFFICIENT_SIZE(sizeof(duint64) * nb); // for body_colors
+                    sub3_res1 += dEFFICIENT_SIZE(sizeof(unsigned char) * m); // for row_colors
 
                     sizeint sub3_res2 = dEFFICIENT_SIZE(sizeof(dxQuickStepperStage6CallContext)); // for dxQuickStepperStage6CallContext;
                     
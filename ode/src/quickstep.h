@@ -35,5 +35,9 @@ unsigned dxEstimateQuickStepMaxCallCount(
 
 void dxQuickStepIsland(const dxStepperProcessingCallContext *callContext);
 
+// the SOR work is linear in the rows, so small islands are as cheap to
+// solve together as one by one
+#define dxQUICKSTEP_ISLAND_BATCH_ROWS 64
+
 
 #endif
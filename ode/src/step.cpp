@@ -266,11 +266,14 @@ static void dxStepIsland_Stage0_Joints(dxStepperStage0JointsCallContext *callCon
 static void dxStepIsland_Stage1(dxStepperStage1CallContext *callContext);
 
 
+struct dxArticulationLayout;
+
 struct dxStepperLocalContext
 {
     void Initialize(dReal *invI, dJointWithInfo1 *jointinfos, unsigned int nj, 
         unsigned int m, unsigned int nub, const unsigned int *mindex, int *findex, 
-        dReal *J, dReal *A, dReal *pairsRhsCfm, dReal *pairsLoHi, 
+        dReal *J, dReal *A, const unsigned int *jointRows, const sizeint *rowStart, 
+        const dxArticulationLayout *articulation, dReal *pairsRhsCfm, dReal *pairsLoHi, 
         atomicord32 *bodyStartJoints, atomicord32 *bodyJointLinks)
     {
         m_invI = invI;
@@ -282,6 +285,9 @@ struct dxStepperLocalContext
         m_findex = findex; 
         m_J = J;
         m_A = A;
+        m_jointRows = jointRows;
+        m_rowStart = rowStart;
+        m_articulation = articulation;
         m_pairsRhsCfm = pairsRhsCfm;
         m_pairsLoHi = pairsLoHi;
         m_bodyStartJoints = bodyStartJoints;
@@ -297,6 +303,9 @@ struct dxStepperLocalContext
     int                             *m_findex;
     dReal                           *m_J;
     dReal                           *m_A;
+    const unsigned int              *m_jointRows;   // first rows of the joints in a sparse A (or NULL if A is dense)
+    const sizeint                   *m_rowStart;    // offsets of the rows of a sparse A
+    const dxArticulationLayout      *m_articulation; // the articulated trees (or NULL if the rows are all in A)
     dReal                           *m_pairsRhsCfm;
     dReal                           *m_pairsLoHi;
     atomicord32                     *m_bodyStartJoints;
@@ -427,6 +436,42 @@ void MultiplyAddJinvMxJToA (dReal *Arow, const dReal *JinvMRow, const dReal *JRo
 }
 
 
+// the same for a block of A stored as an envelope, where each row of a joint
+// is one element longer than the previous one. only the lower triangle of
+// the diagonal blocks is computed.
+
+static inline 
+void MultiplyAddJinvMxJToEnvelope (dReal *Arow, const dReal *JinvMRow, const dReal *JRow,
+    unsigned int infomJinvM, unsigned int infomJ, unsigned int rowlength, bool diagonal)
+{
+    dIASSERT (infomJinvM > 0 && infomJ > 0 && Arow && JinvMRow && JRow);
+    const dReal *currJinvM = JinvMRow;
+    for (unsigned int i = 0; i != infomJinvM; ++i) {
+        dReal JiM0 = currJinvM[JIM_LX];
+        dReal JiM1 = currJinvM[JIM_LY];
+        dReal JiM2 = currJinvM[JIM_LZ];
+        dReal JiM4 = currJinvM[JIM_AX];
+        dReal JiM5 = currJinvM[JIM_AY];
+        dReal JiM6 = currJinvM[JIM_AZ];
+        const unsigned int cols = diagonal ? i + 1 : infomJ;
+        const dReal *currJ = JRow;
+        for (unsigned int j = 0; j != cols; ++j) {
+            dReal sum;
+            sum  = JiM0 * currJ[JME_JLX];
+            sum += JiM1 * currJ[JME_JLY];
+            sum += JiM2 * currJ[JME_JLZ];
+            sum += JiM4 * currJ[JME_JAX];
+            sum += JiM5 * currJ[JME_JAY];
+            sum += JiM6 * currJ[JME_JAZ];
+            Arow[j] += sum;
+            currJ += JME__MAX;
+        }
+        currJinvM += JIM__MAX;
+        Arow += rowlength++;
+    }
+}
+
+
 // this assumes the 4th and 8th rows of B are zero.
 
 static inline 
@@ -507,6 +552,726 @@ void MultiplyAddJxLambdaToCForce(dReal cforce[CFE__MAX],
 }
 
 
+//****************************************************************************
+// sparse system layout
+
+// add the joints reachable from `start' through shared bodies to `order' in
+// breadth-first order, marking them with `markvalue'. returns their count.
+
+static unsigned int OrderJointsBreadthFirst(const dJointWithInfo1 *jointinfos, unsigned int start, 
+    unsigned int *order, unsigned int *mark, unsigned int markvalue)
+{
+    unsigned int head = 0, tail = 0;
+    order[tail++] = start;
+    mark[start] = markvalue;
+    while (head != tail) {
+        const dxJoint *joint = jointinfos[order[head++]].joint;
+        for (unsigned int jb = dJCB__MIN; jb != dJCB__MAX; ++jb) {
+            const dxBody *b = joint->node[jb].body;
+            for (const dxJointNode *n = b != NULL ? b->firstjoint : NULL; n; n = n->next) {
+                // inactive joints are tagged as -1
+                int other = n->joint->tag;
+                if (other != -1 && mark[other] != markvalue) {
+                    mark[other] = markvalue;
+                    order[tail++] = other;
+                }
+            }
+        }
+    }
+    return tail;
+}
+
+// lay the rows of A out as an envelope for a sparse factorization. block
+// (i,j) of A is only nonzero if joints i and j share a body, so the joints
+// are numbered in reverse Cuthill-McKee order, which keeps the nonzero
+// blocks near the diagonal: chains and trees of joints get an envelope that
+// grows linearly with m. each row then starts at the first row of the
+// earliest joint that shares a body with its joint. returns the envelope size.
+
+static sizeint BuildEnvelopeLayout(const dJointWithInfo1 *jointinfos, unsigned int nj, 
+    unsigned int *jointRows, sizeint *rowStart, unsigned int *order, unsigned int *mark)
+{
+    dxSetZero(mark, nj);
+
+    // order each connected set of joints breadth first, starting from the
+    // last joint reached from an arbitrary one (a pseudo-peripheral joint)
+    unsigned int ordered = 0;
+    for (unsigned int ji = 0; ji != nj; ++ji) {
+        if (mark[ji] == 0) {
+            unsigned int count = OrderJointsBreadthFirst(jointinfos, ji, order + ordered, mark, 1);
+            unsigned int peripheral = order[ordered + count - 1];
+            OrderJointsBreadthFirst(jointinfos, peripheral, order + ordered, mark, 2);
+            ordered += count;
+        }
+    }
+    dIASSERT(ordered == nj);
+
+    for (unsigned int lo = 0, hi = nj - 1; lo < hi; ++lo, --hi) {
+        unsigned int tmp = order[lo]; order[lo] = order[hi]; order[hi] = tmp;
+    }
+
+    unsigned int moffs = 0;
+    for (unsigned int k = 0; k != nj; ++k) {
+        unsigned int ji = order[k];
+        jointRows[ji] = moffs;
+        moffs += jointinfos[ji].info.m;
+    }
+
+    sizeint size = 0;
+    rowStart[0] = 0;
+    for (unsigned int k = 0; k != nj; ++k) {
+        unsigned int ji = order[k];
+        const dxJoint *joint = jointinfos[ji].joint;
+        unsigned int first = jointRows[ji];
+        for (unsigned int jb = dJCB__MIN; jb != dJCB__MAX; ++jb) {
+            const dxBody *b = joint->node[jb].body;
+            for (const dxJointNode *n = b != NULL ? b->firstjoint : NULL; n; n = n->next) {
+                int other = n->joint->tag;
+                if (other != -1 && jointRows[other] < first) {
+                    first = jointRows[other];
+                }
+            }
+        }
+        const unsigned int rowsEnd = jointRows[ji] + jointinfos[ji].info.m;
+        for (unsigned int r = jointRows[ji]; r != rowsEnd; ++r) {
+            size += r - first + 1;
+            rowStart[r + 1] = size;
+        }
+    }
+
+    return size;
+}
+
+//****************************************************************************
+// articulated trees
+
+// the purely unbounded joints that connect the bodies of an island without
+// closing a loop form trees, and each tree may also be attached to the
+// static environment (or to kinematic bodies) by one of them. the tree
+// joints and the dynamic bodies are then the nodes of a forest, so that the
+// system of a tree
+//
+//   [ M  J' ] [  a ]   [  f  ]
+//   [ J  -C ] [ -l ] = [ rhs ]
+//
+// (a = the accelerations, l = the joint forces) is factored without any
+// fill-in by eliminating the nodes from the leaves to the root, in time
+// linear in the number of bodies (Baraff, "Linear-time dynamics using
+// Lagrange multipliers", 1996). the rows of the other joints are left to the
+// LCP, which sees the bodies through the factored trees.
+
+#define dxARTICULATION_ROOT         (-1)    // the node has no parent
+#define dxARTICULATION_NONE         (-2)    // not a node: a joint left to the LCP or a kinematic body
+#define dxARTICULATION_UNVISITED    (-3)
+
+#define dxARTICULATION_BLOCK        (dDA__MAX * dDA__MAX)
+
+struct dxArticulationLayout
+{
+    int                             *m_parent;          // parents of the body (0..nb-1) and joint (nb..nb+nj-1) nodes
+    unsigned int                    *m_order;           // nodes of each tree from its root to the leaves
+    unsigned int                    *m_componentStart;  // first elements of the trees in m_order
+    unsigned int                    *m_bodyComponent;   // tree of each dynamic body
+    unsigned int                    m_componentCount;
+};
+
+static inline 
+bool IsArticulatedBody(const dxBody *b)
+{
+    return b != NULL && b->invMass > 0;
+}
+
+static inline 
+unsigned int FindArticulationSet(unsigned int *sets, unsigned int bi)
+{
+    while (sets[bi] != bi) {
+        sets[bi] = sets[sets[bi]];
+        bi = sets[bi];
+    }
+    return bi;
+}
+
+// pick the tree joints among the purely unbounded joints (the first `nub'
+// ones of jointinfos) and order the nodes of each tree breadth first from
+// its root. returns the number of tree joints.
+
+static unsigned int BuildArticulationLayout(dxArticulationLayout *layout, dxBody *const *body, unsigned int nb, 
+    const dJointWithInfo1 *jointinfos, unsigned int nj, unsigned int nub, unsigned int *sets, int *rootJoints)
+{
+    int *parent = layout->m_parent;
+    dxSetValue(parent, (sizeint)nb + nj, dxARTICULATION_NONE);
+    for (unsigned int bi = 0; bi != nb; ++bi) {
+        sets[bi] = bi;
+        rootJoints[bi] = -1;
+        if (IsArticulatedBody(body[bi])) {
+            parent[bi] = dxARTICULATION_UNVISITED;
+        }
+    }
+
+    // a joint joins two trees unless it closes a loop, either directly or
+    // through the environment that both trees are already attached to
+    unsigned int treeJoints = 0;
+    for (unsigned int ji = 0; ji != nub; ++ji) {
+        const dxJoint *joint = jointinfos[ji].joint;
+        const dxBody *b0 = joint->node[0].body, *b1 = joint->node[1].body;
+        const bool dynamic0 = IsArticulatedBody(b0), dynamic1 = IsArticulatedBody(b1);
+        if (dynamic0 && dynamic1) {
+            unsigned int s0 = FindArticulationSet(sets, (unsigned int)b0->tag);
+            unsigned int s1 = FindArticulationSet(sets, (unsigned int)b1->tag);
+            if (s0 == s1 || (rootJoints[s0] != -1 && rootJoints[s1] != -1)) {
+                continue;
+            }
+            sets[s1] = s0;
+            if (rootJoints[s0] == -1) {
+                rootJoints[s0] = rootJoints[s1];
+            }
+        }
+        else if (dynamic0 || dynamic1) {
+            unsigned int s = FindArticulationSet(sets, (unsigned int)(dynamic0 ? b0 : b1)->tag);
+            if (rootJoints[s] != -1) {
+                continue;
+            }
+            rootJoints[s] = (int)ji;
+        }
+        else {
+            continue;
+        }
+        parent[nb + ji] = dxARTICULATION_UNVISITED;
+        ++treeJoints;
+    }
+
+    if (treeJoints != 0) {
+        unsigned int *order = layout->m_order;
+        unsigned int *componentStart = layout->m_componentStart;
+        unsigned int count = 0, components = 0;
+        for (unsigned int bi = 0; bi != nb; ++bi) {
+            if (parent[bi] != dxARTICULATION_UNVISITED) {
+                continue;
+            }
+            // a tree attached to the environment is rooted at its attaching joint
+            int rootJoint = rootJoints[FindArticulationSet(sets, bi)];
+            unsigned int root = rootJoint != -1 ? nb + (unsigned int)rootJoint : bi;
+            componentStart[components] = count;
+            parent[root] = dxARTICULATION_ROOT;
+            order[count++] = root;
+            for (unsigned int head = componentStart[components]; head != count; ++head) {
+                unsigned int node = order[head];
+                if (node < nb) {
+                    layout->m_bodyComponent[node] = components;
+                    for (const dxJointNode *n = body[node]->firstjoint; n; n = n->next) {
+                        // inactive joints are tagged as -1
+                        int other = n->joint->tag;
+                        if (other != -1 && parent[nb + other] == dxARTICULATION_UNVISITED) {
+                            parent[nb + other] = (int)node;
+                            order[count++] = nb + other;
+                        }
+                    }
+                }
+                else {
+                    const dxJoint *joint = jointinfos[node - nb].joint;
+                    for (unsigned int jb = dJCB__MIN; jb != dJCB__MAX; ++jb) {
+                        const dxBody *b = joint->node[jb].body;
+                        if (IsArticulatedBody(b) && parent[b->tag] == dxARTICULATION_UNVISITED) {
+                            parent[b->tag] = (int)node;
+                            order[count++] = (unsigned int)b->tag;
+                        }
+                    }
+                }
+            }
+            ++components;
+        }
+        componentStart[components] = count;
+        layout->m_componentCount = components;
+    }
+
+    return treeJoints;
+}
+
+// invert the symmetric block D, which is definite with the sign `sign', in
+// place through its Cholesky factor. pivots that vanish for degenerate
+// joints are clamped to a tiny fraction of the diagonal.
+
+static void InvertDefiniteBlock(dReal *D, unsigned int n, dReal sign)
+{
+    dReal L[dxARTICULATION_BLOCK], Linv[dxARTICULATION_BLOCK];
+
+    dReal diagmax = 0;
+    for (unsigned int i = 0; i != n; ++i) {
+        diagmax = dMAX(diagmax, dFabs(D[i * n + i]));
+    }
+    const dReal limit = dEpsilon * (diagmax > 0 ? diagmax : REAL(1.0));
+
+    for (unsigned int i = 0; i != n; ++i) {
+        for (unsigned int j = 0; j <= i; ++j) {
+            dReal sum = sign * D[i * n + j];
+            for (unsigned int k = 0; k != j; ++k) {
+                sum -= L[i * n + k] * L[j * n + k];
+            }
+            if (j != i) {
+                L[i * n + j] = sum / L[j * n + j];
+            }
+            else {
+                L[i * n + i] = dSqrt(dMAX(sum, limit));
+            }
+        }
+    }
+
+    for (unsigned int j = 0; j != n; ++j) {
+        for (unsigned int i = j; i != n; ++i) {
+            dReal sum = i == j ? REAL(1.0) : REAL(0.0);
+            for (unsigned int k = j; k != i; ++k) {
+                sum -= L[i * n + k] * Linv[k * n + j];
+            }
+            Linv[i * n + j] = sum / L[i * n + i];
+        }
+    }
+
+    // inv(D) = sign * inv(L)' * inv(L)
+    for (unsigned int i = 0; i != n; ++i) {
+        for (unsigned int j = 0; j <= i; ++j) {
+            dReal sum = 0;
+            for (unsigned int k = i; k != n; ++k) {
+                sum += Linv[k * n + i] * Linv[k * n + j];
+            }
+            D[i * n + j] = D[j * n + i] = sign * sum;
+        }
+    }
+}
+
+// the factors of the trees of an island. each node keeps the inverse of its
+// pivot block D and, unless it is a root, K = inv(D) * H(node, parent). the
+// vectors hold dDA__MAX elements per node: the forces and accelerations of
+// the bodies and the right hand sides and negated forces of the joints.
+
+struct dxArticulationSystem
+{
+    void Initialize(const dxArticulationLayout *layout, dxBody *const *body, unsigned int nb, 
+        const dJointWithInfo1 *jointinfos, const unsigned int *mindex, const dReal *J, dReal *Dinv, dReal *K)
+    {
+        m_layout = layout;
+        m_body = body;
+        m_nb = nb;
+        m_jointinfos = jointinfos;
+        m_mindex = mindex;
+        m_J = J;
+        m_Dinv = Dinv;
+        m_K = K;
+    }
+
+    unsigned int NodeSize(unsigned int node) const
+    {
+        return node < m_nb ? (unsigned int)dDA__MAX : m_jointinfos[node - m_nb].info.m;
+    }
+
+    // the jacobian of a joint on one of its bodies
+    const dReal *JointJacobian(unsigned int ji, unsigned int bi) const
+    {
+        const unsigned int infom = m_jointinfos[ji].info.m;
+        const bool second = m_jointinfos[ji].joint->node[dJCB_SECOND_BODY].body == m_body[bi];
+        return m_J + ((sizeint)m_mindex[ji] * 2 + (second ? infom : 0)) * JME__MAX;
+    }
+
+    // H(node, parent) is J' of the edge for a body and J for a joint
+    const dReal *ParentBlock(unsigned int node, unsigned int parent, sizeint &rowStep, sizeint &colStep) const
+    {
+        if (node < m_nb) {
+            rowStep = 1;
+            colStep = JME__MAX;
+            return JointJacobian(parent - m_nb, node);
+        }
+        rowStep = JME__MAX;
+        colStep = 1;
+        return JointJacobian(node - m_nb, parent);
+    }
+
+    void Factor(const dxBodyStateStore &state, const dReal *pairsRhsCfm);
+    void LoadRhs(dReal *x, const dReal *pairsRhsCfm) const;
+    void ClearComponent(dReal *x, unsigned int component) const;
+    void Solve(dReal *x, unsigned int component) const;
+
+    const dxArticulationLayout      *m_layout;
+    dxBody *const                   *m_body;
+    unsigned int                    m_nb;
+    const dJointWithInfo1           *m_jointinfos;
+    const unsigned int              *m_mindex;
+    const dReal                     *m_J;
+    dReal                           *m_Dinv;
+    dReal                           *m_K;
+};
+
+void dxArticulationSystem::Factor(const dxBodyStateStore &state, const dReal *pairsRhsCfm)
+{
+    const dxArticulationLayout *layout = m_layout;
+    const unsigned int nodeCount = layout->m_componentStart[layout->m_componentCount];
+
+    // the pivot blocks start as the body masses and the negated joint CFMs
+    for (unsigned int k = 0; k != nodeCount; ++k) {
+        const unsigned int node = layout->m_order[k];
+        dReal *D = m_Dinv + (sizeint)node * dxARTICULATION_BLOCK;
+        if (node < m_nb) {
+            const dxBody *b = m_body[node];
+            const unsigned slot = b->state_slot;
+            dMatrix3 tmp, I;
+            dMultiply2_333 (tmp, state.I(slot), state.R(slot));
+            dMultiply0_333 (I, state.R(slot), tmp);
+            dSetZero(D, dxARTICULATION_BLOCK);
+            for (unsigned int i = dSA__MIN; i != dSA__MAX; ++i) {
+                D[(dDA__L_MIN + i) * dDA__MAX + dDA__L_MIN + i] = b->mass.mass;
+                for (unsigned int j = dSA__MIN; j != dSA__MAX; ++j) {
+                    D[(dDA__A_MIN + i) * dDA__MAX + dDA__A_MIN + j] = I[i * dV3E__MAX + j];
+                }
+            }
+        }
+        else {
+            const unsigned int ji = node - m_nb;
+            const unsigned int infom = m_jointinfos[ji].info.m;
+            const dReal *rowRhsCfm = pairsRhsCfm + (sizeint)m_mindex[ji] * RCE__RHS_CFM_MAX;
+            dSetZero(D, (sizeint)infom * infom);
+            for (unsigned int i = 0; i != infom; ++i) {
+                D[i * infom + i] = -rowRhsCfm[i * RCE__RHS_CFM_MAX + RCE_CFM];
+            }
+        }
+    }
+
+    // eliminate the nodes from the leaves: D(parent) -= H(node, parent)' * K
+    for (unsigned int k = nodeCount; k != 0; ) {
+        const unsigned int node = layout->m_order[--k];
+        const unsigned int n = NodeSize(node);
+        const dReal *Dinv = m_Dinv + (sizeint)node * dxARTICULATION_BLOCK;
+        InvertDefiniteBlock(m_Dinv + (sizeint)node * dxARTICULATION_BLOCK, n, node < m_nb ? REAL(1.0) : REAL(-1.0));
+
+        const int parent = layout->m_parent[node];
+        if (parent != dxARTICULATION_ROOT) {
+            const unsigned int p = (unsigned int)parent, q = NodeSize(p);
+            sizeint rs, cs;
+            const dReal *H = ParentBlock(node, p, rs, cs);
+            dReal *K = m_K + (sizeint)node * dxARTICULATION_BLOCK;
+            for (unsigned int i = 0; i != n; ++i) {
+                for (unsigned int j = 0; j != q; ++j) {
+                    dReal sum = 0;
+                    for (unsigned int l = 0; l != n; ++l) {
+                        sum += Dinv[i * n + l] * H[l * rs + j * cs];
+                    }
+                    K[i * q + j] = sum;
+                }
+            }
+            dReal *Dp = m_Dinv + (sizeint)p * dxARTICULATION_BLOCK;
+            for (unsigned int i = 0; i != q; ++i) {
+                for (unsigned int j = 0; j != q; ++j) {
+                    dReal sum = 0;
+                    for (unsigned int l = 0; l != n; ++l) {
+                        sum += H[l * rs + i * cs] * K[l * q + j];
+                    }
+                    Dp[i * q + j] -= sum;
+                }
+            }
+        }
+    }
+}
+
+// zero the body forces and put the joint right hand sides into x
+void dxArticulationSystem::LoadRhs(dReal *x, const dReal *pairsRhsCfm) const
+{
+    const dxArticulationLayout *layout = m_layout;
+    const unsigned int nodeCount = layout->m_componentStart[layout->m_componentCount];
+
+    for (unsigned int k = 0; k != nodeCount; ++k) {
+        const unsigned int node = layout->m_order[k];
+        dReal *xn = x + (sizeint)node * dDA__MAX;
+        if (node < m_nb) {
+            dSetZero(xn, dDA__MAX);
+        }
+        else {
+            const unsigned int ji = node - m_nb;
+            const unsigned int infom = m_jointinfos[ji].info.m;
+            const dReal *rowRhsCfm = pairsRhsCfm + (sizeint)m_mindex[ji] * RCE__RHS_CFM_MAX;
+            for (unsigned int i = 0; i != infom; ++i) {
+                xn[i] = rowRhsCfm[i * RCE__RHS_CFM_MAX + RCE_RHS];
+            }
+        }
+    }
+}
+
+void dxArticulationSystem::ClearComponent(dReal *x, unsigned int component) const
+{
+    const dxArticulationLayout *layout = m_layout;
+    const unsigned int end = layout->m_componentStart[component + 1];
+    for (unsigned int k = layout->m_componentStart[component]; k != end; ++k) {
+        dSetZero(x + (sizeint)layout->m_order[k] * dDA__MAX, dDA__MAX);
+    }
+}
+
+// solve the system of one tree for the vectors in x, in place
+void dxArticulationSystem::Solve(dReal *x, unsigned int component) const
+{
+    const dxArticulationLayout *layout = m_layout;
+    const unsigned int begin = layout->m_componentStart[component];
+    const unsigned int end = layout->m_componentStart[component + 1];
+
+    // from the leaves: z = inv(D) * x, x(parent) -= H(node, parent)' * z
+    for (unsigned int k = end; k != begin; ) {
+        const unsigned int node = layout->m_order[--k];
+        const unsigned int n = NodeSize(node);
+        const dReal *Dinv = m_Dinv + (sizeint)node * dxARTICULATION_BLOCK;
+        dReal *xn = x + (sizeint)node * dDA__MAX;
+        dReal z[dDA__MAX];
+        for (unsigned int i = 0; i != n; ++i) {
+            dReal sum = 0;
+            for (unsigned int l = 0; l != n; ++l) {
+                sum += Dinv[i * n + l] * xn[l];
+            }
+            z[i] = sum;
+        }
+        for (unsigned int i = 0; i != n; ++i) {
+            xn[i] = z[i];
+        }
+
+        const int parent = layout->m_parent[node];
+        if (parent != dxARTICULATION_ROOT) {
+            const unsigned int p = (unsigned int)parent, q = NodeSize(p);
+            sizeint rs, cs;
+            const dReal *H = ParentBlock(node, p, rs, cs);
+            dReal *xp = x + (sizeint)p * dDA__MAX;
+            for (unsigned int i = 0; i != q; ++i) {
+                dReal sum = 0;
+                for (unsigned int l = 0; l != n; ++l) {
+                    sum += H[l * rs + i * cs] * z[l];
+                }
+                xp[i] -= sum;
+            }
+        }
+    }
+
+    // from the root: x = z - K * x(parent)
+    for (unsigned int k = begin; k != end; ++k) {
+        const unsigned int node = layout->m_order[k];
+        const int parent = layout->m_parent[node];
+        if (parent != dxARTICULATION_ROOT) {
+            const unsigned int n = NodeSize(node), q = NodeSize((unsigned int)parent);
+            const dReal *K = m_K + (sizeint)node * dxARTICULATION_BLOCK;
+            const dReal *xp = x + (sizeint)parent * dDA__MAX;
+            dReal *xn = x + (sizeint)node * dDA__MAX;
+            for (unsigned int i = 0; i != n; ++i) {
+                dReal sum = 0;
+                for (unsigned int j = 0; j != q; ++j) {
+                    sum += K[i * q + j] * xp[j];
+                }
+                xn[i] -= sum;
+            }
+        }
+    }
+}
+
+static inline 
+dReal DotJacobianRow(const dReal *JRow, const dReal *v)
+{
+    dReal sum = 0;
+    for (unsigned int i = JME__J_MIN; i != JME__J_MAX; ++i) {
+        sum += JRow[i] * v[i - JME__J_MIN];
+    }
+    return sum;
+}
+
+// solve the constraint system of an island with articulated trees for the
+// lambdas. the trees are factored and then the LCP of the remaining rows is
+// built column by column from the tree responses to the unit forces of its
+// rows, that is, as the Schur complement of the tree rows in A.
+
+static void dxStepIsland_SolveArticulated(dxWorldProcessMemArena *memarena, 
+    const dxStepperProcessingCallContext *callContext, const dxStepperLocalContext *localContext)
+{
+    const dxArticulationLayout *layout = localContext->m_articulation;
+    dxBody *const *body = callContext->m_islandBodiesStart;
+    const unsigned int nb = callContext->m_islandBodiesCount;
+    const dJointWithInfo1 *jointinfos = localContext->m_jointinfos;
+    const unsigned int nj = localContext->m_nj;
+    const unsigned int nub = localContext->m_nub;
+    const unsigned int *mindex = localContext->m_mindex;
+    const int *findex = localContext->m_findex;
+    const dReal *J = localContext->m_J;
+    dReal *pairsRhsLambda = localContext->m_pairsRhsCfm; // the cfm values are still in the lambda elements
+    const dReal *pairsLoHi = localContext->m_pairsLoHi;
+    const int *parent = layout->m_parent;
+    const unsigned int *bodyComponent = layout->m_bodyComponent;
+    const unsigned int componentCount = layout->m_componentCount;
+    const bool warmStart = callContext->m_world->step_warm_starting != 0;
+
+    const sizeint nodes = (sizeint)nb + nj;
+    dReal *Dinv = memarena->AllocateArray<dReal>(nodes * dxARTICULATION_BLOCK);
+    dReal *K = memarena->AllocateArray<dReal>(nodes * dxARTICULATION_BLOCK);
+    dReal *x = memarena->AllocateArray<dReal>(nodes * dDA__MAX);
+
+    dxArticulationSystem system;
+    system.Initialize(layout, body, nb, jointinfos, mindex, J, Dinv, K);
+    system.Factor(callContext->m_world->body_state, pairsRhsLambda);
+
+    unsigned int mlcp = 0, nublcp = 0;
+    for (unsigned int ji = 0; ji != nj; ++ji) {
+        if (parent[nb + ji] == dxARTICULATION_NONE) {
+            mlcp += jointinfos[ji].info.m;
+            // the purely unbounded joints come first
+            if (ji < nub) {
+                nublcp += jointinfos[ji].info.m;
+            }
+        }
+    }
+
+    // the accelerations the trees get from their own joints
+    system.LoadRhs(x, pairsRhsLambda);
+    for (unsigned int c = 0; c != componentCount; ++c) {
+        system.Solve(x, c);
+    }
+
+    if (mlcp != 0) {
+        const unsigned int mskip = dPAD(mlcp);
+        dReal *A = memarena->AllocateOveralignedArray<dReal>((sizeint)mlcp * mskip, AMATRIX_ALIGNMENT);
+        dReal *pairsbx = memarena->AllocateArray<dReal>((sizeint)mlcp * PBX__MAX);
+        dReal *pairslh = memarena->AllocateArray<dReal>((sizeint)mlcp * PLH__MAX);
+        int *findexlcp = memarena->AllocateArray<int>(mlcp);
+        dReal *cfm = memarena->AllocateArray<dReal>(mlcp);
+        // the jacobian rows of the LCP rows and their dynamic bodies (nb for none)
+        const dReal **rowJ = memarena->AllocateArray<const dReal *>((sizeint)mlcp * dJCB__MAX);
+        unsigned int *rowBody = memarena->AllocateArray<unsigned int>((sizeint)mlcp * dJCB__MAX);
+
+        // the LCP sees the right hand sides less what the trees already do
+        unsigned int k = 0;
+        for (unsigned int ji = 0; ji != nj; ++ji) {
+            if (parent[nb + ji] != dxARTICULATION_NONE) {
+                continue;
+            }
+            const dxJoint *joint = jointinfos[ji].joint;
+            const unsigned int ofsi = mindex[ji];
+            const unsigned int infom = jointinfos[ji].info.m;
+            const dReal *JRow = J + (sizeint)ofsi * (2 * JME__MAX);
+            for (unsigned int i = 0; i != infom; ++i, ++k) {
+                const unsigned int row = ofsi + i;
+                dReal rhs = pairsRhsLambda[(sizeint)row * RLE__RHS_LAMBDA_MAX + RLE_RHS];
+                for (unsigned int jb = dJCB__MIN; jb != dJCB__MAX; ++jb) {
+                    const dxBody *b = joint->node[jb].body;
+                    const unsigned int bi = IsArticulatedBody(b) ? (unsigned int)b->tag : nb;
+                    const dReal *JBodyRow = JRow + (sizeint)(jb * infom + i) * JME__MAX;
+                    rowBody[(sizeint)k * dJCB__MAX + jb] = bi;
+                    rowJ[(sizeint)k * dJCB__MAX + jb] = JBodyRow;
+                    if (bi != nb) {
+                        rhs -= DotJacobianRow(JBodyRow, x + (sizeint)bi * dDA__MAX);
+                    }
+                }
+                pairsbx[(sizeint)k * PBX__MAX + PBX_B] = rhs;
+                pairsbx[(sizeint)k * PBX__MAX + PBX_X] = warmStart ? joint->lambda[i] : REAL(0.0);
+                cfm[k] = pairsRhsLambda[(sizeint)row * RCE__RHS_CFM_MAX + RCE_CFM];
+                pairslh[(sizeint)k * PLH__MAX + PLH_LO] = pairsLoHi[(sizeint)row * LHE__LO_HI_MAX + LHE_LO];
+                pairslh[(sizeint)k * PLH__MAX + PLH_HI] = pairsLoHi[(sizeint)row * LHE__LO_HI_MAX + LHE_HI];
+                // findex refers to a row of the same joint
+                const int fival = findex[row];
+                dIASSERT(fival == -1 || dIN_RANGE((unsigned int)fival, ofsi, ofsi + infom));
+                findexlcp[k] = fival != -1 ? (int)(k - i) + (fival - (int)ofsi) : -1;
+            }
+        }
+        dIASSERT(k == mlcp);
+
+        // column kc of A holds the accelerations of the LCP rows under a
+        // unit force of row kc, which only reach the trees of its bodies
+        for (unsigned int kc = 0; kc != mlcp; ++kc) {
+            unsigned int c0 = ~0U, c1 = ~0U;
+            for (unsigned int jb = dJCB__MIN; jb != dJCB__MAX; ++jb) {
+                const unsigned int bi = rowBody[(sizeint)kc * dJCB__MAX + jb];
+                if (bi != nb) {
+                    const unsigned int c = bodyComponent[bi];
+                    if (c0 == ~0U) {
+                        c0 = c;
+                    }
+                    else if (c != c0) {
+                        c1 = c;
+                    }
+                }
+            }
+
+            if (c0 != ~0U) {
+                system.ClearComponent(x, c0);
+                if (c1 != ~0U) {
+                    system.ClearComponent(x, c1);
+                }
+                for (unsigned int jb = dJCB__MIN; jb != dJCB__MAX; ++jb) {
+                    const unsigned int bi = rowBody[(sizeint)kc * dJCB__MAX + jb];
+                    if (bi != nb) {
+                        const dReal *JBodyRow = rowJ[(sizeint)kc * dJCB__MAX + jb];
+                        dReal *xb = x + (sizeint)bi * dDA__MAX;
+                        for (unsigned int i = JME__J_MIN; i != JME__J_MAX; ++i) {
+                            xb[i - JME__J_MIN] += JBodyRow[i];
+                        }
+                    }
+                }
+                system.Solve(x, c0);
+                if (c1 != ~0U) {
+                    system.Solve(x, c1);
+                }
+            }
+
+            for (unsigned int kr = kc; kr != mlcp; ++kr) {
+                dReal sum = 0;
+                for (unsigned int jb = dJCB__MIN; jb != dJCB__MAX; ++jb) {
+                    const unsigned int bi = rowBody[(sizeint)kr * dJCB__MAX + jb];
+                    if (bi != nb && (bodyComponent[bi] == c0 || bodyComponent[bi] == c1)) {
+                        sum += DotJacobianRow(rowJ[(sizeint)kr * dJCB__MAX + jb], x + (sizeint)bi * dDA__MAX);
+                    }
+                }
+                A[(sizeint)kr * mskip + kc] = sum;
+                A[(sizeint)kc * mskip + kr] = sum;
+            }
+            // the response of a row to its own force can not be negative, but
+            // the rounding of stiff trees may make it so in single precision
+            dReal &diag = A[(sizeint)kc * mskip + kc];
+            diag = dMAX(diag, REAL(0.0)) + cfm[kc];
+        }
+
+        BEGIN_STATE_SAVE(memarena, lcpstate) {
+            dxSolveLCP (memarena, mlcp, A, pairsbx, NULL, nublcp, pairslh, findexlcp, warmStart);
+        } END_STATE_SAVE(memarena, lcpstate);
+
+        // the LCP forces act on the trees together with their own joints
+        system.LoadRhs(x, pairsRhsLambda);
+        k = 0;
+        for (unsigned int ji = 0; ji != nj; ++ji) {
+            if (parent[nb + ji] != dxARTICULATION_NONE) {
+                continue;
+            }
+            const unsigned int ofsi = mindex[ji];
+            const unsigned int infom = jointinfos[ji].info.m;
+            for (unsigned int i = 0; i != infom; ++i, ++k) {
+                const dReal lambda = pairsbx[(sizeint)k * PBX__MAX + PBX_X];
+                pairsRhsLambda[(sizeint)(ofsi + i) * RLE__RHS_LAMBDA_MAX + RLE_LAMBDA] = lambda;
+                for (unsigned int jb = dJCB__MIN; jb != dJCB__MAX; ++jb) {
+                    const unsigned int bi = rowBody[(sizeint)k * dJCB__MAX + jb];
+                    if (bi != nb) {
+                        const dReal *JBodyRow = rowJ[(sizeint)k * dJCB__MAX + jb];
+                        dReal *xb = x + (sizeint)bi * dDA__MAX;
+                        for (unsigned int e = JME__J_MIN; e != JME__J_MAX; ++e) {
+                            xb[e - JME__J_MIN] += JBodyRow[e] * lambda;
+                        }
+                    }
+                }
+            }
+        }
+        for (unsigned int c = 0; c != componentCount; ++c) {
+            system.Solve(x, c);
+        }
+    }
+
+    // the tree joint forces are the negated solutions of the joint nodes
+    for (unsigned int ji = 0; ji != nj; ++ji) {
+        if (parent[nb + ji] == dxARTICULATION_NONE) {
+            continue;
+        }
+        const unsigned int infom = jointinfos[ji].info.m;
+        const dReal *xn = x + ((sizeint)nb + ji) * dDA__MAX;
+        dReal *rowLambda = pairsRhsLambda + (sizeint)mindex[ji] * RLE__RHS_LAMBDA_MAX;
+        for (unsigned int i = 0; i != infom; ++i) {
+            rowLambda[i * RLE__RHS_LAMBDA_MAX + RLE_LAMBDA] = -xn[i];
+        }
+    }
+}
+
+
 //****************************************************************************
 
 /*extern */
@@ -625,6 +1390,7 @@ void dxStepIsland_Stage0_Bodies(dxStepperStage0BodiesCallContext *callContext)
     // frame, and compute the rotational force and add it to the torque
     // accumulator. I and invI are a vertical stack of 3x4 matrices, one per body.
     {
+        const dxBodyStateStore &state = callContext->m_stepperCallContext->m_world->body_state;
         dReal *invIrow = callContext->m_invI;
         unsigned int bodyIndex = ThrsafeIncrementIntUpToLimit(&callContext->m_inertiaBodyIndex, nb);
 
@@ -632,30 +1398,32 @@ void dxStepIsland_Stage0_Bodies(dxStepperStage0BodiesCallContext *callContext)
             if (i == bodyIndex) {
                 dMatrix3 tmp;
                 dxBody *b = body[i];
+                const unsigned slot = b->state_slot;
+                const dReal *R = state.R(slot), *avel = state.avel(slot);
 
                 // compute inverse inertia tensor in global frame
-                dMultiply2_333 (tmp, b->invI, b->posr.R);
-                dMultiply0_333 (invIrow, b->posr.R, tmp);
+                dMultiply2_333 (tmp, state.invI(slot), R);
+                dMultiply0_333 (invIrow, R, tmp);
 
                 // Don't apply gyroscopic torques to bodies
                 // if not flagged or the body is kinematic
-                if ((b->flags & dxBodyGyroscopic) && (b->invMass > 0)) {
+                if ((b->flags & dxBodyGyroscopic) && (state.invMass(slot) > 0)) {
                     dMatrix3 I;
                     // compute inertia tensor in global frame
-                    dMultiply2_333 (tmp,b->mass.I,b->posr.R);
-                    dMultiply0_333 (I,b->posr.R,tmp);
+                    dMultiply2_333 (tmp,state.I(slot),R);
+                    dMultiply0_333 (I,R,tmp);
                     // compute rotational force
 #if 0
                     // Explicit computation
-                    dMultiply0_331 (tmp,I,b->avel);
-                    dSubtractVectorCross3(b->tacc,b->avel,tmp);
+                    dMultiply0_331 (tmp,I,avel);
+                    dSubtractVectorCross3(b->tacc,avel,tmp);
 #else
                     // Do the implicit computation based on 
                     //"Stabilizing Gyroscopic Forces in Rigid Multibody Simulations"
                     // (Lacoursière 2006)
                     dReal h = callContext->m_stepperCallContext->m_stepSize; // Step size
                     dVector3 L; // Compute angular momentum
-                    dMultiply0_331(L, I, b->avel);
+                    dMultiply0_331(L, I, avel);
                     
                     // Compute a new effective 'inertia tensor'
                     // for the implicit step: the cross-product 
@@ -914,8 +1682,10 @@ void dxStepIsland_Stage1(dxStepperStage1CallContext *stage1CallContext)
     unsigned int nj = (unsigned int)(ji_end - ji_start);
     dIASSERT((sizeint)(ji_end - ji_start) <= (sizeint)UINT_MAX);
 
-    unsigned int *mindex = NULL;
+    unsigned int *mindex = NULL, *jointRows = NULL;
     dReal *J = NULL, *A = NULL, *pairsRhsCfm = NULL, *pairsLoHi = NULL;
+    sizeint *rowStart = NULL;
+    dxArticulationLayout *articulation = NULL;
     int *findex = NULL;
     atomicord32 *bodyStartJoints = NULL, *bodyJointLinks = NULL;
 
@@ -942,7 +1712,48 @@ void dxStepIsland_Stage1(dxStepperStage1CallContext *stage1CallContext)
         // 'findex' vector.
         findex = memarena->AllocateArray<int>(m);
         J = memarena->AllocateArray<dReal>((sizeint)m * (2 * JME__MAX));
-        A = memarena->AllocateOveralignedArray<dReal>((sizeint)m * dPAD(m), AMATRIX_ALIGNMENT);
+        // when joints connect the bodies into trees, the trees are solved in
+        // linear time and A is only built for the rows of the other joints
+        if (callContext->m_world->step_articulated && nub != 0) {
+            void *layoutstate = memarena->SaveState();
+            const unsigned int nb = callContext->m_islandBodiesCount;
+            dxArticulationLayout *layout = (dxArticulationLayout *)memarena->AllocateBlock(sizeof(dxArticulationLayout));
+            layout->m_parent = memarena->AllocateArray<int>((sizeint)nb + nj);
+            layout->m_order = memarena->AllocateArray<unsigned int>((sizeint)nb + nj);
+            layout->m_componentStart = memarena->AllocateArray<unsigned int>((sizeint)nb + 1);
+            layout->m_bodyComponent = memarena->AllocateArray<unsigned int>(nb);
+            unsigned int treeJoints;
+            BEGIN_STATE_SAVE(memarena, setsstate) {
+                unsigned int *sets = memarena->AllocateArray<unsigned int>(nb);
+                int *rootJoints = memarena->AllocateArray<int>(nb);
+                treeJoints = BuildArticulationLayout(layout, callContext->m_islandBodiesStart, nb, jointinfos, nj, nub, sets, rootJoints);
+            } END_STATE_SAVE(memarena, setsstate);
+            if (treeJoints != 0) {
+                articulation = layout;
+            }
+            else {
+                memarena->RestoreState(layoutstate);
+            }
+        }
+        // when all the joints are unbounded the LCP is a linear system, which
+        // may be factored as a sparse matrix instead of a dense one
+        if (articulation != NULL) {
+            // A is built in stage 3
+        }
+        else if (callContext->m_world->step_sparse && nub == nj) {
+            jointRows = memarena->AllocateArray<unsigned int>(nj);
+            rowStart = memarena->AllocateArray<sizeint>((sizeint)m + 1);
+            sizeint envelopeSize;
+            BEGIN_STATE_SAVE(memarena, layoutstate) {
+                unsigned int *order = memarena->AllocateArray<unsigned int>(nj);
+                unsigned int *mark = memarena->AllocateArray<unsigned int>(nj);
+                envelopeSize = BuildEnvelopeLayout(jointinfos, nj, jointRows, rowStart, order, mark);
+            } END_STATE_SAVE(memarena, layoutstate);
+            A = memarena->AllocateArray<dReal>(envelopeSize);
+        }
+        else {
+            A = memarena->AllocateOveralignedArray<dReal>((sizeint)m * dPAD(m), AMATRIX_ALIGNMENT);
+        }
         pairsRhsCfm = memarena->AllocateArray<dReal>((sizeint)m * RCE__RHS_CFM_MAX);
         pairsLoHi = memarena->AllocateArray<dReal>((sizeint)m * LHE__LO_HI_MAX);
         const unsigned int nb = callContext->m_islandBodiesCount;
@@ -952,14 +1763,14 @@ void dxStepIsland_Stage1(dxStepperStage1CallContext *stage1CallContext)
     }
 
     dxStepperLocalContext *localContext = (dxStepperLocalContext *)memarena->AllocateBlock(sizeof(dxStepperLocalContext));
-    localContext->Initialize(invI, jointinfos, nj, m, nub, mindex, findex, J, A, pairsRhsCfm, pairsLoHi, bodyStartJoints, bodyJointLinks);
+    localContext->Initialize(invI, jointinfos, nj, m, nub, mindex, findex, J, A, jointRows, rowStart, articulation, pairsRhsCfm, pairsLoHi, bodyStartJoints, bodyJointLinks);
 
     void *stage1MemarenaState = memarena->SaveState();
     dxStepperStage3CallContext *stage3CallContext = (dxStepperStage3CallContext*)memarena->AllocateBlock(sizeof(dxStepperStage3CallContext));
     stage3CallContext->Initialize(callContext, localContext, stage1MemarenaState);
 
     if (m > 0) {
-        dReal *JinvM = memarena->AllocateOveralignedArray<dReal>((sizeint)m * (2 * JIM__MAX), JINVM_ALIGNMENT);
+        dReal *JinvM = A != NULL ? memarena->AllocateOveralignedArray<dReal>((sizeint)m * (2 * JIM__MAX), JINVM_ALIGNMENT) : NULL;
         const unsigned int nb = callContext->m_islandBodiesCount;
         dReal *rhs_tmp = memarena->AllocateArray<dReal>((sizeint)nb * dDA__MAX);
 
@@ -1143,7 +1954,7 @@ void dxStepIsland_Stage2b(dxStepperStage2CallContext *stage2CallContext)
     unsigned int nj = localContext->m_nj;
     const unsigned int *mindex = localContext->m_mindex;
 
-    {
+    if (localContext->m_A != NULL) {
         // Warning!!!
         // This code depends on cfm elements and therefore must be in different sub-stage 
         // from Jacobian construction in Stage2a to ensure proper synchronization 
@@ -1152,6 +1963,8 @@ void dxStepIsland_Stage2b(dxStepperStage2CallContext *stage2CallContext)
         dReal *A = localContext->m_A;
         const dReal *pairsRhsCfm = localContext->m_pairsRhsCfm;
         const unsigned m = localContext->m_m;
+        const unsigned int *jointRows = localContext->m_jointRows;
+        const sizeint *rowStart = localContext->m_rowStart;
 
         const unsigned int mskip = dPAD(m);
 
@@ -1160,6 +1973,17 @@ void dxStepIsland_Stage2b(dxStepperStage2CallContext *stage2CallContext)
             const unsigned ofsi = mindex[ji];
             const unsigned int infom = mindex[ji + 1] - ofsi;
 
+            if (rowStart != NULL) {
+                // the rows of a joint follow each other in the envelope and end with their diagonals
+                const unsigned int row = jointRows[ji];
+                dSetZero(A + rowStart[row], rowStart[row + infom] - rowStart[row]);
+                const dReal *rowRfsCrm = pairsRhsCfm + (sizeint)ofsi * RCE__RHS_CFM_MAX;
+                for (unsigned int i = 0; i != infom; ++i) {
+                    A[rowStart[row + i + 1] - 1] = (rowRfsCrm + i * RCE__RHS_CFM_MAX)[RCE_CFM];
+                }
+                continue;
+            }
+
             dReal *Arow = A + (sizeint)mskip * ofsi;
             dSetZero(Arow, (sizeint)mskip * infom);
             dReal *Adiag = Arow + ofsi;
@@ -1170,7 +1994,7 @@ void dxStepIsland_Stage2b(dxStepperStage2CallContext *stage2CallContext)
         }
     }
 
-    {
+    if (localContext->m_A != NULL) {
         // Warning!!!
         // This code depends on J elements and therefore must be in different sub-stage 
         // from Jacobian construction in Stage2a to ensure proper synchronization 
@@ -1229,6 +2053,7 @@ void dxStepIsland_Stage2b(dxStepperStage2CallContext *stage2CallContext)
         // Warning!!!
         dxBody * const *const body = callContext->m_islandBodiesStart;
         const unsigned int nb = callContext->m_islandBodiesCount;
+        const dxBodyStateStore &state = callContext->m_world->body_state;
         const dReal *invI = localContext->m_invI;
         atomicord32 *bodyStartJoints = localContext->m_bodyStartJoints;
         dReal *rhs_tmp = stage2CallContext->m_rhs_tmp;
@@ -1242,10 +2067,13 @@ void dxStepIsland_Stage2b(dxStepperStage2CallContext *stage2CallContext)
             dReal *tmp1curr = rhs_tmp + (sizeint)bi * dDA__MAX;
             const dReal *invIrow = invI + (sizeint)bi * dM3E__MAX;
             dxBody *b = body[bi];
+            const unsigned slot = b->state_slot;
+            const dReal body_invMass = state.invMass(slot);
+            const dReal *lvel = state.lvel(slot), *avel = state.avel(slot);
             // dSetZero(tmp1curr, 8); -- not needed
-            for (unsigned int j = dSA__MIN; j != dSA__MAX; ++j) tmp1curr[dDA__L_MIN + j] = b->facc[dV3E__AXES_MIN + j] * b->invMass + b->lvel[dV3E__AXES_MIN + j] * stepsizeRecip;
+            for (unsigned int j = dSA__MIN; j != dSA__MAX; ++j) tmp1curr[dDA__L_MIN + j] = b->facc[dV3E__AXES_MIN + j] * body_invMass + lvel[dV3E__AXES_MIN + j] * stepsizeRecip;
             dMultiply0_331 (tmp1curr + dDA__A_MIN, invIrow, b->tacc);
-            for (unsigned int k = dSA__MIN; k != dSA__MAX; ++k) tmp1curr[dDA__A_MIN + k] += b->avel[dV3E__AXES_MIN + k] * stepsizeRecip;
+            for (unsigned int k = dSA__MIN; k != dSA__MAX; ++k) tmp1curr[dDA__A_MIN + k] += avel[dV3E__AXES_MIN + k] * stepsizeRecip;
             // Initialize body start joint indices -- this will be needed later for building body related joint list in dxStepIsland_Stage2c
             bodyStartJoints[bi] = 0;
         }
@@ -1290,7 +2118,7 @@ void dxStepIsland_Stage2c(dxStepperStage2CallContext *stage2CallContext)
     unsigned int nj = localContext->m_nj;
     const unsigned int *mindex = localContext->m_mindex;
 
-    {
+    if (localContext->m_A != NULL) {
         // Warning!!!
         // This code depends on A elements and JinvM elements and therefore 
         // must be in different sub-stage from A initialization and JinvM calculation in Stage2b 
@@ -1305,12 +2133,47 @@ void dxStepIsland_Stage2c(dxStepperStage2CallContext *stage2CallContext)
         // i.e. in the same way as the rows of J. block (i,j) of A is only nonzero
         // if joints i and j have at least one body in common. 
         const unsigned int mskip = dPAD(m);
+        const unsigned int *jointRows = localContext->m_jointRows;
+        const sizeint *rowStart = localContext->m_rowStart;
 
         unsigned ji;
         while ((ji = ThrsafeIncrementIntUpToLimit(&stage2CallContext->m_ji_Aaddjb, nj)) != nj) {
             const unsigned ofsi = mindex[ji];
             const unsigned int infom = mindex[ji + 1] - ofsi;
 
+            if (rowStart != NULL) {
+                // the blocks of the joints that share a body and come earlier
+                // in the envelope order lie left of the diagonal block
+                const unsigned int row = jointRows[ji];
+                const unsigned int rowlength = (unsigned int)(rowStart[row + 1] - rowStart[row]);
+                dReal *Alast = A + rowStart[row + 1] - 1; // the diagonal of the first row
+                const dReal *JinvMRow = JinvM + (sizeint)ofsi * (2 * JIM__MAX);
+                dxJoint *joint = jointinfos[ji].joint;
+
+                for (unsigned int jb = dJCB__MIN; jb != dJCB__MAX; ++jb) {
+                    dxBody *b = joint->node[jb].body;
+                    if (b == NULL) {
+                        continue;
+                    }
+                    const dReal *JinvMBody = JinvMRow + (jb != dJCB__MIN ? infom * JIM__MAX : 0);
+                    const dReal *JRow = J + ((sizeint)ofsi * 2 + (jb != dJCB__MIN ? infom : 0)) * JME__MAX;
+                    MultiplyAddJinvMxJToEnvelope (Alast, JinvMBody, JRow, infom, infom, rowlength, true);
+
+                    for (dxJointNode *n = b->firstjoint; n; n = n->next) {
+                        int jo = n->joint->tag;
+                        if (jo != -1 && jointRows[jo] < row) {
+                            const unsigned int jiother_ofsi = mindex[jo];
+                            const unsigned int jiother_infom = mindex[jo + 1] - jiother_ofsi;
+                            const dJointWithInfo1 *jiother = jointinfos + jo;
+                            unsigned int smart_infom = (jiother->joint->node[1].body == b) ? jiother_infom : 0;
+                            const dReal *JOther = J + ((sizeint)jiother_ofsi * 2 + smart_infom) * JME__MAX;
+                            MultiplyAddJinvMxJToEnvelope (Alast - (row - jointRows[jo]), JinvMBody, JOther, infom, jiother_infom, rowlength, false);
+                        }
+                    }
+                }
+                continue;
+            }
+
             dReal *Arow = A + (sizeint)mskip * ofsi;
             const dReal *JinvMRow = JinvM + (sizeint)ofsi * (2 * JIM__MAX);
             dxJoint *joint = jointinfos[ji].joint;
@@ -1444,25 +2307,93 @@ void dxStepIsland_Stage3(dxStepperStage3CallContext *stage3CallContext)
 
     unsigned int m = localContext->m_m;
     unsigned int nub = localContext->m_nub;
-    //const unsigned int *mindex = localContext->m_mindex;
+    const unsigned int *mindex = localContext->m_mindex;
     int *findex = localContext->m_findex;
     dReal *A = localContext->m_A;
     dReal *pairsRhsLambda = localContext->m_pairsRhsCfm; // Reuse cfm buffer for lambdas as the former values are not needed any more
     dReal *pairsLoHi = localContext->m_pairsLoHi;
+    const bool warmStart = callContext->m_world->step_warm_starting != 0;
 
-    if (m > 0) {
+    if (m > 0 && localContext->m_articulation != NULL) {
+        BEGIN_STATE_SAVE(memarena, articulatedstate) {
+            IFTIMING(dTimerNow ("solve articulated trees"));
+            dxStepIsland_SolveArticulated(memarena, callContext, localContext);
+        } END_STATE_SAVE(memarena, articulatedstate);
+    }
+    else if (m > 0 && localContext->m_rowStart != NULL) {
+        BEGIN_STATE_SAVE(memarena, sparsestate) {
+            IFTIMING(dTimerNow ("solve sparse system"));
+
+            // there are no bounds, so lambda solves A*lambda = rhs. the
+            // envelope has the rows in the joint order of the layout.
+            const unsigned int *jointRows = localContext->m_jointRows;
+            const sizeint *rowStart = localContext->m_rowStart;
+            const unsigned int nj = localContext->m_nj;
+            dReal *x = memarena->AllocateArray<dReal>(m);
+            dReal *d = memarena->AllocateArray<dReal>(m);
+
+            for (unsigned int ji = 0; ji != nj; ++ji) {
+                const unsigned int infom = mindex[ji + 1] - mindex[ji];
+                const dReal *rowRhs = pairsRhsLambda + (sizeint)mindex[ji] * RLE__RHS_LAMBDA_MAX;
+                for (unsigned int i = 0; i != infom; ++i) {
+                    x[jointRows[ji] + i] = rowRhs[i * RLE__RHS_LAMBDA_MAX + RLE_RHS];
+                }
+            }
+
+            dxFactorLDLTEnvelope (A, d, rowStart, m);
+            dxSolveLDLTEnvelope (A, d, rowStart, x, m);
+
+            for (unsigned int ji = 0; ji != nj; ++ji) {
+                const unsigned int infom = mindex[ji + 1] - mindex[ji];
+                dReal *rowLambda = pairsRhsLambda + (sizeint)mindex[ji] * RLE__RHS_LAMBDA_MAX;
+                for (unsigned int i = 0; i != infom; ++i) {
+                    rowLambda[i * RLE__RHS_LAMBDA_MAX + RLE_LAMBDA] = x[jointRows[ji] + i];
+                }
+            }
+        } END_STATE_SAVE(memarena, sparsestate);
+    }
+    else if (m > 0) {
         BEGIN_STATE_SAVE(memarena, lcpstate) {
             IFTIMING(dTimerNow ("solve LCP problem"));
 
+            if (warmStart) {
+                // start from the lambdas of the previous step
+                const dJointWithInfo1 *jointinfos = localContext->m_jointinfos;
+                const unsigned int nj = localContext->m_nj;
+                for (unsigned int ji = 0; ji != nj; ++ji) {
+                    const dReal *jointLambda = jointinfos[ji].joint->lambda;
+                    const unsigned int infom = mindex[ji + 1] - mindex[ji];
+                    dReal *rowLambda = pairsRhsLambda + (sizeint)mindex[ji] * RLE__RHS_LAMBDA_MAX;
+                    for (unsigned int i = 0; i != infom; ++i) {
+                        rowLambda[i * RLE__RHS_LAMBDA_MAX + RLE_LAMBDA] = jointLambda[i];
+                    }
+                }
+            }
+
             // solve the LCP problem and get lambda.
             // this will destroy A but that's OK
-            dxSolveLCP (memarena, m, A, pairsRhsLambda, NULL, nub, pairsLoHi, findex);
+            dxSolveLCP (memarena, m, A, pairsRhsLambda, NULL, nub, pairsLoHi, findex, warmStart);
             dSASSERT((int)RLE__RHS_LAMBDA_MAX == PBX__MAX && (int)RLE_RHS == PBX_B && (int)RLE_LAMBDA == PBX_X);
             dSASSERT((int)LHE__LO_HI_MAX == PLH__MAX && (int)LHE_LO == PLH_LO && (int)LHE_HI == PLH_HI);
 
         } END_STATE_SAVE(memarena, lcpstate);
     }
 
+    if (m > 0 && warmStart) {
+        // keep the lambdas for the next step
+        const dJointWithInfo1 *jointinfos = localContext->m_jointinfos;
+        const unsigned int nj = localContext->m_nj;
+        for (unsigned int ji = 0; ji != nj; ++ji) {
+            dReal *jointLambda = jointinfos[ji].joint->lambda;
+            const unsigned int infom = mindex[ji + 1] - mindex[ji];
+            dIASSERT(infom <= dARRAY_SIZE(jointinfos[ji].joint->lambda));
+            const dReal *rowLambda = pairsRhsLambda + (sizeint)mindex[ji] * RLE__RHS_LAMBDA_MAX;
+            for (unsigned int i = 0; i != infom; ++i) {
+                jointLambda[i] = rowLambda[i * RLE__RHS_LAMBDA_MAX + RLE_LAMBDA];
+            }
+        }
+    }
+
     // void *stage3MemarenaState = memarena->SaveState();
 
     dxStepperStage4CallContext *stage4CallContext = (dxStepperStage4CallContext *)memarena->AllocateBlock(sizeof(dxStepperStage4CallContext));
@@ -1516,13 +2447,16 @@ void dxStepIsland_Stage4(dxStepperStage4CallContext *stage4CallContext)
     atomicord32 *bodyStartJoints = localContext->m_bodyStartJoints;
     atomicord32 *bodyJointLinks = localContext->m_bodyJointLinks;
     const unsigned int nb = callContext->m_islandBodiesCount;
+    dxBodyStateStore &state = callContext->m_world->body_state;
 
     unsigned bi;
     while ((bi = ThrsafeIncrementIntUpToLimit(&stage4CallContext->m_bi_constrForce, nb)) != nb) {
         dVector3 angularForceAccumulator;
         dxBody *b = bodies[bi];
+        const unsigned slot = b->state_slot;
+        dReal *lvel = state.lvel(slot);
         const dReal *invIrow = invI + (sizeint)bi * dM3E__MAX;
-        dReal body_invMass_mul_stepSize = stepSize * b->invMass;
+        dReal body_invMass_mul_stepSize = stepSize * state.invMass(slot);
 
         dReal bodyConstrForce[CFE__MAX];
         bool constrForceAvailable = false;
@@ -1559,7 +2493,7 @@ void dxStepIsland_Stage4(dxStepperStage4CallContext *stage4CallContext)
         if (constrForceAvailable) {
             // add fe to cforce and multiply cforce by stepSize
             for (unsigned int j = dSA__MIN; j != dSA__MAX; ++j) {
-                b->lvel[dV3E__AXES_MIN + j] += (bodyConstrForce[CFE__L_MIN + j] + b->facc[dV3E__AXES_MIN + j]) * body_invMass_mul_stepSize;
+                lvel[dV3E__AXES_MIN + j] += (bodyConstrForce[CFE__L_MIN + j] + b->facc[dV3E__AXES_MIN + j]) * body_invMass_mul_stepSize;
             }
             for (unsigned int k = dSA__MIN; k != dSA__MAX; ++k) {
                 angularForceAccumulator[dV3E__AXES_MIN + k] = (bodyConstrForce[CFE__A_MIN + k] + b->tacc[dV3E__AXES_MIN + k]) * stepSize;
@@ -1567,11 +2501,11 @@ void dxStepIsland_Stage4(dxStepperStage4CallContext *stage4CallContext)
         }
         else {
             // add fe to cforce and multiply cforce by stepSize
-            dAddVectorScaledVector3(b->lvel, b->lvel, b->facc, body_invMass_mul_stepSize);
+            dAddVectorScaledVector3(lvel, lvel, b->facc, body_invMass_mul_stepSize);
             dCopyScaledVector3(angularForceAccumulator, b->tacc, stepSize);
         }
 
-        dMultiplyAdd0_331 (b->avel, invIrow, angularForceAccumulator + dV3E__AXES_MIN);
+        dMultiplyAdd0_331 (state.avel(slot), invIrow, angularForceAccumulator + dV3E__AXES_MIN);
 
         // update the position and orientation from the new linear/angular velocity
         // (over the given time step)
@@ -1589,7 +2523,6 @@ void dxStepIsland_Stage4(dxStepperStage4CallContext *stage4CallContext)
 /*extern */
 sizeint dxEstimateStepMemoryRequirements (dxBody * const *body, unsigned int nb, dxJoint * const *_joint, unsigned int _nj)
 {
-    (void)body; // unused
     unsigned int nj, m;
 
     {
@@ -1612,6 +2545,9 @@ sizeint dxEstimateStepMemoryRequirements (dxBody * const *body, unsigned int nb,
 
     sizeint res = 0;
 
+    const bool articulated = nb != 0 && body[0]->world->step_articulated;
+    const sizeint nodes = (sizeint)nb + nj;
+
     res += dOVERALIGNED_SIZE(sizeof(dReal) * dM3E__MAX * nb, INVI_ALIGNMENT); // for invI
 
     {
@@ -1625,11 +2561,20 @@ sizeint dxEstimateStepMemoryRequirements (dxBody * const *body, unsigned int nb,
             sub1_res2 += dEFFICIENT_SIZE(sizeof(int) * m); // for findex
             sub1_res2 += dEFFICIENT_SIZE(sizeof(dReal) * 2 * JME__MAX * m); // for J
             unsigned int mskip = dPAD(m);
-            sub1_res2 += dOVERALIGNED_SIZE(sizeof(dReal) * mskip * m, AMATRIX_ALIGNMENT); // for A
+            sub1_res2 += dOVERALIGNED_SIZE(sizeof(dReal) * mskip * m, AMATRIX_ALIGNMENT); // for A (dense, or an envelope not bigger than the lower triangle)
+            sub1_res2 += dEFFICIENT_SIZE(sizeof(unsigned int) * nj); // for jointRows of a sparse A
+            sub1_res2 += dEFFICIENT_SIZE(sizeof(sizeint) * (m + 1)); // for rowStart of a sparse A
+            sub1_res2 += 2 * dEFFICIENT_SIZE(sizeof(unsigned int) * nj); // for the layout order and marks
             sub1_res2 += dEFFICIENT_SIZE(sizeof(dReal) * RCE__RHS_CFM_MAX * m); // for pairsRhsCfm
             sub1_res2 += dEFFICIENT_SIZE(sizeof(dReal) * LHE__LO_HI_MAX * m); // for pairsLoHi
             sub1_res2 += dEFFICIENT_SIZE(sizeof(atomicord32) * nb); // for bodyStartJoints
             sub1_res2 += dEFFICIENT_SIZE(sizeof(atomicord32)* dJCB__MAX * nj); // for bodyJointLinks
+            if (articulated) {
+                sub1_res2 += dEFFICIENT_SIZE(sizeof(dxArticulationLayout)); // for dxArticulationLayout
+                sub1_res2 += 2 * dEFFICIENT_SIZE(sizeof(unsigned int) * nodes); // for the node parents and order
+                sub1_res2 += 2 * dEFFICIENT_SIZE(sizeof(unsigned int) * (nb + 1)); // for componentStart and bodyComponent
+                sub1_res2 += 2 * dEFFICIENT_SIZE(sizeof(unsigned int) * nb); // for the tree sets and root joints
+            }
         }
 
         {
@@ -1644,7 +2589,19 @@ sizeint dxEstimateStepMemoryRequirements (dxBody * const *body, unsigned int nb,
                 sub2_res1 += dEFFICIENT_SIZE(sizeof(dReal) * dDA__MAX * nb); // for rhs_tmp
                 sub2_res1 += dEFFICIENT_SIZE(sizeof(dxStepperStage2CallContext)); // for dxStepperStage2CallContext
 
-                sub2_res2 += dxEstimateSolveLCPMemoryReq(m, false);
+                sizeint lcp_res = dxEstimateSolveLCPMemoryReq(m, false);
+                sizeint sparse_res = 2 * dEFFICIENT_SIZE(sizeof(dReal) * m); // for the sparse solution and D
+                sub2_res2 += dMAX(lcp_res, sparse_res);
+                if (articulated) {
+                    sizeint articulated_res = 2 * dEFFICIENT_SIZE(sizeof(dReal) * dxARTICULATION_BLOCK * nodes); // for Dinv and K
+                    articulated_res += dEFFICIENT_SIZE(sizeof(dReal) * dDA__MAX * nodes); // for the node vectors
+                    articulated_res += dOVERALIGNED_SIZE(sizeof(dReal) * dPAD(m) * m, AMATRIX_ALIGNMENT); // for A of the LCP rows
+                    articulated_res += dEFFICIENT_SIZE(sizeof(dReal) * (PBX__MAX + PLH__MAX + 1) * m); // for the LCP vectors and cfm
+                    articulated_res += dEFFICIENT_SIZE(sizeof(int) * m); // for findex of the LCP rows
+                    articulated_res += dEFFICIENT_SIZE(sizeof(const dReal *) * dJCB__MAX * m); // for the rows of J
+                    articulated_res += dEFFICIENT_SIZE(sizeof(unsigned int) * dJCB__MAX * m); // for the row bodies
+                    sub2_res2 = dMAX(sub2_res2, articulated_res + lcp_res);
+                }
             }
 
             sub1_res2 += dMAX(sub2_res1, dMAX(sub2_res2, sub2_res3));
@@ -35,6 +35,10 @@ unsigned dxEstimateStepMaxCallCount(
 
 void dxStepIsland(const dxStepperProcessingCallContext *callContext);
 
+// the LCP of a batch would be dense, so only islands that have no
+// constraint rows are stepped together
+#define dxSTEP_ISLAND_BATCH_ROWS 0
+
 
 
 #endif
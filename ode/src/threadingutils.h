@@ -133,6 +133,20 @@ unsigned int ThrsafeIncrementIntUpToLimit(volatile atomicord32 *storagePointer,
     return resultValue;
 }
 
+static inline 
+void ThrsafeRaiseIntToValue(volatile atomicord32 *storagePointer, unsigned int value)
+{
+    while (true) {
+        unsigned int currentValue = *storagePointer;
+        if (currentValue >= value) {
+            break;
+        }
+        if (ThrsafeCompareExchange(storagePointer, (atomicord32)currentValue, (atomicord32)value)) {
+            break;
+        }
+    }
+}
+
 static inline 
 sizeint ThrsafeIncrementSizeUpToLimit(volatile sizeint *storagePointer, sizeint limitValue)
 {
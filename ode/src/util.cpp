@@ -345,9 +345,9 @@ struct dxSingleIslandCallContext;
 
 struct dxIslandsProcessingCallContext
 {
-    dxIslandsProcessingCallContext(dxWorld *world, const dxWorldProcessIslandsInfo &islandsInfo, dReal stepSize, dstepper_fn_t stepper):
-        m_world(world), m_islandsInfo(islandsInfo), m_stepSize(stepSize), m_stepper(stepper),
-        m_groupReleasee(NULL), m_islandToProcessStorage(0), m_stepperAllowedThreads(0)
+    dxIslandsProcessingCallContext(dxWorld *world, const dxWorldProcessIslandsInfo &islandsInfo, dReal stepSize, const dxIslandStepperInfo *steppers):
+        m_world(world), m_islandsInfo(islandsInfo), m_stepSize(stepSize), m_steppers(steppers),
+        m_groupReleasee(NULL), m_islandToProcessStorage(0), m_freeBodiesChunkToProcessStorage(0), m_stepperAllowedThreads(0)
     {
     }
 
@@ -368,12 +368,15 @@ struct dxIslandsProcessingCallContext
 
     sizeint ObtainNextIslandToBeProcessed(sizeint islandsCount);
 
+    void IntegrateFreeBodies();
+
     dxWorld                         *const m_world;
     dxWorldProcessIslandsInfo const &m_islandsInfo;
     dReal                           const m_stepSize;
-    dstepper_fn_t                   const m_stepper;
+    const dxIslandStepperInfo       *const m_steppers;
     dCallReleaseeID                 m_groupReleasee;
     sizeint                          volatile m_islandToProcessStorage;
+    sizeint                          volatile m_freeBodiesChunkToProcessStorage;
     unsigned                        m_stepperAllowedThreads;
 };
 
@@ -383,26 +386,23 @@ struct dxSingleIslandCallContext
     dxSingleIslandCallContext(dxIslandsProcessingCallContext *islandsProcessingContext, 
         dxWorldProcessMemArena *stepperArena, void *arenaInitialState, 
         dxBody *const *islandBodiesStart, dxJoint *const *islandJointsStart):
-        m_islandsProcessingContext(islandsProcessingContext), m_islandIndex(0), 
-        m_stepperArena(stepperArena), m_arenaInitialState(arenaInitialState), 
+        m_islandsProcessingContext(islandsProcessingContext), 
+        m_stepperArena(stepperArena), m_arenaInitialState(arenaInitialState), m_stepper(NULL), 
         m_stepperCallContext(islandsProcessingContext->m_world, islandsProcessingContext->m_stepSize, islandsProcessingContext->m_stepperAllowedThreads, stepperArena, islandBodiesStart, islandJointsStart)
     {
     }
 
-    void AssignIslandSearchProgress(sizeint islandIndex)
-    {
-        m_islandIndex = islandIndex; 
-    }
-
     void AssignIslandSelection(dxBody *const *islandBodiesStart, dxJoint *const *islandJointsStart, 
         unsigned islandBodiesCount, unsigned islandJointsCount)
     {
         m_stepperCallContext.AssignIslandSelection(islandBodiesStart, islandJointsStart, islandBodiesCount, islandJointsCount);
     }
 
-    dxBody *const *GetSelectedIslandBodiesEnd() const { return m_stepperCallContext.GetSelectedIslandBodiesEnd(); }
-    dxJoint *const *GetSelectedIslandJointsEnd() const { return m_stepperCallContext.GetSelectedIslandJointsEnd(); }
-    
+    void AssignIslandStepper(dstepper_fn_t stepper)
+    {
+        m_stepper = stepper;
+    }
+
     void RestoreSavedMemArenaStateForStepper()
     {
         m_stepperArena->RestoreState(m_arenaInitialState);
@@ -414,9 +414,9 @@ struct dxSingleIslandCallContext
     }
 
     dxIslandsProcessingCallContext  *m_islandsProcessingContext;
-    sizeint                          m_islandIndex;
     dxWorldProcessMemArena          *m_stepperArena;
     void                            *m_arenaInitialState;
+    dstepper_fn_t                   m_stepper;
     dxStepperProcessingCallContext  m_stepperCallContext;
 };
 
@@ -424,10 +424,12 @@ struct dxSingleIslandCallContext
 //****************************************************************************
 // Auto disabling
 
-void dInternalHandleAutoDisabling (dxWorld *world, dReal stepsize)
+void dInternalHandleAutoDisabling (dxIslandComponent *component, dReal stepsize)
 {
+    // enabled bodies are only found in the active components of the island graph,
+    // and only the bodies of the given component are touched
     dxBody *bb;
-    for ( bb=world->firstbody; bb; bb=(dxBody*)bb->next )
+    for ( bb=component->first; bb; bb=bb->island_next )
     {
         // don't freeze objects mid-air (patch 1586738)
         if ( bb->firstjoint == NULL ) continue;
@@ -531,11 +533,12 @@ void dInternalHandleAutoDisabling (dxWorld *world, dReal stepsize)
             }
         }
 
-        // if it's idle, accumulate steps and time.
-        // these counters won't overflow because this code doesn't run for disabled bodies.
+        // if it's idle, accumulate steps and time. the body may stay idle
+        // for long while the rest of its island moves, so the countdowns
+        // stop at zero.
         if (idle) {
-            bb->adis_stepsleft--;
-            bb->adis_timeleft -= stepsize;
+            if ( bb->adis_stepsleft > 0 ) bb->adis_stepsleft--;
+            if ( bb->adis_timeleft > 0 ) bb->adis_timeleft -= stepsize;
         }
         else {
             // Reset countdowns
@@ -543,24 +546,68 @@ void dInternalHandleAutoDisabling (dxWorld *world, dReal stepsize)
             bb->adis_timeleft = bb->adis.idle_time;
         }
 
-        // disable the body if it's idle for a long enough time
-        if ( bb->adis_stepsleft <= 0 && bb->adis_timeleft <= 0 )
-        {
-            bb->flags |= dxBodyDisabled; // set the disable flag
-
-            // disabling bodies should also include resetting the velocity
-            // should prevent jittering in big "islands"
-            bb->lvel[0] = 0;
-            bb->lvel[1] = 0;
-            bb->lvel[2] = 0;
-            bb->avel[0] = 0;
-            bb->avel[1] = 0;
-            bb->avel[2] = 0;
-        }
+        // the body is disabled together with its island, once all of the
+        // island is idle for a long enough time (see dxIslandCanSleep)
+    }
+}
+
+
+// an island only goes to sleep when all of its bodies have been idle for long
+// enough. this rules out islands with bodies that can not be auto-disabled or
+// have no joints (don't freeze objects mid-air, patch 1586738).
+
+static bool dxIslandCanSleep (dxBody *const *bodies, unsigned int count)
+{
+    for (unsigned int i = 0; i != count; ++i) {
+        const dxBody *b = bodies[i];
+        if ( (b->flags & dxBodyAutoDisable) == 0 ) return false;
+        if ( b->firstjoint == NULL ) return false;
+        if ( b->adis.average_samples == 0 ) return false;
+        if ( b->adis_stepsleft > 0 || b->adis_timeleft > 0 ) return false;
+    }
+    return true;
+}
+
+// disable the bodies of the island and link them into a ring, so that
+// touching any of them wakes all of them. the joints of the island are
+// left untagged, as they only connect disabled bodies now.
+
+static void dxPutIslandToSleep (dxWorld *world, dxBody *const *bodies, unsigned int count,
+    dxJoint *const *joints, unsigned int jcount)
+{
+    for (unsigned int i = 0; i != count; ++i) {
+        dxBody *b = bodies[i];
+        b->flags |= dxBodyDisabled;
+        b->tag = -1;
+        b->sleep_next = bodies[i + 1 != count ? i + 1 : 0];
+
+        // disabling bodies should also include resetting the velocity
+        // should prevent jittering in big "islands"
+        dZeroVector3 (b->lvel);
+        dZeroVector3 (b->avel);
+        world->body_state.markDirty(b);
+    }
+    for (unsigned int j = 0; j != jcount; ++j) {
+        joints[j]->tag = 0;
     }
 }
 
 
+void dInternalWakeIsland (dxBody *b)
+{
+    dIASSERT (b->isAsleep());
+    dxBody *bb = b;
+    do {
+        dxBody *next = bb->sleep_next;
+        bb->sleep_next = NULL;
+        bb->flags &= ~dxBodyDisabled;
+        bb->adis_stepsleft = bb->adis.idle_steps;
+        bb->adis_timeleft = bb->adis.idle_time;
+        bb = next;
+    } while (bb != b);
+}
+
+
 //****************************************************************************
 // body rotation
 
@@ -582,20 +629,26 @@ static inline dReal sinc (dReal x)
 
 void dxStepBody (dxBody *b, dReal h)
 {
+    // the state is integrated in the body state store and then published to the body
+    dxBodyStateStore &state = b->world->body_state;
+    const unsigned slot = b->state_slot;
+    dReal *pos = state.pos(slot), *bq = state.q(slot);
+    dReal *lvel = state.lvel(slot), *avel = state.avel(slot);
+
     // cap the angular velocity
     if (b->flags & dxBodyMaxAngularSpeed) {
         const dReal max_ang_speed = b->max_angular_speed;
-        const dReal aspeed = dCalcVectorDot3( b->avel, b->avel );
+        const dReal aspeed = dCalcVectorDot3( avel, avel );
         if (aspeed > max_ang_speed*max_ang_speed) {
             const dReal coef = max_ang_speed/dSqrt(aspeed);
-            dScaleVector3(b->avel, coef);
+            dScaleVector3(avel, coef);
         }
     }
     // end of angular velocity cap
 
 
     // handle linear velocity
-    for (unsigned int j=0; j<3; j++) b->posr.pos[j] += h * b->lvel[j];
+    for (unsigned int j=0; j<3; j++) pos[j] += h * lvel[j];
 
     if (b->flags & dxBodyFlagFiniteRotation) {
         dVector3 irv;	// infitesimal rotation vector
@@ -605,13 +658,13 @@ void dxStepBody (dxBody *b, dReal h)
             // split the angular velocity vector into a component along the finite
             // rotation axis, and a component orthogonal to it.
             dVector3 frv;		// finite rotation vector
-            dReal k = dCalcVectorDot3 (b->finite_rot_axis,b->avel);
+            dReal k = dCalcVectorDot3 (b->finite_rot_axis,avel);
             frv[0] = b->finite_rot_axis[0] * k;
             frv[1] = b->finite_rot_axis[1] * k;
             frv[2] = b->finite_rot_axis[2] * k;
-            irv[0] = b->avel[0] - frv[0];
-            irv[1] = b->avel[1] - frv[1];
-            irv[2] = b->avel[2] - frv[2];
+            irv[0] = avel[0] - frv[0];
+            irv[1] = avel[1] - frv[1];
+            irv[2] = avel[2] - frv[2];
 
             // make a rotation quaternion q that corresponds to frv * h.
             // compare this with the full-finite-rotation case below.
@@ -625,39 +678,42 @@ void dxStepBody (dxBody *b, dReal h)
         }
         else {
             // make a rotation quaternion q that corresponds to w * h
-            dReal wlen = dSqrt (b->avel[0]*b->avel[0] + b->avel[1]*b->avel[1] +
-                b->avel[2]*b->avel[2]);
+            dReal wlen = dSqrt (avel[0]*avel[0] + avel[1]*avel[1] +
+                avel[2]*avel[2]);
             h *= REAL(0.5);
             dReal theta = wlen * h;
             q[0] = dCos(theta);
             dReal s = sinc(theta) * h;
-            q[1] = b->avel[0] * s;
-            q[2] = b->avel[1] * s;
-            q[3] = b->avel[2] * s;
+            q[1] = avel[0] * s;
+            q[2] = avel[1] * s;
+            q[3] = avel[2] * s;
         }
 
         // do the finite rotation
         dQuaternion q2;
-        dQMultiply0 (q2,q,b->q);
-        for (unsigned int j=0; j<4; j++) b->q[j] = q2[j];
+        dQMultiply0 (q2,q,bq);
+        for (unsigned int j=0; j<4; j++) bq[j] = q2[j];
 
         // do the infitesimal rotation if required
         if (b->flags & dxBodyFlagFiniteRotationAxis) {
             dReal dq[4];
-            dWtoDQ (irv,b->q,dq);
-            for (unsigned int j=0; j<4; j++) b->q[j] += h * dq[j];
+            dWtoDQ (irv,bq,dq);
+            for (unsigned int j=0; j<4; j++) bq[j] += h * dq[j];
         }
     }
     else {
         // the normal way - do an infitesimal rotation
         dReal dq[4];
-        dWtoDQ (b->avel,b->q,dq);
-        for (unsigned int j=0; j<4; j++) b->q[j] += h * dq[j];
+        dWtoDQ (avel,bq,dq);
+        for (unsigned int j=0; j<4; j++) bq[j] += h * dq[j];
     }
 
     // normalize the quaternion and convert it to a rotation matrix
-    dNormalize4 (b->q);
-    dQtoR (b->q,b->posr.R);
+    dNormalize4 (bq);
+    dQtoR (bq,state.R(slot));
+
+    // the geoms and the user callback see the body
+    state.publish (b);
 
     // notify all attached geoms that this body has moved
     dxWorldProcessContext *world_process_context = b->world->unsafeGetWorldProcessingContext(); 
@@ -670,39 +726,169 @@ void dxStepBody (dxBody *b, dReal h)
     // notify the user
     if (b->moved_callback != NULL) {
         b->moved_callback(b);
+        // the callback may have changed the body through the API
+        state.load (b);
     }
 
     // damping
     if (b->flags & dxBodyLinearDamping) {
         const dReal lin_threshold = b->dampingp.linear_threshold;
-        const dReal lin_speed = dCalcVectorDot3( b->lvel, b->lvel );
+        const dReal lin_speed = dCalcVectorDot3( lvel, lvel );
         if ( lin_speed > lin_threshold) {
             const dReal k = 1 - b->dampingp.linear_scale;
-            dScaleVector3(b->lvel, k);
+            dScaleVector3(lvel, k);
+            dCopyVector3(b->lvel, lvel);
         }
     }
     if (b->flags & dxBodyAngularDamping) {
         const dReal ang_threshold = b->dampingp.angular_threshold;
-        const dReal ang_speed = dCalcVectorDot3( b->avel, b->avel );
+        const dReal ang_speed = dCalcVectorDot3( avel, avel );
         if ( ang_speed > ang_threshold) {
             const dReal k = 1 - b->dampingp.angular_scale;
-            dScaleVector3(b->avel, k);
+            dScaleVector3(avel, k);
+            dCopyVector3(b->avel, avel);
         }
     }
 }
 
 
 //****************************************************************************
-// island processing
+// free bodies
+
+// the bodies that are not connected by any enabled joint are not built into
+// islands. they are integrated in chunks of this many bodies by the threads
+// that step the islands, once the islands have been taken.
+// the arithmetic is that of the steppers for an island without rows, but
+// the geoms of the free bodies are marked as moved after those of the
+// islands. the spaces keep the moved geoms in that order, so the pairs of
+// the next collision pass, and the contacts created from them, may come
+// in another order than with the free bodies stepped between the islands.
+#define dxFREE_BODIES_CHUNK 256
+
+// add the implicit gyroscopic torque of the body to its torque accumulator
+// (Lacoursiere 2006, "Stabilizing Gyroscopic Forces in Rigid Multibody
+// Simulations"), the same way as the steppers do.
+static void dxAddGyroscopicTorque (dxBody *b, const dReal *R, const dReal *bodyI, const dReal *avel, dReal h)
+{
+    dMatrix3 I, tmp;
+    // compute inertia tensor in global frame
+    dMultiply2_333 (tmp, bodyI, R);
+    dMultiply0_333 (I, R, tmp);
+
+    dVector3 L; // angular momentum
+    dMultiply0_331 (L, I, avel);
+
+    dMatrix3 Itild = { 0 };
+    dSetCrossMatrixMinus (Itild, L, dV3E__MAX);
+    for (int ii = dM3E__MIN; ii != dM3E__MAX; ++ii) {
+        Itild[ii] = Itild[ii] * h + I[ii];
+    }
+
+    dScaleVector3 (L, dRecip(h));
+    dMatrix3 itInv;
+    if (dInvertMatrix3 (itInv, Itild) != 0) {
+        dMultiply0_333 (Itild, I, itInv);
+        Itild[dM3E_XX] -= 1; Itild[dM3E_YY] -= 1; Itild[dM3E_ZZ] -= 1;
 
-enum dxISLANDSIZESELEMENT
+        dVector3 tau0;
+        dMultiply0_331 (tau0, Itild, L);
+        dAddVectors3 (b->tacc, b->tacc, tau0);
+    }
+}
+
+// step bodies without constraints over the time interval h. this does the
+// arithmetic of the steppers for an island without joints, in passes over
+// the whole chunk rather than in a stepper call per body.
+static void dxIntegrateFreeBodies (dxWorld *world, dxBody *const *body, unsigned int nb, dReal h)
 {
-    dxISE_BODIES_COUNT,
-    dxISE_JOINTS_COUNT,
+    dxBody *const *const bodyend = body + nb;
+
+    // add the gravity force. gravity normally has only one component, so
+    // there is a loop per component.
+    for (unsigned int j = dSA__MIN; j != dSA__MAX; ++j) {
+        const dReal gravity = world->gravity[dV3E__AXES_MIN + j];
+        if (gravity) {
+            for (dxBody *const *bodycurr = body; bodycurr != bodyend; ++bodycurr) {
+                dxBody *b = *bodycurr;
+                if ((b->flags & dxBodyNoGravity) == 0) {
+                    b->facc[dV3E__AXES_MIN + j] += b->mass.mass * gravity;
+                }
+            }
+        }
+    }
 
-    dxISE__MAX
+    // add stepsize * invM * fe to the body velocities
+    dxBodyStateStore &state = world->body_state;
+    for (dxBody *const *bodycurr = body; bodycurr != bodyend; ++bodycurr) {
+        dxBody *b = *bodycurr;
+        const unsigned slot = b->state_slot;
+        const dReal *R = state.R(slot);
+        const dReal invMass = state.invMass(slot);
+        dReal *lvel = state.lvel(slot), *avel = state.avel(slot);
+
+        // compute inverse inertia tensor in global frame
+        dMatrix3 invI, tmp;
+        dMultiply2_333 (tmp, state.invI(slot), R);
+        dMultiply0_333 (invI, R, tmp);
+
+        if ((b->flags & dxBodyGyroscopic) && (invMass > 0)) {
+            dxAddGyroscopicTorque (b, R, state.I(slot), avel, h);
+        }
+
+        dAddVectorScaledVector3 (lvel, lvel, b->facc, h * invMass);
+        dVector3 angularForce;
+        dCopyScaledVector3 (angularForce, b->tacc, h);
+        dMultiplyAdd0_331 (avel, invI, angularForce);
+    }
+
+    // update the positions and orientations, and zero the force accumulators
+    for (dxBody *const *bodycurr = body; bodycurr != bodyend; ++bodycurr) {
+        dxBody *b = *bodycurr;
+        dxStepBody (b, h);
+        dZeroVector3 (b->facc);
+        dZeroVector3 (b->tacc);
+    }
+}
+
+
+//****************************************************************************
+// island processing
+
+// the island search is split into jobs of whole active components of the
+// island graph, which do not share any bodies or joints. the jobs are only
+// run by several threads when the active components hold at least this
+// many bodies per thread.
+#define dxISLAND_SEARCH_BODIES_PER_THREAD 2048
+
+struct dxIslandSearchJob
+{
+    dxIslandComponent   *m_component;
+    unsigned            m_bodiesOffset;     // offset of the bodies, the free bodies, the stack and the island sizes
+    unsigned            m_jointsOffset;     // offset of the joints
+    unsigned            m_partsOffset;      // offset of the parts reserved for separating the component
+    unsigned            m_islandCount;
+    unsigned            m_bodyCount;
+    unsigned            m_jointCount;
+    unsigned            m_freeCount;
+    unsigned            m_partCount;
+    sizeint             m_maxreq;
 };
 
+// the small islands are stepped in batches of up to this many bodies
+#define dxISLAND_BATCH_BODIES 64
+
+// the constraint rows of an island
+static unsigned int dxCountIslandRows(dxJoint *const *joint, unsigned int nj)
+{
+    unsigned int rows = 0;
+    dxJoint::SureMaxInfo info;
+    for (unsigned int i = 0; i != nj; ++i) {
+        joint[i]->getSureMaxInfo(&info);
+        rows += info.max_m;
+    }
+    return rows;
+}
+
 // This estimates dynamic memory requirements for dxProcessIslands
 static sizeint EstimateIslandProcessingMemoryRequirements(dxWorld *world)
 {
@@ -711,158 +897,466 @@ static sizeint EstimateIslandProcessingMemoryRequirements(dxWorld *world)
     sizeint islandcounts = dEFFICIENT_SIZE((sizeint)(unsigned)world->nb * 2 * sizeof(int));
     res += islandcounts;
 
+    // each joint may be counted by the job of both of its bodies
     sizeint bodiessize = dEFFICIENT_SIZE((sizeint)(unsigned)world->nb * sizeof(dxBody*));
-    sizeint jointssize = dEFFICIENT_SIZE((sizeint)(unsigned)world->nj * sizeof(dxJoint*));
-    res += bodiessize + jointssize;
+    sizeint jointssize = dEFFICIENT_SIZE((sizeint)(unsigned)world->nj * 2 * sizeof(dxJoint*));
+    sizeint freebodiessize = dEFFICIENT_SIZE((sizeint)(unsigned)world->nb * sizeof(dxBody*));
+    res += bodiessize + jointssize + freebodiessize;
+
+    sizeint stacksize = dEFFICIENT_SIZE((sizeint)(unsigned)world->nb * sizeof(dxBody*));
+    res += stacksize;
 
-    sizeint sesize = (bodiessize < jointssize) ? bodiessize : jointssize;
-    res += sesize;
+    sizeint jobssize = dEFFICIENT_SIZE((sizeint)(unsigned)world->nb * sizeof(dxIslandSearchJob));
+    res += jobssize;
+
+    // island starts, order, steppers and rows for batching and scheduling
+    sizeint islandstarts = dEFFICIENT_SIZE((sizeint)(unsigned)world->nb * 2 * sizeof(int));
+    sizeint islandorder = dEFFICIENT_SIZE((sizeint)(unsigned)world->nb * sizeof(int));
+    res += islandstarts + islandorder * 3;
 
     return res;
 }
 
+
+struct dxIslandSearchCallContext
+{
+    dxIslandSearchCallContext(dxWorld *world, dReal stepSize, const dxIslandStepperInfo *steppers, dstepperselect_fn_t stepperSelect,
+        dxIslandSearchJob *jobs, unsigned jobCount, dxIslandComponent *const *parts,
+        unsigned int *islandSizes, unsigned int *islandRows, unsigned int *islandSteppers, 
+        dxBody **bodies, dxJoint **joints, dxBody **freeBodies, dxBody **stack):
+        m_world(world), m_stepSize(stepSize), m_steppers(steppers), m_stepperSelect(stepperSelect),
+        m_jobs(jobs), m_jobCount(jobCount), m_parts(parts),
+        m_islandSizes(islandSizes), m_islandRows(islandRows), m_islandSteppers(islandSteppers), m_bodies(bodies), m_joints(joints), m_freeBodies(freeBodies), m_stack(stack),
+        m_jobToProcessStorage(0)
+    {
+    }
+
+    static int ThreadedSearchGroup_Callback(void *callContext, dcallindex_t callInstanceIndex, dCallReleaseeID callThisReleasee);
+
+    static int ThreadedSearchJobs_Callback(void *callContext, dcallindex_t callInstanceIndex, dCallReleaseeID callThisReleasee);
+    void ThreadedSearchJobs();
+
+    void SearchComponent(dxIslandSearchJob *job);
+
+    dxWorld                         *const m_world;
+    dReal                           const m_stepSize;
+    const dxIslandStepperInfo       *const m_steppers;
+    dstepperselect_fn_t             const m_stepperSelect;
+    dxIslandSearchJob               *const m_jobs;
+    unsigned                        const m_jobCount;
+    dxIslandComponent               *const *const m_parts;
+    unsigned int                    *const m_islandSizes;
+    unsigned int                    *const m_islandRows;
+    unsigned int                    *const m_islandSteppers;
+    dxBody                          **const m_bodies;
+    dxJoint                         **const m_joints;
+    dxBody                          **const m_freeBodies;
+    dxBody                          **const m_stack;
+    atomicord32                     volatile m_jobToProcessStorage;
+};
+
+int dxIslandSearchCallContext::ThreadedSearchGroup_Callback(void *callContext, dcallindex_t callInstanceIndex, dCallReleaseeID callThisReleasee)
+{
+    (void)callContext; // unused
+    (void)callInstanceIndex; // unused
+    (void)callThisReleasee; // unused
+    // Do nothing - it's just a wrapper call
+    return true;
+}
+
+int dxIslandSearchCallContext::ThreadedSearchJobs_Callback(void *callContext, dcallindex_t callInstanceIndex, dCallReleaseeID callThisReleasee)
+{
+    (void)callInstanceIndex; // unused
+    (void)callThisReleasee; // unused
+    static_cast<dxIslandSearchCallContext *>(callContext)->ThreadedSearchJobs();
+    return true;
+}
+
+void dxIslandSearchCallContext::ThreadedSearchJobs()
+{
+    const unsigned jobCount = m_jobCount;
+    unsigned jobIndex;
+    while ((jobIndex = ThrsafeIncrementIntUpToLimit(&m_jobToProcessStorage, jobCount)) != jobCount) {
+        SearchComponent(m_jobs + jobIndex);
+    }
+}
+
+// find the islands of one active component. the results go to the regions
+// of the output arrays reserved for the job, and nothing outside of the
+// component is modified.
+void dxIslandSearchCallContext::SearchComponent(dxIslandSearchJob *job)
+{
+    dxIslandComponent *component = job->m_component;
+
+    // handle auto-disabling of bodies
+    dInternalHandleAutoDisabling (component, m_stepSize);
+
+    // set the body/joint tags of the component to 0
+    for (dxBody *b=component->first; b; b=b->island_next) {
+        b->tag = 0;
+        for (dxJointNode *n=b->firstjoint; n; n=n->next) n->joint->tag = 0;
+    }
+
+    // the stack of unvisited bodies can not hold more than the bodies of the
+    // component. all the bodies in the stack must be tagged!
+    dxBody **stack = m_stack + job->m_bodiesOffset;
+
+    unsigned int *const sizesstart = m_islandSizes + (sizeint)job->m_bodiesOffset * dxISE__MAX;
+    unsigned int *rowscurr = m_islandRows + job->m_bodiesOffset;
+    unsigned int *stepperscurr = m_islandSteppers + job->m_bodiesOffset;
+    dxBody **const bodiesstart = m_bodies + job->m_bodiesOffset;
+    dxJoint **const jointsstart = m_joints + job->m_jointsOffset;
+    dxBody **const freestart = m_freeBodies + job->m_bodiesOffset;
+
+    unsigned int *sizescurr = sizesstart;
+    dxBody **bodystart = bodiesstart;
+    dxJoint **jointstart = jointsstart;
+    dxBody **freecurr = freestart;
+    sizeint maxreq = 0;
+
+    bool enabledfound = false;
+    for (dxBody *bb=component->first; bb; bb=bb->island_next) {
+        // get bb = the next enabled, untagged body, and tag it
+        if (!bb->tag) {
+            if (!(bb->flags & dxBodyDisabled)) {
+                bb->tag = 1;
+
+                dxBody **bodycurr = bodystart;
+                dxJoint **jointcurr = jointstart;
+
+                // tag all bodies and joints starting from bb.
+                *bodycurr++ = bb;
+
+                unsigned int stacksize = 0;
+                dxBody *b = bb;
+
+                while (true) {
+                    // traverse and tag all body's joints, add untagged connected bodies
+                    // to stack
+                    for (dxJointNode *n=b->firstjoint; n; n=n->next) {
+                        dxJoint *njoint = n->joint;
+                        if (!njoint->tag) {
+                            if (njoint->isEnabled()) {
+                                njoint->tag = 1;
+                                *jointcurr++ = njoint;
+
+                                dxBody *nbody = n->body;
+                                // Body disabled flag is not checked here. This is how auto-enable works.
+                                if (nbody && nbody->tag <= 0) {
+                                    nbody->tag = 1;
+                                    stack[stacksize++] = nbody;
+
+                                    // a sleeping island is woken as a whole, as the joints
+                                    // between its bodies may be gone while it sleeps
+                                    if (nbody->isAsleep()) {
+                                        for (dxBody *sb=nbody->sleep_next; sb!=nbody; sb=sb->sleep_next) {
+                                            if (sb->tag <= 0) {
+                                                sb->tag = 1;
+                                                stack[stacksize++] = sb;
+                                            }
+                                        }
+                                        dInternalWakeIsland (nbody);
+                                    }
+                                    // Make sure all bodies are in the enabled state.
+                                    nbody->flags &= ~dxBodyDisabled;
+                                }
+                            } else {
+                                njoint->tag = -1; // Used in Step to prevent search over disabled joints (not needed for QuickStep so far)
+                            }
+                        }
+                    }
+                    dIASSERT(stacksize <= component->size);
+
+                    if (stacksize == 0) {
+                        break;
+                    }
+
+                    b = stack[--stacksize];	// pop body off stack
+                    *bodycurr++ = b;	// put body on body list
+                }
+
+                unsigned int bcount = (unsigned int)(bodycurr - bodystart);
+                unsigned int jcount = (unsigned int)(jointcurr - jointstart);
+                dIASSERT((sizeint)(bodycurr - bodystart) <= (sizeint)UINT_MAX);
+                dIASSERT((sizeint)(jointcurr - jointstart) <= (sizeint)UINT_MAX);
+
+                // an island at rest is neither stepped nor visited again until it is touched
+                if (dxIslandCanSleep(bodystart, bcount)) {
+                    dxPutIslandToSleep(m_world, bodystart, bcount, jointstart, jcount);
+                    continue;
+                }
+                enabledfound = true;
+
+                // a body without joints does not need the stepper
+                if (jcount == 0) {
+                    dIASSERT(bcount == 1);
+                    *freecurr++ = bb;
+                    continue;
+                }
+
+                sizescurr[dxISE_BODIES_COUNT] = bcount;
+                sizescurr[dxISE_JOINTS_COUNT] = jcount;
+                sizescurr += dxISE__MAX;
+
+                unsigned int rows = dxCountIslandRows(jointstart, jcount);
+                unsigned int stepper = m_stepperSelect != NULL ? m_stepperSelect(m_world, jointstart, jcount, rows) : 0;
+                *rowscurr++ = rows;
+                *stepperscurr++ = stepper;
+
+                sizeint islandreq = m_steppers[stepper].m_memoryEstimate(bodystart, bcount, jointstart, jcount);
+                maxreq = (maxreq > islandreq) ? maxreq : islandreq;
+
+                bodystart = bodycurr;
+                jointstart = jointcurr;
+            } else {
+                bb->tag = -1; // Not used so far (assigned to retain consistency with joints)
+            }
+        }
+    }
+
+    dIASSERT((unsigned)(bodystart - bodiesstart) + (unsigned)(freecurr - freestart) <= component->size);
+    dIASSERT((unsigned)(jointstart - jointsstart) <= component->joints);
+
+    job->m_islandCount = (unsigned)(sizescurr - sizesstart) / dxISE__MAX;
+    job->m_bodyCount = (unsigned)(bodystart - bodiesstart);
+    job->m_jointCount = (unsigned)(jointstart - jointsstart);
+    job->m_freeCount = (unsigned)(freecurr - freestart);
+    job->m_maxreq = maxreq;
+
+    // separate the component if joints were detached from it. this only
+    // changes the component and the parts reserved for it.
+    if (component->split) {
+        job->m_partCount = m_world->islands.separate (component, m_parts + job->m_partsOffset, stack);
+    } else {
+        component->awake = enabledfound;
+        job->m_partCount = 0;
+    }
+}
+
+
 static sizeint BuildIslandsAndEstimateStepperMemoryRequirements(
     dxWorldProcessIslandsInfo &islandsinfo, dxWorldProcessMemArena *memarena, 
-    dxWorld *world, dReal stepsize, dmemestimate_fn_t stepperestimate)
+    dxWorld *world, dReal stepsize, const dxIslandStepperInfo *steppers, dstepperselect_fn_t stepperselect)
 {
     sizeint maxreq = 0;
 
-    // handle auto-disabling of bodies
-    dInternalHandleAutoDisabling (world,stepsize);
-
     unsigned int nb = world->nb, nj = world->nj;
     // Make array for island body/joint counts
     unsigned int *islandsizes = memarena->AllocateArray<unsigned int>(2 * (sizeint)nb);
     unsigned int *sizescurr;
 
-    // make arrays for body and joint lists (for a single island) to go into
+    // make arrays for body and joint lists (for a single island) to go into.
+    // the jobs fill them in separate regions, which are compacted afterwards.
     dxBody **body = memarena->AllocateArray<dxBody *>(nb);
-    dxJoint **joint = memarena->AllocateArray<dxJoint *>(nj);
+    dxJoint **joint = memarena->AllocateArray<dxJoint *>(2 * (sizeint)nj);
+    // the bodies without joints are kept apart from the islands
+    dxBody **freebody = memarena->AllocateArray<dxBody *>(nb);
+    sizeint freecount;
+
+    // make arrays for the island offsets in them, the stepping order and the
+    // steppers of the islands
+    unsigned int *islandstarts = memarena->AllocateArray<unsigned int>(2 * (sizeint)nb);
+    unsigned int *islandorder = memarena->AllocateArray<unsigned int>(nb);
+    unsigned int *islandsteppers = memarena->AllocateArray<unsigned int>(nb);
+    sizeint islandcount;
+
+    // the order only matters when several islands are stepped at a time
+    unsigned allowedThreadCount = world->calculateIslandProcessingMaxThreadCount();
+    const bool scheduled = allowedThreadCount > 1;
 
     BEGIN_STATE_SAVE(memarena, stackstate) {
-        // allocate a stack of unvisited bodies in the island. the maximum size of
-        // the stack can be the lesser of the number of bodies or joints, because
-        // new bodies are only ever added to the stack by going through untagged
-        // joints. all the bodies in the stack must be tagged!
-        unsigned int stackalloc = (nj < nb) ? nj : nb;
-        dxBody **stack = memarena->AllocateArray<dxBody *>(stackalloc);
-
-        {
-            // set all body/joint tags to 0
-            for (dxBody *b=world->firstbody; b; b=(dxBody*)b->next) b->tag = 0;
-            for (dxJoint *j=world->firstjoint; j; j=(dxJoint*)j->next) j->tag = 0;
+        // only the components that may contain enabled bodies are visited,
+        // in the order of the world list whatever else the world contains
+        dxIslandGraph &islands = world->islands;
+        islands.orderActive();
+
+        const unsigned jobcount = islands.activeCount();
+        dIASSERT(jobcount <= nb);
+        dxIslandSearchJob *jobs = memarena->AllocateArray<dxIslandSearchJob>(jobcount);
+        dxBody **stack = memarena->AllocateArray<dxBody *>(nb);
+
+        // lay out the regions of the jobs
+        unsigned bodiesoffset = 0, jointsoffset = 0, partsoffset = 0;
+        for (unsigned ji = 0; ji != jobcount; ji++) {
+            dxIslandSearchJob *job = jobs + ji;
+            dxIslandComponent *component = islands.activeComponent(ji);
+            job->m_component = component;
+            job->m_bodiesOffset = bodiesoffset;
+            job->m_jointsOffset = jointsoffset;
+            job->m_partsOffset = partsoffset;
+            bodiesoffset += component->size;
+            jointsoffset += component->joints;
+            if (component->split) partsoffset += component->size - 1;
         }
+        dIASSERT(bodiesoffset <= nb);
+        dIASSERT(jointsoffset <= 2 * nj);
 
-        sizescurr = islandsizes;
-        dxBody **bodystart = body;
-        dxJoint **jointstart = joint;
-        for (dxBody *bb=world->firstbody; bb; bb=(dxBody*)bb->next) {
-            // get bb = the next enabled, untagged body, and tag it
-            if (!bb->tag) {
-                if (!(bb->flags & dxBodyDisabled)) {
-                    bb->tag = 1;
-
-                    dxBody **bodycurr = bodystart;
-                    dxJoint **jointcurr = jointstart;
-
-                    // tag all bodies and joints starting from bb.
-                    *bodycurr++ = bb;
-
-                    unsigned int stacksize = 0;
-                    dxBody *b = bb;
-
-                    while (true) {
-                        // traverse and tag all body's joints, add untagged connected bodies
-                        // to stack
-                        for (dxJointNode *n=b->firstjoint; n; n=n->next) {
-                            dxJoint *njoint = n->joint;
-                            if (!njoint->tag) {
-                                if (njoint->isEnabled()) {
-                                    njoint->tag = 1;
-                                    *jointcurr++ = njoint;
-
-                                    dxBody *nbody = n->body;
-                                    // Body disabled flag is not checked here. This is how auto-enable works.
-                                    if (nbody && nbody->tag <= 0) {
-                                        nbody->tag = 1;
-                                        // Make sure all bodies are in the enabled state.
-                                        nbody->flags &= ~dxBodyDisabled;
-                                        stack[stacksize++] = nbody;
-                                    }
-                                } else {
-                                    njoint->tag = -1; // Used in Step to prevent search over disabled joints (not needed for QuickStep so far)
-                                }
-                            }
-                        }
-                        dIASSERT(stacksize <= (unsigned int)world->nb);
-                        dIASSERT(stacksize <= (unsigned int)world->nj);
+        // a split component can not fall into more parts than it has bodies
+        dxIslandComponent *const *parts = islands.reserveParts(partsoffset);
 
-                        if (stacksize == 0) {
-                            break;
-                        }
+        unsigned int *islandrows = memarena->AllocateArray<unsigned int>(nb);
 
-                        b = stack[--stacksize];	// pop body off stack
-                        *bodycurr++ = b;	// put body on body list
-                    }
+        dxIslandSearchCallContext callContext(world, stepsize, steppers, stepperselect, 
+            jobs, jobcount, parts, islandsizes, islandrows, islandsteppers, body, joint, freebody, stack);
+
+        unsigned threadCount = dMIN(allowedThreadCount, bodiesoffset / dxISLAND_SEARCH_BODIES_PER_THREAD);
+        threadCount = dMIN(threadCount, jobcount);
+
+        if (threadCount > 1 && world->PreallocateResourcesForThreadedCalls(1 + threadCount)) {
+            dCallWaitID searchWait = world->wmem->GetWorldProcessingContext()->GetIslandsSteppingWait();
 
-                    unsigned int bcount = (unsigned int)(bodycurr - bodystart);
-                    unsigned int jcount = (unsigned int)(jointcurr - jointstart);
-                    dIASSERT((sizeint)(bodycurr - bodystart) <= (sizeint)UINT_MAX);
-                    dIASSERT((sizeint)(jointcurr - jointstart) <= (sizeint)UINT_MAX);
+            dCallReleaseeID groupReleasee;
+            world->PostThreadedCall(NULL, &groupReleasee, threadCount, NULL, searchWait, 
+                &dxIslandSearchCallContext::ThreadedSearchGroup_Callback, (void *)&callContext, 0, "World Islands Search Group");
 
-                    sizescurr[dxISE_BODIES_COUNT] = bcount;
-                    sizescurr[dxISE_JOINTS_COUNT] = jcount;
-                    sizescurr += dxISE__MAX;
+            world->PostThreadedCallsGroup(NULL, threadCount, groupReleasee, 
+                &dxIslandSearchCallContext::ThreadedSearchJobs_Callback, (void *)&callContext, "World Islands Search");
+
+            world->WaitThreadedCallExclusively(NULL, searchWait, NULL, "World Islands Search Wait");
+        }
 
-                    sizeint islandreq = stepperestimate(bodystart, bcount, jointstart, jcount);
-                    maxreq = (maxreq > islandreq) ? maxreq : islandreq;
+        // search whatever is left (everything, if no threads were used)
+        callContext.ThreadedSearchJobs();
 
-                    bodystart = bodycurr;
-                    jointstart = jointcurr;
-                } else {
-                    bb->tag = -1; // Not used so far (assigned to retain consistency with joints)
+        // collect the results in the order of the jobs, so that the islands
+        // do not depend on the number of threads
+        sizescurr = islandsizes;
+        dxBody **bodycurr = body;
+        dxJoint **jointcurr = joint;
+        dxBody **freecurr = freebody;
+        for (unsigned ji = 0; ji != jobcount; ji++) {
+            dxIslandSearchJob *job = jobs + ji;
+
+            unsigned sizescount = job->m_islandCount * dxISE__MAX;
+            memmove(sizescurr, islandsizes + (sizeint)job->m_bodiesOffset * dxISE__MAX, sizescount * sizeof(unsigned int));
+            memmove(islandrows + (sizescurr - islandsizes) / dxISE__MAX, islandrows + job->m_bodiesOffset, job->m_islandCount * sizeof(unsigned int));
+            memmove(islandsteppers + (sizescurr - islandsizes) / dxISE__MAX, islandsteppers + job->m_bodiesOffset, job->m_islandCount * sizeof(unsigned int));
+            sizescurr += sizescount;
+            memmove(bodycurr, body + job->m_bodiesOffset, job->m_bodyCount * sizeof(dxBody *));
+            bodycurr += job->m_bodyCount;
+            memmove(jointcurr, joint + job->m_jointsOffset, job->m_jointCount * sizeof(dxJoint *));
+            jointcurr += job->m_jointCount;
+            memmove(freecurr, freebody + job->m_bodiesOffset, job->m_freeCount * sizeof(dxBody *));
+            freecurr += job->m_freeCount;
+
+            maxreq = (maxreq > job->m_maxreq) ? maxreq : job->m_maxreq;
+
+            islands.commitParts(parts + job->m_partsOffset, job->m_partCount);
+
+            // the component is not visited again until one of its bodies gets enabled
+            dxIslandComponent *component = job->m_component;
+            if (!component->awake) {
+                islands.deactivate (component);
+            }
+        }
+
+        islands.releaseParts();
+
+        freecount = (sizeint)(freecurr - freebody);
+
+        sizeint foundcount = ((sizeint)(sizescurr - islandsizes) / dxISE__MAX);
+
+        // merge runs of small islands into batches that are stepped as one
+        // island, saving the stepper setup and the threaded call per island.
+        // the islands of a batch follow each other in the arrays already. the
+        // order array marks the batches that need a new memory estimate.
+        islandcount = 0;
+        for (sizeint i = 0; i != foundcount; ++i) {
+            unsigned int bcount = islandsizes[i * dxISE__MAX + dxISE_BODIES_COUNT];
+            unsigned int jcount = islandsizes[i * dxISE__MAX + dxISE_JOINTS_COUNT];
+            unsigned int rows = islandrows[i];
+            unsigned int stepper = islandsteppers[i];
+
+            if (islandcount != 0 && islandsteppers[islandcount - 1] == stepper) {
+                unsigned int *batchsizes = islandsizes + (islandcount - 1) * dxISE__MAX;
+                if (batchsizes[dxISE_BODIES_COUNT] + bcount <= dxISLAND_BATCH_BODIES
+                    && islandrows[islandcount - 1] + rows <= steppers[stepper].m_batchRows) {
+                    batchsizes[dxISE_BODIES_COUNT] += bcount;
+                    batchsizes[dxISE_JOINTS_COUNT] += jcount;
+                    islandrows[islandcount - 1] += rows;
+                    islandorder[islandcount - 1] = 1;
+                    continue;
                 }
             }
+
+            islandsizes[islandcount * dxISE__MAX + dxISE_BODIES_COUNT] = bcount;
+            islandsizes[islandcount * dxISE__MAX + dxISE_JOINTS_COUNT] = jcount;
+            islandrows[islandcount] = rows;
+            islandsteppers[islandcount] = stepper;
+            islandorder[islandcount] = 0;
+            islandcount++;
+        }
+
+        unsigned int bodiesstart = 0, jointsstart = 0;
+        for (sizeint i = 0; i != islandcount; ++i) {
+            unsigned int bcount = islandsizes[i * dxISE__MAX + dxISE_BODIES_COUNT];
+            unsigned int jcount = islandsizes[i * dxISE__MAX + dxISE_JOINTS_COUNT];
+            if (islandorder[i] != 0) {
+                sizeint batchreq = steppers[islandsteppers[i]].m_memoryEstimate(body + bodiesstart, bcount, joint + jointsstart, jcount);
+                maxreq = (maxreq > batchreq) ? maxreq : batchreq;
+            }
+
+            islandstarts[i * dxISE__MAX + dxISE_BODIES_COUNT] = bodiesstart;
+            islandstarts[i * dxISE__MAX + dxISE_JOINTS_COUNT] = jointsstart;
+            bodiesstart += bcount;
+            jointsstart += jcount;
+            islandorder[i] = (unsigned int)i;
+        }
+
+        // step the most expensive islands first, so that a big island does not
+        // start last and keep the other threads waiting at the end of the step
+        if (scheduled) {
+            dxScheduleIslands(islandorder, islandcount, islandrows, islandsizes);
         }
     } END_STATE_SAVE(memarena, stackstate);
 
 # ifndef dNODEBUG
     // if debugging, check that all objects (except for disabled bodies,
     // unconnected joints, and joints that are connected to disabled bodies)
-    // were tagged.
+    // were tagged. the tags outside of the active components of the island
+    // graph are stale, but all the enabled bodies must be in them.
     {
         for (dxBody *b=world->firstbody; b; b=(dxBody*)b->next) {
-            if (b->flags & dxBodyDisabled) {
-                if (b->tag > 0) dDebug (0,"disabled body tagged");
-            }
-            else {
+            if ((b->flags & dxBodyDisabled) == 0) {
+                if (b->island->active == -1) dDebug (0,"enabled body not in active island component");
                 if (b->tag <= 0) dDebug (0,"enabled body not tagged");
             }
         }
-        for (dxJoint *j=world->firstjoint; j; j=(dxJoint*)j->next) {
-            if ( (( j->node[0].body && (j->node[0].body->flags & dxBodyDisabled)==0 ) ||
-                (j->node[1].body && (j->node[1].body->flags & dxBodyDisabled)==0) )
-                && 
-                j->isEnabled() ) {
-                    if (j->tag <= 0) dDebug (0,"attached enabled joint not tagged");
+        const dxIslandGraph &islands = world->islands;
+        for (dxBody *b=islands.firstActiveBody(); b; b=islands.nextActiveBody(b)) {
+            if (b->flags & dxBodyDisabled) {
+                if (b->tag > 0) dDebug (0,"disabled body tagged");
             }
-            else {
-                if (j->tag > 0) dDebug (0,"unattached or disabled joint tagged");
+            for (dxJointNode *n=b->firstjoint; n; n=n->next) {
+                dxJoint *j = n->joint;
+                if ( (( j->node[0].body && (j->node[0].body->flags & dxBodyDisabled)==0 ) ||
+                    (j->node[1].body && (j->node[1].body->flags & dxBodyDisabled)==0) )
+                    && 
+                    j->isEnabled() ) {
+                        if (j->tag <= 0) dDebug (0,"attached enabled joint not tagged");
+                }
+                else {
+                    if (j->tag > 0) dDebug (0,"unattached or disabled joint tagged");
+                }
             }
         }
     }
 # endif
 
-    sizeint islandcount = ((sizeint)(sizescurr - islandsizes) / dxISE__MAX);
-    islandsinfo.AssignInfo(islandcount, islandsizes, body, joint);
+    islandsinfo.AssignInfo(islandcount, islandsizes, islandstarts, islandorder, islandsteppers, body, joint, freebody, freecount);
 
     return maxreq;
 }
 
 static unsigned EstimateIslandProcessingSimultaneousCallsMaximumCount(unsigned activeThreadCount, unsigned islandsAllowedThreadCount, 
-    unsigned stepperAllowedThreadCount, dmaxcallcountestimate_fn_t maxCallCountEstimator)
+    unsigned stepperAllowedThreadCount, const dxIslandStepperInfo *steppers, unsigned stepperCount)
 {
-    unsigned stepperCallsMaximum = maxCallCountEstimator(activeThreadCount, stepperAllowedThreadCount);
+    // any of the steppers may run on each of the threads
+    unsigned stepperCallsMaximum = 0;
+    for (unsigned i = 0; i != stepperCount; ++i) {
+        unsigned stepperCalls = steppers[i].m_maxCallCountEstimate(activeThreadCount, stepperAllowedThreadCount);
+        stepperCallsMaximum = dMAX(stepperCallsMaximum, stepperCalls);
+    }
     unsigned islandsIntermediateCallsMaximum = (1 + 2); // ThreadedProcessIslandSearch_Callback + (ThreadedProcessIslandStepper_Callback && ThreadedProcessIslandSearch_Callback)
 
     unsigned result = 
@@ -884,11 +1378,14 @@ static unsigned EstimateIslandProcessingSimultaneousCallsMaximumCount(unsigned a
 // bodies will not be included in the simulation. disabled bodies are
 // re-enabled if they are found to be part of an active island.
 bool dxProcessIslands (dxWorld *world, const dxWorldProcessIslandsInfo &islandsInfo, 
-    dReal stepSize, dstepper_fn_t stepper, dmaxcallcountestimate_fn_t maxCallCountEstimator)
+    dReal stepSize, const dxIslandStepperInfo *steppers, unsigned stepperCount)
 {
     bool result = false;
 
-    dxIslandsProcessingCallContext callContext(world, islandsInfo, stepSize, stepper);
+    // the steppers work on the body state store; bring it up to date with the API changes
+    world->body_state.refresh();
+
+    dxIslandsProcessingCallContext callContext(world, islandsInfo, stepSize, steppers);
 
     do {
         dxStepWorkingMemory *wmem = world->wmem;
@@ -906,7 +1403,7 @@ bool dxProcessIslands (dxWorld *world, const dxWorldProcessIslandsInfo &islandsI
 
         unsigned stepperAllowedThreadCount = islandsAllowedThreadCount; // For now, set stepper allowed threads equal to island stepping threads
 
-        unsigned simultaneousCallsCount = EstimateIslandProcessingSimultaneousCallsMaximumCount(activeThreadCount, islandsAllowedThreadCount, stepperAllowedThreadCount, maxCallCountEstimator);
+        unsigned simultaneousCallsCount = EstimateIslandProcessingSimultaneousCallsMaximumCount(activeThreadCount, islandsAllowedThreadCount, stepperAllowedThreadCount, steppers, stepperCount);
         if (!world->PreallocateResourcesForThreadedCalls(simultaneousCallsCount)) {
             break;
         }
@@ -994,51 +1491,41 @@ void dxIslandsProcessingCallContext::ThreadedProcessIslandSearch(dxSingleIslandC
     bool finalizeJob = false;
 
     const dxWorldProcessIslandsInfo &islandsInfo = m_islandsInfo;
-    unsigned int const *islandSizes = islandsInfo.GetIslandSizes();
 
     const sizeint islandsCount = islandsInfo.GetIslandsCount();
     sizeint islandToProcess = ObtainNextIslandToBeProcessed(islandsCount);
 
     if (islandToProcess != islandsCount) {
-        // First time, the counts are zeros and on next passes, adding counts will skip island that has just been processed by stepper
-        dxBody *const *islandBodiesStart = stepperCallContext->GetSelectedIslandBodiesEnd();
-        dxJoint *const *islandJointsStart = stepperCallContext->GetSelectedIslandJointsEnd();
-        sizeint islandIndex = stepperCallContext->m_islandIndex;
-
-        for (; ; ++islandIndex) {
-            unsigned int bcount = islandSizes[islandIndex * dxISE__MAX + dxISE_BODIES_COUNT];
-            unsigned int jcount = islandSizes[islandIndex * dxISE__MAX + dxISE_JOINTS_COUNT];
+        // The islands are handed out in the scheduled order
+        sizeint islandIndex = islandsInfo.GetIslandOrder()[islandToProcess];
+        unsigned int const *islandSizes = islandsInfo.GetIslandSizes() + islandIndex * dxISE__MAX;
+        unsigned int const *islandStarts = islandsInfo.GetIslandStarts() + islandIndex * dxISE__MAX;
 
-            if (islandIndex == islandToProcess) {
-                // Store selected island details
-                stepperCallContext->AssignIslandSelection(islandBodiesStart, islandJointsStart, bcount, jcount);
+        dxBody *const *islandBodiesStart = islandsInfo.GetBodiesArray() + islandStarts[dxISE_BODIES_COUNT];
+        dxJoint *const *islandJointsStart = islandsInfo.GetJointsArray() + islandStarts[dxISE_JOINTS_COUNT];
 
-                // Store next island index to continue search from
-                ++islandIndex;
-                stepperCallContext->AssignIslandSearchProgress(islandIndex);
+        // Store selected island details
+        stepperCallContext->AssignIslandSelection(islandBodiesStart, islandJointsStart, 
+            islandSizes[dxISE_BODIES_COUNT], islandSizes[dxISE_JOINTS_COUNT]);
+        stepperCallContext->AssignIslandStepper(m_steppers[islandsInfo.GetIslandSteppers()[islandIndex]].m_stepper);
 
-                // Restore saved stepper memory arena position
-                stepperCallContext->RestoreSavedMemArenaStateForStepper();
+        // Restore saved stepper memory arena position
+        stepperCallContext->RestoreSavedMemArenaStateForStepper();
 
-                dCallReleaseeID nextSearchReleasee;
+        dCallReleaseeID nextSearchReleasee;
 
-                // Summary fault flag may be omitted as any failures will automatically propagate to dependent releasee (i.e. to m_groupReleasee)
-                m_world->PostThreadedCallForUnawareReleasee(NULL, &nextSearchReleasee, 1, m_groupReleasee, NULL, 
-                    &dxIslandsProcessingCallContext::ThreadedProcessIslandSearch_Callback, (void *)stepperCallContext, 0, "World Islands Stepping Selection");
+        // Summary fault flag may be omitted as any failures will automatically propagate to dependent releasee (i.e. to m_groupReleasee)
+        m_world->PostThreadedCallForUnawareReleasee(NULL, &nextSearchReleasee, 1, m_groupReleasee, NULL, 
+            &dxIslandsProcessingCallContext::ThreadedProcessIslandSearch_Callback, (void *)stepperCallContext, 0, "World Islands Stepping Selection");
 
-                stepperCallContext->AssignStepperCallFinalReleasee(nextSearchReleasee);
+        stepperCallContext->AssignStepperCallFinalReleasee(nextSearchReleasee);
 
-                m_world->PostThreadedCall(NULL, NULL, 0, nextSearchReleasee, NULL, 
-                    &dxIslandsProcessingCallContext::ThreadedProcessIslandStepper_Callback, (void *)stepperCallContext, 0, "Island Stepping Job Start");
-
-                break;
-            }
-
-            islandBodiesStart += bcount;
-            islandJointsStart += jcount;
-        }
+        m_world->PostThreadedCall(NULL, NULL, 0, nextSearchReleasee, NULL, 
+            &dxIslandsProcessingCallContext::ThreadedProcessIslandStepper_Callback, (void *)stepperCallContext, 0, "Island Stepping Job Start");
     }
     else {
+        // the free bodies are left for the threads that run out of islands
+        IntegrateFreeBodies();
         finalizeJob = true;
     }
 
@@ -1062,7 +1549,7 @@ int dxIslandsProcessingCallContext::ThreadedProcessIslandStepper_Callback(void *
 
 void dxIslandsProcessingCallContext::ThreadedProcessIslandStepper(dxSingleIslandCallContext *stepperCallContext)
 {
-    m_stepper(&stepperCallContext->m_stepperCallContext);
+    stepperCallContext->m_stepper(&stepperCallContext->m_stepperCallContext);
 }
 
 sizeint dxIslandsProcessingCallContext::ObtainNextIslandToBeProcessed(sizeint islandsCount)
@@ -1070,6 +1557,21 @@ sizeint dxIslandsProcessingCallContext::ObtainNextIslandToBeProcessed(sizeint is
     return ThrsafeIncrementSizeUpToLimit(&m_islandToProcessStorage, islandsCount);
 }
 
+void dxIslandsProcessingCallContext::IntegrateFreeBodies()
+{
+    const dxWorldProcessIslandsInfo &islandsInfo = m_islandsInfo;
+    dxBody *const *freeBodies = islandsInfo.GetFreeBodiesArray();
+    const sizeint freeCount = islandsInfo.GetFreeBodiesCount();
+    const sizeint chunkCount = (freeCount + (dxFREE_BODIES_CHUNK - 1)) / dxFREE_BODIES_CHUNK;
+
+    sizeint chunk;
+    while ((chunk = ThrsafeIncrementSizeUpToLimit(&m_freeBodiesChunkToProcessStorage, chunkCount)) != chunkCount) {
+        sizeint first = chunk * dxFREE_BODIES_CHUNK;
+        unsigned int count = (unsigned int)dMIN((sizeint)dxFREE_BODIES_CHUNK, freeCount - first);
+        dxIntegrateFreeBodies(m_world, freeBodies + first, count, m_stepSize);
+    }
+}
+
 
 //****************************************************************************
 // World processing context management
@@ -1160,7 +1662,7 @@ sizeint dxWorldProcessMemArena::AdjustArenaSizeForReserveRequirements(sizeint ar
 
 
 bool dxReallocateWorldProcessContext (dxWorld *world, dxWorldProcessIslandsInfo &islandsInfo, 
-    dReal stepSize, dmemestimate_fn_t stepperEstimate)
+    dReal stepSize, const dxIslandStepperInfo *steppers, dstepperselect_fn_t stepperSelect)
 {
     bool result = false;
 
@@ -1196,7 +1698,7 @@ bool dxReallocateWorldProcessContext (dxWorld *world, dxWorldProcessIslandsInfo
         }
         dIASSERT(islandsArena->IsStructureValid());
 
-        sizeint stepperReq = BuildIslandsAndEstimateStepperMemoryRequirements(islandsInfo, islandsArena, world, stepSize, stepperEstimate);
+        sizeint stepperReq = BuildIslandsAndEstimateStepperMemoryRequirements(islandsInfo, islandsArena, world, stepSize, steppers, stepperSelect);
         dIASSERT(stepperReq == dEFFICIENT_SIZE(stepperReq));
 
         sizeint stepperReqWithCallContext = stepperReq + dEFFICIENT_SIZE(sizeof(dxSingleIslandCallContext));
@@ -25,11 +25,13 @@
 
 #include "objects.h"
 #include "common.h"
+#include <algorithm>
 
 
 /* utility */
 
-void dInternalHandleAutoDisabling (dxWorld *world, dReal stepsize);
+void dInternalHandleAutoDisabling (dxIslandComponent *component, dReal stepsize);
+void dInternalWakeIsland (dxBody *b);
 void dxStepBody (dxBody *b, dReal h);
 
 
@@ -256,26 +258,83 @@ private:
     dCallWaitID             m_pcwIslandsSteppingWait;
 };
 
+enum dxISLANDSIZESELEMENT
+{
+    dxISE_BODIES_COUNT,
+    dxISE_JOINTS_COUNT,
+
+    dxISE__MAX
+};
+
+// the cost of stepping an island, used to start the expensive islands first.
+// the iteration count (or the LCP size) grows with the constraint rows, so the
+// rows rank the islands the same way for all the steppers.
+struct dxIslandCostGreater
+{
+    dxIslandCostGreater(const unsigned int *rows, const unsigned int *sizes): m_rows(rows), m_sizes(sizes) {}
+
+    unsigned int cost(unsigned int i) const { return m_rows[i] + m_sizes[i * dxISE__MAX + dxISE_BODIES_COUNT]; }
+
+    // islands of equal cost keep their order
+    bool operator ()(unsigned int a, unsigned int b) const
+    {
+        unsigned int costa = cost(a), costb = cost(b);
+        return costa != costb ? costa > costb : a < b;
+    }
+
+    const unsigned int *m_rows;
+    const unsigned int *m_sizes;
+};
+
+// sorts the island indices in `order' so that the most expensive islands are
+// stepped first. `rows' holds the constraint rows and `sizes' the sizes
+// (dxISE__MAX elements) of each island.
+inline void dxScheduleIslands(unsigned int *order, sizeint count, const unsigned int *rows, const unsigned int *sizes)
+{
+    std::sort(order, order + count, dxIslandCostGreater(rows, sizes));
+}
+
 struct dxWorldProcessIslandsInfo
 {
-    void AssignInfo(sizeint islandcount, unsigned int const *islandsizes, dxBody *const *bodies, dxJoint *const *joints)
+    void AssignInfo(sizeint islandcount, unsigned int const *islandsizes, unsigned int const *islandstarts, 
+        unsigned int const *islandorder, unsigned int const *islandsteppers, dxBody *const *bodies, dxJoint *const *joints, 
+        dxBody *const *freebodies, sizeint freecount)
     {
         m_IslandCount = islandcount;
         m_pIslandSizes = islandsizes;
+        m_pIslandStarts = islandstarts;
+        m_pIslandOrder = islandorder;
+        m_pIslandSteppers = islandsteppers;
         m_pBodies = bodies;
         m_pJoints = joints;
+        m_pFreeBodies = freebodies;
+        m_FreeBodyCount = freecount;
     }
 
     sizeint GetIslandsCount() const { return m_IslandCount; }
     unsigned int const *GetIslandSizes() const { return m_pIslandSizes; }
+    // offsets of the island bodies/joints in the arrays, laid out like the sizes
+    unsigned int const *GetIslandStarts() const { return m_pIslandStarts; }
+    // the islands in the order they are to be stepped in
+    unsigned int const *GetIslandOrder() const { return m_pIslandOrder; }
+    // the index of the stepper of each island
+    unsigned int const *GetIslandSteppers() const { return m_pIslandSteppers; }
     dxBody *const *GetBodiesArray() const { return m_pBodies; }
     dxJoint *const *GetJointsArray() const { return m_pJoints; }
+    // the enabled bodies without joints, which are not in any island
+    dxBody *const *GetFreeBodiesArray() const { return m_pFreeBodies; }
+    sizeint GetFreeBodiesCount() const { return m_FreeBodyCount; }
 
 private:
     sizeint                  m_IslandCount;
     unsigned int const      *m_pIslandSizes;
+    unsigned int const      *m_pIslandStarts;
+    unsigned int const      *m_pIslandOrder;
+    unsigned int const      *m_pIslandSteppers;
     dxBody *const           *m_pBodies;
     dxJoint *const          *m_pJoints;
+    dxBody *const           *m_pFreeBodies;
+    sizeint                  m_FreeBodyCount;
 };
 
 struct dxStepperProcessingCallContext
@@ -321,16 +380,30 @@ struct dxStepperProcessingCallContext
 
 typedef void (*dstepper_fn_t) (const dxStepperProcessingCallContext *callContext);
 typedef unsigned (*dmaxcallcountestimate_fn_t) (unsigned activeThreadCount, unsigned allowedThreadCount);
+typedef sizeint (*dmemestimate_fn_t) (dxBody * const *body, unsigned int nb, 
+                                     dxJoint * const *_joint, unsigned int _nj);
 
-bool dxProcessIslands (dxWorld *world, const dxWorldProcessIslandsInfo &islandsInfo, 
-                       dReal stepSize, dstepper_fn_t stepper, dmaxcallcountestimate_fn_t maxCallCountEstimator);
+// a stepper the islands can be processed with
+struct dxIslandStepperInfo
+{
+    dstepper_fn_t               m_stepper;
+    dmemestimate_fn_t           m_memoryEstimate;
+    dmaxcallcountestimate_fn_t  m_maxCallCountEstimate;
+    unsigned                    m_batchRows;    // the small islands that have at most this many constraint rows together are stepped in batches
+};
 
+// picks the stepper of an island from its joints and constraint rows.
+// returns the index of the stepper in the array given to the processing.
+typedef unsigned (*dstepperselect_fn_t) (dxWorld *world, dxJoint * const *joint, unsigned int nj, unsigned int rows);
 
-typedef sizeint (*dmemestimate_fn_t) (dxBody * const *body, unsigned int nb, 
-                                     dxJoint * const *_joint, unsigned int _nj);
+bool dxProcessIslands (dxWorld *world, const dxWorldProcessIslandsInfo &islandsInfo, 
+                       dReal stepSize, const dxIslandStepperInfo *steppers, unsigned stepperCount);
 
+// the islands are stepped with the first of `steppers' unless a
+// `stepperselect' function is given. only the islands that are stepped
+// with the same stepper are batched together.
 bool dxReallocateWorldProcessContext (dxWorld *world, dxWorldProcessIslandsInfo &islandsinfo, 
-                                      dReal stepsize, dmemestimate_fn_t stepperestimate);
+                                      dReal stepsize, const dxIslandStepperInfo *steppers, dstepperselect_fn_t stepperselect);
 
 dxWorldProcessMemArena *dxAllocateTemporaryWorldProcessMemArena(
     sizeint memreq, const dxWorldProcessMemoryManager *memmgr/*=NULL*/, const dxWorldProcessMemoryReserveInfo *reserveinfo/*=NULL*/);
@@ -25,6 +25,11 @@
 #include <UnitTest++.h>
 #include <ode/ode.h>
 #include <ode/odemath.h>
+#include "common.h"
+#include <vector>
+#include "../ode/src/config.h"
+#include "../ode/src/matrix.h"
+#include "../ode/src/fastsimd_impl.h"
 
 
 
@@ -245,3 +250,293 @@ TEST(test_dOrthogonalizeR)
     }
 
 }
+
+
+// Sizes around the vector kernel thresholds and the block sizes of the
+// factorizer (2) and the solvers (4)
+static const int ldltTestSizes[] = { 1, 2, 3, 5, 16, 17, 18, 38, 73 };
+
+// A = M*M' + n*I with random M is symmetric positive definite
+static void makePositiveDefinite(std::vector<dReal> &A, int n, int nskip)
+{
+    std::vector<dReal> M(n * nskip);
+    for (int i = 0; i < n; ++i) {
+        for (int j = 0; j < n; ++j) {
+            M[i * nskip + j] = dRandReal() - REAL(0.5);
+        }
+    }
+    A.assign(n * nskip, REAL(0.0));
+    for (int i = 0; i < n; ++i) {
+        for (int j = 0; j < n; ++j) {
+            dReal sum = i == j ? (dReal)n : REAL(0.0);
+            for (int m = 0; m < n; ++m) {
+                sum += M[i * nskip + m] * M[j * nskip + m];
+            }
+            A[i * nskip + j] = sum;
+        }
+    }
+}
+
+TEST(test_dDot)
+{
+    dRandSetSeed(1);
+    std::vector<dReal> a(80), b(80);
+    for (int i = 0; i < 80; ++i) {
+        a[i] = dRandReal() * 2 - 1;
+        b[i] = dRandReal() * 2 - 1;
+    }
+    for (int n = 0; n <= 80; ++n) {
+        dReal expected = 0;
+        for (int i = 0; i < n; ++i) {
+            expected += a[i] * b[i];
+        }
+        CHECK_CLOSE(expected, dDot(&a[0], &b[0], n), (n + 1) * dEpsilon * 4);
+    }
+}
+
+TEST(test_dFactorSolveLDLT)
+{
+    dRandSetSeed(2);
+    for (unsigned k = 0; k != sizeof(ldltTestSizes) / sizeof(ldltTestSizes[0]); ++k) {
+        const int n = ldltTestSizes[k], nskip = dPAD(n);
+
+        std::vector<dReal> A, L, d(n), b(n), x(n);
+        makePositiveDefinite(A, n, nskip);
+        for (int i = 0; i < n; ++i) {
+            b[i] = dRandReal() - REAL(0.5);
+        }
+
+        L = A;
+        dFactorLDLT(&L[0], &d[0], n, nskip);
+        x = b;
+        dSolveLDLT(&L[0], &d[0], &x[0], n, nskip);
+
+        for (int i = 0; i < n; ++i) {
+            dReal Ax = 0;
+            for (int j = 0; j < n; ++j) {
+                Ax += A[i * nskip + j] * x[j];
+            }
+            CHECK_CLOSE(b[i], Ax, n * dEpsilon * 1000);
+        }
+    }
+}
+
+// The factorization and the solves are checked against textbook scalar loops.
+// The library runs the vector kernels of the CPU for the longer rows.
+TEST(test_dFactorLDLTMatchesScalar)
+{
+    dRandSetSeed(3);
+    for (unsigned k = 0; k != sizeof(ldltTestSizes) / sizeof(ldltTestSizes[0]); ++k) {
+        const int n = ldltTestSizes[k], nskip = dPAD(n);
+
+        std::vector<dReal> A, L, d(n);
+        makePositiveDefinite(A, n, nskip);
+        L = A;
+        dFactorLDLT(&L[0], &d[0], n, nskip);
+
+        std::vector<dReal> refL(n * nskip, REAL(0.0)), refD(n);
+        for (int i = 0; i < n; ++i) {
+            for (int j = 0; j < i; ++j) {
+                dReal sum = A[i * nskip + j];
+                for (int m = 0; m < j; ++m) {
+                    sum -= refL[i * nskip + m] * refL[j * nskip + m] * refD[m];
+                }
+                refL[i * nskip + j] = sum / refD[j];
+            }
+            dReal sum = A[i * nskip + i];
+            for (int m = 0; m < i; ++m) {
+                sum -= refL[i * nskip + m] * refL[i * nskip + m] * refD[m];
+            }
+            refD[i] = sum;
+        }
+
+        for (int i = 0; i < n; ++i) {
+            for (int j = 0; j < i; ++j) {
+                CHECK_CLOSE(refL[i * nskip + j], L[i * nskip + j], n * dEpsilon * 10);
+            }
+            CHECK_CLOSE(REAL(1.0), d[i] * refD[i], n * dEpsilon * 10);
+        }
+    }
+}
+
+TEST(test_dSolveL1MatchesScalar)
+{
+    dRandSetSeed(4);
+    for (unsigned k = 0; k != sizeof(ldltTestSizes) / sizeof(ldltTestSizes[0]); ++k) {
+        const int n = ldltTestSizes[k], nskip = dPAD(n);
+
+        // A unit lower triangle with small entries keeps the solutions bounded
+        std::vector<dReal> L(n * nskip, REAL(0.0)), b(n);
+        for (int i = 0; i < n; ++i) {
+            for (int j = 0; j < i; ++j) {
+                L[i * nskip + j] = (dRandReal() - REAL(0.5)) / n;
+            }
+            b[i] = dRandReal() - REAL(0.5);
+        }
+
+        std::vector<dReal> x(b), refX(n);
+        dSolveL1(&L[0], &x[0], n, nskip);
+        for (int i = 0; i < n; ++i) {
+            dReal sum = b[i];
+            for (int j = 0; j < i; ++j) {
+                sum -= L[i * nskip + j] * refX[j];
+            }
+            refX[i] = sum;
+        }
+        for (int i = 0; i < n; ++i) {
+            CHECK_CLOSE(refX[i], x[i], n * dEpsilon * 10);
+        }
+
+        std::vector<dReal> xT(b), refXT(n);
+        dSolveL1T(&L[0], &xT[0], n, nskip);
+        for (int i = n - 1; i >= 0; --i) {
+            dReal sum = b[i];
+            for (int j = i + 1; j < n; ++j) {
+                sum -= L[j * nskip + i] * refXT[j];
+            }
+            refXT[i] = sum;
+        }
+        for (int i = 0; i < n; ++i) {
+            CHECK_CLOSE(refXT[i], xT[i], n * dEpsilon * 10);
+        }
+    }
+}
+
+TEST(test_dxFactorLDLTEnvelopeSingular)
+{
+    // two equal rows, as a loop of joints without CFM makes them, with a
+    // consistent right hand side: x0 + x1 = 0 and x2 = 1
+    const sizeint rowstart[] = { 0, 1, 3, 6 };
+    dReal A[] = { 1, 1, 1, 1, 1, 3 };
+    dReal d[3], x[] = { 1, 1, 3 };
+    dxFactorLDLTEnvelope(A, d, rowstart, 3);
+    dxSolveLDLTEnvelope(A, d, rowstart, x, 3);
+    for (int i = 0; i < 3; ++i) {
+        CHECK(dFabs(d[i]) < dInfinity);
+        CHECK(dFabs(x[i]) < dInfinity);
+    }
+    CHECK_CLOSE(REAL(0.0), x[0] + x[1], dSqrt(dEpsilon));
+    CHECK_CLOSE(REAL(1.0), x[2], dSqrt(dEpsilon));
+}
+
+
+#if dxFAST_KERNELS_SIMD
+
+// The AVX2 and AVX-512 kernels are called directly so that both are checked
+// on CPUs which the dispatchers would route to AVX-512 only
+
+struct FastKernels
+{
+    dReal (*dot)(const dReal *a, const dReal *b, unsigned n);
+    dReal (*dotStrided)(const dReal *a, const dReal *b, unsigned n);
+    void (*dot4Rows)(dReal Z[4], const dReal *L, unsigned rowSkip, const dReal *b, unsigned n);
+    void (*dot2x2)(dReal Z[4], const dReal *L, const dReal *B, unsigned rowSkip, unsigned n);
+    void (*scaleDot2)(dReal Z[3], dReal *A, unsigned rowSkip, const dReal *d, unsigned n);
+};
+
+static const unsigned fastKernelTestSizes[] = { 16, 17, 23, 32, 33, 40, 63, 64, 73, 100 };
+
+static bool isClose(dReal expected, dReal actual, dReal tolerance)
+{
+    return dFabs(expected - actual) <= tolerance;
+}
+
+// Whether all the kernels match the scalar loops within the tolerance
+static bool checkFastKernels(const FastKernels &kernels)
+{
+    bool result = true;
+    const unsigned maxN = 100, rowSkip = dPAD(maxN);
+    std::vector<dReal> rows(4 * rowSkip), b(2 * maxN);
+    for (unsigned i = 0; i != rows.size(); ++i) {
+        rows[i] = dRandReal() * 2 - 1;
+    }
+    for (unsigned i = 0; i != b.size(); ++i) {
+        b[i] = dRandReal() * 2 - 1;
+    }
+
+    for (unsigned k = 0; k != sizeof(fastKernelTestSizes) / sizeof(fastKernelTestSizes[0]); ++k) {
+        const unsigned n = fastKernelTestSizes[k];
+        const dReal tol = (n + 1) * dEpsilon * 4;
+
+        dReal ref[4] = { 0, 0, 0, 0 }, refStrided = 0;
+        for (unsigned r = 0; r != 4; ++r) {
+            for (unsigned i = 0; i != n; ++i) {
+                ref[r] += rows[r * rowSkip + i] * b[i];
+            }
+        }
+        for (unsigned i = 0; i != n; ++i) {
+            refStrided += rows[i] * b[2 * i];
+        }
+        result &= isClose(ref[0], kernels.dot(&rows[0], &b[0], n), tol);
+        result &= isClose(refStrided, kernels.dotStrided(&rows[0], &b[0], n), tol);
+
+        dReal Z[4];
+        kernels.dot4Rows(Z, &rows[0], rowSkip, &b[0], n);
+        for (unsigned r = 0; r != 4; ++r) {
+            result &= isClose(ref[r], Z[r], tol);
+        }
+
+        // Rows 0 and 1 times rows 2 and 3
+        dReal ref2x2[4] = { 0, 0, 0, 0 };
+        for (unsigned i = 0; i != n; ++i) {
+            dReal p1 = rows[i], p2 = rows[rowSkip + i];
+            dReal q1 = rows[2 * rowSkip + i], q2 = rows[3 * rowSkip + i];
+            ref2x2[0] += p1 * q1;
+            ref2x2[1] += p1 * q2;
+            ref2x2[2] += p2 * q1;
+            ref2x2[3] += p2 * q2;
+        }
+        kernels.dot2x2(Z, &rows[0], &rows[2 * rowSkip], rowSkip, n);
+        for (unsigned r = 0; r != 4; ++r) {
+            result &= isClose(ref2x2[r], Z[r], tol);
+        }
+
+        std::vector<dReal> scaled(rows.begin(), rows.begin() + 2 * rowSkip);
+        dReal refScale[3] = { 0, 0, 0 };
+        for (unsigned i = 0; i != n; ++i) {
+            dReal p1 = rows[i], p2 = rows[rowSkip + i];
+            refScale[0] += p1 * p1 * b[i];
+            refScale[1] += p2 * p1 * b[i];
+            refScale[2] += p2 * p2 * b[i];
+        }
+        kernels.scaleDot2(Z, &scaled[0], rowSkip, &b[0], n);
+        for (unsigned r = 0; r != 3; ++r) {
+            result &= isClose(refScale[r], Z[r], tol);
+        }
+        for (unsigned i = 0; i != n; ++i) {
+            result &= isClose(rows[i] * b[i], scaled[i], dEpsilon);
+            result &= isClose(rows[rowSkip + i] * b[i], scaled[rowSkip + i], dEpsilon);
+        }
+    }
+    return result;
+}
+
+TEST(test_FastKernelsAVX2)
+{
+    if (!__builtin_cpu_supports("avx2") || !__builtin_cpu_supports("fma")) {
+        return;
+    }
+
+    const FastKernels kernels = {
+        &dxFastDot_AVX2<1>, &dxFastDot_AVX2<2>, &dxFastDot4Rows_AVX2<1>,
+        &dxFastDot2x2_AVX2, &dxFastScaleDot2_AVX2<1>
+    };
+    dRandSetSeed(5);
+    CHECK(checkFastKernels(kernels));
+}
+
+TEST(test_FastKernelsAVX512)
+{
+    if (!__builtin_cpu_supports("avx512f")) {
+        return;
+    }
+
+    const FastKernels kernels = {
+        &dxFastDot_AVX512<1>, &dxFastDot_AVX512<2>, &dxFastDot4Rows_AVX512<1>,
+        &dxFastDot2x2_AVX512, &dxFastScaleDot2_AVX512<1>
+    };
+    dRandSetSeed(5);
+    CHECK(checkFastKernels(kernels));
+}
+
+#endif // #if dxFAST_KERNELS_SIMD